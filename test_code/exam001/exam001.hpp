@@ -5,22 +5,48 @@
 
 /*
 Exam001という名前の，気温を測定するセンサのサンプルプログラムです．
-関数の中身は"exam001.cpp"ファイルに書かれています
+Exam001は通信に使うI2Cの型(Bus)のテンプレートになっています．
+sc::Exam001 exam001(i2c, ...)のように書くと，i2cの型(pico::I2Cなど)がBusになり，仮想関数を通さずに通信します．
+sc::Exam001<>のように書くと，Busはsc::I2Cになり，どのI2Cでも使えます．(こちらは"exam001.cpp"で一度だけコンパイルされます)
+テンプレートは使う側で中身が見えている必要があるので，関数の中身もこのファイルに書かれています．
 */
 
 namespace sc  // scという名前空間を使用します．(他のライブラリなどとの名前かぶりを防止するため)
 {
+    //! @brief Exam001のキャリブレーション(補正)用のデータと，補正の計算
+    //! 補正は整数だけで計算し，0.01℃単位の値を返します．(picoにはFPUがないので，doubleの計算は遅い)
+    struct Exam001Calibration
+    {
+        uint16_t dig_T1 = 1;  // 気温補正用データ
+        int16_t dig_T2 = 1, dig_T3 = 3;  // 気温補正用データ
+        // ↑　一度補正用データを受信して，デフォルトの値を設定しておく（うまく読み込めなかった時のため）
+
+        //! @brief 気温データを補正
+        //! @param raw_temperature 生データ
+        //! @return 補正後の気温 (0.01℃)
+        constexpr int32_t compensate_temperature(int32_t raw_temperature) const noexcept
+        {
+            // 注：キャリブレーションの計算はセンサによって全く違います．↓は適当に作った一例です
+            const int32_t var1 = (static_cast<int32_t>(dig_T1 << 1) * (static_cast<int32_t>(dig_T2))) >> 11;  // キャリブレーションの計算を行っています．
+            const int32_t var2 = (((static_cast<int32_t>(dig_T1) * static_cast<int32_t>(dig_T1)) >> 12) * static_cast<int32_t>(dig_T3)) >> 14;
+            return raw_temperature*var1 + var2;  // 0.01℃単位の値を返す  (℃に直す割り算は，表示するときに行う)
+        }
+    };
+
     //! @brief Exam001による測定を行うクラス
+    //! @tparam Bus 通信に使うI2Cの型  sc::I2Cなら仮想関数で，pico::I2Cなどなら直接呼び出します
+    template<class Bus = I2C>
     class Exam001 : public Sensor  // Exam001という名前のセンサのプログラムは，Exam001というクラスの中に書きます．Exam001型を作っています．
     {
-        // ここには宣言しか書かれていません．関数の中身は"exam.cpp"ファイルに書かれています(分割コンパイルという)
+        // ここには宣言だけを書いています．関数の中身はクラスの後に書かれています
 
-        const I2C& _i2c;  // I2C通信を行うためのI2C型のオブジェクトです  定数にすることで意図しない変更を防いでいます
+        const Bus& _i2c;  // I2C通信を行うためのI2C型のオブジェクトです  定数にすることで意図しない変更を防いでいます
         const I2C::SlaveAddr _slave_addr;  // I2C通信では通信相手のアドレスを一緒に送り誰宛の通信かを識別しています．そのためのこのセンサのアドレスです．  定数にすることで意図しない変更を防いでいます
         int32_t _raw_temperature;
     public:  // publicなメンバはこのクラスの外からアクセスできます
-        Exam001(const I2C& i2c, I2C::SlaveAddr slave_addr);  // このクラスの初期設定を行います(コンストラクタという)
+        Exam001(const Bus& i2c, I2C::SlaveAddr slave_addr);  // このクラスの初期設定を行います(コンストラクタという)
         Measurement measure();  // 測定を行う関数
+        Result<Measurement> try_measure();  // 例外を投げずに測定を行う関数  失敗した場合はエラーを返す
     private:
         // 測定のモード
         enum Mode  // 定数に名前を付けてわかりやすくしています．(列挙体)
@@ -30,10 +56,7 @@ namespace sc  // scという名前空間を使用します．(他のライブラ
             MODE_NORMAL = 3
         };
 
-        //  キャリブレーション(補正)を行うためのデータ
-        uint16_t dig_T1 = 1;  // 気温補正用データ
-        int16_t dig_T2 = 1, dig_T3 = 3;  // 気温補正用データ
-        // ↑　一度補正用データを受信して，デフォルトの値を設定しておく（うまく読み込めなかった時のため）
+        Exam001Calibration _calibration;  // キャリブレーション(補正)を行うためのデータ
 
         bool check_connection() noexcept;  // センサが正常に接続されていることを確認
 
@@ -41,10 +64,108 @@ namespace sc  // scという名前空間を使用します．(他のライブラ
 
         void read_calibration_data();  // 補正用データ読み取り
 
-        void read_raw();  // 生データ読み取り (キャリブレーション前のデータを受信)
-
-        float calibrate_temperature();  // 気温データを補正
+        Result<void> read_raw();  // 生データ読み取り (キャリブレーション前のデータを受信)
     };
+
+    //! @brief Exam001というクラスを構築
+    template<class Bus>  // テンプレートのクラスの関数には，毎回これを付けます
+    Exam001<Bus>::Exam001(const Bus& i2c, I2C::SlaveAddr slave_addr):  // Exam001<Bus>::というのはExam001というクラスの中の関数だという意味です．
+        _i2c(i2c),  // コンストラクタでは，(...):の後に，メンバ変数名(値)のように書くことで，メンバ変数の初期化を行います
+        _slave_addr(slave_addr)
+    {
+        if (!check_connection())  // センサと正常に通信できているかを確認
+        {
+            raise(SC_ERROR_INFO(ErrorCode::wrong_device, "An error has occured in communication with the sensor"));  // エラーを投げる．エラーはchatch句でキャッチされる．キャッチされなかったらプログラムが終了する．(-fno-exceptionsでは，ログを記録して停止する)
+        }
+
+        set_measurement_method();  // 測定方法などを設定
+        read_calibration_data();  // キャリブレーション用のデータを読み込み
+    }
+
+    //! @brief 測定を行う
+    //! @return 測定結果
+    template<class Bus>
+    Measurement Exam001<Bus>::measure()
+    {
+        return try_measure().value();  // エラーだったら，ここで例外を投げる
+    }
+
+    //! @brief 例外を投げずに測定を行う
+    //! @return 測定結果  失敗した場合はエラー
+    template<class Bus>
+    Result<Measurement> Exam001<Bus>::try_measure()
+    {
+        const Result<void> read_result = read_raw();  // データを受信
+        if (!read_result)  // 受信に失敗していたら
+    return read_result.error();  // エラーを返す  (エラーはまだ記録されていない．必要なときにerror().log()で記録する)
+        const Result<Temperature> temperature = Temperature::create_centi(_calibration.compensate_temperature(_raw_temperature));  // キャリブレーションをして，範囲内かを確認してからTemperature型の変数に保存  (ここまで整数だけで計算する)
+        if (!temperature)
+    return temperature.error();
+
+        return Measurement(temperature.value());  // 測定値を返す  (temperature, pressure)のようにすることで気温以外もまとめて返すことができます
+    }
+
+    //! @brief センサのチップIDを受信して接続を確認
+    //! @return 正常だったらtrue, 異常だったらfalse
+    template<class Bus>
+    bool Exam001<Bus>::check_connection() noexcept  // エラーを返さない関数です
+    {
+        const I2C::MemoryAddr ChipID_Addr(0x00);  // センサ内のチップIDが保存されているメモリアドレス
+        uint8_t chip_id[1];  // 受信したチップIDの保存先
+        const Result<void> result = I2CAccess<Bus>::read_mem_into(_i2c, chip_id, _slave_addr, ChipID_Addr);  // I2Cで1バイト受信してチップIDを取得  失敗しても例外は投げず，エラーを返す
+        if (!result)  // 受信に失敗していたら
+        {
+            result.error().log();  // エラーを記録
+    return false;  // 異常なのでfalseを返す
+        }
+        constexpr uint8_t CorrectChipID = 0x60;  // 正しいチップID
+        if (chip_id[0] == CorrectChipID)  // 正しいチップIDが読み取れたかを確認
+        {
+    return true;  // 正常なのでtrueを返す
+        } else {
+            SC_ERROR_INFO(ErrorCode::wrong_device, "read wrong chip ID").log();  // 正しくないIDだったらエラーを記録
+    return false;  // 異常なのでfalseを返す
+        }
+    }
+
+    //! @brief 測定方法などを設定
+    //! @param mode 測定モード
+    template<class Bus>
+    void Exam001<Bus>::set_measurement_method(Mode mode)  // 他にも，測定の間隔やノイズ処理などの設定項目があったら，ここで設定する
+    {
+        const I2C::MemoryAddr SettingMemoryAddr(0xf2);  // 設定を書き込むセンサ内のメモリアドレス
+        const uint8_t setting[1] = {static_cast<uint8_t>(mode << 2)};  // 書き込む設定
+        I2CAccess<Bus>::write_mem(_i2c, setting, _slave_addr, SettingMemoryAddr).value();  // 設定をセンサに書き込む  失敗したら例外を投げる
+        // ここでしている計算(mode << 2)はセンサによって違います．これは適当に作った一例です
+    }
+
+    //! @brief 補正用データ読み取り
+    template<class Bus>
+    void Exam001<Bus>::read_calibration_data()
+    {
+        const I2C::MemoryAddr CalibrationAddr(0x88);  // センサ内でキャリブレーション用のデータが保存されているメモリアドレス
+        uint8_t calibration_data[6];  // キャリブレーションデータの保存先
+        I2CAccess<Bus>::read_mem_into(_i2c, calibration_data, _slave_addr, CalibrationAddr).value();  // キャリブレーションデータを受信  失敗したら例外を投げる
+        _calibration.dig_T1 = calibration_data[0] | (calibration_data[1] << 8);  // キャリブレーションデータを保存
+        _calibration.dig_T2 = calibration_data[2] | (calibration_data[3] << 8);  // 注：この時の計算方法やデータの数はセンサによって違います．この計算は適当に作った一例です
+        _calibration.dig_T3 = calibration_data[4] | (calibration_data[5] << 8);  // << はビットシフト演算子です
+    }
+
+    // 生データ読み取り (キャリブレーション前のデータを受信)
+    template<class Bus>
+    Result<void> Exam001<Bus>::read_raw()
+    {
+        const I2C::MemoryAddr TemperatureAddr(0x60);  // センサ内で気温が保存されているメモリアドレス
+        uint8_t raw_data[3];  // 受信したデータの保存先  (配列なのでヒープを使わない)
+        const Result<void> result = I2CAccess<Bus>::read_mem_into(_i2c, raw_data, _slave_addr, TemperatureAddr);  // センサの値を受信
+        if (!result)
+    return result.error();
+        _raw_temperature = static_cast<uint32_t>(raw_data[0] << 12) | static_cast<uint32_t>(raw_data[1] << 4) | (raw_data[2] >> 4);  // 受信した値を保存
+        // 注：↑計算方法などはセンサによって違います．これは適当に作った一例です
+        return Result<void>();
+    }
+
+    extern template class Exam001<I2C>;  // sc::I2Cを使うものは"exam001.cpp"で一度だけコンパイルする
 }
 
 #endif // SC19_CODE_TEST_EXAM001_EXAM001_HPP_
\ No newline at end of file
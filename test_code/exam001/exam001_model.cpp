@@ -0,0 +1,25 @@
+#include "sc_pico/sc_host.hpp"
+
+/*
+PC上でExam001を動かすときに，センサの代わりになるモデルです．(picoでのビルドには使いません)
+I2C0のスレーブアドレス0x05に，Exam001と同じメモリを持つセンサをつなぎます．
+*/
+
+namespace
+{
+    //! @brief Exam001のメモリのモデル
+    class Exam001Model
+    {
+        host::RegisterDevice _device;  // センサ内のメモリ
+    public:
+        Exam001Model()
+        {
+            _device.set(0x00, {0x60});  // チップID
+            _device.set(0x88, {0x00, 0x04, 0x01, 0x00, 0x00, 0x00});  // キャリブレーションデータ  dig_T1 = 1024, dig_T2 = 1, dig_T3 = 0
+            _device.set(0x60, {0x00, 0x9c, 0x40});  // 生データ  キャリブレーション後は25.00度
+            host::I2C::connect(false, sc::I2C::SlaveAddr(0x05), _device);
+        }
+    };
+
+    Exam001Model exam001_model;  // プログラムの開始時につなぐ
+}
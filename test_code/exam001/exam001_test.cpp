@@ -6,14 +6,28 @@ int main()
 {
     stdio_init_all();  // pico-SDKを初期化
     
-    pico::I2C i2c(pico::I2C::Pin(4, 5), 500*1000); // GPIO4とGPIO5のピンを使う，500kHzのI2C通信をセットアップ
+    pico::I2C i2c(pico::I2C::Pin::of<4, 5>(), 500*1000); // GPIO4とGPIO5のピンを使う，500kHzのI2C通信をセットアップ  (I2Cに使えないピンならコンパイルエラー)
     sc::Exam001 exam001(i2c, sc::I2C::SlaveAddr(0x05));  // センサExam001をセットアップ．このセンサは渡されたi2cを使って通信する．
 
-    sc::Measurement measured_data;
-    while (true)
+    // 測定値の処理はコア1で行い，コア0は測定だけを繰り返す  段は上から順に通る
+    sc::MovingAverage<int32_t, 4> temperature_average;  // 気温の移動平均  0.01℃単位の整数のまま計算する
+    auto pipeline = sc::make_pipeline<sc::Measurement, 8>(sc::PipelineBase::Backpressure::wait,  // 処理が追いつかなければ測定を待たせる
+        [&temperature_average](sc::Measurement& measured_data)  // 気温を平均してノイズを減らす
+        {
+            const int32_t average = temperature_average.update(measured_data.get<sc::Temperature>().get_centi());
+            measured_data.set(sc::Temperature::from_centi(average));
+        },
+        [](sc::Measurement& measured_data)  // 気温を出力する  Log::writeでSDカードにも保存されるようにする予定
+        {
+            sc::Log::write("exam001 temperature: %f\n", measured_data.get<sc::Temperature>().get());
+        });
+    pico::start_pipeline(pipeline);  // コア1でパイプラインの処理とログの出力を始める
+
+    auto measure = [&exam001, &pipeline]
     {
-        measured_data = exam001.measure();  // Exam001で測定を行い，Measurement型の値を受け取る  Measurement型には複数の測定値を保存できる
-        sc::Temperature measured_temperature = measured_data.get<sc::Temperature>();  // Measurement型の中からTemperature型の値を取り出す
-        sc::Log::write("exam001 temperature: %f\n", measured_temperature.get());  // 気温を出力する  Log::writeでSDカードにも保存されるようにする予定
-    }
+        pipeline.push(exam001.measure(), pico::get_time_us());  // Exam001で測定を行い，Measurement型の値をコア1に渡す  Measurement型には複数の測定値を保存できる
+    };
+    sc::Scheduler<> scheduler;
+    scheduler.add(measure, 2*1000);  // 2msごと(500Hz)に測定する  全力で回すのではなく，決まった間隔で測定する
+    pico::run_scheduler(scheduler);  // 次の測定の時刻までは眠って待つ
 }
\ No newline at end of file
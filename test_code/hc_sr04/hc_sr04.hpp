@@ -0,0 +1,88 @@
+#ifndef SC19_CODE_TEST_HC_SR04_HC_SR04_HPP_  // 同じファイルを2回読み込まないためのものです
+#define SC19_CODE_TEST_HC_SR04_HC_SR04_HPP_
+
+#include "sc_pico/sc.hpp"
+
+/*
+超音波距離センサHC-SR04で距離を測るプログラムです．
+トリガーを出してエコーのパルスの幅を測るのは，pico::PulseCapture(picoのPIO)が行います．CPUは結果を取り出して距離に直すだけです．
+HC_SR04は，パルスの幅を測るクラスの型(Capture)のテンプレートになっています．(Exam001と同じく，sc::HC_SR04 hc_sr04(capture)と書けば型は自動で決まります)
+*/
+
+namespace sc
+{
+    //! @brief HC-SR04による測定を行うクラス
+    //! @tparam Capture エコーのパルスの幅を測るクラスの型  pico::PulseCaptureなど
+    template<class Capture = PulseCapture>
+    class HC_SR04 : public Sensor
+    {
+        Capture& _capture;  // エコーのパルスの幅を測るオブジェクト
+        float _sound_speed;  // 音速 (cm/μs)
+    public:
+        explicit HC_SR04(Capture& capture);
+        Measurement measure();  // 測定を行う関数
+        Result<Measurement> try_measure();  // 例外を投げずに測定を行う関数  エコーがなかった場合はエラーを返す
+        void set_temperature(Temperature temperature) noexcept;  // 気温に合わせて音速を補正
+    private:
+        uint32_t read_latest_width_us();  // 最新のパルスの幅を読み取る
+    };
+
+    //! @brief HC_SR04というクラスを構築  音速は20℃のときの値から始める
+    //! @param capture エコーのパルスの幅を測るオブジェクト  トリガーとエコーのピンはこちらで設定します
+    template<class Capture>
+    HC_SR04<Capture>::HC_SR04(Capture& capture):
+        _capture(capture),
+        _sound_speed(0.0f)
+    {
+        set_temperature(Temperature(20.0F));
+    }
+
+    //! @brief 測定を行う
+    //! @return 測定結果
+    template<class Capture>
+    Measurement HC_SR04<Capture>::measure()
+    {
+        return try_measure().value();  // エラーだったら，ここで例外を投げる
+    }
+
+    //! @brief 例外を投げずに測定を行う
+    //! @return 測定結果  エコーがなかった(遠すぎる・センサがない)場合はエラー
+    template<class Capture>
+    Result<Measurement> HC_SR04<Capture>::try_measure()
+    {
+        const uint32_t width_us = read_latest_width_us();
+        if (width_us == PulseCapture::NoEcho)
+    return SC_ERROR_INFO(ErrorCode::no_response, "HC-SR04 did not receive an echo");  // エコーが返ってこなかった
+        const Result<Distance> distance = Distance::create(width_us * _sound_speed / 2.0F);  // 音が往復した時間なので，距離は半分
+        if (!distance)
+    return distance.error();
+
+        return Measurement(distance.value());
+    }
+
+    //! @brief 気温に合わせて音速を補正
+    //! @param temperature 気温
+    template<class Capture>
+    void HC_SR04<Capture>::set_temperature(Temperature temperature) noexcept
+    {
+        const float sound_speed_m_s = 331.5F + 0.61F * temperature.get();  // 音速 (m/s)
+        _sound_speed = sound_speed_m_s * 1e-4F;  // m/s から cm/μs に直す
+    }
+
+    //! @brief FIFOにたまっているパルスの幅のうち最新のものを読み取る  なければ次の測定が終わるまで待つ
+    //! @return パルスの幅 (μs)  エコーがなかったときはPulseCapture::NoEcho
+    template<class Capture>
+    uint32_t HC_SR04<Capture>::read_latest_width_us()
+    {
+        uint32_t width_us = PulseCapture::NoEcho;
+        bool has_width = false;
+        while (_capture.pop(width_us)) has_width = true;  // 古い結果を捨てる
+        if (has_width)
+    return width_us;
+        _capture.wait();  // 測定は繰り返し行われるので，必ず次の結果が来る
+        _capture.pop(width_us);
+        return width_us;
+    }
+}
+
+#endif // SC19_CODE_TEST_HC_SR04_HC_SR04_HPP_
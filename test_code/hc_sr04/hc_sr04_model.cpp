@@ -0,0 +1,23 @@
+#include "sc_pico/sc_host.hpp"
+
+/*
+PC上でHC-SR04を動かすときに，センサの代わりになるモデルです．(picoでのビルドには使いません)
+GPIO15(エコー)に，実機で記録したエコーのパルスの幅を順に返すモデルをつなぎます．
+*/
+
+namespace
+{
+    //! @brief HC-SR04のエコーのモデル
+    class HC_SR04Model
+    {
+        host::EchoDevice _device;  // 記録したエコー
+    public:
+        HC_SR04Model()
+        {
+            _device.set_widths({1164, 1171, 1158, 1166, sc::PulseCapture::NoEcho, 1163});  // 約20cmの壁  途中で1回エコーが返ってこなかった
+            host::PulseCapture::connect(15, _device);
+        }
+    };
+
+    HC_SR04Model hc_sr04_model;  // プログラムの開始時につなぐ
+}
\ No newline at end of file
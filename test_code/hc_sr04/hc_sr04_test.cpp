@@ -0,0 +1,50 @@
+#include "sc_pico/sc_pico.hpp"
+
+#include "hc_sr04.hpp"
+
+namespace
+{
+    //! @brief 障害物までの距離による安全の段階  距離が小さい方から並べる
+    enum class Safety : uint8_t
+    {
+        stop,
+        danger,
+        attention,
+        safe
+    };
+
+    constexpr const char* SafetyNames[] = {"STOP", "DANG", "ATTN", "SAFE"};  // ログに出す段階の名前
+
+    //! 段階の境目 (cm)  {rise, fall}  以前のjudge_dist_safe(test.cpp)と同じ境目で，上がるときは10cm離れるまで待つ
+    //! 停止と危険の境目は以前の処理が逆向き(60未満で停止，50より大きければ危険)だったので，60cmより大きくなるまで停止のままにする
+    constexpr sc::HysteresisClassifier<int16_t, 4>::Thresholds SafetyThresholds = {{{61, 60}, {151, 140}, {211, 200}}};
+}
+
+int main()
+{
+    stdio_init_all();  // pico-SDKを初期化
+    pico::start_log_drain();  // ログの出力はコア1で行い，測定のループを止めないようにする
+
+    pico::PulseCapture echo_capture(14, 15);  // GPIO14からトリガーを出し，GPIO15でエコーを受ける  パルスの幅はPIOが測る
+    sc::HC_SR04 hc_sr04(echo_capture);  // センサHC-SR04をセットアップ
+    sc::MovingAverage<int16_t, 3> distance_average;  // 以前のcalc_distance_average(test.cpp)と同じく，3回分の平均で判定する
+    sc::HysteresisClassifier<int16_t, 4> safety(SafetyThresholds, static_cast<uint8_t>(Safety::safe));  // 境目の近くで段階が行ったり来たりしないように，ヒステリシスを付けて判定する
+
+    while (true)
+    {
+        const sc::Result<sc::Measurement> measured_data = hc_sr04.try_measure();  // 遠すぎてエコーが返ってこないこともあるので，例外を投げずに測定する
+        if (!measured_data)
+        {
+            measured_data.error().log();  // エラーを記録して次の測定へ
+        continue;
+        }
+        sc::Distance measured_distance = measured_data.value().get<sc::Distance>();  // Measurement型の中からDistance型の値を取り出す
+        sc::Log::write("hc_sr04 distance: %f\n", measured_distance.get());  // 距離(cm)を出力する
+        const int16_t average_cm = distance_average.update(static_cast<int16_t>(measured_distance.get()));
+        const auto transition = safety.step(average_cm);  // 以前のjudge_dist_safeと同じく，1回に1段階だけ移る
+        if (transition.is_changed())
+        {
+            sc::Log::write("hc_sr04 safety: %s -> %s\n", SafetyNames[transition.from], SafetyNames[transition.to]);  // 段階が変わったときだけ出力する
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,2225 @@
+/*************************************
+ *************************************
+
+
+このファイルは見なくてかまいません
+内部の実装を知りたい場合のみ見てください
+
+
+*************************************
+*************************************/
+
+#include "sc.hpp"
+
+//! @file sc.cpp
+//! @brief プログラム全体で共通の，基本的な機能
+//! @date 2023-10-27T23:08
+
+
+// Raspberry pi pico での有線通信やセンサ値の処理を簡単にするプログラムです
+namespace sc
+{
+    /**************************************************/
+    /********************ログ・エラー*******************/
+    /**************************************************/
+
+    /***** class Error *****/
+
+    //! @brief エラーを記録し，標準エラー出力に出力します
+    //! @param FILE ＿FILE＿としてください (自動でファイル名に置き換わります)
+    //! @param LINE ＿LINE＿としてください (自動で行番号に置き換わります)
+    //! @param message 出力したいエラーメッセージ (自動で改行)
+    Error::Error(const std::string& FILE, int LINE, const std::string& message) noexcept:
+        _message(message)
+    {
+#ifdef SC_EXCEPTIONS
+        try
+        {
+#endif
+            const std::string output_message = "<<ERROR>>  FILE : " + std::string(FILE) + "  LINE : " + std::to_string(LINE) + "\n           MESSAGE : " + _message + "\n";  // 出力する形式に変形
+            std::cerr << output_message << std::endl;  // cerrでエラーとして出力
+
+            Log::write(output_message);  // エラーをログデータに記録 (外部で定義してください)
+#ifdef SC_EXCEPTIONS
+        }
+        catch (const std::exception& e) {std::cerr << "<<ERROR>>  FILE : " << __FILE__ << "  LINE : " << __LINE__ << "/n           MESSAGE : Error logging failed.   " << e.what() << std::endl;}  // エラー：エラーログの記録に失敗しました
+        catch(...) {std::cerr << "<<ERROR>>  FILE : " << __FILE__ << "  LINE : " << __LINE__ << "/n           MESSAGE : Error logging failed." << std::endl;}  // エラー：エラーログの記録に失敗しました
+#endif
+    }
+
+    //! @brief エラーについての説明文を返します
+    //! @return エラーの説明
+    const char* Error::what() const noexcept
+    {
+        return _message.c_str();
+    }
+
+    //! @brief エラーを記録し，標準エラー出力に出力します
+    //! @param FILE ＿FILE＿としてください (自動でファイル名に置き換わります)
+    //! @param LINE ＿LINE＿としてください (自動で行番号に置き換わります)
+    //! @param message 出力したいエラーメッセージ (自動で改行)
+    //! @param e キャッチした例外
+    Error::Error(const std::string& FILE, int LINE, const std::string& message, const std::exception& e) noexcept:
+        Error(FILE, LINE, message + "   " + e.what()) {}
+
+    /***** struct ErrorInfo *****/
+
+    //! @brief Errorと同じ形式でログに記録します
+    //! 文字列を組み立てるのはこの関数を呼び出したときだけです
+    void ErrorInfo::log() const noexcept
+    {
+        Log::error("<<ERROR>>  FILE : %s  LINE : %u\n           MESSAGE : %s\n", file, static_cast<unsigned>(line), message);
+    }
+
+    //! @brief エラーを投げます
+    //! 例外が無効な場合(-fno-exceptions)は，ログに記録し，出力してから停止します
+    //! @param error_info エラーの種類と発生した場所
+    void raise(const ErrorInfo& error_info)
+    {
+#ifdef SC_EXCEPTIONS
+        throw Error(error_info.file, error_info.line, error_info.message);
+#else
+        error_info.log();
+        Log::set_async(false);
+        Log::flush();  // 停止する前に残りのログを出力する
+        std::abort();
+#endif
+    }
+
+
+    /***** class Log *****/
+
+    namespace
+    {
+        //! @brief 非同期モードで出力を待つログの1レコード
+        struct LogRecord
+        {
+            uint8_t size = 0;  // バイト数
+            char text[SC_LOG_RECORD_SIZE];  // ログの文字列またはバイナリ形式のレコード  (終端文字なし)
+        };
+        static_assert(SC_LOG_RECORD_SIZE <= UINT8_MAX, "\n\n<!ERROR!> SC_LOG_RECORD_SIZE must be 255 or less\n\n");  // SC_LOG_RECORD_SIZEは255以下にしてください
+
+        //! @brief バイナリ形式で使った書式  書式の文字列のアドレスで探し，表の位置を書式のIDとする
+        struct LogFormatEntry
+        {
+            const char* format = nullptr;  // 書式の文字列
+            bool is_defined = false;  // 書式の定義を出力済みか
+        };
+        constexpr std::size_t LogFormatTableSize = 64;  // 使える書式の数 (2のべき乗)
+
+        RingBuffer<LogRecord, SC_LOG_BUFFER_SIZE> log_records;  // 出力を待つログ  (書き込み側はLog::post，読み込み側はLog::flush)
+        std::atomic<bool> is_log_async{false};  // 非同期モードかどうか
+        std::atomic<Log::Format> log_format{Log::Format::text};  // 出力形式
+        std::atomic<std::size_t> dropped_log_count{0};  // バッファが満杯で捨てたログの数  (書き込み側のみが更新)
+        std::size_t reported_dropped_count = 0;  // 捨てたことを出力済みのログの数  (読み込み側のみが更新)
+        LogFormatEntry log_format_table[LogFormatTableSize];  // バイナリ形式で使った書式  (書き込み側のみが使う)
+        uint32_t (*log_lock)() = nullptr;  // 排他を始める関数  (Log::set_lockで設定)
+        void (*log_unlock)(uint32_t) = nullptr;  // 排他を終える関数
+
+        //! @brief 非同期モードのバッファを複数のスレッド(コア)から使うための排他  (Log::set_lockで関数を設定したときのみ)
+        class LogLockGuard
+        {
+            bool _is_locked;  // 排他しているか
+            uint32_t _saved_state = 0;  // lockが返した元の状態  (picoでは割り込みの許可)
+        public:
+            //! @param is_needed falseなら排他しない  (同期モードで出力を待つ間に，他のコアや割り込みを止めないため)
+            explicit LogLockGuard(bool is_needed) noexcept:
+                _is_locked(is_needed && log_lock && log_unlock)
+            {
+                if (_is_locked) _saved_state = log_lock();
+            }
+            ~LogLockGuard() {if (_is_locked) log_unlock(_saved_state);}
+            LogLockGuard(const LogLockGuard&) = delete;
+            LogLockGuard& operator=(const LogLockGuard&) = delete;
+        };
+
+        //! @brief バッファから1レコードを取り出す
+        //! -fno-exceptionsのraise()では，コア1が出力している途中でコア0も読み込むため，取り出す間は排他する
+        //! @param record 取り出したレコード
+        //! @return 取り出せたらtrue
+        bool pop_log_record(LogRecord& record) noexcept
+        {
+            const LogLockGuard guard(true);
+            return log_records.pop(record);
+        }
+
+        //! @brief バイナリ形式のレコードの先頭2バイトを書き込む
+        void set_record_header(uint8_t* record, Log::RecordType record_type, std::size_t size) noexcept
+        {
+            record[0] = static_cast<uint8_t>(record_type);
+            record[1] = static_cast<uint8_t>(size - 2);
+        }
+
+        //! @brief 書式の表の位置を探す
+        //! @param format 書式の文字列
+        //! @return 表の位置  表が満杯で見つからなければLogFormatTableSize
+        std::size_t find_log_format(const char* format) noexcept
+        {
+            const std::size_t hash = reinterpret_cast<uintptr_t>(format) >> 2;  // 文字列のアドレスは実行中に変わらないので，IDの代わりに使える
+            for (std::size_t i = 0; i < LogFormatTableSize; ++i)
+            {
+                const std::size_t index = (hash + i) & (LogFormatTableSize - 1);
+                if (log_format_table[index].format == format || log_format_table[index].format == nullptr)
+    return index;
+            }
+            return LogFormatTableSize;
+        }
+    }
+
+    //! @brief 文字列をそのままログに記録します
+    //! @param log 書き込む文字列
+    void Log::write(const std::string& log) noexcept
+    {
+        post(log.data(), log.size());
+    }
+
+    //! @brief 出力形式を切り替えます  (書き込み側のみ呼び出せます)
+    //! バイナリ形式にするたびに，書式の定義を出力し直します
+    //! @param format 出力形式
+    void Log::set_format(Format format) noexcept
+    {
+        const LogLockGuard guard(is_async());
+        if (format == Format::binary)
+        {
+            for (LogFormatEntry& entry : log_format_table) entry.is_defined = false;
+        }
+        log_format.store(format, std::memory_order_release);
+    }
+
+    //! @brief 出力形式を取得
+    //! @return 出力形式
+    Log::Format Log::get_format() noexcept
+    {
+        return log_format.load(std::memory_order_acquire);
+    }
+
+    //! @brief 非同期モードを切り替えます
+    //! 非同期モードでは，ログはバッファに入れられ，flush()を呼んだときに出力されます
+    //! @param is_async 非同期モードにするならtrue
+    void Log::set_async(bool is_async) noexcept
+    {
+        is_log_async.store(is_async, std::memory_order_release);
+    }
+
+    //! @brief 非同期モードかどうかを取得
+    //! @return 非同期モードならtrue
+    bool Log::is_async() noexcept
+    {
+        return is_log_async.load(std::memory_order_acquire);
+    }
+
+    //! @brief バッファに溜まっているログを全て出力します  (読み込み側のみ呼び出せます  set_lock()の排他があればraise()からも呼び出せます)
+    //! バッファが満杯で捨てたログがあれば，その数も出力します
+    //! @return 出力したレコード数
+    std::size_t Log::flush() noexcept
+    {
+        std::size_t flushed_count = 0;
+        LogRecord record;
+        while (pop_log_record(record))
+        {
+            output(record.text, record.size);
+            ++flushed_count;
+        }
+        std::size_t new_dropped_count = 0;  // 前回の出力から捨てたログの数
+        {
+            const LogLockGuard guard(true);
+            new_dropped_count = get_dropped_count() - reported_dropped_count;
+            reported_dropped_count += new_dropped_count;
+        }
+        if (new_dropped_count)
+        {
+            char message[48];
+            const int message_size = std::snprintf(message + 2, sizeof(message) - 2, "<<LOG>> %u logs were dropped\n", static_cast<unsigned>(new_dropped_count));
+            const std::size_t size = std::min<std::size_t>(message_size, sizeof(message) - 3) + 2;
+            if (get_format() == Format::binary)
+            {
+                set_record_header(reinterpret_cast<uint8_t*>(message), RecordType::text, size);
+                output(message, size);
+            }
+            else
+            {
+                output(message + 2, size - 2);
+            }
+        }
+        return flushed_count;
+    }
+
+    //! @brief バッファが満杯で捨てたログの数を取得
+    //! @return 捨てたログの数の累計
+    std::size_t Log::get_dropped_count() noexcept
+    {
+        return dropped_log_count.load(std::memory_order_relaxed);
+    }
+
+    //! @brief 複数のスレッド(コア)から書き込むための排他の関数を設定します  (非同期モードにする前に呼び出してください)
+    //! 非同期モードの間は，書き込み側の処理とflush()がバッファから取り出す処理をこの関数で挟みます
+    //! @param lock 排他を始めて，元の状態(picoでは割り込みの許可)を返す関数
+    //! @param unlock lockが返した状態を受け取り，排他を終える関数
+    void Log::set_lock(uint32_t (*lock)(), void (*unlock)(uint32_t)) noexcept
+    {
+        log_lock = lock;
+        log_unlock = unlock;
+    }
+
+    //! @brief 文字列をログに記録します
+    //! バイナリ形式では，文字列のレコードに入れて記録します
+    //! @param log 書き込む文字列
+    //! @param size 文字数
+    void Log::post(const char* log, std::size_t size) noexcept
+    {
+        const LogLockGuard guard(is_async());  // 長い文字列を分けたレコードの間に，他のコアのログが入らないようにする
+        if (get_format() == Format::text)
+        {
+            enqueue(log, size);
+    return;
+        }
+        uint8_t record[2 + UINT8_MAX];
+        for (std::size_t offset = 0; offset < size; offset += UINT8_MAX)
+        {
+            const std::size_t record_size = std::min<std::size_t>(size - offset, UINT8_MAX) + 2;  // 長い文字列は複数のレコードに分ける
+            set_record_header(record, RecordType::text, record_size);
+            std::memcpy(record + 2, log + offset, record_size - 2);
+            enqueue(record, record_size);
+        }
+    }
+
+    //! @brief バイナリ形式で書式を使ったログを記録します
+    //! 初めて使う書式であれば，先に書式の定義を記録します
+    //! @param format 書式の文字列
+    //! @param record 書き込むレコード  先頭3バイト(種類・バイト数・書式のID)はこの関数で書き込みます
+    //! @param size レコードのバイト数
+    //! @return 記録できればtrue  書式の表が満杯のときや書式が長すぎるときはfalse
+    bool Log::post_event(const char* format, uint8_t* record, std::size_t size) noexcept
+    {
+        const LogLockGuard guard(is_async());  // 書式の表も書き込み側で共有する
+        const std::size_t format_id = find_log_format(format);
+        if (format_id == LogFormatTableSize)
+    return false;
+        LogFormatEntry& entry = log_format_table[format_id];
+        if (!entry.is_defined)
+        {
+            const std::size_t format_size = std::strlen(format);
+            if (format_size + 1 > UINT8_MAX)
+    return false;
+            uint8_t definition[2 + UINT8_MAX];
+            set_record_header(definition, RecordType::format, format_size + 3);
+            definition[2] = static_cast<uint8_t>(format_id);
+            std::memcpy(definition + 3, format, format_size);
+            entry.format = format;
+            entry.is_defined = enqueue(definition, format_size + 3);  // 捨てられた場合は次回に定義し直す
+            if (!entry.is_defined)
+    return true;  // 書式の定義がないと読めないので，ログも捨てる (捨てた数はenqueueで数え済み)
+        }
+        set_record_header(record, RecordType::event, size);
+        record[2] = static_cast<uint8_t>(format_id);
+        enqueue(record, size);
+        return true;
+    }
+
+    //! @brief バイト列を出力するか，非同期モードではバッファに入れます
+    //! バッファに全体が入らない場合は，途中で切れないように全体を捨てます
+    //! @param data 書き込むバイト列
+    //! @param size バイト数
+    //! @return 出力したかバッファに入れたらtrue  捨てたらfalse
+    bool Log::enqueue(const void* data, std::size_t size) noexcept
+    {
+        if (!is_async())
+        {
+            output(static_cast<const char*>(data), size);
+    return true;
+        }
+        const std::size_t record_num = (size + SC_LOG_RECORD_SIZE - 1) / SC_LOG_RECORD_SIZE;
+        if (SC_LOG_BUFFER_SIZE - log_records.size() < record_num)  // 空きは読み込み側によって増えるだけなので，ここで足りていれば全て入る
+        {
+            dropped_log_count.store(dropped_log_count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);  // 書き込み側しか更新せず，複数のときは排他されているため，アトミックな加算は不要
+    return false;
+        }
+        LogRecord record;
+        for (std::size_t offset = 0; offset < size; offset += record.size)
+        {
+            record.size = std::min<std::size_t>(size - offset, SC_LOG_RECORD_SIZE);  // 長いログは複数のレコードに分ける
+            std::memcpy(record.text, static_cast<const char*>(data) + offset, record.size);
+            log_records.push(record);
+        }
+        return true;
+    }
+
+
+
+
+    /**************************************************/
+    /*****************測定値および変換******************/
+    /**************************************************/
+
+    /***** class Binary *****/
+
+    //! @brief データの保存場所を確保
+    //! @param size 確保するバイト数
+    //! @return 書き込み先の先頭
+    uint8_t* Binary::allocate(std::size_t size)
+    {
+        _size = size;
+        if (size <= InlineCapacity)
+        {
+            _storage = Storage::inline_data;
+            _data = _inline_data;
+            return _inline_data;
+        }
+        _storage = Storage::heap_data;
+        _heap_data.reset(new uint8_t[size]);
+        _data = _heap_data.get();
+        return _heap_data.get();
+    }
+
+    //! @brief バイト列を作成
+    //! @param size 配列のサイズ
+    //! @param binary_data 配列  (コピーされます)
+    Binary::Binary(std::size_t size, const uint8_t* binary_data):
+        Binary()
+    {
+        uint8_t* destination = allocate(size);
+        if (size)
+        {
+            std::memcpy(destination, binary_data, size);
+        }
+    }
+
+    //! @brief バイト列を作成
+    //! @param binary_data deque型の値
+    Binary::Binary(const std::deque<uint8_t>& binary_data):
+        Binary()
+    {
+        std::copy(binary_data.begin(), binary_data.end(), allocate(binary_data.size()));
+    }
+
+    //! @brief 0で埋められたバイト列を作成
+    //! @param size バイト数
+    Binary::Binary(std::size_t size):
+        Binary()
+    {
+        std::memset(allocate(size), 0, size);
+    }
+
+    //! @brief 呼び出し元の配列をコピーせずに参照するバイト列を作成
+    //! @param binary_view 参照する配列  Binaryより長く生存している必要があります
+    //! @return 配列を参照するバイト列
+    Binary Binary::view_of(Span<const uint8_t> binary_view) noexcept
+    {
+        Binary binary;
+        binary._size = binary_view.size();
+        binary._data = binary_view.data();
+        return binary;
+    }
+
+    Binary::Binary(Binary&& old_binary) noexcept:
+        _storage(old_binary._storage),
+        _size(old_binary._size),
+        _data(old_binary._data),
+        _heap_data(std::move(old_binary._heap_data))
+    {
+        if (_storage == Storage::inline_data)
+        {
+            std::memcpy(_inline_data, old_binary._inline_data, _size);
+            _data = _inline_data;
+        }
+        old_binary._storage = Storage::view;
+        old_binary._size = 0;
+        old_binary._data = nullptr;
+    }
+
+    Binary& Binary::operator=(Binary&& old_binary) noexcept
+    {
+        if (this == &old_binary)
+    return *this;
+
+        _storage = old_binary._storage;
+        _size = old_binary._size;
+        _data = old_binary._data;
+        _heap_data = std::move(old_binary._heap_data);
+        if (_storage == Storage::inline_data)
+        {
+            std::memcpy(_inline_data, old_binary._inline_data, _size);
+            _data = _inline_data;
+        }
+        old_binary._storage = Storage::view;
+        old_binary._size = 0;
+        old_binary._data = nullptr;
+        return *this;
+    }
+
+    //! @brief バイト列のサイズを計算
+    //! @return バイト列のサイズ
+    std::size_t Binary::size() const noexcept
+    {
+        return _size;
+    }
+
+    //! @brief バイト列のindex番目の要素を取得
+    //! @param index 先頭の要素よりいくつ後の要素か
+    //! @return バイト列のindex番目の要素
+    const uint8_t Binary::at(std::size_t index) const
+    {
+        if (_size <= index)
+        {
+#ifdef SC_EXCEPTIONS
+            throw std::out_of_range("sc::Binary::at");
+#else
+            raise(SC_ERROR_INFO(ErrorCode::invalid_argument, "sc::Binary::at"));
+#endif
+        }
+        return _data[index];
+    }
+
+    //! @brief バイト列のindex番目の要素を取得
+    //! @param index 先頭の要素よりいくつ後の要素か
+    //! @return バイト列のindex番目の要素
+    const uint8_t Binary::operator[](std::size_t index) const
+    {
+        return at(index);
+    }
+
+    //! @brief バイト列の先頭を取得
+    //! @return バイト列の先頭のポインタ  コピーはされません
+    const uint8_t* Binary::data() const noexcept
+    {
+        return _data;
+    }
+
+    //! @brief 書き込み用にバイト列の先頭を取得
+    //! @return バイト列の先頭のポインタ
+    //! view_of で作成したバイト列には書き込めません
+    uint8_t* Binary::writable_data()
+    {
+        switch (_storage)
+        {
+            case Storage::inline_data:
+    return _inline_data;
+            case Storage::heap_data:
+    return _heap_data.get();
+            default:
+                raise(SC_ERROR_INFO(ErrorCode::read_only, "Binary created by view_of is read-only."));  // view_ofで作成したバイト列は書き込みできません
+        }
+    }
+
+    //! @brief バイト列をコピーせずに参照
+    //! @return バイト列を参照するSpan
+    Span<const uint8_t> Binary::get_view() const noexcept
+    {
+        return Span<const uint8_t>(_data, _size);
+    }
+
+    //! @brief 呼び出し元の配列を参照しているかを取得
+    //! @return view_of で作成した場合true
+    bool Binary::is_view() const noexcept
+    {
+        return _storage == Storage::view;
+    }
+
+    //! @brief 実際に保存されているバイト列をvector型にコピーして取得
+    //! @return vector形式のコピーされたバイト列
+    //! ヒープを使用するため，送信などではdata()やget_view()を使ってください
+    std::vector<uint8_t> Binary::get_raw() const
+    {
+        return std::vector<uint8_t>(_data, _data + _size);
+    }
+
+    /***** class Temperature *****/
+
+    //! @brief 気温の値をセットアップ
+    //! @param temperature 気温 (℃)  0.01℃単位に丸めて保存します
+    Temperature::Temperature(float temperature):
+        _centi_temperature(static_cast<int32_t>(std::lround(temperature * 100.0F)))
+    {
+        if (!is_valid(temperature))
+        {
+            raise(SC_ERROR_INFO(ErrorCode::invalid_argument, "Invalid temperature value entered."));  // 無効な温度の値が入力されました
+        }
+    }
+
+    //! @brief 0.01℃単位の値から気温をセットアップ  (範囲は確認済み)
+    Temperature::Temperature(Centi centi_temperature) noexcept:
+        _centi_temperature(centi_temperature.value) {}
+
+    //! @brief 気温を確認してセットアップ  (例外を投げません)
+    //! @param temperature 気温
+    //! @return 範囲外のときはエラー
+    Result<Temperature> Temperature::create(float temperature) noexcept
+    {
+        if (!is_valid(temperature))
+    return SC_ERROR_INFO(ErrorCode::invalid_argument, "Invalid temperature value entered.");  // 無効な温度の値が入力されました
+        return Temperature(Centi{static_cast<int32_t>(std::lround(temperature * 100.0F))});
+    }
+
+    //! @brief 0.01℃単位の値から気温をセットアップ
+    //! @param centi_temperature 気温 (0.01℃)
+    Temperature Temperature::from_centi(int32_t centi_temperature)
+    {
+        return create_centi(centi_temperature).value();  // 範囲外なら，ここで例外を投げる
+    }
+
+    //! @brief 0.01℃単位の値から気温を確認してセットアップ  (例外を投げません)
+    //! 浮動小数点数の計算を行いません
+    //! @param centi_temperature 気温 (0.01℃)
+    //! @return 範囲外のときはエラー
+    Result<Temperature> Temperature::create_centi(int32_t centi_temperature) noexcept
+    {
+        if (!is_valid_centi(centi_temperature))
+    return SC_ERROR_INFO(ErrorCode::invalid_argument, "Invalid temperature value entered.");  // 無効な温度の値が入力されました
+        return Temperature(Centi{centi_temperature});
+    }
+
+    //! @brief 気温が範囲内かを確認
+    //! @param temperature 気温
+    //! @return 範囲内ならtrue
+    bool Temperature::is_valid(float temperature) noexcept
+    {
+        static constexpr float MinTemperature = -10.0F;  // 気温の最小値
+        static constexpr float MaxTemperature = 45.0F;  // 気温の最大値
+
+        return MinTemperature <= temperature && temperature <= MaxTemperature;  // NaNも範囲外にする  (整数に直せないため)
+    }
+
+    //! @brief 0.01℃単位の気温が範囲内かを確認
+    //! @param centi_temperature 気温 (0.01℃)
+    //! @return 範囲内ならtrue
+    bool Temperature::is_valid_centi(int32_t centi_temperature) noexcept
+    {
+        static constexpr int32_t MinCentiTemperature = -1000;  // 気温の最小値 (0.01℃)
+        static constexpr int32_t MaxCentiTemperature = 4500;  // 気温の最大値 (0.01℃)
+
+        return MinCentiTemperature <= centi_temperature && centi_temperature <= MaxCentiTemperature;
+    }
+
+    //! @brief 気温を取得
+    //! @return 気温 (℃)
+    float Temperature::get() const noexcept
+    {
+        return static_cast<float>(_centi_temperature) / 100.0F;
+    }
+
+    //! @brief 気温を0.01℃単位で取得  (浮動小数点数の計算を行いません)
+    //! @return 気温 (0.01℃)
+    int32_t Temperature::get_centi() const noexcept
+    {
+        return _centi_temperature;
+    }
+
+    /***** class Pressure *****/
+
+    //! @brief 気圧の値をセットアップ
+    Pressure::Pressure(float pressure):
+        _pressure(pressure)
+    {
+        if (!is_valid(_pressure))
+        {
+            raise(SC_ERROR_INFO(ErrorCode::invalid_argument, "Invalid pressure value entered."));  // 無効な気圧の値が入力されました
+        }
+    }
+
+    //! @brief 気圧を確認してセットアップ  (例外を投げません)
+    //! @param pressure 気圧
+    //! @return 範囲外のときはエラー
+    Result<Pressure> Pressure::create(float pressure) noexcept
+    {
+        if (!is_valid(pressure))
+    return SC_ERROR_INFO(ErrorCode::invalid_argument, "Invalid pressure value entered.");  // 無効な気圧の値が入力されました
+        return Pressure(pressure);
+    }
+
+    //! @brief 気圧が範囲内かを確認
+    //! @param pressure 気圧
+    //! @return 範囲内ならtrue
+    bool Pressure::is_valid(float pressure) noexcept
+    {
+        static constexpr float MinPressure = 970.0F;  // 気圧の最小値
+        static constexpr float MaxPressure = 1030.0F;  // 気圧の最大値
+
+        return !(pressure < MinPressure || MaxPressure < pressure);
+    }
+
+    //! @brief 気圧を取得
+    //! @return 気圧
+    float Pressure::get() const noexcept
+    {
+        return static_cast<float>(_pressure);
+    }
+
+    /***** class Humidity *****/
+
+    //! @brief 湿度をセットアップ
+    Humidity::Humidity(float humidity):
+        _humidity(humidity)
+    {
+        if (!is_valid(_humidity))
+        {
+            raise(SC_ERROR_INFO(ErrorCode::invalid_argument, "Invalid humidity value entered."));  // 無効な湿度の値が入力されました
+        }
+    }
+
+    //! @brief 湿度を確認してセットアップ  (例外を投げません)
+    //! @param humidity 湿度
+    //! @return 範囲外のときはエラー
+    Result<Humidity> Humidity::create(float humidity) noexcept
+    {
+        if (!is_valid(humidity))
+    return SC_ERROR_INFO(ErrorCode::invalid_argument, "Invalid humidity value entered.");  // 無効な湿度の値が入力されました
+        return Humidity(humidity);
+    }
+
+    //! @brief 湿度が範囲内かを確認
+    //! @param humidity 湿度
+    //! @return 範囲内ならtrue
+    bool Humidity::is_valid(float humidity) noexcept
+    {
+        static constexpr float MinHumidity = 0.0F;  // 湿度の最小値
+        static constexpr float MaxHumidity = 100.0F;  // 湿度の最大値
+
+        return !(humidity < MinHumidity || MaxHumidity < humidity);
+    }
+
+    //! @brief 湿度を取得
+    //! @return 湿度
+    float Humidity::get() const noexcept
+    {
+        return static_cast<float>(_humidity);
+    }
+    
+    /***** class Distance *****/
+
+    //! @brief 距離をセットアップ
+    Distance::Distance(float distance):
+        _distance(distance)
+    {
+        if (!is_valid(_distance))
+        {
+            raise(SC_ERROR_INFO(ErrorCode::invalid_argument, "Invalid distance value entered."));  // 無効な距離の値が入力されました
+        }
+    }
+
+    //! @brief 距離を確認してセットアップ  (例外を投げません)
+    //! @param distance 距離
+    //! @return 範囲外のときはエラー
+    Result<Distance> Distance::create(float distance) noexcept
+    {
+        if (!is_valid(distance))
+    return SC_ERROR_INFO(ErrorCode::invalid_argument, "Invalid distance value entered.");  // 無効な距離の値が入力されました
+        return Distance(distance);
+    }
+
+    //! @brief 距離が範囲内かを確認
+    //! @param distance 距離
+    //! @return 範囲内ならtrue
+    bool Distance::is_valid(float distance) noexcept
+    {
+        static constexpr float MinDistance = 0.0F;  // 距離の最小値
+        static constexpr float MaxDistance = 100000.0F;  // 距離の最大値  (1km)
+
+        return !(distance < MinDistance || MaxDistance < distance);
+    }
+
+    //! @brief 距離を取得
+    //! @return 距離
+    float Distance::get() const noexcept
+    {
+        return static_cast<float>(_distance);
+    }
+
+    /***** class Position *****/
+
+    //! @brief 位置をセットアップ  (範囲は確認済み)
+    Position::Position(int32_t latitude_e7, int32_t longitude_e7, int32_t altitude_mm) noexcept:
+        _latitude_e7(latitude_e7),
+        _longitude_e7(longitude_e7),
+        _altitude_mm(altitude_mm) {}
+
+    //! @brief 1e-7度単位の緯度・経度とmm単位の高度から位置をセットアップ
+    //! @param latitude_e7 緯度 (1e-7度)  北が正
+    //! @param longitude_e7 経度 (1e-7度)  東が正
+    //! @param altitude_mm 高度 (mm)
+    Position Position::from_e7(int32_t latitude_e7, int32_t longitude_e7, int32_t altitude_mm)
+    {
+        return create_e7(latitude_e7, longitude_e7, altitude_mm).value();  // 範囲外なら，ここで例外を投げる
+    }
+
+    //! @brief 位置を確認してセットアップ  (例外を投げません)
+    //! @param latitude_e7 緯度 (1e-7度)  北が正
+    //! @param longitude_e7 経度 (1e-7度)  東が正
+    //! @param altitude_mm 高度 (mm)
+    //! @return 範囲外のときはエラー
+    Result<Position> Position::create_e7(int32_t latitude_e7, int32_t longitude_e7, int32_t altitude_mm) noexcept
+    {
+        if (!is_valid_e7(latitude_e7, longitude_e7, altitude_mm))
+    return SC_ERROR_INFO(ErrorCode::invalid_argument, "Invalid position value entered.");  // 無効な位置の値が入力されました
+        return Position(latitude_e7, longitude_e7, altitude_mm);
+    }
+
+    //! @brief 位置が範囲内かを確認
+    //! @return 範囲内ならtrue
+    bool Position::is_valid_e7(int32_t latitude_e7, int32_t longitude_e7, int32_t altitude_mm) noexcept
+    {
+        static constexpr int32_t MaxLatitude = 900000000;  // 緯度の絶対値の最大値 (1e-7度)
+        static constexpr int32_t MaxLongitude = 1800000000;  // 経度の絶対値の最大値 (1e-7度)
+        static constexpr int32_t MinAltitude = -1000 * 1000;  // 高度の最小値 (mm)
+        static constexpr int32_t MaxAltitude = 100000 * 1000;  // 高度の最大値 (mm)  (100km)
+
+        return -MaxLatitude <= latitude_e7 && latitude_e7 <= MaxLatitude
+            && -MaxLongitude <= longitude_e7 && longitude_e7 <= MaxLongitude
+            && MinAltitude <= altitude_mm && altitude_mm <= MaxAltitude;
+    }
+
+    //! @brief 緯度を取得
+    //! @return 緯度 (度)  北が正
+    double Position::get_latitude() const noexcept
+    {
+        return _latitude_e7 / 1e7;
+    }
+
+    //! @brief 経度を取得
+    //! @return 経度 (度)  東が正
+    double Position::get_longitude() const noexcept
+    {
+        return _longitude_e7 / 1e7;
+    }
+
+    //! @brief 高度を取得
+    //! @return 高度 (m)
+    float Position::get_altitude() const noexcept
+    {
+        return static_cast<float>(_altitude_mm) / 1000.0F;
+    }
+
+    int32_t Position::get_latitude_e7() const noexcept {return _latitude_e7;}
+
+    int32_t Position::get_longitude_e7() const noexcept {return _longitude_e7;}
+
+    int32_t Position::get_altitude_mm() const noexcept {return _altitude_mm;}
+
+    /***** class Time *****/
+
+    //! @brief 時刻をセットアップ  (範囲は確認済み)
+    Time::Time(uint32_t millisecond_of_day, uint16_t year, uint8_t month, uint8_t day) noexcept:
+        _millisecond_of_day(millisecond_of_day),
+        _year(year),
+        _month(month),
+        _day(day) {}
+
+    //! @brief 0時からの時間と日付から時刻をセットアップ
+    //! @param millisecond_of_day 0時からの時間 (ms)
+    //! @param year 年  日付がないときは0
+    //! @param month 月
+    //! @param day 日
+    Time Time::from_millisecond(uint32_t millisecond_of_day, uint16_t year, uint8_t month, uint8_t day)
+    {
+        return create(millisecond_of_day, year, month, day).value();  // 範囲外なら，ここで例外を投げる
+    }
+
+    //! @brief 時刻を確認してセットアップ  (例外を投げません)
+    //! @param millisecond_of_day 0時からの時間 (ms)
+    //! @param year 年  日付がないときは0
+    //! @param month 月
+    //! @param day 日
+    //! @return 範囲外のときはエラー
+    Result<Time> Time::create(uint32_t millisecond_of_day, uint16_t year, uint8_t month, uint8_t day) noexcept
+    {
+        if (!is_valid(millisecond_of_day, year, month, day))
+    return SC_ERROR_INFO(ErrorCode::invalid_argument, "Invalid time value entered.");  // 無効な時刻の値が入力されました
+        return Time(millisecond_of_day, year, month, day);
+    }
+
+    //! @brief 時刻が範囲内かを確認  日付がないときは月と日も0にする
+    //! @return 範囲内ならtrue
+    bool Time::is_valid(uint32_t millisecond_of_day, uint16_t year, uint8_t month, uint8_t day) noexcept
+    {
+        static constexpr uint32_t MillisecondPerDay = 24 * 60 * 60 * 1000 + 1000;  // 1日の長さ (ms)  うるう秒の分を含む
+
+        if (MillisecondPerDay <= millisecond_of_day)
+    return false;
+        if (year == 0)
+    return month == 0 && day == 0;
+        return 1 <= month && month <= 12 && 1 <= day && day <= 31;
+    }
+
+    uint32_t Time::get_millisecond_of_day() const noexcept {return _millisecond_of_day;}
+
+    uint8_t Time::get_hour() const noexcept {return static_cast<uint8_t>(std::min<uint32_t>(_millisecond_of_day / 3600000, 23));}
+
+    uint8_t Time::get_minute() const noexcept {return static_cast<uint8_t>(std::min<uint32_t>(_millisecond_of_day / 60000 - get_hour() * 60, 59));}
+
+    //! @brief 秒を取得  うるう秒のときは60
+    uint8_t Time::get_second() const noexcept {return static_cast<uint8_t>(_millisecond_of_day / 1000 - (get_hour() * 60 + get_minute()) * 60);}
+
+    uint16_t Time::get_millisecond() const noexcept {return static_cast<uint16_t>(_millisecond_of_day % 1000);}
+
+    //! @brief 日付を受信しているかを確認
+    bool Time::has_date() const noexcept {return _year != 0;}
+
+    uint16_t Time::get_year() const noexcept {return _year;}
+
+    uint8_t Time::get_month() const noexcept {return _month;}
+
+    uint8_t Time::get_day() const noexcept {return _day;}
+
+    /***** class DOP *****/
+
+    //! @brief DOPをセットアップ  (範囲は確認済み)
+    DOP::DOP(uint16_t centi_pdop, uint16_t centi_hdop, uint16_t centi_vdop) noexcept:
+        _centi_pdop(centi_pdop),
+        _centi_hdop(centi_hdop),
+        _centi_vdop(centi_vdop) {}
+
+    //! @brief 0.01単位の値からDOPをセットアップ
+    //! @param centi_pdop 位置精度低下率 (0.01)  受信していないときはUnknown
+    //! @param centi_hdop 水平精度低下率 (0.01)  受信していないときはUnknown
+    //! @param centi_vdop 垂直精度低下率 (0.01)  受信していないときはUnknown
+    DOP DOP::from_centi(uint16_t centi_pdop, uint16_t centi_hdop, uint16_t centi_vdop)
+    {
+        return create_centi(centi_pdop, centi_hdop, centi_vdop).value();  // 範囲外なら，ここで例外を投げる
+    }
+
+    //! @brief 0.01単位の値からDOPを確認してセットアップ  (例外を投げません)
+    //! @return 範囲外のときはエラー
+    Result<DOP> DOP::create_centi(uint16_t centi_pdop, uint16_t centi_hdop, uint16_t centi_vdop) noexcept
+    {
+        if (!is_valid_centi(centi_pdop) || !is_valid_centi(centi_hdop) || !is_valid_centi(centi_vdop))
+    return SC_ERROR_INFO(ErrorCode::invalid_argument, "Invalid DOP value entered.");  // 無効なDOPの値が入力されました
+        return DOP(centi_pdop, centi_hdop, centi_vdop);
+    }
+
+    //! @brief DOPが範囲内かを確認
+    //! @param centi_dop DOP (0.01)
+    //! @return 範囲内かUnknownならtrue
+    bool DOP::is_valid_centi(uint16_t centi_dop) noexcept
+    {
+        static constexpr uint16_t MaxCentiDOP = 9999;  // DOPの最大値 (0.01)  NMEAで表せる最大の99.99
+
+        return centi_dop <= MaxCentiDOP || centi_dop == Unknown;
+    }
+
+    //! @brief 0.01単位のDOPを小数に直す  受信していないときはNaN
+    float DOP::to_float(uint16_t centi_dop) noexcept
+    {
+        return (centi_dop == Unknown ? NAN : static_cast<float>(centi_dop) / 100.0F);
+    }
+
+    float DOP::get_pdop() const noexcept {return to_float(_centi_pdop);}
+
+    float DOP::get_hdop() const noexcept {return to_float(_centi_hdop);}
+
+    float DOP::get_vdop() const noexcept {return to_float(_centi_vdop);}
+
+    uint16_t DOP::get_centi_pdop() const noexcept {return _centi_pdop;}
+
+    uint16_t DOP::get_centi_hdop() const noexcept {return _centi_hdop;}
+
+    uint16_t DOP::get_centi_vdop() const noexcept {return _centi_vdop;}
+
+    /**************************************************/
+    /***********************通信***********************/
+    /**************************************************/
+
+    /***** class I2C::SlaveAddr *****/
+
+    //! @brief 通信先のスレーブアドレスをセットアップ
+    //! @param device_select_id 通信先のデバイスのスレーブアドレス
+    I2C::SlaveAddr::SlaveAddr(uint8_t slave_addr):
+        _slave_addr(slave_addr)
+    {
+        if (!is_valid(_slave_addr))
+        {
+            raise(SC_ERROR_INFO(ErrorCode::invalid_argument, "Invalid slave address entered."));  // 無効なスレーブアドレスの値が入力されました
+        }
+    }
+
+    //! @brief スレーブアドレスを確認してセットアップ  (例外を投げません)
+    //! @param slave_addr スレーブアドレス
+    //! @return 範囲外のときはエラー
+    Result<I2C::SlaveAddr> I2C::SlaveAddr::create(uint8_t slave_addr) noexcept
+    {
+        if (!is_valid(slave_addr))
+    return SC_ERROR_INFO(ErrorCode::invalid_argument, "Invalid slave address entered.");  // 無効なスレーブアドレスの値が入力されました
+        return SlaveAddr(slave_addr);
+    }
+
+    //! @brief スレーブアドレスが範囲内かを確認
+    //! @param slave_addr スレーブアドレス
+    //! @return 範囲内ならtrue
+    bool I2C::SlaveAddr::is_valid(uint8_t slave_addr) noexcept
+    {
+        static constexpr uint8_t MinSlaveAddr = 0x00;  // スレーブアドレスの最小値
+        static constexpr uint8_t MaxSlaveAddr = 0xef;  // スレーブアドレスの最大値
+
+        return !(slave_addr < MinSlaveAddr || MaxSlaveAddr < slave_addr);
+    }
+
+    //! @brief スレーブアドレスを取得
+    //! @return スレーブアドレス
+    uint8_t I2C::SlaveAddr::get() const noexcept
+    {
+        return _slave_addr;
+    }
+
+    /***** class I2C::MemoryAddr *****/
+
+    //! @brief I2Cスレーブ内のメモリーアドレスをセットアップ
+    I2C::MemoryAddr::MemoryAddr(uint8_t memory_addr):
+        _memory_addr(memory_addr)
+    {
+        static constexpr uint8_t MinMemoryAddr = 0x00;  // メモリーアドレスの最大値
+        static constexpr uint8_t MaxMemoryAddr = 0xff;  // メモリーアドレスの最小値
+        
+        if (_memory_addr < MinMemoryAddr || MaxMemoryAddr < _memory_addr)
+        {
+            raise(SC_ERROR_INFO(ErrorCode::invalid_argument, "Invalid memory_addr value entered."));  // 無効なメモリーアドレスの値が入力されました
+        }
+    }
+    
+    //! @brief I2Cスレーブ内のメモリーアドレスを取得
+    //! @return メモリーアドレス
+    uint8_t I2C::MemoryAddr::get() const noexcept
+    {
+        return _memory_addr;
+    }
+
+    /***** class I2C::Segment *****/
+
+    //! @brief 通信の区間をセットアップ
+    I2C::Segment::Segment(SlaveAddr slave_addr, int16_t memory_addr, bool is_read, Span<const uint8_t> output_data, std::size_t size) noexcept:
+        _slave_addr(slave_addr.get()),
+        _memory_addr(memory_addr),
+        _is_read(is_read),
+        _output_data(output_data),
+        _size(size) {}
+
+    //! @brief 受信する区間
+    //! @param size 受信するバイト数
+    //! @param slave_addr 通信先のデバイスのスレーブアドレス
+    I2C::Segment I2C::Segment::read(std::size_t size, SlaveAddr slave_addr) noexcept
+    {
+        return Segment(slave_addr, -1, true, Span<const uint8_t>(), size);
+    }
+
+    //! @brief メモリから受信する区間
+    //! @param size 受信するバイト数
+    //! @param slave_addr 通信先のデバイスのスレーブアドレス
+    //! @param memory_addr 通信先のデバイス内のメモリアドレス
+    I2C::Segment I2C::Segment::read_mem(std::size_t size, SlaveAddr slave_addr, MemoryAddr memory_addr) noexcept
+    {
+        return Segment(slave_addr, memory_addr.get(), true, Span<const uint8_t>(), size);
+    }
+
+    //! @brief 送信する区間
+    //! @param output_data 送信するデータ  通信が終わるまで保持してください
+    //! @param slave_addr 通信先のデバイスのスレーブアドレス
+    I2C::Segment I2C::Segment::write(Span<const uint8_t> output_data, SlaveAddr slave_addr) noexcept
+    {
+        return Segment(slave_addr, -1, false, output_data, output_data.size());
+    }
+
+    //! @brief メモリに送信する区間
+    //! @param output_data 送信するデータ  通信が終わるまで保持してください
+    //! @param slave_addr 通信先のデバイスのスレーブアドレス
+    //! @param memory_addr 通信先のデバイス内のメモリアドレス
+    I2C::Segment I2C::Segment::write_mem(Span<const uint8_t> output_data, SlaveAddr slave_addr, MemoryAddr memory_addr) noexcept
+    {
+        return Segment(slave_addr, memory_addr.get(), false, output_data, output_data.size());
+    }
+
+    //! @brief スレーブアドレスを取得
+    uint8_t I2C::Segment::get_slave_addr() const noexcept
+    {
+        return _slave_addr;
+    }
+
+    //! @brief メモリアドレスを送る区間かを確認
+    bool I2C::Segment::has_memory_addr() const noexcept
+    {
+        return 0 <= _memory_addr;
+    }
+
+    //! @brief メモリアドレスを取得
+    uint8_t I2C::Segment::get_memory_addr() const noexcept
+    {
+        return static_cast<uint8_t>(_memory_addr);
+    }
+
+    //! @brief 受信する区間かを確認
+    bool I2C::Segment::is_read() const noexcept
+    {
+        return _is_read;
+    }
+
+    //! @brief 送信するデータを取得
+    Span<const uint8_t> I2C::Segment::get_output_data() const noexcept
+    {
+        return _output_data;
+    }
+
+    //! @brief 送受信するバイト数を取得
+    std::size_t I2C::Segment::size() const noexcept
+    {
+        return _size;
+    }
+
+    /***** class I2C *****/
+
+    //! @brief I2Cによる受信
+    //! @param size 受信するバイト数
+    //! @param slave_addr 通信先のデバイスのスレーブアドレス
+    //! @return Binary型のバイト列
+    Binary I2C::read(std::size_t size, SlaveAddr slave_addr) const
+    {
+        const Segment segment = Segment::read(size, slave_addr);
+        Binary input_data(size);  // InlineCapacity以下ならヒープを使用しない
+        transfer_into(Span<const Segment>(&segment, 1), Span<uint8_t>(input_data.writable_data(), size));
+        return input_data;
+    }
+
+    //! @brief I2Cによるメモリからの受信
+    //! @param size 受信するバイト数
+    //! @param slave_addr 通信先のデバイスのスレーブアドレス
+    //! @param memory_addr 通信先のデバイス内のメモリアドレス
+    //! @return Binary型のバイト列
+    Binary I2C::read_mem(std::size_t size, SlaveAddr slave_addr, MemoryAddr memory_addr) const
+    {
+        const Segment segment = Segment::read_mem(size, slave_addr, memory_addr);
+        Binary input_data(size);  // InlineCapacity以下ならヒープを使用しない
+        transfer_into(Span<const Segment>(&segment, 1), Span<uint8_t>(input_data.writable_data(), size));
+        return input_data;
+    }
+
+    //! @brief I2Cによる送信
+    //! @param output_data 送信するデータ
+    //! @param slave_addr 通信先のデバイスのスレーブアドレス
+    void I2C::write(const Binary& output_data, SlaveAddr slave_addr) const
+    {
+        const Segment segment = Segment::write(output_data.get_view(), slave_addr);
+        transfer_into(Span<const Segment>(&segment, 1), Span<uint8_t>());
+    }
+
+    //! @brief I2Cによるメモリからの送信
+    //! @param output_data 送信するデータ
+    //! @param slave_addr 通信先のデバイスのスレーブアドレス
+    //! @param memory_addr 通信先のデバイス内のメモリアドレス
+    void I2C::write_mem(const Binary& output_data, SlaveAddr slave_addr, MemoryAddr memory_addr) const
+    {
+        const Segment segment = Segment::write_mem(output_data.get_view(), slave_addr, memory_addr);
+        transfer_into(Span<const Segment>(&segment, 1), Span<uint8_t>());
+    }
+
+    //! @brief 複数の区間の通信をまとめて行う
+    //! @param segments 通信する区間  { }で囲んで複数入力
+    //! @return 受信した全てのデータを区間の順に詰めたBinary型のバイト列
+    Binary I2C::transfer(std::initializer_list<Segment> segments) const
+    {
+        const Span<const Segment> segment_span(segments.begin(), segments.size());
+        const std::size_t size = get_read_size(segment_span);
+        Binary input_data(size);  // 結果は1つのバッファにまとめる  InlineCapacity以下ならヒープを使用しない
+        transfer_into(segment_span, Span<uint8_t>(input_data.writable_data(), size));
+        return input_data;
+    }
+
+    //! @brief 複数の区間の通信を続けて行う
+    //! @param segments 通信する区間
+    //! @param input_data 受信したデータの保存先  受信する区間のデータを順に詰めて保存します
+    void I2C::transfer_into(Span<const Segment> segments, Span<uint8_t> input_data) const
+    {
+        try_transfer_into(segments, input_data).value();
+    }
+
+    //! @brief I2Cによるメモリからの受信  (通信のエラーで例外を投げません)
+    //! @param size 受信するバイト数
+    //! @param slave_addr 通信先のデバイスのスレーブアドレス
+    //! @param memory_addr 通信先のデバイス内のメモリアドレス
+    //! @return Binary型のバイト列か，通信のエラー
+    Result<Binary> I2C::try_read_mem(std::size_t size, SlaveAddr slave_addr, MemoryAddr memory_addr) const
+    {
+        const Segment segment = Segment::read_mem(size, slave_addr, memory_addr);
+        Binary input_data(size);  // InlineCapacity以下ならヒープを使用しない
+        const Result<void> result = try_transfer_into(Span<const Segment>(&segment, 1), Span<uint8_t>(input_data.writable_data(), size));
+        if (!result)
+    return result.error();
+        return input_data;
+    }
+
+    //! @brief I2Cによるメモリへの送信  (通信のエラーで例外を投げません)
+    //! @param output_data 送信するデータ
+    //! @param slave_addr 通信先のデバイスのスレーブアドレス
+    //! @param memory_addr 通信先のデバイス内のメモリアドレス
+    //! @return 通信のエラー
+    Result<void> I2C::try_write_mem(const Binary& output_data, SlaveAddr slave_addr, MemoryAddr memory_addr) const
+    {
+        const Segment segment = Segment::write_mem(output_data.get_view(), slave_addr, memory_addr);
+        return try_transfer_into(Span<const Segment>(&segment, 1), Span<uint8_t>());
+    }
+
+    //! @brief 受信する区間のバイト数の合計を取得
+    //! @param segments 通信する区間
+    //! @return transfer_into()の結果の保存に必要なバイト数
+    std::size_t I2C::get_read_size(Span<const Segment> segments) noexcept
+    {
+        std::size_t size = 0;
+        for (const Segment& segment : segments)
+        {
+            if (segment.is_read())
+            {
+                size += segment.size();
+            }
+        }
+        return size;
+    }
+
+    /***** class SPI::CS_Pin *****/
+
+    //! @brief SPIのCSピンをセットアップ
+    //! @param cs_gpio CSピンのGPIO番号
+    SPI::CS_Pin::CS_Pin(uint8_t cs_gpio):
+        _cs_gpio(cs_gpio)
+    {
+        if (!is_valid(_cs_gpio))
+        {
+            raise(SC_ERROR_INFO(ErrorCode::invalid_argument, "Invalid slave address entered."));  // 無効なスレーブアドレスの値が入力されました
+        }
+    }
+
+    //! @brief CSピンのGPIO番号を確認してセットアップ  (例外を投げません)
+    //! @param cs_gpio CSピンのGPIO番号
+    //! @return 範囲外のときはエラー
+    Result<SPI::CS_Pin> SPI::CS_Pin::create(uint8_t cs_gpio) noexcept
+    {
+        if (!is_valid(cs_gpio))
+    return SC_ERROR_INFO(ErrorCode::invalid_argument, "Invalid slave address entered.");  // 無効なスレーブアドレスの値が入力されました
+        return CS_Pin(cs_gpio);
+    }
+
+    //! @brief CSピンのGPIO番号が範囲内かを確認
+    //! @param cs_gpio CSピンのGPIO番号
+    //! @return 範囲内ならtrue
+    bool SPI::CS_Pin::is_valid(uint8_t cs_gpio) noexcept
+    {
+        static constexpr uint8_t MinCsGpio = 0;  // CSピンのGPIO番号の最小値
+        static constexpr uint8_t MaxCsGpio = 28;  // CSピンのGPIO番号の最大値
+
+        return !(cs_gpio < MinCsGpio || MaxCsGpio < cs_gpio);
+    }
+
+    //! @brief SPIのCSピンのGPIO番号を取得
+    //! @return CSピンのGPIO番号
+    uint8_t SPI::CS_Pin::get() const noexcept
+    {
+        return _cs_gpio;
+    }
+
+    /***** class SPI::Transfer *****/
+
+    //! @brief 非同期の転送のハンドルを作成
+    //! @param spi 転送を行っているSPI
+    //! @param sequence 転送の通し番号
+    SPI::Transfer::Transfer(const SPI& spi, uint32_t sequence) noexcept:
+        _spi(&spi),
+        _sequence(sequence) {}
+
+    //! @brief 転送が終わったかを確認
+    //! @return 終わっていればtrue
+    bool SPI::Transfer::is_done() const
+    {
+        return _spi->is_transfer_done(_sequence);
+    }
+
+    //! @brief 転送が終わるまで待つ
+    void SPI::Transfer::wait() const
+    {
+        _spi->wait_transfer(_sequence);
+    }
+
+    /***** class SPI *****/
+
+    //! @brief SPIによる受信
+    //! @param size 受信するバイト数
+    //! @param cs_pin 通信先につながるCSピン
+    //! @return Binary型のバイト列
+    Binary SPI::read(std::size_t size, CS_Pin cs_pin) const
+    {
+        Binary input_data(size);  // InlineCapacity以下ならヒープを使用しない
+        read_async(Span<uint8_t>(input_data.writable_data(), size), cs_pin).wait();
+        return input_data;
+    }
+
+    //! @brief SPIによるメモリからの受信
+    //! @param size 受信するバイト数
+    //! @param cs_pin 通信先につながるCSピン
+    //! @param memory_addr 通信先のデバイス内のメモリアドレス
+    //! @return Binary型のバイト列
+    //! メモリアドレスの8ビット目は自動的に1になります．
+    Binary SPI::read_mem(std::size_t size, CS_Pin cs_pin, MemoryAddr memory_addr) const
+    {
+        Binary input_data(size);  // InlineCapacity以下ならヒープを使用しない
+        read_mem_async(Span<uint8_t>(input_data.writable_data(), size), cs_pin, memory_addr).wait();
+        return input_data;
+    }
+
+    //! @brief SPIによる送信
+    //! @param output_data 送信するデータ
+    //! @param cs_pin 通信先につながるCSピン
+    void SPI::write(const Binary& output_data, CS_Pin cs_pin) const
+    {
+        write_async(output_data.get_view(), cs_pin).wait();
+    }
+
+    //! @brief SPIによるメモリからの送信
+    //! @param output_data 送信するデータ
+    //! @param cs_pin 通通信先につながるCSピン
+    //! @param memory_addr 通信先のデバイス内のメモリアドレス
+    //! メモリアドレスの8ビット目は自動的に0になります
+    void SPI::write_mem(const Binary& output_data, CS_Pin cs_pin, MemoryAddr memory_addr) const
+    {
+        write_mem_async(output_data.get_view(), cs_pin, memory_addr).wait();
+    }
+
+    /***** class SPI::MemoryAddr *****/
+
+    //! @brief SPIスレーブ内のメモリーアドレスをセットアップ
+    SPI::MemoryAddr::MemoryAddr(uint8_t memory_addr):
+        _memory_addr(memory_addr)
+    {
+        static constexpr uint8_t MinMemoryAddr = 0x00;  // メモリーアドレスの最大値
+        static constexpr uint8_t MaxMemoryAddr = 0xff;  // メモリーアドレスの最小値
+        
+        if (_memory_addr < MinMemoryAddr || MaxMemoryAddr < _memory_addr)
+        {
+            raise(SC_ERROR_INFO(ErrorCode::invalid_argument, "Invalid memory_addr value entered."));  // 無効なメモリーアドレスの値が入力されました
+        }
+    }
+    
+    //! @brief SPIスレーブ内のメモリーアドレスを取得
+    //! @return メモリーアドレス
+    uint8_t SPI::MemoryAddr::get() const noexcept
+    {
+        return _memory_addr;
+    }
+    
+    //! @brief SPI送信用のメモリーアドレスを取得
+    //! @return 8ビット目が0に置き換えられたメモリーアドレス
+    uint8_t SPI::MemoryAddr::get_0() const noexcept
+    {
+        return _memory_addr & 0b01111111;
+    }
+    
+    //! @brief SPI受信用のメモリーアドレスを取得
+    //! @return 8ビット目が1に置き換えられたメモリーアドレス
+    uint8_t SPI::MemoryAddr::get_1() const noexcept
+    {
+        return _memory_addr | 0b10000000;
+    }
+
+    /***** class NmeaParser *****/
+
+    //! @brief 受信した1バイトを解析する
+    //! @param input_byte 受信したバイト
+    //! @return 正しい文を受信し終えたときはその種類  文の途中や正しくない文のときはSentence::none
+    NmeaParser::Sentence NmeaParser::feed(uint8_t input_byte) noexcept
+    {
+        const char input_char = static_cast<char>(input_byte);
+        if (input_char == '$')  // どの状態でも，新しい文の始まりからやり直す
+        {
+            if (_state != State::wait_start) abort_sentence();
+            begin_sentence();
+    return Sentence::none;
+        }
+        if (_state == State::wait_start)
+    return Sentence::none;
+        if (_sentence_size < UINT8_MAX) ++_sentence_size;
+        if (MaxSentenceSize < _sentence_size && _sentence != Sentence::other)  // 解析しない文は，受信機独自の長い文でもよい
+        {
+            abort_sentence();
+    return Sentence::none;
+        }
+
+        const int hex_digit = ('0' <= input_char && input_char <= '9') ? input_char - '0'
+            : ('A' <= input_char && input_char <= 'F') ? input_char - 'A' + 10
+            : ('a' <= input_char && input_char <= 'f') ? input_char - 'a' + 10 : -1;  // チェックサムの桁
+        const bool is_line_end = (input_char == '\r' || input_char == '\n');
+        switch (_state)
+        {
+        case State::field:
+            if (input_char == '*')
+            {
+                end_field();
+                _state = State::checksum_high;
+            }
+            else if (is_line_end)  // チェックサムのない文は受け付けない
+            {
+                abort_sentence();
+            }
+            else if (_sentence == Sentence::other)  // 解析しない文は，チェックサムだけを計算する
+            {
+                _checksum ^= input_byte;
+            }
+            else
+            {
+                _checksum ^= input_byte;
+                if (input_char == ',')
+                {
+                    end_field();
+                    ++_field_index;
+                    begin_field();
+                }
+                else
+                {
+                    add_to_field(input_char);
+                }
+            }
+            break;
+        case State::checksum_high:
+        case State::checksum_low:
+            if (hex_digit < 0)
+            {
+                abort_sentence();
+        break;
+            }
+            _received_checksum = static_cast<uint8_t>((_received_checksum << 4) | hex_digit);
+            _state = (_state == State::checksum_high ? State::checksum_low : State::wait_end);
+            break;
+        case State::wait_end:
+            if (is_line_end)
+    return end_sentence();
+            abort_sentence();
+            break;
+        case State::wait_start:
+            break;
+        }
+        return Sentence::none;
+    }
+
+    //! @brief 受信したデータをまとめて解析する
+    //! @param input_data 受信したデータ
+    //! @return 正しい文を受信し終えた数
+    std::size_t NmeaParser::feed(Span<const uint8_t> input_data) noexcept
+    {
+        std::size_t sentence_num = 0;
+        for (uint8_t input_byte : input_data)
+        {
+            if (feed(input_byte) != Sentence::none) ++sentence_num;
+        }
+        return sentence_num;
+    }
+
+    //! @brief UARTで受信しているデータを全て解析する  (ループの中で繰り返し呼び出してください)
+    //! @param uart GNSS受信機をつないだUART
+    //! @return 正しい文を受信し終えた数
+    std::size_t NmeaParser::poll(const UART& uart)
+    {
+        uint8_t chunk[32];  // 受信バッファから少しずつ取り出す  (行ごとにはコピーしない)
+        std::size_t sentence_num = 0;
+        while (const std::size_t size = uart.read_into(chunk))
+        {
+            sentence_num += feed(Span<const uint8_t>(chunk, size));
+        }
+        return sentence_num;
+    }
+
+    //! @brief 解析した最新の値を取得
+    //! @return Position(測位できているとき)・Time・DOPを保存したMeasurement
+    const Measurement& NmeaParser::get_measurement() const noexcept
+    {
+        return _measurement;
+    }
+
+    //! @brief 受信した文の統計を取得
+    const NmeaParser::Stats& NmeaParser::get_stats() const noexcept
+    {
+        return _stats;
+    }
+
+    //! @brief 受信中の文と解析した値，統計を消去
+    void NmeaParser::reset() noexcept
+    {
+        _state = State::wait_start;
+        _measurement = Measurement();
+        _stats = Stats();
+    }
+
+    //! @brief '$'を受信し，新しい文を始める
+    void NmeaParser::begin_sentence() noexcept
+    {
+        _state = State::field;
+        _sentence = Sentence::none;
+        _field_index = 0;
+        _sentence_size = 1;
+        _checksum = 0;
+        _received_checksum = 0;
+        _fix = Fix{};
+        std::fill(std::begin(_fix.centi_dop), std::end(_fix.centi_dop), DOP::Unknown);
+        begin_field();
+    }
+
+    //! @brief 新しいフィールドを始める
+    void NmeaParser::begin_field() noexcept
+    {
+        _field = Field{0, 0, 0, -1, false, true, '\0'};
+    }
+
+    //! @brief フィールドに1文字加え，数値を組み立てる
+    void NmeaParser::add_to_field(char input_char) noexcept
+    {
+        static constexpr uint8_t MaxDigitNum = 18;  // uint64_tに収まる桁数
+
+        if (_field_index == 0)  // 文の種類は最後の3文字で判断する  ("GPGGA"や"GNGGA"など)
+        {
+            _type[0] = _type[1];
+            _type[1] = _type[2];
+            _type[2] = input_char;
+        }
+        if (_field.size == 0)
+        {
+            _field.first_char = input_char;
+        }
+        ++_field.size;  // 解析する文は長さを制限しているので，あふれない
+
+        if ('0' <= input_char && input_char <= '9')
+        {
+            if (_field.digit_count < MaxDigitNum)
+            {
+                _field.mantissa = _field.mantissa * 10 + static_cast<uint64_t>(input_char - '0');
+                ++_field.digit_count;
+                if (0 <= _field.fraction_count) ++_field.fraction_count;
+            }
+            else if (_field.fraction_count < 0)  // 整数部が長すぎる  (小数部なら，それ以降の桁を切り捨てる)
+            {
+                _field.is_number = false;
+            }
+        }
+        else if (input_char == '.' && _field.fraction_count < 0)
+        {
+            _field.fraction_count = 0;
+        }
+        else if (input_char == '-' && _field.size == 1)
+        {
+            _field.is_negative = true;
+        }
+        else
+        {
+            _field.is_number = false;
+        }
+    }
+
+    //! @brief フィールドを受信し終え，文の種類とフィールドの番号に応じて値を読み取る
+    void NmeaParser::end_field() noexcept
+    {
+        if (_field_index == 0)
+        {
+            const bool is_address = (_field.size == 5 && _field.first_char != 'P');  // 'P'で始まる文は受信機独自の文
+            _sentence = !is_address ? Sentence::other
+                : std::equal(_type, _type + 3, "GGA") ? Sentence::gga
+                : std::equal(_type, _type + 3, "RMC") ? Sentence::rmc
+                : std::equal(_type, _type + 3, "GSA") ? Sentence::gsa : Sentence::other;
+    return;
+        }
+
+        switch (_sentence)
+        {
+        case Sentence::gga:  // $--GGA,時刻,緯度,N/S,経度,E/W,品質,衛星数,HDOP,高度,M,ジオイド高,M,,*hh
+            switch (_field_index)
+            {
+            case 1: read_time(); break;
+            case 2: read_coordinate(has_latitude, _fix.latitude_e7); break;
+            case 3: read_hemisphere(has_latitude, _fix.latitude_e7, 'N', 'S'); break;
+            case 4: read_coordinate(has_longitude, _fix.longitude_e7); break;
+            case 5: read_hemisphere(has_longitude, _fix.longitude_e7, 'E', 'W'); break;
+            case 6: _fix.is_fixed = (_field.is_number && _field.mantissa != 0); break;  // 0は測位できていない
+            case 8: read_dop(1); break;
+            case 9: read_altitude(); break;
+            default: break;
+            }
+            break;
+        case Sentence::rmc:  // $--RMC,時刻,A/V,緯度,N/S,経度,E/W,速度,方位,日付,...*hh
+            switch (_field_index)
+            {
+            case 1: read_time(); break;
+            case 2: _fix.is_fixed = (_field.first_char == 'A'); break;
+            case 9: read_date(); break;
+            default: break;
+            }
+            break;
+        case Sentence::gsa:  // $--GSA,A/M,測位の種類,衛星番号x12,PDOP,HDOP,VDOP*hh
+            switch (_field_index)
+            {
+            case 2: _fix.is_fixed = (_field.is_number && 2 <= _field.mantissa); break;  // 1は測位できていない
+            case 15: read_dop(0); break;
+            case 16: read_dop(1); break;
+            case 17: read_dop(2); break;
+            default: break;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    //! @brief 改行を受信し，チェックサムが正しければ値を反映する
+    //! @return 正しい文のときはその種類
+    NmeaParser::Sentence NmeaParser::end_sentence() noexcept
+    {
+        _state = State::wait_start;
+        if (_checksum != _received_checksum)
+        {
+            ++_stats.checksum_error_count;
+    return Sentence::none;
+        }
+        if ((_fix.field_flags & is_broken) || !apply_fix())
+        {
+            ++_stats.format_error_count;
+    return Sentence::none;
+        }
+        ++_stats.sentence_count;
+        return _sentence;
+    }
+
+    //! @brief 受信中の文を捨てる
+    void NmeaParser::abort_sentence() noexcept
+    {
+        _state = State::wait_start;
+        ++_stats.format_error_count;
+    }
+
+    //! @brief フィールドの数値を，小数点以下 decimals 桁の整数として読み取る  (四捨五入)
+    //! @param decimals 小数点以下の桁数
+    //! @param value 読み取った値の保存先
+    //! @return 数値でないときはfalse
+    bool NmeaParser::read_scaled(uint8_t decimals, int64_t& value) const noexcept
+    {
+        static constexpr uint64_t Pow10[] = {1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL, 100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL, 10000000000000ULL, 100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL, 100000000000000000ULL, 1000000000000000000ULL};
+
+        if (!_field.is_number || _field.digit_count == 0)
+    return false;
+        const int fraction_count = std::max<int>(_field.fraction_count, 0);
+        if (18 < _field.digit_count - fraction_count + decimals)  // 整数部が長すぎる
+    return false;
+        uint64_t scaled = _field.mantissa;
+        if (fraction_count <= decimals)
+        {
+            scaled *= Pow10[decimals - fraction_count];
+        }
+        else
+        {
+            const uint64_t divisor = Pow10[fraction_count - decimals];
+            scaled = (scaled + divisor / 2) / divisor;
+        }
+        value = (_field.is_negative ? -static_cast<int64_t>(scaled) : static_cast<int64_t>(scaled));
+        return true;
+    }
+
+    //! @brief 時刻(hhmmss.ss)を読み取る
+    void NmeaParser::read_time() noexcept
+    {
+        int64_t scaled;  // hhmmssとミリ秒を並べた値
+        if (_field.size == 0)
+    return;
+        if (!read_scaled(3, scaled) || scaled < 0)
+        {
+            _fix.field_flags |= is_broken;
+    return;
+        }
+        const uint32_t hour = static_cast<uint32_t>(scaled / 10000000);
+        const uint32_t minute = static_cast<uint32_t>(scaled / 100000 % 100);
+        const uint32_t second = static_cast<uint32_t>(scaled / 1000 % 100);
+        if (23 < hour || 59 < minute || 60 < second)  // 60秒はうるう秒
+        {
+            _fix.field_flags |= is_broken;
+    return;
+        }
+        _fix.millisecond_of_day = ((hour * 60 + minute) * 60 + second) * 1000 + static_cast<uint32_t>(scaled % 1000);
+        _fix.field_flags |= has_time;
+    }
+
+    //! @brief 緯度(ddmm.mmmm)・経度(dddmm.mmmm)を整数だけで1e-7度に直して読み取る
+    //! @param flag 読み取れたときに立てるビット
+    //! @param value_e7 読み取った値の保存先 (1e-7度)
+    void NmeaParser::read_coordinate(FixFlag flag, int32_t& value_e7) noexcept
+    {
+        static constexpr int64_t MinuteE7PerDegreeField = 100 * 10000000LL;  // "ddmm"の度の1の位 (1e-7分)
+        static constexpr int64_t MaxCoordinateE7 = 1800000000;  // 経度の最大値 (1e-7度)
+
+        int64_t scaled;  // 度と分を並べた値 (1e-7分)
+        if (_field.size == 0)
+    return;
+        if (!read_scaled(7, scaled) || scaled < 0 || 60 * 10000000LL <= scaled % MinuteE7PerDegreeField)
+        {
+            _fix.field_flags |= is_broken;
+    return;
+        }
+        const int64_t coordinate_e7 = scaled / MinuteE7PerDegreeField * 10000000 + (scaled % MinuteE7PerDegreeField + 30) / 60;
+        if (MaxCoordinateE7 < coordinate_e7)
+        {
+            _fix.field_flags |= is_broken;
+    return;
+        }
+        value_e7 = static_cast<int32_t>(coordinate_e7);
+        _fix.field_flags |= flag;
+    }
+
+    //! @brief 緯度・経度の次の，北緯・南緯(東経・西経)のフィールドを読み取る
+    //! @param flag 緯度・経度を読み取れたときに立てたビット
+    //! @param value_e7 緯度・経度  南緯・西経なら負にする
+    //! @param positive_char 北緯・東経を表す文字
+    //! @param negative_char 南緯・西経を表す文字
+    void NmeaParser::read_hemisphere(FixFlag flag, int32_t& value_e7, char positive_char, char negative_char) noexcept
+    {
+        if (!(_fix.field_flags & flag))
+    return;
+        if (_field.size == 1 && _field.first_char == negative_char)
+        {
+            value_e7 = -value_e7;
+        }
+        else if (!(_field.size == 1 && _field.first_char == positive_char))
+        {
+            _fix.field_flags |= is_broken;
+        }
+    }
+
+    //! @brief 高度(m)をmmに直して読み取る
+    void NmeaParser::read_altitude() noexcept
+    {
+        int64_t altitude_mm;
+        if (_field.size == 0)
+    return;
+        if (!read_scaled(3, altitude_mm) || altitude_mm < INT32_MIN || INT32_MAX < altitude_mm)
+        {
+            _fix.field_flags |= is_broken;
+    return;
+        }
+        _fix.altitude_mm = static_cast<int32_t>(altitude_mm);
+        _fix.field_flags |= has_altitude;
+    }
+
+    //! @brief 日付(ddmmyy)を読み取る
+    void NmeaParser::read_date() noexcept
+    {
+        int64_t ddmmyy;
+        if (_field.size == 0)
+    return;
+        if (_field.digit_count != 6 || !read_scaled(0, ddmmyy) || ddmmyy < 0)
+        {
+            _fix.field_flags |= is_broken;
+    return;
+        }
+        _fix.day = static_cast<uint8_t>(ddmmyy / 10000);
+        _fix.month = static_cast<uint8_t>(ddmmyy / 100 % 100);
+        _fix.year = static_cast<uint16_t>(2000 + ddmmyy % 100);
+        _fix.field_flags |= has_date;
+    }
+
+    //! @brief DOPを0.01単位で読み取る
+    //! @param index 0:PDOP 1:HDOP 2:VDOP
+    void NmeaParser::read_dop(std::size_t index) noexcept
+    {
+        static constexpr int64_t MaxCentiDOP = 9999;  // DOPの最大値 (0.01)
+
+        int64_t centi_dop;
+        if (_field.size == 0)
+    return;
+        if (!read_scaled(2, centi_dop) || centi_dop < 0 || MaxCentiDOP < centi_dop)
+        {
+            _fix.field_flags |= is_broken;
+    return;
+        }
+        _fix.centi_dop[index] = static_cast<uint16_t>(centi_dop);
+    }
+
+    //! @brief チェックサムが正しい文から読み取った値をMeasurementに反映する
+    //! GGAは位置・時刻・HDOP，RMCは日付付きの時刻，GSAはDOPを反映します．
+    //! @return 値が範囲外のときはfalse
+    bool NmeaParser::apply_fix() noexcept
+    {
+        const auto merge_dop = [this]()
+        {
+            uint16_t centi_dop[3];
+            std::copy(std::begin(_fix.centi_dop), std::end(_fix.centi_dop), centi_dop);
+            if (_measurement.contains<DOP>())  // 受信しなかった値は前の値を使う  (GGAはHDOPしかない)
+            {
+                const DOP previous = _measurement.get<DOP>();
+                const uint16_t previous_centi_dop[3] = {previous.get_centi_pdop(), previous.get_centi_hdop(), previous.get_centi_vdop()};
+                for (std::size_t i = 0; i < 3; ++i)
+                {
+                    if (centi_dop[i] == DOP::Unknown) centi_dop[i] = previous_centi_dop[i];
+                }
+            }
+            return DOP::create_centi(centi_dop[0], centi_dop[1], centi_dop[2]);
+        };
+
+        switch (_sentence)
+        {
+        case Sentence::gga:
+            if (_fix.field_flags & has_time)
+            {
+                uint16_t year = 0;
+                uint8_t month = 0;
+                uint8_t day = 0;
+                if (_measurement.contains<Time>())  // RMCで受信した日付を，日付が変わるまで使う
+                {
+                    const Time previous = _measurement.get<Time>();
+                    if (previous.get_millisecond_of_day() <= _fix.millisecond_of_day)
+                    {
+                        year = previous.get_year();
+                        month = previous.get_month();
+                        day = previous.get_day();
+                    }
+                }
+                const Result<Time> time = Time::create(_fix.millisecond_of_day, year, month, day);
+                if (!time)
+    return false;
+                _measurement.set(time.value());
+            }
+            if (_fix.is_fixed && (_fix.field_flags & has_latitude) && (_fix.field_flags & has_longitude) && (_fix.field_flags & has_altitude))
+            {
+                const Result<Position> position = Position::create_e7(_fix.latitude_e7, _fix.longitude_e7, _fix.altitude_mm);
+                if (!position)
+    return false;
+                _measurement.set(position.value());
+            }
+            else
+            {
+                _measurement.erase<Position>();  // 測位が途切れた
+            }
+            break;
+        case Sentence::rmc:
+            if ((_fix.field_flags & has_time) && (_fix.field_flags & has_date))
+            {
+                const Result<Time> time = Time::create(_fix.millisecond_of_day, _fix.year, _fix.month, _fix.day);
+                if (!time)
+    return false;
+                _measurement.set(time.value());
+            }
+            break;
+        case Sentence::gsa:
+            if (!_fix.is_fixed)
+            {
+                _measurement.erase<DOP>();  // 測位が途切れた
+            }
+            break;
+        default:
+            break;
+        }
+
+        if (_fix.is_fixed && (_sentence == Sentence::gga || _sentence == Sentence::gsa))
+        {
+            const Result<DOP> dop = merge_dop();
+            if (!dop)
+    return false;
+            _measurement.set(dop.value());
+        }
+        return true;
+    }
+
+
+    /**************************************************/
+    /**********************モーター*********************/
+    /**************************************************/
+
+
+    /**************************************************/
+    /************************記録***********************/
+    /**************************************************/
+
+
+    /***** class FatFile *****/
+
+    namespace
+    {
+        constexpr uint32_t FatEntryPerBlock = SD::BlockSize / 4;  // 1ブロックのFATのエントリ数
+        constexpr uint32_t FatEndOfChain = 0x0FFFFFFF;  // クラスタのチェーンの終わり
+        constexpr uint32_t FatEntryMask = 0x0FFFFFFF;  // FAT32のエントリの下位28ビット  (上位4ビットは予約)
+        constexpr std::size_t DirEntrySize = 32;  // ディレクトリエントリのバイト数
+
+        uint16_t load_le16(const uint8_t* data) noexcept
+        {
+            return static_cast<uint16_t>(data[0] | data[1] << 8);
+        }
+
+        uint32_t load_le32(const uint8_t* data) noexcept
+        {
+            return static_cast<uint32_t>(data[0]) | static_cast<uint32_t>(data[1]) << 8 | static_cast<uint32_t>(data[2]) << 16 | static_cast<uint32_t>(data[3]) << 24;
+        }
+
+        void store_le16(uint8_t* data, uint16_t value) noexcept
+        {
+            data[0] = static_cast<uint8_t>(value);
+            data[1] = static_cast<uint8_t>(value >> 8);
+        }
+
+        void store_le32(uint8_t* data, uint32_t value) noexcept
+        {
+            store_le16(data, static_cast<uint16_t>(value));
+            store_le16(data + 2, static_cast<uint16_t>(value >> 16));
+        }
+
+        //! @brief FAT32のブートセクタかを確認
+        bool is_fat32_boot_sector(const uint8_t* block) noexcept
+        {
+            const uint8_t cluster_size = block[13];
+            return load_le16(&block[11]) == SD::BlockSize && cluster_size && !(cluster_size & (cluster_size - 1))
+                && load_le16(&block[14]) && block[16] && !load_le16(&block[17]) && !load_le16(&block[22])  // FAT12/16のルートディレクトリとFATの大きさは0
+                && load_le32(&block[32]) && load_le32(&block[36]);
+        }
+
+        //! @brief ファイル名を，ディレクトリエントリの8.3形式  (空白で埋めた大文字の11文字)  に直す
+        //! @return 8.3形式で表せない名前のときはfalse
+        bool to_short_name(const char* name, uint8_t (&short_name)[11]) noexcept
+        {
+            static constexpr char Symbols[] = "!#$%&'()-@^_`{}~";  // 使える記号
+            std::fill(std::begin(short_name), std::end(short_name), ' ');
+            std::size_t position = 0;
+            std::size_t limit = 8;  // 名前は8文字，拡張子は3文字まで
+            for (; *name; ++name)
+            {
+                char c = *name;
+                if (c == '.')
+                {
+                    if (!position || limit == 11)
+    return false;  // 名前がないか，2つ目の'.'
+                    position = 8;
+                    limit = 11;
+        continue;
+                }
+                if ('a' <= c && c <= 'z') c = static_cast<char>(c - 'a' + 'A');
+                const bool is_valid = ('A' <= c && c <= 'Z') || ('0' <= c && c <= '9') || (c && std::strchr(Symbols, c));
+                if (position == limit || !is_valid)
+    return false;  // 長すぎるか，使えない文字
+                short_name[position++] = static_cast<uint8_t>(c);
+            }
+            return limit == 8 ? position != 0 : position != 8;  // '.'の後ろの拡張子は空にしない
+        }
+    }
+
+    //! @brief 書き込み先のSDカードを設定  create()でファイルを作るまで何もしない
+    FatFile::FatFile(const SD& sd) noexcept:
+        _sd(sd),
+        _block{} {}
+
+    //! @brief ルートディレクトリにファイルを作り，連続したクラスタを確保する
+    //! @param name ファイル名  8.3形式  ("LOG00001.BIN"など)
+    //! @param capacity 確保するバイト数  これ以上は追記できません
+    //! @return 同じ名前のファイルがある，連続した空き領域がないなどのときはエラー
+    Result<void> FatFile::create(const char* name, uint64_t capacity)
+    {
+        uint8_t short_name[11];
+        if (_is_open)
+    return SC_ERROR_INFO(ErrorCode::invalid_argument, "FatFile is already open");  // 前のファイルをclose()していない
+        if (!capacity || MaxFileSize < capacity)
+    return SC_ERROR_INFO(ErrorCode::invalid_argument, "Invalid FatFile capacity");  // FAT32のファイルの大きさは4GB未満
+        if (!to_short_name(name, short_name))
+    return SC_ERROR_INFO(ErrorCode::invalid_argument, "Invalid 8.3 file name");  // 8.3形式のファイル名ではない
+
+        Result<void> result = mount();
+        if (!result)
+    return result;
+        result = find_entry(short_name);  // 先に空きエントリを探し，失敗したときにクラスタを確保したままにしない
+        if (!result)
+    return result;
+        const uint64_t cluster_bytes = static_cast<uint64_t>(_cluster_size) * SD::BlockSize;
+        const uint32_t cluster_count = static_cast<uint32_t>((capacity + cluster_bytes - 1) / cluster_bytes);
+        const Result<uint32_t> first_cluster = allocate(cluster_count);
+        if (!first_cluster)
+    return first_cluster.error();
+
+        const Span<uint8_t> block(_block, SD::BlockSize);
+        result = _sd.read_blocks(_entry_block, block);
+        if (!result)
+    return result;
+        uint8_t* const entry = &_block[_entry_offset];
+        std::fill(entry, entry + DirEntrySize, 0);
+        std::copy(std::begin(short_name), std::end(short_name), entry);
+        entry[11] = 0x20;  // アーカイブ属性
+        for (std::size_t date_offset : {16, 18, 24})
+        {
+            store_le16(&entry[date_offset], 0x0021);  // 作成・アクセス・更新の日付  時計がないので1980-01-01
+        }
+        store_le16(&entry[20], static_cast<uint16_t>(first_cluster.value() >> 16));
+        store_le16(&entry[26], static_cast<uint16_t>(first_cluster.value()));
+        result = _sd.write_blocks(_entry_block, block);
+        if (!result)
+    return result;
+
+        _first_block = get_cluster_block(first_cluster.value());
+        _capacity = std::min(cluster_count * cluster_bytes, MaxFileSize);
+        _size = 0;
+        _is_open = true;
+        std::fill(std::begin(_block), std::end(_block), 0);
+        return {};
+    }
+
+    //! @brief ファイルの末尾に追記する  (SectorWriterのStorageとしての関数)
+    //! 最後のブロックの途中までのデータは，保存しておいたデータと合わせてブロック全体を書きます．
+    //! @param offset ファイル上の位置  get_size()と同じ値  (追記のみ)
+    //! @param output_data 追記するデータ
+    //! @return 確保した大きさを超えるとき，書けなかったときはエラー  書けなかったときは大きさを進めないので，同じoffsetから書き直せます
+    Result<void> FatFile::begin_write(uint64_t offset, Span<const uint8_t> output_data)
+    {
+        if (!_is_open || offset != _size)
+    return SC_ERROR_INFO(ErrorCode::invalid_argument, "FatFile can only append to the end of an open file");  // 末尾以外への書き込み
+        if (_capacity - _size < output_data.size())
+    return SC_ERROR_INFO(ErrorCode::buffer_too_small, "FatFile is full");  // 確保したクラスタを使い切った
+
+        const uint64_t size = _size + output_data.size();  // 書き終えた後の大きさ  全てのブロックを書けるまで_sizeは進めない  (同じ位置から書き直せるように)
+        uint32_t block = _first_block + static_cast<uint32_t>(offset / SD::BlockSize);
+        std::size_t tail_size = static_cast<std::size_t>(offset % SD::BlockSize);  // 最後のブロックに入っているバイト数
+        if (tail_size)  // 最後のブロックの続きを埋める
+        {
+            const std::size_t count = std::min(output_data.size(), SD::BlockSize - tail_size);
+            std::copy(output_data.begin(), output_data.begin() + count, &_block[tail_size]);
+            tail_size += count;
+            output_data = output_data.subspan(count, output_data.size() - count);
+            if (tail_size == SD::BlockSize)
+            {
+                const Result<void> result = _sd.write_blocks(block++, Span<const uint8_t>(_block, SD::BlockSize));
+                if (!result)
+    return result;
+                tail_size = 0;
+            }
+        }
+        const std::size_t full_size = output_data.size() / SD::BlockSize * SD::BlockSize;
+        if (full_size)  // ブロック全体のデータはコピーせずにまとめて書く
+        {
+            const Result<void> result = _sd.write_blocks(block, output_data.subspan(0, full_size));
+            if (!result)
+    return result;
+            block += static_cast<uint32_t>(full_size / SD::BlockSize);
+            output_data = output_data.subspan(full_size, output_data.size() - full_size);
+        }
+        if (!output_data.empty())  // 新しいブロックの途中まで  書けるまでは_blockの前のブロックのデータを残す
+        {
+            alignas(4) uint8_t last_block[SD::BlockSize] = {};
+            std::copy(output_data.begin(), output_data.end(), last_block);
+            const Result<void> result = _sd.write_blocks(block, Span<const uint8_t>(last_block, SD::BlockSize));
+            if (!result)
+    return result;
+            std::copy(std::begin(last_block), std::end(last_block), _block);
+        }
+        else if (tail_size)  // 最後のブロックの続きを埋めて，まだ途中まで
+        {
+            const Result<void> result = _sd.write_blocks(block, Span<const uint8_t>(_block, SD::BlockSize));
+            if (!result)
+    return result;
+        }
+        _size = size;
+        return {};
+    }
+
+    //! @brief ディレクトリエントリのファイルの大きさを，書いたバイト数に更新する
+    //! 更新するまでは，PCなどからは前に更新したときの大きさまでしか読めません．
+    //! @return 書けなかったときはエラー
+    Result<void> FatFile::sync()
+    {
+        if (!_is_open)
+    return SC_ERROR_INFO(ErrorCode::invalid_argument, "FatFile is not open");  // create()していない
+        alignas(4) uint8_t entry_block[SD::BlockSize];  // _blockには最後のブロックのデータがあるので別に用意する
+        const Result<void> result = _sd.read_blocks(_entry_block, Span<uint8_t>(entry_block, SD::BlockSize));
+        if (!result)
+    return result;
+        store_le32(&entry_block[_entry_offset + 28], static_cast<uint32_t>(_size));
+        return _sd.write_blocks(_entry_block, Span<const uint8_t>(entry_block, SD::BlockSize));
+    }
+
+    //! @brief ファイルの大きさを更新して閉じる  使わなかったクラスタは確保したまま残ります
+    //! @return 書けなかったときはエラー
+    Result<void> FatFile::close()
+    {
+        const Result<void> result = sync();
+        _is_open = false;
+        return result;
+    }
+
+    //! @brief ブートセクタを読み，FATとデータ領域の位置を求める  (パーティションテーブルがあれば最初のFAT32のパーティション)
+    Result<void> FatFile::mount()
+    {
+        const Span<uint8_t> block(_block, SD::BlockSize);
+        Result<void> result = _sd.read_blocks(0, block);
+        if (!result)
+    return result;
+        if (load_le16(&_block[510]) != 0xAA55)
+    return SC_ERROR_INFO(ErrorCode::wrong_device, "SD card has no boot sector");  // フォーマットされていない
+        uint32_t volume_block = 0;  // FAT32の領域の最初のブロック
+        if (!is_fat32_boot_sector(_block))  // MBRのパーティションテーブルから探す
+        {
+            for (std::size_t partition = 446; partition < 510; partition += 16)
+            {
+                if (_block[partition + 4] == 0x0B || _block[partition + 4] == 0x0C)  // FAT32のパーティション
+                {
+                    volume_block = load_le32(&_block[partition + 8]);
+        break;
+                }
+            }
+            if (volume_block)
+            {
+                result = _sd.read_blocks(volume_block, block);
+                if (!result)
+    return result;
+            }
+            if (!volume_block || !is_fat32_boot_sector(_block))
+    return SC_ERROR_INFO(ErrorCode::wrong_device, "SD card is not formatted as FAT32");  // FAT12/16やexFATは使えない
+        }
+
+        _cluster_size = _block[13];
+        _fat_num = _block[16];
+        _fat_size = load_le32(&_block[36]);
+        _fat_block = volume_block + load_le16(&_block[14]);
+        _data_block = _fat_block + _fat_num * _fat_size;
+        _root_cluster = load_le32(&_block[44]);
+        const uint32_t volume_size = load_le32(&_block[32]);
+        const uint16_t fs_info = load_le16(&_block[48]);
+        _fs_info_block = (fs_info && fs_info != 0xFFFF) ? volume_block + fs_info : 0;
+        if (volume_size <= _data_block - volume_block || _sd.get_block_num() < volume_block + volume_size)
+    return SC_ERROR_INFO(ErrorCode::wrong_device, "FAT32 volume does not fit in SD card");  // ブートセクタの値が壊れている
+        _cluster_num = std::min((volume_size - (_data_block - volume_block)) / _cluster_size, _fat_size * FatEntryPerBlock - 2);
+        return {};
+    }
+
+    //! @brief ルートディレクトリから，同じ名前のファイルがないことを確認し，空きエントリを探す
+    //! @param short_name 8.3形式のファイル名
+    //! @return 同じ名前のファイルがある，空きエントリがないときはエラー
+    Result<void> FatFile::find_entry(const uint8_t (&short_name)[11])
+    {
+        bool has_free_entry = false;
+        uint32_t cluster = _root_cluster;
+        for (uint32_t cluster_count = 0; cluster_count < _cluster_num; ++cluster_count)  // FATがループしていても止まる
+        {
+            if (cluster < 2 || _cluster_num + 2 <= cluster)
+    return SC_ERROR_INFO(ErrorCode::wrong_device, "FAT32 directory chain is broken");  // データ領域の外のクラスタ
+            for (uint32_t i = 0; i < _cluster_size; ++i)
+            {
+                const uint32_t block = get_cluster_block(cluster) + i;
+                const Result<void> result = _sd.read_blocks(block, Span<uint8_t>(_block, SD::BlockSize));
+                if (!result)
+    return result;
+                for (uint16_t offset = 0; offset < SD::BlockSize; offset += DirEntrySize)
+                {
+                    const uint8_t* const entry = &_block[offset];
+                    if (entry[0] == 0x00 || entry[0] == 0xE5)  // 空きエントリ  (0x00は以降も全て空き)
+                    {
+                        if (!has_free_entry)
+                        {
+                            _entry_block = block;
+                            _entry_offset = offset;
+                            has_free_entry = true;
+                        }
+                        if (entry[0] == 0x00)
+    return {};
+        continue;
+                    }
+                    if (entry[11] != 0x0F && std::equal(std::begin(short_name), std::end(short_name), entry))  // 長いファイル名のエントリ以外で同じ名前
+    return SC_ERROR_INFO(ErrorCode::invalid_argument, "File already exists");  // 既存のファイルは上書きしない
+                }
+            }
+            const Result<uint32_t> next_cluster = read_fat(cluster);
+            if (!next_cluster)
+    return next_cluster.error();
+            if (0x0FFFFFF8 <= next_cluster.value())
+        break;  // チェーンの終わり
+            cluster = next_cluster.value();
+        }
+        if (!has_free_entry)
+    return SC_ERROR_INFO(ErrorCode::buffer_too_small, "Root directory is full");  // ディレクトリのクラスタは増やさない
+        return {};
+    }
+
+    //! @brief 連続した空きクラスタを探し，チェーンを全てのFATに書き込む
+    //! FSInfoの次の空きクラスタから探し始めるので，ログを続けて作るときはFATの先頭から読み直しません．
+    //! @param cluster_count 確保するクラスタの数
+    //! @return 最初のクラスタ  連続した空きがないときはエラー
+    Result<uint32_t> FatFile::allocate(uint32_t cluster_count)
+    {
+        const Span<uint8_t> block(_block, SD::BlockSize);
+        uint32_t start_cluster = 2;  // 探し始めるクラスタ
+        if (_fs_info_block)
+        {
+            const Result<void> result = _sd.read_blocks(_fs_info_block, block);
+            if (!result)
+    return result.error();
+            const uint32_t next_free = load_le32(&_block[492]);
+            if (load_le32(&_block[0]) == 0x41615252 && load_le32(&_block[484]) == 0x61417272 && 2 <= next_free && next_free < _cluster_num + 2)
+            {
+                start_cluster = next_free;
+            }
+        }
+
+        uint32_t first_cluster = 0;
+        uint32_t free_count = 0;  // 連続した空きクラスタの数
+        for (uint32_t i = 0; i < _cluster_num && free_count < cluster_count; ++i)
+        {
+            const uint32_t cluster = 2 + (start_cluster - 2 + i) % _cluster_num;
+            if (cluster == 2) free_count = 0;  // 最後のクラスタと最初のクラスタはつながっていない
+            if (!i || cluster % FatEntryPerBlock == 0 || cluster == 2)
+            {
+                const Result<void> result = _sd.read_blocks(_fat_block + cluster / FatEntryPerBlock, block);
+                if (!result)
+    return result.error();
+            }
+            if (load_le32(&_block[cluster % FatEntryPerBlock * 4]) & FatEntryMask)
+            {
+                free_count = 0;
+        continue;
+            }
+            if (!free_count++) first_cluster = cluster;
+        }
+        if (free_count < cluster_count)
+    return SC_ERROR_INFO(ErrorCode::buffer_too_small, "SD card has no contiguous free space");  // 連続した空き領域がない
+
+        const uint32_t last_cluster = first_cluster + cluster_count - 1;
+        for (uint32_t fat_block = first_cluster / FatEntryPerBlock; fat_block <= last_cluster / FatEntryPerBlock; ++fat_block)
+        {
+            Result<void> result = _sd.read_blocks(_fat_block + fat_block, block);
+            if (!result)
+    return result.error();
+            const uint32_t begin = std::max(first_cluster, fat_block * FatEntryPerBlock);
+            const uint32_t end = std::min(last_cluster + 1, (fat_block + 1) * FatEntryPerBlock);
+            for (uint32_t cluster = begin; cluster < end; ++cluster)
+            {
+                uint8_t* const fat_entry = &_block[cluster % FatEntryPerBlock * 4];
+                store_le32(fat_entry, (load_le32(fat_entry) & ~FatEntryMask) | (cluster == last_cluster ? FatEndOfChain : cluster + 1));
+            }
+            for (uint8_t fat = 0; fat < _fat_num; ++fat)
+            {
+                result = _sd.write_blocks(_fat_block + fat * _fat_size + fat_block, block);
+                if (!result)
+    return result.error();
+            }
+        }
+
+        if (_fs_info_block)  // 空きクラスタの数と次の空きクラスタを更新
+        {
+            Result<void> result = _sd.read_blocks(_fs_info_block, block);
+            if (!result)
+    return result.error();
+            if (load_le32(&_block[0]) == 0x41615252 && load_le32(&_block[484]) == 0x61417272)
+            {
+                const uint32_t free_cluster_num = load_le32(&_block[488]);
+                if (free_cluster_num != UINT32_MAX)  // UINT32_MAXは不明
+                {
+                    store_le32(&_block[488], cluster_count <= free_cluster_num ? free_cluster_num - cluster_count : UINT32_MAX);
+                }
+                store_le32(&_block[492], last_cluster + 1 < _cluster_num + 2 ? last_cluster + 1 : 2);
+                result = _sd.write_blocks(_fs_info_block, block);
+                if (!result)
+    return result.error();
+            }
+        }
+        return first_cluster;
+    }
+
+    //! @brief FATから次のクラスタを読む
+    //! @param cluster クラスタの番号
+    //! @return 次のクラスタの番号  (0x0FFFFFF8以上はチェーンの終わり)
+    Result<uint32_t> FatFile::read_fat(uint32_t cluster)
+    {
+        const Result<void> result = _sd.read_blocks(_fat_block + cluster / FatEntryPerBlock, Span<uint8_t>(_block, SD::BlockSize));
+        if (!result)
+    return result.error();
+        return load_le32(&_block[cluster % FatEntryPerBlock * 4]) & FatEntryMask;
+    }
+
+
+    /**************************************************/
+    /**********************センサ**********************/
+    /**************************************************/
+
+    
+}
@@ -0,0 +1,1228 @@
+/*************************************
+ *************************************
+
+
+このファイルは見なくてかまいません
+内部の実装を知りたい場合のみ見てください
+
+
+*************************************
+*************************************/
+
+#include "sc_pico.hpp"
+
+//! @file sc_pico.cpp
+//! @brief picoに関するプログラム
+//! @date 2023-10-28T15:47
+
+
+//! @brief ログを出力する関数です．
+//! @param log 書き込む文字列
+//! @param size 文字数
+void sc::Log::output(const char* log, std::size_t size) noexcept
+{
+    std::fwrite(log, 1, size, stdout);
+    std::fflush(stdout);
+    // ログの出力からログを記録すると再帰してしまうため，失敗してもErrorは投げない
+}
+
+namespace pico
+{
+    namespace
+    {
+        spin_lock_t* log_spin_lock = nullptr;  // 2つのコアからのログの書き込みを排他するハードウェアのスピンロック
+
+        //! @brief ログのスピンロックを取得  (同じコアの割り込みからの書き込みとも混ざらないように，割り込みも止める)
+        //! @return 元の割り込みの状態
+        uint32_t lock_log()
+        {
+            return spin_lock_blocking(log_spin_lock);
+        }
+
+        //! @brief ログのスピンロックを解放し，割り込みの状態を戻す
+        //! @param saved_irq lock_log()が返した割り込みの状態
+        void unlock_log(uint32_t saved_irq)
+        {
+            spin_unlock(log_spin_lock, saved_irq);
+        }
+
+        //! @brief コア0とコア1の両方からログを書き込めるように，スピンロックで排他する
+        //! コア1のパイプラインの段やコア0のエラー(raise()など)が同時にログを書き込んでも，循環バッファが壊れないようにします
+        void share_log_between_cores()
+        {
+            if (!log_spin_lock) log_spin_lock = spin_lock_init(spin_lock_claim_unused(true));
+            sc::Log::set_lock(lock_log, unlock_log);
+        }
+    }
+
+    //! @brief コア1でログの出力を始める
+    //! これ以降のログは非同期モードで記録され，コア1が出力するため，コア0の処理を止めません
+    //! コア1を他の用途に使う場合は呼び出さないでください
+    void start_log_drain()
+    {
+        share_log_between_cores();
+        sc::Log::set_async(true);
+        multicore_launch_core1([]
+        {
+            while (true)
+            {
+                if (!sc::Log::flush()) sleep_us(100);  // 出力するログがなければ少し待つ
+            }
+        });
+    }
+
+    //! @brief コア1で，処理(step)とログの出力を繰り返す
+    //! これ以降のログは非同期モードで記録され，コア1が出力します
+    //! @param step コア1で繰り返し呼ぶ関数  処理することがなければfalseを返す
+    //! @param context stepに渡すポインタ
+    void launch_core1(bool (*step)(void*), void* context)
+    {
+        static bool (*core1_step)(void*) = nullptr;  // コア1に渡す関数はキャプチャを持てないため，ここに保存する
+        static void* core1_context = nullptr;
+        core1_step = step;
+        core1_context = context;
+        share_log_between_cores();
+        sc::Log::set_async(true);
+        multicore_launch_core1([]
+        {
+            while (true)
+            {
+                const bool is_processed = core1_step(core1_context);
+                if (!sc::Log::flush() && !is_processed) tight_loop_contents();  // 処理もログもなければ待つ  (値が届いたらすぐに処理できるように，スリープはしない)
+            }
+        });
+    }
+
+    /***** class PinIO *****/
+
+    //! @brief picoの汎用入出力をセットアップ
+    PinIO::PinIO(uint8_t pin_gpio, Direction direction, Pull pull):
+        _pin_gpio(pin_gpio)
+    {
+        constexpr uint8_t MinPinGpio = 0;  // GPIOピンの最小の番号
+        constexpr uint8_t MaxPinGpio = 28; // GPIOピンの最大の番号
+
+        if (_pin_gpio < MinPinGpio || MaxPinGpio < _pin_gpio)
+        {
+            sc::raise(SC_ERROR_INFO(sc::ErrorCode::invalid_argument, "Invalid pin_gpio number entered"));  // 無効なピンのGPIO番号が入力されました
+        }
+
+        init_pin(pin_gpio);
+        set_direction(direction);
+        set_pull(pull);
+    }
+
+    //! @brief 汎用入出力のピンを初期化
+    //! @param pin_gpio 初期化するピンのGPIO番号
+    void PinIO::init_pin(uint8_t pin_gpio) const
+    {
+        gpio_init(pin_gpio);  // pico-SDKの関数  ピンの初期化を行う
+    }
+
+    //! @brief 入力か出力かを設定
+    //! @param direction 入出力の方向
+    void PinIO::set_direction(Direction direction) const
+    {
+        if (direction == Direction::in)
+        {
+            gpio_set_dir(_pin_gpio, GPIO_IN);  // pico-SDKの関数  通信方向の設定を行う
+        } else {
+            gpio_set_dir(_pin_gpio, GPIO_OUT);  // pico-SDKの関数  通信方向の設定を行う
+        }
+    }
+
+    //! @brief プルアップ・プルダウンを設定
+    //! @param pull プルアップ・プルダウン・使用しない
+    void PinIO::set_pull(Pull pull) const
+    {
+        switch (pull)
+        {
+            case Pull::no_use:
+            {
+                gpio_disable_pulls(_pin_gpio);  // pico-SDKの関数  プルアップ・プルダウンを無効化
+                break;
+            }
+            case Pull::up:
+            {
+                gpio_pull_up(_pin_gpio);
+                break;
+            }
+            case Pull::down:
+            {
+                gpio_pull_down(_pin_gpio);
+                break;
+            }
+        }
+    }
+
+    //! @brief 入力用ピンから読み込み
+    //! @return High(1)かLow(0)か
+    bool PinIO::read() const
+    {
+        return gpio_get(_pin_gpio);  // pico-SDKの関数  ピンがHighになっているかLowになっているかを取得する
+    }
+
+    //! @brief 出力用ピンに書き込み
+    //! @param level High(1)かLow(0)か
+    void PinIO::write(bool level) const
+    {
+        gpio_put(_pin_gpio, level);  // pico-SDKの関数  ピンにHighかLowを出力する
+    }
+
+    /***** class PinGroup *****/
+
+    //! @brief 複数のピンをまとめてセットアップ
+    //! @param mask グループに含めるピンのGPIO番号のビット  rp2040::gpio_mask({...})で作成
+    //! @param direction 入出力の方向
+    //! @param pull プルアップ・プルダウン
+    PinGroup::PinGroup(uint32_t mask, Direction direction, Pull pull):
+        _mask(mask)
+    {
+        if (!_mask || (_mask >> (rp2040::MaxGpio + 1)))
+        {
+            sc::raise(SC_ERROR_INFO(sc::ErrorCode::invalid_argument, "Invalid pin_gpio number entered"));  // 無効なピンのGPIO番号が入力されました
+        }
+
+        gpio_init_mask(_mask);  // pico-SDKの関数  まとめて初期化する
+        gpio_set_dir_masked(_mask, (direction == Direction::out) ? _mask : 0);  // pico-SDKの関数  まとめて方向を設定する
+        for (uint8_t pin_gpio = 0; pin_gpio <= rp2040::MaxGpio; ++pin_gpio)  // プルアップ・プルダウンはまとめて設定するレジスタがない
+        {
+            if (!rp2040::contains(_mask, pin_gpio))
+        continue;
+            gpio_set_pulls(pin_gpio, pull == Pull::up, pull == Pull::down);  // pico-SDKの関数
+        }
+    }
+
+    /***** class PinEdgeIRQ *****/
+
+    PinEdgeIRQ* PinEdgeIRQ::edge_irqs[rp2040::MaxGpio + 1] = {};
+
+    //! @brief ピンのエッジの割り込みをセットアップ
+    //! @param mask 記録するピンのGPIO番号のビット
+    //! @param edge 記録するエッジ
+    //! @param pull プルアップ・プルダウン
+    PinEdgeIRQ::PinEdgeIRQ(uint32_t mask, Edge edge, PinIO::Pull pull):
+        _mask(mask)
+    {
+        if (!_mask || (_mask >> (rp2040::MaxGpio + 1)))
+        {
+            sc::raise(SC_ERROR_INFO(sc::ErrorCode::invalid_argument, "Invalid pin_gpio number entered"));  // 無効なピンのGPIO番号が入力されました
+        }
+        for (uint8_t pin_gpio = 0; pin_gpio <= rp2040::MaxGpio; ++pin_gpio)
+        {
+            if (rp2040::contains(_mask, pin_gpio) && edge_irqs[pin_gpio])
+            {
+                sc::raise(SC_ERROR_INFO(sc::ErrorCode::invalid_argument, "The pin already has a PinEdgeIRQ"));  // このピンには既にPinEdgeIRQが作られています
+            }
+        }
+
+        uint32_t events = 0;  // 割り込みを起こすエッジ
+        if (static_cast<uint8_t>(edge) & static_cast<uint8_t>(Edge::rising)) events |= GPIO_IRQ_EDGE_RISE;
+        if (static_cast<uint8_t>(edge) & static_cast<uint8_t>(Edge::falling)) events |= GPIO_IRQ_EDGE_FALL;
+        gpio_init_mask(_mask);
+        gpio_set_dir_in_masked(_mask);
+        for (uint8_t pin_gpio = 0; pin_gpio <= rp2040::MaxGpio; ++pin_gpio)
+        {
+            if (!rp2040::contains(_mask, pin_gpio))
+        continue;
+            gpio_set_pulls(pin_gpio, pull == PinIO::Pull::up, pull == PinIO::Pull::down);
+            edge_irqs[pin_gpio] = this;
+            gpio_set_irq_enabled_with_callback(pin_gpio, events, true, irq_handler);  // pico-SDKの関数  エッジで割り込み処理を行う
+        }
+    }
+
+    //! @brief 割り込みを止めて，ピンの記録先を解除する
+    PinEdgeIRQ::~PinEdgeIRQ()
+    {
+        for (uint8_t pin_gpio = 0; pin_gpio <= rp2040::MaxGpio; ++pin_gpio)
+        {
+            if (!rp2040::contains(_mask, pin_gpio))
+        continue;
+            gpio_set_irq_enabled(pin_gpio, GPIO_IRQ_EDGE_RISE | GPIO_IRQ_EDGE_FALL, false);
+            edge_irqs[pin_gpio] = nullptr;
+        }
+    }
+
+    //! @brief 古い順に記録を取り出す
+    //! @param event 取り出した記録の保存先
+    //! @return 取り出せたらtrue  記録がなければfalse
+    bool PinEdgeIRQ::pop(Event& event)
+    {
+        return _events.pop(event);
+    }
+
+    //! @brief 取り出す前にあふれて捨てた記録の数を取得
+    std::size_t PinEdgeIRQ::get_overflow_count() const noexcept
+    {
+        return _events.get_overflow_count();
+    }
+
+    //! @brief エッジの割り込み処理  時刻と向きを記録するだけで戻る
+    //! @param gpio 変化したピンのGPIO番号
+    //! @param events 起きたエッジ  (GPIO_IRQ_EDGE_RISEとGPIO_IRQ_EDGE_FALL)
+    void PinEdgeIRQ::irq_handler(uint gpio, uint32_t events)
+    {
+        PinEdgeIRQ* const edge_irq = edge_irqs[gpio];
+        if (!edge_irq)
+    return;
+        const uint64_t now_us = time_us_64();  // pico-SDKの関数  起動からの時間(μs)を取得する
+        const bool is_rising = (events & GPIO_IRQ_EDGE_RISE);
+        const bool is_falling = (events & GPIO_IRQ_EDGE_FALL);
+        if (is_rising && is_falling)  // 短いパルスで両方起きていたら，今のレベルから順番を決める
+        {
+            const bool level = gpio_get(gpio);
+            edge_irq->_events.push(Event{now_us, static_cast<uint8_t>(gpio), !level});
+            edge_irq->_events.push(Event{now_us, static_cast<uint8_t>(gpio), level});
+        } else {
+            edge_irq->_events.push(Event{now_us, static_cast<uint8_t>(gpio), is_rising});
+        }
+    }
+
+    /***** class PulseCapture *****/
+
+    namespace
+    {
+        constexpr uint PulseCaptureProgramLength = 18;  // PIOのプログラムの命令数
+        constexpr uint32_t PulseCaptureClockHz = 2000000;  // ステートマシンのクロック  2サイクルのループが1μsになる
+        constexpr uint32_t PulseCaptureTriggerUs = 10;  // トリガーのパルスの幅 (μs)
+
+        //! @brief トリガーを出してエコーの幅を数えるPIOのプログラムを作る
+        //! x = タイムアウトから1μsごとに減らし，エコーが終わったときのxをRX FIFOに入れます．(幅 = タイムアウト - x)
+        //! タイムアウトしたときは0xffffffffを入れます．
+        //! 最初にTX FIFOから待機の時間(yに残す)とタイムアウトの値(OSRに残す)を順に受け取ります．
+        //! @param instructions 命令の保存先  jmpの行き先は0から数えたもの (pio_add_programが読み込む位置に合わせて直す)
+        void make_pulse_capture_program(uint16_t (&instructions)[PulseCaptureProgramLength])
+        {
+            enum Label : uint  // 命令の位置
+            {
+                Start = 3,  // 測定の開始  (.wrap_target)
+                WaitRise = 6,  // エコーがHighになるのを待つ
+                High = 9,  // エコーの幅を数え始める
+                Count = 10,  // エコーがHighの間数える
+                StillHigh = 12,
+                NoEcho = 13,  // タイムアウト
+                PushWidth = 14,  // 結果をFIFOに入れる
+                Wait = 17  // 次の測定まで待つ  (.wrap)
+            };
+            const uint16_t program[PulseCaptureProgramLength] = {
+                static_cast<uint16_t>(pio_encode_pull(false, true)),  // 0: 待機の時間を受け取る
+                static_cast<uint16_t>(pio_encode_mov(pio_y, pio_osr)),  // 1: y = 待機の時間
+                static_cast<uint16_t>(pio_encode_pull(false, true)),  // 2: タイムアウトの値を受け取る
+                static_cast<uint16_t>(pio_encode_mov(pio_x, pio_osr)),  // 3 Start: x = タイムアウト
+                static_cast<uint16_t>(pio_encode_set(pio_pins, 1) | pio_encode_delay(19)),  // 4: トリガーをHighにして10μs待つ
+                static_cast<uint16_t>(pio_encode_set(pio_pins, 0)),  // 5: トリガーをLowに戻す
+                static_cast<uint16_t>(pio_encode_jmp_pin(High)),  // 6 WaitRise: エコーがHighになったら数え始める
+                static_cast<uint16_t>(pio_encode_jmp_x_dec(WaitRise)),  // 7: 1μs待つ
+                static_cast<uint16_t>(pio_encode_jmp(NoEcho)),  // 8: エコーが来なかった
+                static_cast<uint16_t>(pio_encode_mov(pio_x, pio_osr)),  // 9 High: x = タイムアウト
+                static_cast<uint16_t>(pio_encode_jmp_pin(StillHigh)),  // 10 Count: エコーがHighなら続ける
+                static_cast<uint16_t>(pio_encode_jmp(PushWidth)),  // 11: エコーが終わった
+                static_cast<uint16_t>(pio_encode_jmp_x_dec(Count)),  // 12 StillHigh: 1μs数える  xが0なら次へ進む(タイムアウト)
+                static_cast<uint16_t>(pio_encode_mov_not(pio_x, pio_null)),  // 13 NoEcho: x = 0xffffffff
+                static_cast<uint16_t>(pio_encode_mov(pio_isr, pio_x)),  // 14 PushWidth: 結果をISRに移す
+                static_cast<uint16_t>(pio_encode_push(false, false)),  // 15: RX FIFOに入れる  満杯なら捨てる
+                static_cast<uint16_t>(pio_encode_mov(pio_x, pio_y)),  // 16: x = 待機の時間
+                static_cast<uint16_t>(pio_encode_jmp_x_dec(Wait) | pio_encode_delay(1)),  // 17 Wait: 1μsずつ待つ
+            };
+            std::copy(program, program + PulseCaptureProgramLength, instructions);
+            static_assert(Start == 3 && Wait == PulseCaptureProgramLength - 1, "\n\n<!ERROR!> The PIO program of PulseCapture is broken\n\n");  // PIOのプログラムの位置がずれています
+        }
+    }
+
+    //! @brief PIOのステートマシンで測定を始める
+    //! @param trigger_gpio トリガーを出すピンのGPIO番号
+    //! @param echo_gpio エコーを受けるピンのGPIO番号
+    //! @param timeout_us エコーを待つ最大の時間 (μs)
+    //! @param min_cycle_us 測定の最短の周期 (μs)  トリガーからこの時間が過ぎるまで次のトリガーを出しません  (HC-SR04は60ms以上)
+    PulseCapture::PulseCapture(uint8_t trigger_gpio, uint8_t echo_gpio, uint32_t timeout_us, uint32_t min_cycle_us):
+        _timeout_us(timeout_us),
+        _pio(pio0),
+        _sm(pio_claim_unused_sm(pio0, true))  // pico-SDKの関数  空いているステートマシンを確保する  なければパニック
+    {
+        if (rp2040::MaxGpio < trigger_gpio || rp2040::MaxGpio < echo_gpio || trigger_gpio == echo_gpio)
+        {
+            sc::raise(SC_ERROR_INFO(sc::ErrorCode::invalid_argument, "Invalid pin_gpio number entered"));  // 無効なピンのGPIO番号が入力されました
+        }
+        if (!timeout_us || timeout_us == NoEcho)
+        {
+            sc::raise(SC_ERROR_INFO(sc::ErrorCode::invalid_argument, "Invalid timeout entered"));  // 無効なタイムアウトが入力されました
+        }
+        if (min_cycle_us <= PulseCaptureTriggerUs)
+        {
+            sc::raise(SC_ERROR_INFO(sc::ErrorCode::invalid_argument, "Invalid minimum cycle entered"));  // 無効な最短の周期が入力されました
+        }
+
+        uint16_t instructions[PulseCaptureProgramLength];
+        make_pulse_capture_program(instructions);
+        const pio_program_t program = {instructions, PulseCaptureProgramLength, -1};
+        _program_offset = pio_add_program(_pio, &program);  // pico-SDKの関数  jmpの行き先は読み込んだ位置に合わせて直される
+
+        pio_gpio_init(_pio, trigger_gpio);
+        pio_gpio_init(_pio, echo_gpio);
+        gpio_pull_down(echo_gpio);  // センサがつながっていないときはLow
+        pio_sm_set_consecutive_pindirs(_pio, _sm, trigger_gpio, 1, true);
+        pio_sm_set_consecutive_pindirs(_pio, _sm, echo_gpio, 1, false);
+
+        pio_sm_config config = pio_get_default_sm_config();
+        sm_config_set_wrap(&config, _program_offset + 3, _program_offset + PulseCaptureProgramLength - 1);
+        sm_config_set_set_pins(&config, trigger_gpio, 1);
+        sm_config_set_in_pins(&config, echo_gpio);
+        sm_config_set_jmp_pin(&config, echo_gpio);
+        sm_config_set_clkdiv(&config, static_cast<float>(clock_get_hz(clk_sys)) / PulseCaptureClockHz);
+        pio_sm_init(_pio, _sm, _program_offset, &config);
+        pio_sm_put(_pio, _sm, min_cycle_us - PulseCaptureTriggerUs);  // 最初に待機の時間を渡す  トリガー以外の時間がこれ以上あるので，エコーの長さによらず周期はmin_cycle_us以上になる
+        pio_sm_put(_pio, _sm, _timeout_us);  // 次にタイムアウトの値を渡す
+        pio_sm_set_enabled(_pio, _sm, true);
+    }
+
+    //! @brief 測定を止めて，ステートマシンと命令メモリを解放する
+    PulseCapture::~PulseCapture()
+    {
+        pio_sm_set_enabled(_pio, _sm, false);
+        uint16_t instructions[PulseCaptureProgramLength];
+        make_pulse_capture_program(instructions);
+        const pio_program_t program = {instructions, PulseCaptureProgramLength, -1};
+        pio_remove_program(_pio, &program, _program_offset);
+        pio_sm_unclaim(_pio, _sm);
+    }
+
+    //! @brief 古い順にエコーのパルスの幅を取り出す
+    //! @param width_us 取り出したパルスの幅(μs)の保存先  タイムアウトしたときはNoEcho
+    //! @return 取り出せたらtrue  まだ測定が終わっていなければfalse
+    bool PulseCapture::pop(uint32_t& width_us)
+    {
+        if (pio_sm_is_rx_fifo_empty(_pio, _sm))
+    return false;
+        const uint32_t remaining = pio_sm_get(_pio, _sm);  // タイムアウトまでの残り
+        width_us = (remaining == NoEcho) ? NoEcho : _timeout_us - remaining;
+        return true;
+    }
+
+    //! @brief 次の測定が終わって，RX FIFOに結果が入るまで待つ
+    void PulseCapture::wait()
+    {
+        while (pio_sm_is_rx_fifo_empty(_pio, _sm))
+        {
+            tight_loop_contents();  // pico-SDKの関数  何もしない
+        }
+    }
+
+
+    /***** class I2C *****/
+
+    //! @brief I2Cのセットアップ
+    //! @param i2c_id I2C0かI2C1か
+    I2C::I2C(Pin i2c_pin, uint32_t freq):
+        _i2c(i2c_pin.get_i2c_id() ? i2c1 : i2c0),
+        _i2c_pin(i2c_pin),
+        _freq(freq)
+    {
+        init_i2c();
+        set_i2c_pin();
+    }
+
+    //! @brief I2C通信を初期化する
+    void I2C::init_i2c()
+    {
+        i2c_init(_i2c, _freq);  // pico-SDKの関数  I2Cを初期化する
+    }
+
+    //! @brief ピンをI2Cとして有効化する
+    void I2C::set_i2c_pin()
+    {
+        gpio_set_function(_i2c_pin.get_sda_gpio(), GPIO_FUNC_I2C);  // pico-SDKの関数  ピンの機能をI2Cモードにする
+        gpio_pull_up(_i2c_pin.get_sda_gpio());  // pico-SDKの関数  プルアップ抵抗を有効にする
+        gpio_set_function(_i2c_pin.get_scl_gpio(), GPIO_FUNC_I2C);  // pico-SDKの関数  ピンの機能をI2Cモードにする
+        gpio_pull_up(_i2c_pin.get_scl_gpio());  // pico-SDKの関数  プルアップ抵抗を有効にする
+    }
+
+    //! @brief 複数の区間の通信を続けて行う  (通信のエラーで例外を投げません)
+    //! @param segments 通信する区間
+    //! @param input_data 受信したデータの保存先  受信する区間のデータを順に詰めて保存します
+    //! @return 通信のエラー
+    //! 同じスレーブアドレスの区間が続く場合は，STOPをせずにリピーテッドスタートで続けます．
+    sc::Result<void> I2C::try_transfer_into(sc::Span<const Segment> segments, sc::Span<uint8_t> input_data) const
+    {
+        if (input_data.size() < get_read_size(segments))
+        {
+    return SC_ERROR_INFO(sc::ErrorCode::buffer_too_small, "Input buffer is too small for the transfer");  // 受信したデータの保存先が小さすぎます
+        }
+
+        std::size_t input_size = 0;  // 保存先に受信したバイト数
+        for (std::size_t i = 0; i < segments.size(); ++i)
+        {
+            const Segment& segment = segments[i];
+            // スレーブアドレスを変えるにはSTOPが必要なので，同じスレーブアドレスが続く場合のみリピーテッドスタートにする
+            const bool no_stop = (i + 1 < segments.size() && segments[i + 1].get_slave_addr() == segment.get_slave_addr());
+            int result = 0;  // pico-SDKの関数の戻り値  負の値なら失敗
+            if (segment.is_read())
+            {
+                if (segment.has_memory_addr())
+                {
+                    const uint8_t memory_addr_num = segment.get_memory_addr();
+                    result = i2c_write_blocking(_i2c, segment.get_slave_addr(), &memory_addr_num, 1, true);  // pico-SDKの関数  メモリアドレスを送信する
+                }
+                if (0 <= result)
+                {
+                    result = i2c_read_blocking(_i2c, segment.get_slave_addr(), input_data.data() + input_size, segment.size(), no_stop);  // pico-SDKの関数  受信する
+                }
+                input_size += segment.size();
+            } else if (segment.has_memory_addr()) {  // メモリアドレスとデータは1回の送信で送らないと，データがメモリアドレスとして扱われてしまう
+                sc::Binary output_data(segment.size() + 1);  // InlineCapacity以下ならヒープを使用しない
+                output_data.writable_data()[0] = segment.get_memory_addr();
+                std::copy(segment.get_output_data().begin(), segment.get_output_data().end(), output_data.writable_data() + 1);
+                result = i2c_write_blocking(_i2c, segment.get_slave_addr(), output_data.data(), output_data.size(), no_stop);  // pico-SDKの関数  送信する
+            } else {
+                result = i2c_write_blocking(_i2c, segment.get_slave_addr(), segment.get_output_data().data(), segment.size(), no_stop);  // pico-SDKの関数  送信する
+            }
+            if (result < 0)
+            {
+    return SC_ERROR_INFO(sc::ErrorCode::no_response, "I2C device did not respond");  // I2Cのデバイスが応答しませんでした
+            }
+        }
+        return sc::Result<void>();
+    }
+
+
+    /***** class SPI *****/
+
+    SPI::DmaState SPI::dma_states[2];
+
+    //! @brief SPIのセットアップ
+    //! @param spi_id SPI0かSPI1か
+    SPI::SPI(Pin spi_pin, uint32_t freq):
+        _spi_id(spi_pin.get_spi_id()),
+        _spi(_spi_id ? spi1 : spi0),
+        _spi_pin(spi_pin),
+        _freq(freq)
+    {
+        init_spi();
+        set_spi_pin();
+        set_dma();
+    }
+
+    //! SPI通信を初期化する
+    void SPI::init_spi()
+    {
+        spi_init(_spi, _freq);  // pico-SDKの関数  SPIを初期化する
+    }
+
+    //! @brief ピンをSPIとして有効化する
+    void SPI::set_spi_pin()
+    {
+        gpio_set_function(_spi_pin.get_mosi_gpio(), GPIO_FUNC_SPI);  // pico-SDKの関数  ピンの機能をSPIモードにする
+        gpio_set_function(_spi_pin.get_miso_gpio(), GPIO_FUNC_SPI);  // pico-SDKの関数  ピンの機能をSPIモードにする
+        gpio_set_function(_spi_pin.get_sck_gpio(), GPIO_FUNC_SPI);  // pico-SDKの関数  ピンの機能をSPIモードにする
+        const uint32_t cs_gpio_mask = _spi_pin.get_cs_gpio_mask();  // CSピンをまとめて設定
+        gpio_init_mask(cs_gpio_mask);
+        gpio_set_mask(cs_gpio_mask);  // 出力にする前にHigh(非選択)にしておく
+        gpio_set_dir_out_masked(cs_gpio_mask);
+    }
+
+    //! @brief 送信用と受信用のDMAのチャンネルを確保し，転送終了の割り込み処理を設定する
+    void SPI::set_dma()
+    {
+        DmaState& state = dma_states[_spi_id];
+        if (state.rx_channel < 0)
+        {
+            state.tx_channel = dma_claim_unused_channel(true);  // pico-SDKの関数  空いているDMAのチャンネルを確保
+            state.rx_channel = dma_claim_unused_channel(true);
+        }
+        static bool is_handler_added = false;  // SPI0とSPI1で共通の割り込み処理を登録したか
+        if (!is_handler_added)
+        {
+            irq_add_shared_handler(DMA_IRQ_0, dma_handler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);  // 他のDMAの割り込み処理と共存できるように登録
+            irq_set_enabled(DMA_IRQ_0, true);
+            is_handler_added = true;
+        }
+        dma_channel_set_irq0_enabled(state.rx_channel, true);  // 受信が終わったら割り込み処理を行う
+    }
+
+    //! @brief DMAの転送が終わったときに呼び出される割り込み処理  CSピンをHighに戻す
+    void SPI::dma_handler()
+    {
+        for (DmaState& state : dma_states)
+        {
+            if (0 <= state.rx_channel && dma_channel_get_irq0_status(state.rx_channel))
+            {
+                dma_channel_acknowledge_irq0(state.rx_channel);
+                gpio_put(state.cs_gpio, 1);  // 受信の終了は最後のバイトの送受信の終了なので，すぐにCSを戻せる
+                state.completed_sequence = state.started_sequence;
+            }
+        }
+    }
+
+    //! @brief 通信先につながるCSピンの出力レベルを0にして通信相手を選択
+    //! @param cs_gpio 選択したいCSピン
+    //! 前の転送が終わっていなければ，終わるまで待ってから選択します
+    void SPI::select_cs(CS_Pin cs_gpio) const
+    {
+        wait_transfer(dma_states[_spi_id].started_sequence);
+        gpio_put(cs_gpio.get(), 0);
+    }
+
+    //! @brief 通信先につながるCSピンの出力レベルを1にして通信相手の選択を解除
+    //! @param cs_gpio 選択を解除したいCSピン
+    void SPI::deselect_cs(CS_Pin cs_gpio) const
+    {
+        gpio_put(cs_gpio.get(), 1);
+    }
+
+    //! @brief DMAによる転送を開始する
+    //! @param output_data 送信するデータ  nullptrのときは0を送信
+    //! @param input_data 受信したデータの保存先  nullptrのときは受信したデータを捨てる
+    //! @param size 転送するバイト数
+    //! @param cs_pin 通信先につながるCSピン
+    //! @param memory_addr_num 最初に送るメモリアドレス  nullptrのときは送らない
+    //! @return 転送の終了を確認するためのハンドル
+    //! 前の転送が終わっていなければ，終わるまで待ってから開始します
+    sc::SPI::Transfer SPI::start_transfer(const uint8_t* output_data, uint8_t* input_data, std::size_t size, CS_Pin cs_pin, const uint8_t* memory_addr_num) const
+    {
+        static const uint8_t ZeroByte = 0;  // 受信のときに送信する値
+        static uint8_t discarded_byte;  // 送信のときに受信したデータの捨て先
+
+        DmaState& state = dma_states[_spi_id];
+        wait_transfer(state.started_sequence);  // 転送の順番を守るため，前の転送が終わるのを待つ
+
+        state.cs_gpio = cs_pin.get();
+        select_cs(cs_pin);
+        if (memory_addr_num)
+        {
+            spi_write_blocking(_spi, memory_addr_num, 1);  // 1バイトだけなのでDMAを使わずに送信
+        }
+        const uint32_t sequence = state.started_sequence + 1;
+        if (!size)
+        {
+            deselect_cs(cs_pin);
+            state.started_sequence = sequence;
+            state.completed_sequence = sequence;
+    return Transfer(*this, sequence);
+        }
+
+        dma_channel_config tx_config = dma_channel_get_default_config(state.tx_channel);
+        channel_config_set_transfer_data_size(&tx_config, DMA_SIZE_8);
+        channel_config_set_read_increment(&tx_config, output_data != nullptr);
+        channel_config_set_write_increment(&tx_config, false);
+        channel_config_set_dreq(&tx_config, spi_get_dreq(_spi, true));  // SPIの送信FIFOに空きがあるときに転送
+        dma_channel_configure(state.tx_channel, &tx_config, &spi_get_hw(_spi)->dr, (output_data ? output_data : &ZeroByte), size, false);
+
+        dma_channel_config rx_config = dma_channel_get_default_config(state.rx_channel);
+        channel_config_set_transfer_data_size(&rx_config, DMA_SIZE_8);
+        channel_config_set_read_increment(&rx_config, false);
+        channel_config_set_write_increment(&rx_config, input_data != nullptr);
+        channel_config_set_dreq(&rx_config, spi_get_dreq(_spi, false));  // SPIの受信FIFOにデータがあるときに転送
+        dma_channel_configure(state.rx_channel, &rx_config, (input_data ? input_data : &discarded_byte), &spi_get_hw(_spi)->dr, size, false);
+
+        state.started_sequence = sequence;
+        dma_start_channel_mask((1U << state.tx_channel) | (1U << state.rx_channel));  // 送信と受信を同時に開始
+        return Transfer(*this, sequence);
+    }
+
+    //! @brief SPIによる受信を開始し，終了を待たずに戻る
+    //! @param input_data 受信したデータの保存先  この大きさだけ受信します
+    //! @param cs_pin 通信先につながるCSピン
+    //! @return 転送の終了を確認するためのハンドル
+    sc::SPI::Transfer SPI::read_async(sc::Span<uint8_t> input_data, CS_Pin cs_pin) const
+    {
+        return start_transfer(nullptr, input_data.data(), input_data.size(), cs_pin, nullptr);
+    }
+
+    //! @brief SPIによるメモリからの受信を開始し，終了を待たずに戻る
+    //! @param input_data 受信したデータの保存先  この大きさだけ受信します
+    //! @param cs_pin 通信先につながるCSピン
+    //! @param memory_addr 通信先のデバイス内のメモリアドレス
+    //! @return 転送の終了を確認するためのハンドル
+    //! メモリアドレスの8ビット目は自動的に1になります．
+    sc::SPI::Transfer SPI::read_mem_async(sc::Span<uint8_t> input_data, CS_Pin cs_pin, MemoryAddr memory_addr) const
+    {
+        const uint8_t memory_addr_num = memory_addr.get_1();
+        return start_transfer(nullptr, input_data.data(), input_data.size(), cs_pin, &memory_addr_num);
+    }
+
+    //! @brief SPIによる送信を開始し，終了を待たずに戻る
+    //! @param output_data 送信するデータ
+    //! @param cs_pin 通信先につながるCSピン
+    //! @return 転送の終了を確認するためのハンドル
+    sc::SPI::Transfer SPI::write_async(sc::Span<const uint8_t> output_data, CS_Pin cs_pin) const
+    {
+        return start_transfer(output_data.data(), nullptr, output_data.size(), cs_pin, nullptr);
+    }
+
+    //! @brief SPIによるメモリへの送信を開始し，終了を待たずに戻る
+    //! @param output_data 送信するデータ
+    //! @param cs_pin 通信先につながるCSピン
+    //! @param memory_addr 通信先のデバイス内のメモリアドレス
+    //! @return 転送の終了を確認するためのハンドル
+    //! メモリアドレスの8ビット目は自動的に0になります
+    sc::SPI::Transfer SPI::write_mem_async(sc::Span<const uint8_t> output_data, CS_Pin cs_pin, MemoryAddr memory_addr) const
+    {
+        const uint8_t memory_addr_num = memory_addr.get_0();
+        return start_transfer(output_data.data(), nullptr, output_data.size(), cs_pin, &memory_addr_num);
+    }
+
+    //! @brief CSピンを変えずに送信し，終わるまで待つ  (受信したデータは捨てる)
+    //! @param output_data 送信するデータ
+    void SPI::write_blocking(sc::Span<const uint8_t> output_data) const
+    {
+        spi_write_blocking(_spi, output_data.data(), output_data.size());  // pico-SDKの関数
+    }
+
+    //! @brief CSピンを変えずに受信し，終わるまで待つ
+    //! @param input_data 受信したデータの保存先  この大きさだけ受信します
+    //! @param fill_byte 受信している間に送信する値  (SDカードは0xff)
+    void SPI::read_blocking(sc::Span<uint8_t> input_data, uint8_t fill_byte) const
+    {
+        spi_read_blocking(_spi, fill_byte, input_data.data(), input_data.size());  // pico-SDKの関数
+    }
+
+    //! @brief SPIの周波数を変える  (SDカードの初期化など)
+    //! @param freq 周波数 (/s)  get_freq()で，構築したときの周波数に戻せます
+    void SPI::set_freq(uint32_t freq) const
+    {
+        spi_set_baudrate(_spi, freq);  // pico-SDKの関数  実際の周波数は，設定できる中で指定以下の最も近い値
+    }
+
+    //! @brief 構築したときの周波数 (/s) を取得
+    uint32_t SPI::get_freq() const noexcept
+    {
+        return _freq;
+    }
+
+    //! @brief 通し番号 sequence の転送が終わったかを確認
+    bool SPI::is_transfer_done(uint32_t sequence) const
+    {
+        return 0 <= static_cast<int32_t>(dma_states[_spi_id].completed_sequence - sequence);  // 通し番号が一周しても正しく比較する
+    }
+
+    //! @brief 通し番号 sequence の転送が終わるまで待つ
+    void SPI::wait_transfer(uint32_t sequence) const
+    {
+        while (!is_transfer_done(sequence))
+        {
+            tight_loop_contents();  // pico-SDKの関数  何もしない
+        }
+    }
+
+
+    /***** class UART *****/
+
+    UART::RxBuffer UART::uart0_input_data;
+    UART::RxBuffer UART::uart1_input_data;
+    UART::DmaRxBuffer UART::uart0_dma_input_data;
+    UART::DmaRxBuffer UART::uart1_dma_input_data;
+    UART::DmaRxState UART::dma_rx_states[2];
+
+    //! @brief UARTのセットアップ
+    //! @param uart_pin UARTで使用するピン
+    //! @param freq 周波数 (/s)
+    //! @param rx_mode 受信の方法  GNSSなど高速で受信し続ける場合はRxMode::dma
+    UART::UART(Pin uart_pin, uint32_t freq, RxMode rx_mode):
+        _uart_id(uart_pin.get_uart_id()),
+        _uart(_uart_id ? uart1 : uart0),
+        _uart_pin(uart_pin),
+        _freq(freq),
+        _rx_mode(rx_mode)
+    {
+        init_uart();
+        set_uart_pin();
+        if (_rx_mode == RxMode::dma)
+        {
+            set_dma();
+        } else {
+            set_irq();
+        }
+    }
+
+    //! @brief UART通信を初期化する
+    void UART::init_uart()
+    {
+        uart_init(_uart, _freq);  // pico-SDKの関数  UARTを初期化する
+    }
+
+    //! @brief ピンをUARTとして有効化する
+    void UART::set_uart_pin()
+    {
+        gpio_set_function(_uart_pin.get_tx_gpio(), GPIO_FUNC_UART);  // pico-SDKの関数  ピンの機能をUARTモードにする
+        gpio_set_function(_uart_pin.get_rx_gpio(), GPIO_FUNC_UART);  // pico-SDKの関数  ピンの機能をUARTモードにする
+    }
+
+    //! 割り込み処理を設定する
+    void UART::set_irq()
+    {
+        if (_uart_id)
+        {
+            uart_set_hw_flow(uart1, false, false);  // フロー制御(受信準備が終わるまで送信しないで待つ機能)を無効にする
+            uart_set_format(uart1, 8, 1, UART_PARITY_NONE);  // UART通信の設定をする
+            uart_set_fifo_enabled(uart1, false);  // FIFO(受信したデータを一時的に保管する機能)をオフにし，1文字ずつ受信する
+            irq_set_exclusive_handler(UART1_IRQ, uart1_handler);  // 割り込み処理で実行する関数をセット
+            irq_set_enabled(UART1_IRQ, true);  // 割り込み処理を有効にする
+            uart_set_irq_enables(uart1, true, false);  // 割り込み処理を受信のみで使用する
+        } else {
+            uart_set_hw_flow(uart0, false, false);  // フロー制御(受信準備が終わるまで送信しないで待つ機能)を無効にする
+            uart_set_format(uart0, 8, 1, UART_PARITY_NONE);  // UART通信の設定をする
+            uart_set_fifo_enabled(uart0, false);  // FIFO(受信したデータを一時的に保管する機能)をオフにし，1文字ずつ受信する
+            irq_set_exclusive_handler(UART0_IRQ, uart0_handler);  // 割り込み処理で実行する関数をセット
+            irq_set_enabled(UART0_IRQ, true);  // 割り込み処理を有効にする
+            uart_set_irq_enables(uart0, true, false);  // 割り込み処理を受信のみで使用する
+        }
+    }
+
+    //! @brief FIFOを有効にし，DMAで循環バッファに受信し続けるように設定する
+    void UART::set_dma()
+    {
+        DmaRxBuffer& input_data = get_dma_input_data();
+        uart_set_hw_flow(_uart, false, false);  // フロー制御(受信準備が終わるまで送信しないで待つ機能)を無効にする
+        uart_set_format(_uart, 8, 1, UART_PARITY_NONE);  // UART通信の設定をする
+        uart_set_fifo_enabled(_uart, true);  // FIFO(32バイト)を有効にし，DMAでまとめて取り出す
+
+        constexpr uint32_t IdleChars = 10;  // 何文字分の時間データが届かなければフレームの終わりとするか
+        input_data.set_frame('\n', IdleChars * 10 * 1000000 / _freq);  // 1文字は10ビット (スタート・データ8・ストップ)
+
+        DmaRxState& state = dma_rx_states[_uart_id];
+        state.channel = dma_claim_unused_channel(true);  // pico-SDKの関数  空いているDMAのチャンネルを確保
+        state.restarted_count = 0;
+        dma_channel_config config = dma_channel_get_default_config(state.channel);
+        channel_config_set_transfer_data_size(&config, DMA_SIZE_8);  // 1バイトずつ転送
+        channel_config_set_read_increment(&config, false);  // 読み込み元はUARTのデータレジスタのまま
+        channel_config_set_write_increment(&config, true);
+        channel_config_set_dreq(&config, uart_get_dreq(_uart, false));  // UARTが受信したときに転送
+        channel_config_set_ring(&config, true, __builtin_ctz(DmaRxBuffer::capacity()));  // 書き込み先をバッファの中で循環させる
+        static bool is_handler_added = false;  // UART0とUART1で共通の割り込み処理を登録したか
+        if (!is_handler_added)
+        {
+            irq_add_shared_handler(DMA_IRQ_0, dma_handler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);  // SPIのDMAの割り込み処理と共存できるように登録
+            irq_set_enabled(DMA_IRQ_0, true);
+            is_handler_added = true;
+        }
+        dma_channel_set_irq0_enabled(state.channel, true);  // 転送が終わったら割り込み処理でやり直す
+        dma_channel_configure(state.channel, &config, input_data.get_dma_buffer(), &uart_get_hw(_uart)->dr, DmaRxTransferCount, true);  // 転送を開始
+    }
+
+    //! @brief DMAの受信の転送が終わったときに呼び出される割り込み処理  同じ書き込み先から転送をやり直す
+    //! 転送の回数には上限があるため，やり直さないと受信し続けられません．
+    void UART::dma_handler()
+    {
+        for (DmaRxState& state : dma_rx_states)
+        {
+            if (0 <= state.channel && dma_channel_get_irq0_status(state.channel))
+            {
+                dma_channel_acknowledge_irq0(state.channel);
+                state.restart_sequence = state.restart_sequence + 1;
+                state.restarted_count = state.restarted_count + DmaRxTransferCount;
+                dma_channel_set_trans_count(state.channel, DmaRxTransferCount, true);  // 書き込み先のアドレスは前の転送の続きのまま
+            }
+        }
+    }
+
+    //! @brief 割り込み処理でUART0の受信をする際に呼び出される関数
+    //! バッファが満杯のときは新しいデータを捨て，get_overflow_count()で数えます
+    void UART::uart0_handler()
+    {
+        while (uart_is_readable(uart0))
+        {
+            uart0_input_data.push(uart_getc(uart0));
+        }
+    }
+
+    //! @brief 割り込み処理でUART1の受信をする際に呼び出される関数
+    //! バッファが満杯のときは新しいデータを捨て，get_overflow_count()で数えます
+    void UART::uart1_handler()
+    {
+        while (uart_is_readable(uart1))
+        {
+            uart1_input_data.push(uart_getc(uart1));
+        }
+    }
+
+    //! @brief このUARTの受信用バッファを取得
+    UART::RxBuffer& UART::get_input_data() const noexcept
+    {
+        return (_uart_id ? uart1_input_data : uart0_input_data);
+    }
+
+    //! @brief このUARTのDMA用の受信バッファを取得し，DMAが書き込んだ分を反映する
+    UART::DmaRxBuffer& UART::get_dma_input_data() const
+    {
+        DmaRxBuffer& input_data = (_uart_id ? uart1_dma_input_data : uart0_dma_input_data);
+        const DmaRxState& state = dma_rx_states[_uart_id];
+        if (0 <= state.channel)
+        {
+            uint32_t restart_sequence;
+            uint32_t written_count;  // DMAが書き込んだバイト数の累計  (2^32で一周するが，差だけを使うので問題ない)
+            do
+            {
+                restart_sequence = state.restart_sequence;
+                written_count = state.restarted_count + (DmaRxTransferCount - dma_channel_hw_addr(state.channel)->transfer_count);
+            } while (restart_sequence != state.restart_sequence);  // 読み出しの途中で割り込み処理が転送をやり直したら読み直す
+            input_data.update(written_count, time_us_64());
+        }
+        return input_data;
+    }
+
+    //! @brief 受信していて，まだ読み出していないバイト数
+    std::size_t UART::available() const
+    {
+        return (_rx_mode == RxMode::dma ? get_dma_input_data().size() : get_input_data().size());
+    }
+
+    //! @brief UARTによる受信
+    //! @return Binary型のバイト列．
+    //! 割り込み処理で受信していたデータを全てまとめて返す．受信したデータは削除される．
+    sc::Binary UART::read() const
+    {
+        return read(available());
+    }
+
+    //! @brief UARTによる受信
+    //! @param size 受信するバイト数
+    //! @return Binary型のバイト列
+    //! 割り込み処理で受信していたデータを古い順に size バイト分返す
+    sc::Binary UART::read(std::size_t size) const
+    {
+        sc::Binary input_data(std::min(size, available()));  // InlineCapacity以下ならヒープを使用しない
+        read_into(sc::Span<uint8_t>(input_data.writable_data(), input_data.size()));
+        return input_data;
+    }
+
+    //! @brief UARTによる受信
+    //! @param input_data 受信したデータの保存先  この大きさまで受信します
+    //! @return 受信したバイト数
+    std::size_t UART::read_into(sc::Span<uint8_t> input_data) const
+    {
+        if (_rx_mode == RxMode::dma)
+    return get_dma_input_data().read_into(input_data);
+        return get_input_data().read_into(input_data);
+    }
+
+    //! @brief 受信用バッファが満杯で捨てたバイト数を取得
+    std::size_t UART::get_overflow_count() const noexcept
+    {
+        if (_rx_mode == RxMode::dma)
+    return get_dma_input_data().get_overflow_count();  // DMAが書き込んだ分を反映してから数える
+        return get_input_data().get_overflow_count();
+    }
+
+    //! @brief 受信したデータを区切る方法を設定  (RxMode::dmaのときのみ)
+    //! @param delimiter 区切り文字  NMEAなら'\n'  負の値のときは使用しない
+    //! @param idle_timeout_us この時間データが届かなければ区切る (μs)  0のときは使用しない
+    void UART::set_rx_frame(int delimiter, uint32_t idle_timeout_us)
+    {
+        if (_rx_mode != RxMode::dma)
+        {
+            sc::raise(SC_ERROR_INFO(sc::ErrorCode::invalid_argument, "set_rx_frame requires RxMode::dma"));  // 受信の区切りはRxMode::dmaのときのみ設定できます
+        }
+        (_uart_id ? uart1_dma_input_data : uart0_dma_input_data).set_frame(delimiter, idle_timeout_us);
+    }
+
+    //! @brief 区切り文字か無通信の時間によって，1つのまとまりを受信し終えたかを確認
+    //! @return RxMode::dmaのときは区切りまで受信していればtrue  RxMode::interruptのときは受信したデータがあればtrue
+    bool UART::is_frame_ready() const
+    {
+        if (_rx_mode == RxMode::dma)
+    return get_dma_input_data().is_frame_ready(time_us_64());
+        return !get_input_data().empty();
+    }
+
+    //! @brief 区切りまでのデータを受信
+    //! @return Binary型のバイト列  区切りまで受信していなければ空
+    //! RxMode::interruptのときはread()と同じ
+    sc::Binary UART::read_frame() const
+    {
+        if (_rx_mode != RxMode::dma)
+    return read();
+        uint8_t frame[SC_PICO_UART_RX_BUFFER_SIZE];
+        const std::size_t size = get_dma_input_data().read_frame_into(sc::Span<uint8_t>(frame), time_us_64());
+        return sc::Binary(size, frame);
+    }
+
+    //! @brief UARTによる送信
+    //! @param output_data 送信するデータ
+    //! @param no_use 不要．互換性維持のためにある
+    void UART::write(const sc::Binary& output_data) const
+    {
+        uart_write_blocking(_uart, output_data.data(), output_data.size());
+    }
+
+
+    /***** class SD *****/
+
+    namespace
+    {
+        constexpr uint32_t SdInitFreq = 400000;  // 初期化するときのSPIの周波数 (/s)
+        constexpr uint8_t SdAppCommand = 0x80;  // ACMD  (CMD55の後に送るコマンド)
+        constexpr uint8_t SdIdle = 0x01;  // R1  初期化中
+        constexpr uint8_t SdIllegalCommand = 0x04;  // R1  使えないコマンド
+        constexpr uint8_t SdStartBlock = 0xFE;  // 1ブロックの読み書きとCMD18のデータの始まり
+        constexpr uint8_t SdStartMultiBlock = 0xFC;  // CMD25のデータの始まり
+        constexpr uint8_t SdStopMultiBlock = 0xFD;  // CMD25の終わり
+        constexpr uint64_t SdInitTimeoutUs = 1000000;  // 初期化を待つ時間 (μs)
+        constexpr uint64_t SdReadTimeoutUs = 200000;  // 読み込みのデータを待つ時間 (μs)
+        constexpr uint64_t SdWriteTimeoutUs = 500000;  // 書き込みの終わりを待つ時間 (μs)
+    }
+
+    //! @brief SDカードを初期化し，ブロックの数を読む
+    //! @param spi 通信に使うSPI  SDカードのCSピンを含めて構築してください
+    //! @param cs_pin SDカードにつながるCSピン
+    SD::SD(const SPI& spi, SPI::CS_Pin cs_pin):
+        _spi(spi),
+        _cs_pin(cs_pin)
+    {
+        init().value();  // 初期化できなかったら，ここで例外を投げる
+    }
+
+    //! @brief 連続したブロックを読む  2ブロック以上はCMD18でまとめて読む
+    //! @param block 最初のブロックの番号
+    //! @param input_data 読んだデータの保存先  BlockSizeの倍数のバイト数
+    //! @return 範囲外のとき，読めなかったときはエラー
+    sc::Result<void> SD::read_blocks(uint32_t block, sc::Span<uint8_t> input_data) const
+    {
+        const sc::Result<void> result = check_range(block, input_data.size());
+        if (!result)
+    return result;
+        const std::size_t block_count = input_data.size() / BlockSize;
+        const uint32_t address = _is_block_address ? block : block * BlockSize;
+        bool is_read = true;
+        _spi.select_cs(_cs_pin);
+        if (block_count == 1)
+        {
+            is_read = send_command(17, address) == 0 && receive_data(input_data);  // CMD17  READ_SINGLE_BLOCK
+        } else {
+            is_read = send_command(18, address) == 0;  // CMD18  READ_MULTIPLE_BLOCK
+            for (std::size_t i = 0; is_read && i < block_count; ++i)
+            {
+                is_read = receive_data(input_data.subspan(i * BlockSize, BlockSize));
+            }
+            send_command(12, 0);  // CMD12  STOP_TRANSMISSION  失敗したときも止める
+            is_read &= wait_ready(SdWriteTimeoutUs);
+        }
+        deselect();
+        if (!is_read)
+    return SC_ERROR_INFO(sc::ErrorCode::no_response, "SD card read failed");  // SDカードが応答しないか，データを送らなかった
+        return {};
+    }
+
+    //! @brief 連続したブロックに書く  2ブロック以上は，消去するブロック数を伝えてからCMD25でまとめて書く
+    //! @param block 最初のブロックの番号
+    //! @param output_data 書くデータ  BlockSizeの倍数のバイト数
+    //! @return 範囲外のとき，書けなかったときはエラー
+    sc::Result<void> SD::write_blocks(uint32_t block, sc::Span<const uint8_t> output_data) const
+    {
+        const sc::Result<void> result = check_range(block, output_data.size());
+        if (!result)
+    return result;
+        const std::size_t block_count = output_data.size() / BlockSize;
+        const uint32_t address = _is_block_address ? block : block * BlockSize;
+        bool is_written = true;
+        _spi.select_cs(_cs_pin);
+        if (block_count == 1)
+        {
+            is_written = send_command(24, address) == 0 && send_block(SdStartBlock, output_data.data());  // CMD24  WRITE_BLOCK
+        } else {
+            send_command(SdAppCommand | 23, static_cast<uint32_t>(block_count));  // ACMD23  SET_WR_BLK_ERASE_COUNT  先に消去させて速くする (失敗してもよい)
+            is_written = send_command(25, address) == 0;  // CMD25  WRITE_MULTIPLE_BLOCK
+            for (std::size_t i = 0; is_written && i < block_count; ++i)
+            {
+                is_written = send_block(SdStartMultiBlock, &output_data.data()[i * BlockSize]);
+            }
+            if (wait_ready(SdWriteTimeoutUs))
+            {
+                const uint8_t stop_token = SdStopMultiBlock;
+                _spi.write_blocking(sc::Span<const uint8_t>(&stop_token, 1));
+            } else {
+                is_written = false;
+            }
+        }
+        is_written &= wait_ready(SdWriteTimeoutUs);  // 書き込みが終わるまでMISOがLowになる
+        deselect();
+        if (!is_written)
+    return SC_ERROR_INFO(sc::ErrorCode::no_response, "SD card write failed");  // SDカードが応答しないか，データを受け取らなかった
+        return {};
+    }
+
+    uint32_t SD::get_block_num() const noexcept
+    {
+        return _block_num;
+    }
+
+    //! @brief SPIモードに切り替えて初期化し，アドレスの単位とブロックの数を確認する
+    sc::Result<void> SD::init()
+    {
+        const uint8_t dummy_clocks[10] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+        _spi.set_freq(SdInitFreq);
+        _spi.write_blocking(sc::Span<const uint8_t>(dummy_clocks));  // CSピンをHighにしたまま74クロック以上送ると，SDカードがコマンドを受け付ける
+        _spi.select_cs(_cs_pin);
+
+        uint8_t r1 = 0xFF;
+        for (int i = 0; i < 10 && r1 != SdIdle; ++i)
+        {
+            r1 = send_command(0, 0);  // CMD0  GO_IDLE_STATE  SPIモードになる
+        }
+        if (r1 != SdIdle)
+        {
+            deselect();
+    return SC_ERROR_INFO(sc::ErrorCode::no_response, "SD card did not respond");  // SDカードが入っていない
+        }
+
+        bool is_version2 = false;  // 物理層の仕様がVer.2.00以降か  (SDHC・SDXCはVer.2.00以降)
+        uint8_t response[4];
+        if (!(send_command(8, 0x1AA) & SdIllegalCommand))  // CMD8  SEND_IF_COND  2.7-3.6Vと確認用の0xAA
+        {
+            _spi.read_blocking(sc::Span<uint8_t>(response), 0xFF);
+            if ((response[2] & 0x0F) != 0x01 || response[3] != 0xAA)
+            {
+                deselect();
+    return SC_ERROR_INFO(sc::ErrorCode::wrong_device, "SD card does not support 3.3V");  // 電圧が合わないか，SDカードではない
+            }
+            is_version2 = true;
+        }
+
+        const uint64_t start_us = time_us_64();
+        do
+        {
+            r1 = send_command(SdAppCommand | 41, is_version2 ? (1U << 30) : 0);  // ACMD41  SD_SEND_OP_COND  Ver.2.00以降はSDHC・SDXCに対応していることを伝える
+        } while (r1 == SdIdle && time_us_64() - start_us < SdInitTimeoutUs);
+        if (r1 != 0)
+        {
+            deselect();
+    return SC_ERROR_INFO(sc::ErrorCode::no_response, "SD card did not finish initialization");  // 初期化が終わらない
+        }
+
+        _is_block_address = false;
+        if (is_version2 && send_command(58, 0) == 0)  // CMD58  READ_OCR
+        {
+            _spi.read_blocking(sc::Span<uint8_t>(response), 0xFF);
+            _is_block_address = response[0] & 0x40;  // CCS  SDHC・SDXC
+        }
+        if (!_is_block_address && send_command(16, BlockSize) != 0)  // CMD16  SET_BLOCKLEN  SDSCは512バイトに揃える
+        {
+            deselect();
+    return SC_ERROR_INFO(sc::ErrorCode::wrong_device, "SD card does not support 512-byte blocks");  // ブロックの大きさを変えられない
+        }
+
+        uint8_t csd[16];
+        const bool has_csd = send_command(9, 0) == 0 && receive_data(sc::Span<uint8_t>(csd));  // CMD9  SEND_CSD
+        deselect();
+        if (!has_csd)
+    return SC_ERROR_INFO(sc::ErrorCode::no_response, "SD card did not send CSD");  // 容量がわからない
+        if ((csd[0] >> 6) == 1)  // CSD Ver.2.0  (SDHC・SDXC)
+        {
+            const uint32_t c_size = (static_cast<uint32_t>(csd[7] & 0x3F) << 16) | (static_cast<uint32_t>(csd[8]) << 8) | csd[9];
+            _block_num = (c_size + 1) * 1024;
+        } else {  // CSD Ver.1.0  (SDSC)
+            const uint32_t read_bl_len = csd[5] & 0x0F;
+            const uint32_t c_size = (static_cast<uint32_t>(csd[6] & 0x03) << 10) | (static_cast<uint32_t>(csd[7]) << 2) | (csd[8] >> 6);
+            const uint32_t c_size_mult = ((csd[9] & 0x03) << 1) | (csd[10] >> 7);
+            _block_num = (c_size + 1) << (c_size_mult + 2 + read_bl_len - 9);
+        }
+
+        _spi.set_freq(_spi.get_freq());
+        return {};
+    }
+
+    //! @brief 読み書きするブロックがSDカードの中にあるかを確認
+    sc::Result<void> SD::check_range(uint32_t block, std::size_t size) const noexcept
+    {
+        if (!size || size % BlockSize)
+    return SC_ERROR_INFO(sc::ErrorCode::invalid_argument, "SD data size must be a multiple of BlockSize");  // ブロック単位でしか読み書きできない
+        if (_block_num < block || _block_num - block < size / BlockSize)
+    return SC_ERROR_INFO(sc::ErrorCode::invalid_argument, "SD block is out of range");  // SDカードの容量の外
+        return {};
+    }
+
+    //! @brief CSピンを戻し，SDカードがMISOを離すように1バイト送る
+    void SD::deselect() const
+    {
+        _spi.deselect_cs(_cs_pin);
+        receive_byte();
+    }
+
+    //! @brief 0xffを送りながら1バイト受信
+    uint8_t SD::receive_byte() const
+    {
+        uint8_t input_byte;
+        _spi.read_blocking(sc::Span<uint8_t>(&input_byte, 1), 0xFF);
+        return input_byte;
+    }
+
+    //! @brief SDカードがbusyでなくなる  (MISOがHighになる)  まで待つ
+    //! @param timeout_us 待つ時間 (μs)
+    //! @return 時間内に終わらなかったときはfalse
+    bool SD::wait_ready(uint64_t timeout_us) const
+    {
+        const uint64_t start_us = time_us_64();
+        while (receive_byte() != 0xFF)
+        {
+            if (timeout_us < time_us_64() - start_us)
+    return false;
+        }
+        return true;
+    }
+
+    //! @brief コマンドを送り，R1の応答を受信する  CSピンは選択しておくこと
+    //! @param command コマンドの番号  ACMDはSdAppCommandとのOR  (先にCMD55を送る)
+    //! @param argument 引数
+    //! @return R1  0は成功，0xffは応答なし
+    uint8_t SD::send_command(uint8_t command, uint32_t argument) const
+    {
+        if (command & SdAppCommand)
+        {
+            command &= ~SdAppCommand;
+            const uint8_t r1 = send_command(55, 0);  // CMD55  APP_CMD
+            if (1 < r1)
+    return r1;
+        }
+        if (command != 0 && command != 12)
+        {
+            wait_ready(SdWriteTimeoutUs);  // 前の書き込みが終わってから送る  (CMD0とCMD12は待たない)
+        }
+        const uint8_t crc = (command == 0) ? 0x95 : (command == 8) ? 0x87 : 0x01;  // SPIモードでCRCを確認するのはCMD0とCMD8のみ
+        const uint8_t frame[6] = {static_cast<uint8_t>(0x40 | command), static_cast<uint8_t>(argument >> 24), static_cast<uint8_t>(argument >> 16),
+            static_cast<uint8_t>(argument >> 8), static_cast<uint8_t>(argument), crc};
+        _spi.write_blocking(sc::Span<const uint8_t>(frame));
+        if (command == 12)
+        {
+            receive_byte();  // CMD12の後の1バイトは意味のないデータ
+        }
+        uint8_t r1 = 0xFF;
+        for (int i = 0; i < 10 && (r1 & 0x80); ++i)  // 応答は8バイト以内に来る
+        {
+            r1 = receive_byte();
+        }
+        return r1;
+    }
+
+    //! @brief データの始まりを待ち，データとCRCを受信する
+    //! @param input_data 受信したデータの保存先  (1ブロックかCSD)
+    //! @return 時間内にデータが始まらなかったときはfalse
+    bool SD::receive_data(sc::Span<uint8_t> input_data) const
+    {
+        const uint64_t start_us = time_us_64();
+        uint8_t token;
+        while ((token = receive_byte()) == 0xFF)
+        {
+            if (SdReadTimeoutUs < time_us_64() - start_us)
+    return false;
+        }
+        if (token != SdStartBlock)
+    return false;  // エラーのトークン
+        uint8_t crc[2];
+        _spi.read_blocking(input_data, 0xFF);
+        _spi.read_blocking(sc::Span<uint8_t>(crc), 0xFF);  // SPIモードではCRCを確認しない
+        return true;
+    }
+
+    //! @brief 1ブロックを送り，受け付けたかを確認する
+    //! @param token データの始まりのトークン
+    //! @param output_data 送信するデータ  BlockSizeバイト
+    //! @return SDカードが受け付けなかったときはfalse
+    bool SD::send_block(uint8_t token, const uint8_t* output_data) const
+    {
+        if (!wait_ready(SdWriteTimeoutUs))
+    return false;
+        static const uint8_t Crc[2] = {0xFF, 0xFF};  // SPIモードではCRCを確認しない
+        _spi.write_blocking(sc::Span<const uint8_t>(&token, 1));
+        _spi.write_blocking(sc::Span<const uint8_t>(output_data, BlockSize));
+        _spi.write_blocking(sc::Span<const uint8_t>(Crc));
+        return (receive_byte() & 0x1F) == 0x05;  // データレスポンス  受け付けた
+    }
+}
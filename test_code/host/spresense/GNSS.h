@@ -0,0 +1,95 @@
+#ifndef SC19_CODE_TEST_HOST_SPRESENSE_GNSS_H_
+#define SC19_CODE_TEST_HOST_SPRESENSE_GNSS_H_
+
+/*************************************
+ *************************************
+
+
+PC上でspresense/gnss_trackerのファイルをビルドするための，Spresense SDKのGNSS.hの代わりです
+gnss_trackerが使うものだけを，Spresense SDKと同じ名前で用意しています
+
+
+*************************************
+*************************************/
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+//! @brief ArduinoのStringの代わり  (gnss_trackerが使う操作のみ)
+class String
+{
+    std::string _string;  // 文字列
+public:
+    String() = default;
+    String(const char* string): _string(string) {}
+
+    String& operator=(const char* string) {_string = string; return *this;}
+    String& operator+=(const char* string) {_string += string; return *this;}
+    String& operator+=(const String& string) {_string += string._string; return *this;}
+
+    const char* c_str() const noexcept {return _string.c_str();}
+    unsigned int length() const noexcept {return static_cast<unsigned int>(_string.size());}
+};
+
+//! @brief 測位の種類
+enum SpPvtType
+{
+    SpPvtTypeNone = 0,  // 測位していない
+    SpPvtTypeGnss,  // GNSSで測位した
+    SpPvtTypeUser  // ユーザが設定した
+};
+
+//! @brief 測位のモード
+enum SpFixMode
+{
+    FixInvalid = 1,  // 測位できていない
+    Fix2D,  // 2次元で測位した
+    Fix3D  // 3次元で測位した
+};
+
+//! @brief 時刻 (UTC)
+struct SpGnssTime
+{
+    unsigned short year;  // 年
+    unsigned char month;  // 月
+    unsigned char day;  // 日
+    unsigned char hour;  // 時
+    unsigned char minute;  // 分
+    unsigned char sec;  // 秒
+    unsigned long usec;  // マイクロ秒
+};
+
+//! @brief 測位結果  (Spresense SDKのSpNavDataと同じ名前のメンバ)
+class SpNavData
+{
+public:
+    static constexpr unsigned int MaxSatelliteNum = 24;  // 保存できる衛星の数
+
+    SpGnssTime time;  // 時刻
+    unsigned char type;  // 測位の種類  SpPvtType
+    unsigned char numSatellites;  // 見えている衛星の数
+    unsigned char numSatellitesCalcPos;  // 測位に使った衛星の数
+    double latitude;  // 緯度 (度)
+    double longitude;  // 経度 (度)
+    double altitude;  // 高度 (m)
+    float velocity;  // 速度 (m/s)
+    float direction;  // 進行方向 (度)
+    float pdop;  // 位置精度低下率
+    float hdop;  // 水平精度低下率
+    float vdop;  // 垂直精度低下率
+    float tdop;  // 時刻精度低下率
+    unsigned char posFixMode;  // 測位のモード  SpFixMode
+    unsigned char posDataExist;  // 位置が求まっているか
+    unsigned short satelliteIds[MaxSatelliteNum];  // 見えている衛星の番号
+
+    //! @brief 見えている衛星の番号を取得
+    //! @param index 衛星の番号  0からnumSatellites-1まで
+    unsigned long getSatelliteId(unsigned long index) const noexcept
+    {
+        return index < MaxSatelliteNum ? satelliteIds[index] : 0;
+    }
+};
+
+#endif  // SC19_CODE_TEST_HOST_SPRESENSE_GNSS_H_
@@ -0,0 +1,47 @@
+#include "gnss_log_host.h"
+
+namespace
+{
+    //! @brief ファイルを追記用に開く
+    //! @return ファイルの大きさ  開けなかったときは-1
+    long host_open(void* context, const char* name)
+    {
+        std::FILE*& file = *static_cast<std::FILE**>(context);
+        file = std::fopen(name, "ab");
+        if (!file)
+    return -1;  // 開けなかった
+        if (std::fseek(file, 0, SEEK_END) != 0)
+        {
+            std::fclose(file);
+            file = nullptr;
+    return -1;  // 末尾に移動できなかった
+        }
+        return std::ftell(file);
+    }
+
+    //! @brief ファイルの末尾に書き出す
+    //! @return 書き出したバイト数
+    unsigned long host_write(void* context, const char* data, unsigned long size)
+    {
+        return static_cast<unsigned long>(std::fwrite(data, 1, size, *static_cast<std::FILE**>(context)));
+    }
+
+    //! @brief 書き出したデータをOSに渡す
+    bool host_flush(void* context)
+    {
+        return std::fflush(*static_cast<std::FILE**>(context)) == 0;
+    }
+
+    //! @brief ファイルを閉じる
+    void host_close(void* context)
+    {
+        std::FILE*& file = *static_cast<std::FILE**>(context);
+        std::fclose(file);
+        file = nullptr;
+    }
+}
+
+LogBackend get_host_log_backend(std::FILE*& file) noexcept
+{
+    return LogBackend{&file, host_open, host_write, host_flush, host_close};
+}
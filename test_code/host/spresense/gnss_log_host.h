@@ -0,0 +1,23 @@
+#ifndef SC19_CODE_TEST_HOST_SPRESENSE_GNSS_LOG_HOST_H_
+#define SC19_CODE_TEST_HOST_SPRESENSE_GNSS_LOG_HOST_H_
+
+/*************************************
+ *************************************
+
+
+PC上でspresense/gnss_trackerのログ(gnss_log.h)を試すための，PCのファイルに書き出すLogBackendです
+SDカードの代わりに，std::FILEで開いたファイルに追記します
+
+
+*************************************
+*************************************/
+
+#include <cstdio>
+#include "gnss_log.h"
+
+//! @brief PCのファイルに追記するLogBackendを作る
+//! @param file 開いたファイルを入れる場所  ログを閉じるまで残しておくこと
+//! @return OpenAppendFile()とOpenRecordFile()に渡すLogBackend
+LogBackend get_host_log_backend(std::FILE*& file) noexcept;
+
+#endif  // SC19_CODE_TEST_HOST_SPRESENSE_GNSS_LOG_HOST_H_
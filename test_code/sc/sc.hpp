@@ -13,15 +13,56 @@
 *************************************/
 
 #define _USE_MATH_DEFINES  // 円周率などの定数を使用する  math.hを読み込む前に定義する必要がある (math.hはcmathやiostreamに含まれる)
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cfloat>
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <deque>
 #include <initializer_list>
 #include <iostream>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
 #include <string>
-#include <unordered_map>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+// ログの1レコードに入る文字数  これより長いログは複数のレコードに分けて記録します
+#ifndef SC_LOG_RECORD_SIZE
+#define SC_LOG_RECORD_SIZE 96
+#endif
+
+// 非同期モードでのログのレコード数 (2のべき乗)  コンパイル時に -DSC_LOG_BUFFER_SIZE=64 のようにして変更できます
+#ifndef SC_LOG_BUFFER_SIZE
+#define SC_LOG_BUFFER_SIZE 32
+#endif
+
+// ピンのエッジの記録を保存する数 (2のべき乗)  コンパイル時に -DSC_PIN_EDGE_BUFFER_SIZE=64 のようにして変更できます
+#ifndef SC_PIN_EDGE_BUFFER_SIZE
+#define SC_PIN_EDGE_BUFFER_SIZE 16
+#endif
+
+// 例外が有効か  -fno-exceptionsでビルドした場合は，エラーのときに例外を投げる代わりにログを記録して停止します
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS)
+#define SC_EXCEPTIONS 1
+#endif
+
+// エラーの種類と発生した場所をsc::ErrorInfoとして作成  例：return SC_ERROR_INFO(sc::ErrorCode::no_response, "I2C device did not respond");
+#define SC_ERROR_INFO(code, message) (::sc::ErrorInfo{code, __FILE__, static_cast<uint16_t>(__LINE__), message})
+
+// 記録するログの最低の重要度  0:debug 1:info 2:warning 3:error  コンパイル時に -DSC_LOG_LEVEL=0 のようにして変更できます
+#ifndef SC_LOG_LEVEL
+#define SC_LOG_LEVEL 1
+#endif
+
 //! @file sc.hpp
 //! @brief プログラム全体で共通の，基本的な機能
 //! @date 2023-10-29T15:29
@@ -46,29 +87,273 @@ namespace sc
         const char* what() const noexcept override;
     };
 
+    //! @brief エラーの種類
+    enum class ErrorCode : uint8_t
+    {
+        invalid_argument,  // 引数の値が範囲外
+        not_found,  // 取得しようとした値が保存されていない
+        no_response,  // 通信先のデバイスが応答しない
+        wrong_device,  // 通信先のデバイスが想定と違う
+        buffer_too_small,  // 保存先が小さすぎる
+        read_only  // 書き込みできない
+    };
+
+    //! @brief エラーの種類と発生した場所
+    //! 全てコンパイル時に決まる値なので，作るだけならヒープも文字列の操作も使いません．SC_ERROR_INFOで作成してください．
+    struct ErrorInfo
+    {
+        ErrorCode code;  // エラーの種類
+        const char* file;  // エラーが発生したファイル
+        uint16_t line;  // エラーが発生した行
+        const char* message;  // エラーメッセージ
+        void log() const noexcept;
+    };
+
+    [[noreturn]] void raise(const ErrorInfo& error_info);
+
+    //! @brief 値かエラーのどちらかを保存  (std::expectedの代わり)
+    //! 例外を投げずにエラーを返すために使います．value()でエラーを取り出そうとした場合のみ，例外を投げます．
+    template<typename T>
+    class Result
+    {
+        bool _has_value;  // 値を保存しているか
+        union
+        {
+            T _value;  // 保存している値
+            ErrorInfo _error;  // 保存しているエラー
+        };
+    public:
+        Result(const T& value): _has_value(true), _value(value) {}
+        Result(T&& value): _has_value(true), _value(std::move(value)) {}
+        Result(const ErrorInfo& error) noexcept: _has_value(false), _error(error) {}
+        Result(const Result& result): _has_value(result._has_value)
+        {
+            if (_has_value) new (&_value) T(result._value);
+            else new (&_error) ErrorInfo(result._error);
+        }
+        Result(Result&& result): _has_value(result._has_value)
+        {
+            if (_has_value) new (&_value) T(std::move(result._value));
+            else new (&_error) ErrorInfo(result._error);
+        }
+        Result& operator=(const Result&) = delete;
+        ~Result() {if (_has_value) _value.~T();}
+
+        bool has_value() const noexcept {return _has_value;}
+        explicit operator bool() const noexcept {return _has_value;}
+
+        //! @brief 値を取得  エラーのときはraise()します
+        T& value() & {if (!_has_value) raise(_error); return _value;}
+        //! @brief 値を取得  エラーのときはraise()します
+        const T& value() const & {if (!_has_value) raise(_error); return _value;}
+        //! @brief 値を取得  エラーのときはraise()します
+        T&& value() && {if (!_has_value) raise(_error); return std::move(_value);}
+        //! @brief 値を取得  エラーのときは代わりの値を返します
+        T value_or(const T& default_value) const {return (_has_value ? _value : default_value);}
+        //! @brief エラーを取得  (エラーのときのみ呼び出せます)
+        const ErrorInfo& error() const noexcept {return _error;}
+    };
+
+    //! @brief 値を返さない処理の成功かエラーを保存
+    template<>
+    class Result<void>
+    {
+        bool _has_value = true;  // 成功したか
+        ErrorInfo _error{};  // 保存しているエラー
+    public:
+        Result() noexcept = default;
+        Result(const ErrorInfo& error) noexcept: _has_value(false), _error(error) {}
+
+        bool has_value() const noexcept {return _has_value;}
+        explicit operator bool() const noexcept {return _has_value;}
+
+        //! @brief エラーのときはraise()します
+        void value() const {if (!_has_value) raise(_error);}
+        //! @brief エラーを取得  (エラーのときのみ呼び出せます)
+        const ErrorInfo& error() const noexcept {return _error;}
+    };
+
     //! @brief ログを記録
+    //! 非同期モードでは，書式化した文字列を確保済みのレコードの循環バッファに入れるだけで戻ります．
+    //! 出力はflush()を呼ぶ側  (picoではコア1，PC上では別のスレッド)  が行います．
+    //! 複数のスレッド(コア)から書き込む場合は，set_lock()で排他する関数を設定してください．(pico::start_log_drain()とpico::launch_core1()が設定します)
     class Log
     {
     public:
+        //! @brief ログの重要度
+        enum class Level : uint8_t
+        {
+            debug,
+            info,
+            warning,
+            error
+        };
+        static constexpr Level MinLevel = static_cast<Level>(SC_LOG_LEVEL);  // これより重要度の低いログはコンパイル時に取り除かれる
+
+        //! @brief ログの出力形式
+        enum class Format : uint8_t
+        {
+            text,  // 書式化した文字列
+            binary  // 書式のIDと引数の生のバイト列  (PC上でhost::LogDecoderを使って文字列に戻します)
+        };
+
+        //! @brief バイナリ形式での1レコードの種類  (先頭の1バイト  次の1バイトは続くデータのバイト数)
+        enum class RecordType : uint8_t
+        {
+            text = 0xa1,  // 文字列
+            format = 0xa2,  // 書式の定義  書式のID(1バイト)と書式の文字列
+            event = 0xa3  // 書式を使ったログ  書式のID(1バイト)と引数
+        };
+
+        //! @brief バイナリ形式での引数の種類  (引数ごとに先頭の1バイト)
+        enum class ArgType : uint8_t
+        {
+            int32 = 1,
+            uint32,
+            int64,
+            uint64,
+            float32,
+            float64,
+            string,  // 文字数(1バイト)と文字列
+            pointer  // 8バイト
+        };
+
         static void write(const std::string& log) noexcept;
 
         //! @brief printfの形式でログを記録
+        //! @tparam LogLevel ログの重要度  MinLevelより低い場合は何もしません
         //! @param format フォーマット文字列
         //! @param args フォーマット文字列に埋め込む値
-        template<typename... Args>
-        static void write(const std::string& format, Args... args) noexcept
+        template<Level LogLevel = Level::info, typename... Args>
+        static void write(const char* format, Args... args) noexcept
         {
-            try
+            if constexpr (LogLevel >= MinLevel)
             {
-                const size_t formatted_chars_num = std::snprintf(nullptr, 0, format.c_str(), args...);  // フォーマット後の文字数を計算
-                char formatted_chars[formatted_chars_num + 1];  // フォーマット済みの文字列を保存するための配列を作成
-                std::snprintf(&formatted_chars[0], formatted_chars_num + 1, format.c_str(), args...);  // フォーマットを実行
-                Log::write(formatted_chars);  // ログを記録
+                if constexpr (sizeof...(Args) == 0)
+                {
+                    post(format, std::strlen(format));  // 書式化が不要な場合はそのまま記録
+                }
+                else
+                {
+                    if (get_format() == Format::binary)
+                    {
+                        uint8_t record[2 + UINT8_MAX];
+                        uint8_t* record_end = record + 3;  // 種類・バイト数・書式のIDの後ろに引数を書き込む
+                        if ((encode_arg(record_end, record + sizeof(record), args) && ...) && post_event(format, record, record_end - record))
+    return;
+                        // 書式の表が満杯のときや，引数が大きすぎるときは文字列として記録する
+                    }
+                    char formatted_chars[SC_LOG_RECORD_SIZE];  // ほとんどのログはこの大きさに収まるので，1回の書式化で済む
+                    const int formatted_chars_num = std::snprintf(formatted_chars, sizeof(formatted_chars), format, args...);
+                    if (formatted_chars_num < 0)
+    return;
+                    if (static_cast<std::size_t>(formatted_chars_num) < sizeof(formatted_chars))
+                    {
+                        post(formatted_chars, formatted_chars_num);
+                    }
+                    else
+                    {
+#ifdef SC_EXCEPTIONS
+                        try
+                        {
+#endif
+                            std::string long_chars(formatted_chars_num, '\0');  // 収まらない場合のみヒープに確保して書式化し直す
+                            std::snprintf(&long_chars[0], formatted_chars_num + 1, format, args...);
+                            post(long_chars.data(), long_chars.size());
+#ifdef SC_EXCEPTIONS
+                        }
+                        catch(const std::exception& e) {Error(__FILE__, __LINE__, "Failed to save log", e);}  // ログの保存に失敗しました
+#endif
+                    }
+                }
             }
-            catch(const std::exception& e) {Error(__FILE__, __LINE__, "Failed to save log", e);}  // ログの保存に失敗しました
         }
         // この関数は以下の資料を参考にて作成しました
         // https://pyopyopyo.hatenablog.com/entry/2019/02/08/102456
+
+        //! @brief 重要度debugのログを記録
+        template<typename... Args> static void debug(const char* format, Args... args) noexcept {write<Level::debug>(format, args...);}
+        //! @brief 重要度infoのログを記録
+        template<typename... Args> static void info(const char* format, Args... args) noexcept {write<Level::info>(format, args...);}
+        //! @brief 重要度warningのログを記録
+        template<typename... Args> static void warning(const char* format, Args... args) noexcept {write<Level::warning>(format, args...);}
+        //! @brief 重要度errorのログを記録
+        template<typename... Args> static void error(const char* format, Args... args) noexcept {write<Level::error>(format, args...);}
+
+        static void set_format(Format format) noexcept;
+        static Format get_format() noexcept;
+        static void set_async(bool is_async) noexcept;
+        static bool is_async() noexcept;
+        static std::size_t flush() noexcept;
+        static std::size_t get_dropped_count() noexcept;
+        static void set_lock(uint32_t (*lock)(), void (*unlock)(uint32_t)) noexcept;
+
+        static void output(const char* log, std::size_t size) noexcept;  // ログを実際に出力する関数 (外部で定義してください)
+    private:
+        static void post(const char* log, std::size_t size) noexcept;
+        static bool post_event(const char* format, uint8_t* record, std::size_t size) noexcept;
+        static bool enqueue(const void* data, std::size_t size) noexcept;
+
+        //! @brief バイナリ形式で引数を1つ書き込む
+        //! @param record_end 書き込む位置  書き込んだ分だけ進めます
+        //! @param record_limit 書き込める範囲の終端
+        //! @param value 書き込む値
+        //! @return 書き込めたらtrue  範囲に収まらなければfalse
+        template<typename T>
+        static bool encode_arg(uint8_t*& record_end, const uint8_t* record_limit, T value) noexcept
+        {
+            if constexpr (std::is_same_v<T, const char*> || std::is_same_v<T, char*>)
+            {
+                if (record_limit - record_end < 2)
+    return false;
+                const std::size_t length = std::min<std::size_t>(std::strlen(value), record_limit - record_end - 2);  // 収まらない分は切り捨てる
+                *record_end++ = static_cast<uint8_t>(ArgType::string);
+                *record_end++ = static_cast<uint8_t>(length);
+                std::memcpy(record_end, value, length);
+                record_end += length;
+                return true;
+            }
+            else if constexpr (std::is_pointer_v<T>)
+            {
+                return encode_raw(record_end, record_limit, ArgType::pointer, static_cast<uint64_t>(reinterpret_cast<uintptr_t>(value)));
+            }
+            else if constexpr (std::is_enum_v<T>)
+            {
+                return encode_arg(record_end, record_limit, static_cast<std::underlying_type_t<T>>(value));
+            }
+            else if constexpr (std::is_floating_point_v<T>)
+            {
+                if constexpr (sizeof(T) == sizeof(float)) return encode_raw(record_end, record_limit, ArgType::float32, value);  // floatはdoubleに変換せずにそのまま書き込む (FPUのないpicoでは変換も重い)
+                else return encode_raw(record_end, record_limit, ArgType::float64, static_cast<double>(value));
+            }
+            else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+            {
+                if constexpr (sizeof(T) <= sizeof(int32_t)) return encode_raw(record_end, record_limit, ArgType::int32, static_cast<int32_t>(value));
+                else return encode_raw(record_end, record_limit, ArgType::int64, static_cast<int64_t>(value));
+            }
+            else if constexpr (std::is_integral_v<T>)
+            {
+                if constexpr (sizeof(T) <= sizeof(uint32_t)) return encode_raw(record_end, record_limit, ArgType::uint32, static_cast<uint32_t>(value));
+                else return encode_raw(record_end, record_limit, ArgType::uint64, static_cast<uint64_t>(value));
+            }
+            else
+            {
+                static_assert(sizeof(T) == 0, "\n\n<!ERROR!> This type cannot be written to the log\n\n");  // この型はログに書き込めません
+                return false;
+            }
+        }
+
+        //! @brief 引数の種類と値のバイト列(リトルエンディアン)を書き込む
+        template<typename T>
+        static bool encode_raw(uint8_t*& record_end, const uint8_t* record_limit, ArgType arg_type, T value) noexcept
+        {
+            if (record_limit - record_end < static_cast<std::ptrdiff_t>(1 + sizeof(T)))
+    return false;
+            *record_end++ = static_cast<uint8_t>(arg_type);
+            std::memcpy(record_end, &value, sizeof(T));  // picoもPCもリトルエンディアンなのでそのままコピーする
+            record_end += sizeof(T);
+            return true;
+        }
     };
 
     //! @brief ゼロ除算防止
@@ -97,21 +382,86 @@ namespace sc
     /*****************測定値および変換******************/
     /**************************************************/
 
+    //! @brief 連続したメモリ上の配列を，所有せずに参照する
+    //! C++17にはstd::spanがないため，その代わりに使います．参照先の配列はSpanより長く生存している必要があります．
+    template<typename T>
+    class Span
+    {
+        T* _data;  // 参照している配列の先頭
+        std::size_t _size;  // 参照している要素数
+    public:
+        constexpr Span() noexcept:
+            _data(nullptr), _size(0) {}
+
+        //! @brief 配列を参照
+        //! @param data 配列の先頭
+        //! @param size 要素数
+        constexpr Span(T* data, std::size_t size) noexcept:
+            _data(data), _size(size) {}
+
+        //! @brief 配列を参照
+        //! @param data 配列
+        template<std::size_t Size>
+        constexpr Span(T (&data)[Size]) noexcept:
+            _data(data), _size(Size) {}
+
+        //! @brief Span<uint8_t>からSpan<const uint8_t>のように変換
+        template<typename U, typename = std::enable_if_t<std::is_convertible<U(*)[], T(*)[]>::value>>
+        constexpr Span(const Span<U>& span) noexcept:
+            _data(span.data()), _size(span.size()) {}
+
+        constexpr T* data() const noexcept {return _data;}
+        constexpr std::size_t size() const noexcept {return _size;}
+        constexpr bool empty() const noexcept {return _size == 0;}
+        constexpr T* begin() const noexcept {return _data;}
+        constexpr T* end() const noexcept {return _data + _size;}
+        constexpr T& operator[](std::size_t index) const noexcept {return _data[index];}
+
+        //! @brief 一部分を参照
+        //! @param offset 先頭からいくつ後の要素から参照するか
+        //! @param count 参照する要素数
+        constexpr Span subspan(std::size_t offset, std::size_t count) const noexcept
+        {
+            return Span(_data + offset, count);
+        }
+    };
+
     //! @brief 通信用のバイト列
+    //! InlineCapacity バイト以下のデータはクラス内の配列に保存し，ヒープを使用しません．
+    //! コピーはできず，ムーブのみ可能です．view_of で作成した場合は呼び出し元の配列を参照するだけで，コピーしません．
     class Binary
     {
-        const std::vector<uint8_t> _binary_data;  // バイト列のデータ
+    public:
+        static constexpr std::size_t InlineCapacity = 32;  // ヒープを使わずに保存できる最大のバイト数
+    private:
+        //! @brief データの保存場所
+        enum class Storage
+        {
+            inline_data,  // クラス内の配列
+            heap_data,  // ヒープ (InlineCapacityを超える場合)
+            view  // 呼び出し元の配列 (所有しない)
+        };
+
+        Storage _storage;  // データの保存場所
+        std::size_t _size;  // バイト列のサイズ
+        const uint8_t* _data;  // データの先頭
+        std::unique_ptr<uint8_t[]> _heap_data;  // ヒープに確保したデータ
+        uint8_t _inline_data[InlineCapacity];  // クラス内に保存したデータ
+
+        Binary() noexcept:
+            _storage(Storage::view), _size(0), _data(nullptr) {}
+
+        uint8_t* allocate(std::size_t size);
     public:
         //! @brief バイト列を作成
         //! @param binary_data { }で囲んだデータ
         explicit Binary(const std::initializer_list<uint8_t>& binary_data):
-            _binary_data(binary_data) {}
+            Binary(binary_data.size(), binary_data.begin()) {}
 
         //! @brief バイト列を作成
         //! @param size 配列のサイズ
-        //! @param binary_data 配列
-        Binary(std::size_t size, uint8_t* binary_data):
-            _binary_data(binary_data, binary_data + size) {}
+        //! @param binary_data 配列  (コピーされます)
+        Binary(std::size_t size, const uint8_t* binary_data);
 
         //! @brief バイト列を作成
         //! @param binary_data 配列
@@ -121,29 +471,52 @@ namespace sc
 
         //! @brief バイト列を作成
         //! @param binary_data vectorの配列
-        explicit Binary(std::vector<uint8_t> binary_data):
-            _binary_data(binary_data) {}
+        explicit Binary(const std::vector<uint8_t>& binary_data):
+            Binary(binary_data.size(), binary_data.data()) {}
 
         //! @brief バイト列を作成
         //! @param binary_data deque型の値
-        explicit Binary(std::deque<uint8_t> binary_data):
-            _binary_data(binary_data.begin(), binary_data.end()) {}
+        explicit Binary(const std::deque<uint8_t>& binary_data);
+
+        //! @brief 0で埋められたバイト列を作成
+        //! @param size バイト数
+        //! 受信用のバッファとして使い，writable_data()に直接書き込みます．
+        explicit Binary(std::size_t size);
+
+        //! @brief 呼び出し元の配列をコピーせずに参照するバイト列を作成
+        //! @param binary_view 参照する配列  Binaryより長く生存している必要があります
+        static Binary view_of(Span<const uint8_t> binary_view) noexcept;
+
+        Binary(Binary&& old_binary) noexcept;
 
-        std::size_t size() const;
+        Binary& operator=(Binary&& old_binary) noexcept;
+
+        Binary(const Binary&) = delete;
+
+        Binary& operator=(const Binary&) = delete;
+
+        std::size_t size() const noexcept;
 
         const uint8_t at(std::size_t index) const;
 
         const uint8_t operator[](std::size_t index) const;
 
+        const uint8_t* data() const noexcept;
+
+        uint8_t* writable_data();
+
+        Span<const uint8_t> get_view() const noexcept;
+
+        bool is_view() const noexcept;
+
         std::vector<uint8_t> get_raw() const;
     };
 
     //! @brief 測定値に関するクラスの親クラス．
+    //! 子クラスはMeasurementにコピーして保存するため，仮想関数を持たずトリビアルにコピーできる必要があります．
     class Quantity
     {
     public:
-        virtual ~Quantity() = default;
-
         //! @brief データを通信用のバイト列に変換
         // 未実装
         // virtual Binary to_binary() const = 0;
@@ -154,25 +527,46 @@ namespace sc
             message,
             temperature,
             pressure,
-            humidity
+            humidity,
+            distance,
+            position,
+            time,
+            dop,
+            number_of_id  // IDの種類の数  (常に最後に置く)
         };
     };
 
     //! @brief 測定値をまとめて扱う
-    class Measurement : Noncopyable
+    //! Quantity::IDごとに固定の保存場所を持ち，ヒープやRTTIを使わずに保存・取得します．
+    class Measurement
     {
-        std::unordered_map<Quantity::ID, Quantity*> _measurement;  // 測定値をまとめたデータ
+        static constexpr std::size_t IDNum = static_cast<std::size_t>(Quantity::ID::number_of_id);  // IDの種類の数
+        static constexpr std::size_t SlotSize = 16;  // 1つの測定値を保存できる最大のバイト数
+        static_assert(IDNum <= 32, "\n\n<!ERROR!> Too many Quantity::ID for Measurement\n\n");  // IDが多すぎてMeasurementで扱えません
 
-        //! @brief 再起関数を使い，最初の要素からmapに入れて初期化
-        template<class FirstQuantity, class... RestQuantitys>
-        void init_first(const FirstQuantity& first_quantity, const RestQuantitys... rest_quantitys)
+        //! @brief 1種類の測定値の保存場所
+        struct Slot
         {
-            if (_measurement.count(FirstQuantity::id()))
-            {
-                delete _measurement.at(FirstQuantity::id());
-            }
-            _measurement[FirstQuantity::id()] = new FirstQuantity(first_quantity);
+            alignas(8) unsigned char data[SlotSize];
+        };
+
+        Slot _slots[IDNum];  // ID順に並べた測定値の保存場所
+        uint32_t _existing_ids = 0;  // 保存されている測定値のIDのビット
+
+        //! @brief IDから保存場所の番号を取得
+        template<class QuantityDerived>
+        static constexpr std::size_t index() noexcept
+        {
+            static_assert(std::is_base_of<Quantity, QuantityDerived>::value, "\n\n<!ERROR!> The Measurement class can only handle values of child classes of type Quantity\n\n");  // MeasurementクラスではQuantity型の子クラスの値しか扱えません
+            static_assert(std::is_trivially_copyable<QuantityDerived>::value && sizeof(QuantityDerived) <= SlotSize, "\n\n<!ERROR!> Quantity is too large or not trivially copyable\n\n");  // Measurementに保存できないQuantity型です
+            return static_cast<std::size_t>(QuantityDerived::id());
+        }
 
+        //! @brief 再起関数を使い，最初の要素から保存
+        template<class FirstQuantity, class... RestQuantitys>
+        void init_first(const FirstQuantity& first_quantity, const RestQuantitys&... rest_quantitys)
+        {
+            set(first_quantity);
             init_first(rest_quantitys...);
         }
 
@@ -183,66 +577,843 @@ namespace sc
         template<class... QuantityDeriveds>
         explicit Measurement(const QuantityDeriveds&... quantity_deriveds)
         {
-            static_assert(std::conjunction<std::is_base_of<Quantity, QuantityDeriveds>...>::value, "\n\n<!ERROR!> The Measurement class can only handle values of child classes of type Quantity\n\n");  // MeasurementクラスではQuantity型の子クラスの値しか扱えません
-            
             init_first(quantity_deriveds...);
         }
 
-        Measurement(Measurement&& old_measurement);
+        //! @brief 測定値を保存  同じ種類の測定値があれば上書き
+        //! @param quantity_derived 保存したい測定値
+        template<class QuantityDerived>
+        void set(const QuantityDerived& quantity_derived) noexcept
+        {
+            constexpr std::size_t Index = index<QuantityDerived>();
+            new (_slots[Index].data) QuantityDerived(quantity_derived);
+            _existing_ids |= (1UL << Index);
+        }
 
-        Measurement& operator=(Measurement&& old_measurement);
+        //! @brief 測定値が保存されているかを確認
+        template<class QuantityDerived>
+        bool contains() const noexcept
+        {
+            return _existing_ids & (1UL << index<QuantityDerived>());
+        }
 
-        ~Measurement();
+        //! @brief 保存してある測定値を消去  (GNSSの測位が途切れたときなど)
+        template<class QuantityDerived>
+        void erase() noexcept
+        {
+            _existing_ids &= ~(1UL << index<QuantityDerived>());
+        }
 
         //! @brief 保存してある測定値を取得
         template<class QuantityDerived>
         QuantityDerived get() const
         {
-            static_assert(std::is_base_of<Quantity, QuantityDerived>::value, "\n\n<!ERROR!> The Measurement class can only handle values of child classes of type Quantity\n\n");  // MeasurementクラスではQuantity型の子クラスの値しか扱えません
-
-            return *dynamic_cast<QuantityDerived*>(_measurement.at(QuantityDerived::id()));
+            constexpr std::size_t Index = index<QuantityDerived>();
+            if (!(_existing_ids & (1UL << Index)))
+            {
+                raise(SC_ERROR_INFO(ErrorCode::not_found, "The quantity has not been measured."));  // 取得しようとした測定値は保存されていません
+            }
+            return *std::launder(reinterpret_cast<const QuantityDerived*>(_slots[Index].data));
         }
 
         // 未実装
         // Binary to_binary() const;
     };
 
-    //! @brief 気温の値の保存，操作．
-    //! 単位：℃
-    class Temperature final : public Quantity
-    {
-        const float _temperature;  // 気温データ
-    public:
-        static constexpr ID id() {return ID::temperature;}
-        explicit Temperature(float temperature);
-        float get() const noexcept;
-    };
+    //! @brief 気温の値の保存，操作．
+    //! 単位：℃
+    //! 0.01℃単位の整数で保存します．センサの補正の計算を整数だけで行えば，FPUのないpicoでも浮動小数点数の計算は表示するとき(get())だけになります．
+    class Temperature final : public Quantity
+    {
+        const int32_t _centi_temperature;  // 気温データ (0.01℃)
+    public:
+        static constexpr ID id() {return ID::temperature;}
+        explicit Temperature(float temperature);
+        static Result<Temperature> create(float temperature) noexcept;
+        static Temperature from_centi(int32_t centi_temperature);
+        static Result<Temperature> create_centi(int32_t centi_temperature) noexcept;
+        float get() const noexcept;
+        int32_t get_centi() const noexcept;
+    private:
+        //! @brief 0.01℃単位の値から構築するための目印  (floatの値から構築するコンストラクタと区別する)
+        struct Centi
+        {
+            int32_t value;
+        };
+
+        explicit Temperature(Centi centi_temperature) noexcept;
+        static bool is_valid(float temperature) noexcept;
+        static bool is_valid_centi(int32_t centi_temperature) noexcept;
+    };
+
+    //! @brief 気圧の値の保存，操作．
+    //! 単位：hPa
+    class Pressure final : public Quantity
+    {
+        const float _pressure;  // 気圧データ
+    public:
+        static constexpr ID id() {return ID::pressure;}
+        explicit Pressure(float pressure);
+        static Result<Pressure> create(float pressure) noexcept;
+        float get() const noexcept;
+    private:
+        static bool is_valid(float pressure) noexcept;
+    };
+
+    //! @brief 湿度の値の保存，操作．
+    //! 単位：%
+    class Humidity final : public Quantity
+    {
+        const float _humidity;  // 湿度データ
+    public:
+        static constexpr ID id() {return ID::humidity;}
+        explicit Humidity(float humidity);
+        static Result<Humidity> create(float humidity) noexcept;
+        float get() const noexcept;
+    private:
+        static bool is_valid(float humidity) noexcept;
+    };
+
+    //! @brief 距離の値の保存，操作．
+    //! 単位：cm
+    class Distance final : public Quantity
+    {
+        const float _distance;  // 距離データ
+    public:
+        static constexpr ID id() {return ID::distance;}
+        explicit Distance(float distance);
+        static Result<Distance> create(float distance) noexcept;
+        float get() const noexcept;
+    private:
+        static bool is_valid(float distance) noexcept;
+    };
+
+    //! @brief GNSSで測位した位置の保存，操作．
+    //! 単位：緯度・経度は1e-7度，高度(平均海面からの高さ)はmm
+    //! floatでは緯度・経度の精度(約1m)が足りないため，整数で保存します．
+    class Position final : public Quantity
+    {
+        const int32_t _latitude_e7;  // 緯度 (1e-7度)  北が正
+        const int32_t _longitude_e7;  // 経度 (1e-7度)  東が正
+        const int32_t _altitude_mm;  // 高度 (mm)
+    public:
+        static constexpr ID id() {return ID::position;}
+        static Position from_e7(int32_t latitude_e7, int32_t longitude_e7, int32_t altitude_mm);
+        static Result<Position> create_e7(int32_t latitude_e7, int32_t longitude_e7, int32_t altitude_mm) noexcept;
+        double get_latitude() const noexcept;
+        double get_longitude() const noexcept;
+        float get_altitude() const noexcept;
+        int32_t get_latitude_e7() const noexcept;
+        int32_t get_longitude_e7() const noexcept;
+        int32_t get_altitude_mm() const noexcept;
+    private:
+        Position(int32_t latitude_e7, int32_t longitude_e7, int32_t altitude_mm) noexcept;
+        static bool is_valid_e7(int32_t latitude_e7, int32_t longitude_e7, int32_t altitude_mm) noexcept;
+    };
+
+    //! @brief GNSSで受信した時刻(UTC)の保存，操作．
+    //! 日付は受信していない(NMEAのGGAのみの)場合があるため，has_date()で確認してください．
+    class Time final : public Quantity
+    {
+        const uint32_t _millisecond_of_day;  // 0時からの時間 (ms)
+        const uint16_t _year;  // 年  日付がないときは0
+        const uint8_t _month;  // 月
+        const uint8_t _day;  // 日
+    public:
+        static constexpr ID id() {return ID::time;}
+        static Time from_millisecond(uint32_t millisecond_of_day, uint16_t year = 0, uint8_t month = 0, uint8_t day = 0);
+        static Result<Time> create(uint32_t millisecond_of_day, uint16_t year = 0, uint8_t month = 0, uint8_t day = 0) noexcept;
+        uint32_t get_millisecond_of_day() const noexcept;
+        uint8_t get_hour() const noexcept;
+        uint8_t get_minute() const noexcept;
+        uint8_t get_second() const noexcept;
+        uint16_t get_millisecond() const noexcept;
+        bool has_date() const noexcept;
+        uint16_t get_year() const noexcept;
+        uint8_t get_month() const noexcept;
+        uint8_t get_day() const noexcept;
+    private:
+        Time(uint32_t millisecond_of_day, uint16_t year, uint8_t month, uint8_t day) noexcept;
+        static bool is_valid(uint32_t millisecond_of_day, uint16_t year, uint8_t month, uint8_t day) noexcept;
+    };
+
+    //! @brief GNSSの精度低下率(DOP)の保存，操作．
+    //! 単位：なし  0.01単位の整数で保存します．受信していない値はUnknownです．
+    class DOP final : public Quantity
+    {
+    public:
+        static constexpr uint16_t Unknown = UINT16_MAX;  // 受信していない値
+    private:
+        const uint16_t _centi_pdop;  // 位置精度低下率 (0.01)
+        const uint16_t _centi_hdop;  // 水平精度低下率 (0.01)
+        const uint16_t _centi_vdop;  // 垂直精度低下率 (0.01)
+    public:
+        static constexpr ID id() {return ID::dop;}
+        static DOP from_centi(uint16_t centi_pdop, uint16_t centi_hdop, uint16_t centi_vdop);
+        static Result<DOP> create_centi(uint16_t centi_pdop, uint16_t centi_hdop, uint16_t centi_vdop) noexcept;
+        float get_pdop() const noexcept;
+        float get_hdop() const noexcept;
+        float get_vdop() const noexcept;
+        uint16_t get_centi_pdop() const noexcept;
+        uint16_t get_centi_hdop() const noexcept;
+        uint16_t get_centi_vdop() const noexcept;
+    private:
+        DOP(uint16_t centi_pdop, uint16_t centi_hdop, uint16_t centi_vdop) noexcept;
+        static bool is_valid_centi(uint16_t centi_dop) noexcept;
+        static float to_float(uint16_t centi_dop) noexcept;
+    };
+    
+    /**************************************************/
+    /******************フィルタ・判定*******************/
+    /**************************************************/
+
+    // フィルタはどれも update(値) で1つの値を入れてフィルタ後の値を返し，get() で最新の値を，reset() で初期状態に戻します．
+    // 整数の型を使う場合，固定小数点数として扱います．(例えば，1/100℃単位のint32_t)
+    // ヒープは使用せず，窓の大きさはコンパイル時に決めます．
+
+    //! @brief 移動平均  窓の合計を保持し，1回の更新は窓の大きさによらず一定時間で終わります．
+    //! 浮動小数点数では，合計の丸め誤差がたまらないように，窓の一周ごとに足し算だけで求めた合計に置き換えます．
+    //! @tparam T 値の型
+    //! @tparam WindowSize 平均を取る値の数
+    //! @tparam Sum 合計の型  整数では溢れないように，大きな型を使います
+    template<typename T, std::size_t WindowSize, typename Sum = std::conditional_t<std::is_floating_point_v<T>, T, int64_t>>
+    class MovingAverage
+    {
+        static_assert(std::is_arithmetic_v<T>, "\n\n<!ERROR!> MovingAverage can only handle integer or floating point values\n\n");  // MovingAverageは整数か浮動小数点数しか扱えません
+        static_assert(WindowSize > 0, "\n\n<!ERROR!> The window size of MovingAverage must not be zero\n\n");  // MovingAverageの窓の大きさは1以上にしてください
+
+        T _window[WindowSize] = {};  // 窓に入っている値  _indexの位置が最も古い
+        Sum _sum = 0;  // 窓の値の合計
+        Sum _lap_sum = 0;  // 窓の今の周で入れた値の合計  (浮動小数点数のみ使用)
+        std::size_t _index = 0;  // 次に書き込む位置
+        std::size_t _count = 0;  // 窓に入っている値の数
+    public:
+        //! @brief 値を1つ入れる
+        //! @param value 新しい値
+        //! @return 窓の平均  窓が埋まるまでは，入れた値だけの平均
+        T update(T value) noexcept
+        {
+            _sum += static_cast<Sum>(value) - static_cast<Sum>(_window[_index]);  // 最も古い値と入れ替える  (埋まるまでは0と入れ替える)
+            _window[_index] = value;
+            if constexpr (std::is_floating_point_v<Sum>)
+            {
+                _lap_sum += value;
+            }
+            if (++_index == WindowSize)
+            {
+                _index = 0;
+                if constexpr (std::is_floating_point_v<Sum>)
+                {
+                    _sum = _lap_sum;  // 一周すると窓の値は全て今の周で入れた値になるので，引き算の誤差を含まない合計に置き換える
+                    _lap_sum = 0;
+                }
+            }
+            if (_count < WindowSize) ++_count;
+            return get();
+        }
+
+        //! @brief 窓の平均を取得
+        T get() const noexcept
+        {
+            if (!_count)
+    return T(0);
+            return static_cast<T>(_sum / static_cast<Sum>(_count));
+        }
+
+        //! @brief 窓を空にする
+        void reset() noexcept
+        {
+            std::fill(std::begin(_window), std::end(_window), T(0));
+            _sum = 0;
+            _lap_sum = 0;
+            _index = 0;
+            _count = 0;
+        }
+
+        //! @brief 窓に入っている値の数を取得
+        std::size_t size() const noexcept {return _count;}
+
+        static constexpr std::size_t window_size() noexcept {return WindowSize;}
+    };
+
+    //! @brief 指数移動平均  y += (x - y) / 2^Shift
+    //! 係数が2のべき乗の逆数なので，整数でも乗算・除算なしで計算できます．整数では，切り捨ての誤差が出ないよう内部でShiftビット多く持ちます．
+    //! @tparam T 値の型
+    //! @tparam Shift 係数の指数  大きいほど滑らか  (時定数は約2^Shift回)
+    template<typename T, unsigned Shift>
+    class ExponentialAverage
+    {
+        static_assert(std::is_arithmetic_v<T>, "\n\n<!ERROR!> ExponentialAverage can only handle integer or floating point values\n\n");  // ExponentialAverageは整数か浮動小数点数しか扱えません
+        static_assert(Shift < 16, "\n\n<!ERROR!> The shift of ExponentialAverage is too large\n\n");  // ExponentialAverageのShiftが大きすぎます
+        using State = std::conditional_t<std::is_floating_point_v<T>, T, int64_t>;  // 内部の値の型
+
+        State _state = 0;  // 平均  整数ではShiftビット左にずらして持つ
+        bool _is_started = false;  // 最初の値を入れたか
+    public:
+        //! @brief 値を1つ入れる
+        //! @param value 新しい値
+        //! @return 平均  最初の値はそのまま返す
+        T update(T value) noexcept
+        {
+            if (!_is_started)
+            {
+                _is_started = true;
+                _state = to_state(value);  // 0から立ち上がらないように，最初の値から始める
+            } else {
+                if constexpr (std::is_floating_point_v<T>)
+                {
+                    _state += (value - _state) * (T(1) / T(1UL << Shift));
+                } else {
+                    _state += static_cast<State>(value) - (_state >> Shift);  // 算術右シフト (C++20からは規格でも保証)
+                }
+            }
+            return get();
+        }
+
+        //! @brief 平均を取得
+        T get() const noexcept
+        {
+            if constexpr (std::is_floating_point_v<T>)
+            {
+                return _state;
+            } else {
+                return static_cast<T>(_state >> Shift);
+            }
+        }
+
+        //! @brief 最初の値を入れる前に戻す
+        void reset() noexcept
+        {
+            _state = 0;
+            _is_started = false;
+        }
+    private:
+        //! @brief 値を内部の値の型に直す
+        static State to_state(T value) noexcept
+        {
+            if constexpr (std::is_floating_point_v<T>)
+            {
+                return value;
+            } else {
+                return static_cast<State>(value) * (State(1) << Shift);
+            }
+        }
+    };
+
+    //! @brief 移動中央値  突発的な外れ値(超音波センサの誤反射など)を取り除きます．
+    //! 窓の値を並べ替えた状態で持ち，1回の更新では古い値を抜いて新しい値を挿入するだけです．(比較と移動は窓の大きさ分  3や5などの小さな窓向け)
+    //! @tparam T 値の型
+    //! NaNは入れないでください．(並べ替えられないため)
+    //! @tparam WindowSize 中央値を取る値の数  奇数
+    template<typename T, std::size_t WindowSize>
+    class MovingMedian
+    {
+        static_assert(std::is_arithmetic_v<T>, "\n\n<!ERROR!> MovingMedian can only handle integer or floating point values\n\n");  // MovingMedianは整数か浮動小数点数しか扱えません
+        static_assert(WindowSize % 2 == 1, "\n\n<!ERROR!> The window size of MovingMedian must be odd\n\n");  // MovingMedianの窓の大きさは奇数にしてください
+
+        T _window[WindowSize] = {};  // 入れた順の値  _indexの位置が最も古い
+        T _sorted[WindowSize] = {};  // 小さい順に並べた値  先頭の_count個が有効
+        std::size_t _index = 0;  // 次に書き込む位置
+        std::size_t _count = 0;  // 窓に入っている値の数
+    public:
+        //! @brief 値を1つ入れる
+        //! @param value 新しい値
+        //! @return 窓の中央値  窓が埋まるまでは，入れた値だけの中央値 (偶数個なら大きい方)
+        T update(T value) noexcept
+        {
+            std::size_t position = _count;  // 空いた位置
+            if (_count == WindowSize)
+            {
+                position = 0;
+                while (position < WindowSize - 1 && _sorted[position] != _window[_index])  // 最も古い値を抜く
+                {
+                    ++position;
+                }
+            } else {
+                ++_count;
+            }
+            while (position > 0 && value < _sorted[position - 1])  // 空いた位置から，新しい値が入る位置まで値をずらす
+            {
+                _sorted[position] = _sorted[position - 1];
+                --position;
+            }
+            while (position + 1 < _count && _sorted[position + 1] < value)
+            {
+                _sorted[position] = _sorted[position + 1];
+                ++position;
+            }
+            _sorted[position] = value;
+            _window[_index] = value;
+            if (++_index == WindowSize) _index = 0;
+            return get();
+        }
+
+        //! @brief 窓の中央値を取得
+        T get() const noexcept {return _sorted[_count / 2];}
+
+        //! @brief 窓を空にする
+        void reset() noexcept
+        {
+            _index = 0;
+            _count = 0;
+        }
+
+        //! @brief 窓に入っている値の数を取得
+        std::size_t size() const noexcept {return _count;}
+
+        static constexpr std::size_t window_size() noexcept {return WindowSize;}
+    };
+
+    //! @brief 1次のIIRフィルタ  y[n] = b0*x[n] + b1*x[n-1] - a1*y[n-1]
+    //! 整数では，係数をFractionBitsビットの固定小数点数にして，浮動小数点数の演算なしで計算します．
+    //! 出力もFractionBitsビット多く持つため，丸め誤差で出力が止まって入力に追いつかないことはありません．
+    //! @tparam T 値の型
+    //! @tparam FractionBits 整数のときの係数の小数部のビット数
+    template<typename T, unsigned FractionBits = 14>
+    class FirstOrderIIR
+    {
+        static_assert(std::is_arithmetic_v<T>, "\n\n<!ERROR!> FirstOrderIIR can only handle integer or floating point values\n\n");  // FirstOrderIIRは整数か浮動小数点数しか扱えません
+        static_assert(FractionBits <= 16, "\n\n<!ERROR!> The fraction bits of FirstOrderIIR are too many\n\n");  // FirstOrderIIRの小数部のビット数が多すぎます
+        static constexpr bool IsFloat = std::is_floating_point_v<T>;
+    public:
+        using Coefficient = std::conditional_t<IsFloat, T, int32_t>;  // 係数の型
+    private:
+        using Accumulator = std::conditional_t<IsFloat, T, int64_t>;  // 積和の型
+
+        Coefficient _b0, _b1, _a1;  // 係数
+        T _last_input = 0;  // 1つ前の入力
+        Accumulator _output = 0;  // 1つ前の出力  整数ではFractionBitsビット左にずらして持つ
+        bool _is_started = false;  // 最初の値を入れたか
+    public:
+        //! @brief 係数を指定してFirstOrderIIRを構築
+        //! @param b0, b1, a1 係数  整数の型でも小数で指定し，固定小数点数に直して使います
+        constexpr FirstOrderIIR(float b0, float b1, float a1) noexcept:
+            _b0(to_coefficient(b0)),
+            _b1(to_coefficient(b1)),
+            _a1(to_coefficient(a1)) {}
+
+        //! @brief 1次のローパスフィルタ(双一次変換)を作る
+        //! @param cutoff_hz 遮断周波数 (Hz)
+        //! @param sampling_hz 値を入れる周波数 (Hz)
+        static FirstOrderIIR low_pass(float cutoff_hz, float sampling_hz) noexcept
+        {
+            const float k = std::tan(static_cast<float>(M_PI) * cutoff_hz / sampling_hz);
+            return FirstOrderIIR(k / (1.0F + k), k / (1.0F + k), (k - 1.0F) / (k + 1.0F));
+        }
+
+        //! @brief 値を1つ入れる
+        //! @param value 新しい値
+        //! @return フィルタ後の値  最初の値は，その値が続いていたものとして計算する
+        T update(T value) noexcept
+        {
+            if (!_is_started)
+            {
+                _is_started = true;
+                _last_input = value;
+                _output = Accumulator(value) * (Accumulator(1) << (IsFloat ? 0 : FractionBits));  // 0から立ち上がらないように，最初の値が続いていたことにする (直流ゲインが1の場合)
+            }
+            if constexpr (IsFloat)
+            {
+                _output = _b0 * value + _b1 * _last_input - _a1 * _output;
+            } else {
+                _output = Accumulator(_b0) * value + Accumulator(_b1) * _last_input - ((Accumulator(_a1) * _output) >> FractionBits);
+            }
+            _last_input = value;
+            return get();
+        }
+
+        //! @brief フィルタ後の値を取得
+        T get() const noexcept
+        {
+            if constexpr (IsFloat)
+            {
+                return _output;
+            } else {
+                return static_cast<T>((_output + (Accumulator(1) << FractionBits >> 1)) >> FractionBits);  // 四捨五入して整数に戻す
+            }
+        }
+
+        //! @brief 最初の値を入れる前に戻す
+        void reset() noexcept
+        {
+            _last_input = 0;
+            _output = 0;
+            _is_started = false;
+        }
+    private:
+        //! @brief 係数を固定小数点数に直す
+        static constexpr Coefficient to_coefficient(float coefficient) noexcept
+        {
+            if constexpr (IsFloat)
+            {
+                return static_cast<Coefficient>(coefficient);
+            } else {
+                return static_cast<Coefficient>(coefficient * static_cast<float>(1UL << FractionBits) + (coefficient < 0 ? -0.5F : 0.5F));  // 四捨五入
+            }
+        }
+    };
+
+    //! @brief 測定値(Quantityの子クラス)をフィルタに通す
+    //! 例： sc::QuantityFilter<sc::Distance, sc::MovingMedian<float, 5>> distance_filter;
+    //! @tparam QuantityDerived 測定値の型
+    //! @tparam Filter フィルタの型  値はQuantityDerived::get()の型で入れる
+    template<class QuantityDerived, class Filter>
+    class QuantityFilter
+    {
+        static_assert(std::is_base_of<Quantity, QuantityDerived>::value, "\n\n<!ERROR!> QuantityFilter can only handle values of child classes of type Quantity\n\n");  // QuantityFilterではQuantity型の子クラスの値しか扱えません
+
+        Filter _filter{};  // 値のフィルタ
+    public:
+        QuantityFilter() = default;
+
+        //! @brief フィルタを指定してQuantityFilterを構築
+        //! @param filter フィルタ  (FirstOrderIIR::low_pass()で作ったものなど)
+        explicit QuantityFilter(const Filter& filter):
+            _filter(filter) {}
+
+        //! @brief 測定値を1つ入れる
+        //! @param quantity 新しい測定値
+        //! @return フィルタ後の測定値
+        QuantityDerived update(const QuantityDerived& quantity)
+        {
+            return QuantityDerived(_filter.update(quantity.get()));
+        }
+
+        //! @brief 測定値を1つ入れる  フィルタ後の値が範囲外なら，例外を投げずにエラーを返す
+        //! @param quantity 新しい測定値
+        //! @return フィルタ後の測定値
+        Result<QuantityDerived> try_update(const QuantityDerived& quantity) noexcept
+        {
+            return QuantityDerived::create(_filter.update(quantity.get()));
+        }
+
+        void reset() noexcept {_filter.reset();}
+
+        Filter& get_filter() noexcept {return _filter;}
+    };
+
+    //! @brief ヒステリシスのある段階の判定  (距離からSAFE/ATTN/DANG/STOPを決めるなど)
+    //! 段階は値が小さい方から0, 1, 2, ...と数え，段階の境目ごとに，上の段階に上がる値(rise)と下の段階に下がる値(fall)を表で指定します．
+    //! update()は境目の数だけ比較して足すだけで，分岐がなく，段階によらず一定時間で終わります．step()は一度に1段階だけ移ります．
+    //! 例： sc::HysteresisClassifier<int16_t, 4> safety({{{61, 60}, {151, 140}, {211, 200}}}, 3);  (hc_sr04のjudge_dist_safeと同じ  境目は60/61cm，140/151cm，200/211cm)
+    //! @tparam T 値の型
+    //! @tparam LevelNum 段階の数
+    template<typename T, std::size_t LevelNum>
+    class HysteresisClassifier
+    {
+        static_assert(LevelNum >= 2 && LevelNum <= 256, "\n\n<!ERROR!> The number of levels of HysteresisClassifier must be 2 to 256\n\n");  // HysteresisClassifierの段階の数は2から256にしてください
+    public:
+        //! @brief 段階の境目
+        struct Threshold
+        {
+            T rise;  // 値がこれ以上になったら上の段階に上がる
+            T fall;  // 値がこれより小さくなったら下の段階に下がる  rise以下にする
+        };
+
+        using Thresholds = std::array<Threshold, LevelNum - 1>;  // 下の境目から順に並べた表
+
+        //! @brief 段階が変わったことを知らせるイベント
+        struct Transition
+        {
+            uint8_t from;  // 前の段階
+            uint8_t to;  // 新しい段階
+
+            constexpr bool is_changed() const noexcept {return from != to;}
+        };
+    private:
+        Thresholds _thresholds;  // 段階の境目の表
+        uint8_t _level;  // 今の段階
+    public:
+        //! @brief 表を指定してHysteresisClassifierを構築
+        //! @param thresholds 段階の境目の表  riseもfallも下の境目ほど小さくしてください
+        //! @param initial_level 最初の段階
+        constexpr HysteresisClassifier(const Thresholds& thresholds, uint8_t initial_level = 0):
+            _thresholds(thresholds),
+            _level(initial_level)
+        {
+            if (!is_valid(thresholds) || initial_level >= LevelNum)
+            {
+                raise(SC_ERROR_INFO(ErrorCode::invalid_argument, "The thresholds of HysteresisClassifier are not in order"));  // 境目の表が並んでいないか，最初の段階が範囲外です
+            }
+        }
+
+        //! @brief 値を入れて段階を判定する
+        //! 今の段階より下の境目はfallと，上の境目はriseと比べ，超えている境目の数を新しい段階とします．(一度に何段階でも移れます)
+        //! @param value 新しい値  NaNは最も下の段階になります
+        //! @return 前と新しい段階
+        constexpr Transition update(T value) noexcept
+        {
+            uint8_t level = 0;
+            for (std::size_t i = 0; i < LevelNum - 1; ++i)
+            {
+                const Threshold& threshold = _thresholds[i];
+                level += (value >= (i < _level ? threshold.fall : threshold.rise));
+            }
+            const Transition transition{_level, level};
+            _level = level;
+            return transition;
+        }
+
+        //! @brief 値を入れて，一度に1段階だけ移るように段階を判定する
+        //! 今の段階の下の境目のfallより小さければ1つ下がり，上の境目のrise以上なら1つ上がります．
+        //! 値が大きく変わったときは，呼び出すたびに1段階ずつ移ります．(hc_sr04のjudge_dist_safeと同じ判定)
+        //! @param value 新しい値  NaNは1つ下がります
+        //! @return 前と新しい段階
+        constexpr Transition step(T value) noexcept
+        {
+            uint8_t level = _level;
+            if (_level > 0 && !(value >= _thresholds[_level - 1].fall)) --level;
+            else if (_level < LevelNum - 1 && value >= _thresholds[_level].rise) ++level;
+            const Transition transition{_level, level};
+            _level = level;
+            return transition;
+        }
+
+        //! @brief 今の段階を取得
+        constexpr uint8_t get_level() const noexcept {return _level;}
+
+        //! @brief 段階の数を取得
+        static constexpr std::size_t level_num() noexcept {return LevelNum;}
+
+        //! @brief 境目の表が正しいかを確認
+        //! @param thresholds 段階の境目の表
+        //! @return fallがrise以下で，下の境目ほど小さければtrue
+        static constexpr bool is_valid(const Thresholds& thresholds) noexcept
+        {
+            for (std::size_t i = 0; i < LevelNum - 1; ++i)
+            {
+                if (!(thresholds[i].fall <= thresholds[i].rise))
+    return false;
+                if (i > 0 && !(thresholds[i - 1].rise <= thresholds[i].rise && thresholds[i - 1].fall <= thresholds[i].fall))
+    return false;
+            }
+            return true;
+        }
+    };
+
+    /**************************************************/
+    /***********************通信***********************/
+    /**************************************************/
+
+    //! @brief 1つの書き込み側と1つの読み込み側の間で，ロックせずにデータを受け渡すリングバッファ
+    //! 割り込み処理(書き込み側)とメインの処理(読み込み側)の間などで使用します．ヒープは使用しません．
+    //! @tparam T 保存する値の型
+    //! @tparam Capacity 保存できる要素数  2のべき乗
+    template<typename T, std::size_t Capacity>
+    class RingBuffer : Noncopyable
+    {
+        static_assert(Capacity && !(Capacity & (Capacity - 1)), "\n\n<!ERROR!> The capacity of RingBuffer must be a power of two\n\n");  // RingBufferの容量は2のべき乗にしてください
+        static constexpr std::size_t IndexMask = Capacity - 1;
+
+        T _buffer[Capacity];  // 保存しているデータ
+        std::atomic<std::size_t> _head{0};  // 次に書き込む位置  (書き込み側のみが更新)
+        std::atomic<std::size_t> _tail{0};  // 次に読み込む位置  (読み込み側のみが更新)
+        std::atomic<std::size_t> _overflow_count{0};  // 満杯で書き込めなかった要素数
+    public:
+        //! @brief 末尾に追加  (書き込み側のみ呼び出せます)
+        //! @param value 追加する値
+        //! @return 追加できたらtrue  満杯のときは値を捨ててfalse
+        bool push(const T& value) noexcept
+        {
+            const std::size_t head = _head.load(std::memory_order_relaxed);
+            if (head - _tail.load(std::memory_order_acquire) == Capacity)
+            {
+                _overflow_count.store(_overflow_count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);  // 書き込み側しか更新しないため，アトミックな加算(Cortex-M0+にはない)は不要
+    return false;
+            }
+            _buffer[head & IndexMask] = value;
+            _head.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        //! @brief 先頭から取り出す  (読み込み側のみ呼び出せます)
+        //! @param value 取り出した値の保存先
+        //! @return 取り出せたらtrue  空のときはfalse
+        bool pop(T& value) noexcept
+        {
+            const std::size_t tail = _tail.load(std::memory_order_relaxed);
+            if (tail == _head.load(std::memory_order_acquire))
+    return false;
+            value = _buffer[tail & IndexMask];
+            _tail.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        //! @brief 先頭からまとめて取り出す  (読み込み側のみ呼び出せます)
+        //! @param output 取り出した値の保存先  この大きさまで取り出します
+        //! @return 取り出した要素数
+        std::size_t read_into(Span<T> output) noexcept
+        {
+            const std::size_t tail = _tail.load(std::memory_order_relaxed);
+            const std::size_t count = std::min(output.size(), _head.load(std::memory_order_acquire) - tail);
+            const std::size_t first_count = std::min(count, Capacity - (tail & IndexMask));  // バッファの終端までの要素数
+            std::copy(&_buffer[tail & IndexMask], &_buffer[tail & IndexMask] + first_count, output.data());
+            std::copy(&_buffer[0], &_buffer[count - first_count], output.data() + first_count);
+            _tail.store(tail + count, std::memory_order_release);
+            return count;
+        }
+
+        //! @brief 保存しているデータを全て捨てる  (読み込み側のみ呼び出せます)
+        void clear() noexcept
+        {
+            _tail.store(_head.load(std::memory_order_acquire), std::memory_order_release);
+        }
+
+        //! @brief 保存している要素数を取得
+        std::size_t size() const noexcept
+        {
+            return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+        }
+
+        bool empty() const noexcept {return size() == 0;}
+
+        bool full() const noexcept {return size() == Capacity;}
+
+        static constexpr std::size_t capacity() noexcept {return Capacity;}
+
+        //! @brief 満杯で書き込めずに捨てた要素数を取得
+        std::size_t get_overflow_count() const noexcept
+        {
+            return _overflow_count.load(std::memory_order_relaxed);
+        }
+    };
+
+
+    //! @brief DMAなどのハードウェアが書き込む循環バッファから，受信したデータを読み出す
+    //! 書き込んだバイト数の累計を update() で受け取り，区切り文字か一定時間の無通信でデータのまとまり(フレーム)を区切ります．
+    //! 読み出しが追いつかずに上書きされたデータは古い順に捨て，get_overflow_count()で数えます．
+    //! @tparam Capacity バッファのバイト数  2のべき乗
+    template<std::size_t Capacity>
+    class DmaRingBuffer : Noncopyable
+    {
+        static_assert(Capacity && !(Capacity & (Capacity - 1)), "\n\n<!ERROR!> The capacity of DmaRingBuffer must be a power of two\n\n");  // DmaRingBufferの容量は2のべき乗にしてください
+        static constexpr std::size_t IndexMask = Capacity - 1;
+
+        alignas(Capacity) uint8_t _buffer[Capacity];  // DMAのリング機能を使うため，バッファのバイト数の倍数のアドレスに置く
+        std::size_t _read_count = 0;  // 読み出したバイト数の累計
+        std::size_t _written_count = 0;  // 書き込まれたバイト数の累計
+        std::size_t _scanned_count = 0;  // 区切り文字を探し終えたバイト数の累計
+        std::size_t _frame_end_count = 0;  // 読み出していない最初のフレームの区切り文字の直後までのバイト数の累計
+        std::size_t _overflow_count = 0;  // 上書きされて捨てたバイト数
+        uint64_t _last_receive_time_us = 0;  // 最後にデータが増えた時刻 (μs)
+        int _delimiter = -1;  // フレームの区切り文字  負の値のときは使用しない
+        uint32_t _idle_timeout_us = 0;  // この時間データが増えなければフレームの終わりとする (μs)  0のときは使用しない
+
+        //! @brief 区切り文字で区切られたフレームのバイト数  なければ0
+        std::size_t delimited_size() const noexcept
+        {
+            const std::size_t frame_size = _frame_end_count - _read_count;
+            return (frame_size <= size() ? frame_size : 0);
+        }
+
+        //! @brief 読み出していない最初の区切り文字を探す
+        //! 見つけたフレームを読み出すまでは先を探さないので，複数の文が届いていても1つずつ区切れます．
+        void find_frame_end() noexcept
+        {
+            if (_delimiter < 0 || delimited_size())
+    return;
+            if (size() < _scanned_count - _read_count)  // 探していない部分が捨てられた
+            {
+                _scanned_count = _read_count;
+            }
+            while (_scanned_count != _written_count)
+            {
+                if (_buffer[_scanned_count++ & IndexMask] == _delimiter)
+                {
+                    _frame_end_count = _scanned_count;
+    return;
+                }
+            }
+        }
+
+        //! @brief 先頭から count バイトをコピーして読み出したことにする
+        std::size_t copy_out(Span<uint8_t> output, std::size_t count) noexcept
+        {
+            count = std::min(count, output.size());
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                output[i] = _buffer[(_read_count + i) & IndexMask];
+            }
+            _read_count += count;
+            return count;
+        }
+    public:
+        //! @brief フレームの区切り方を設定
+        //! @param delimiter 区切り文字  NMEAなら'\n'  負の値のときは使用しない
+        //! @param idle_timeout_us この時間データが届かなければフレームの終わりとする (μs)  0のときは使用しない
+        void set_frame(int delimiter, uint32_t idle_timeout_us) noexcept
+        {
+            _delimiter = delimiter;
+            _idle_timeout_us = idle_timeout_us;
+        }
+
+        //! @brief DMAの書き込み先として渡すバッファを取得
+        uint8_t* get_dma_buffer() noexcept {return _buffer;}
+
+        static constexpr std::size_t capacity() noexcept {return Capacity;}
+
+        //! @brief DMAが書き込んだバイト数を反映し，区切り文字を探す
+        //! @param written_count 書き込まれたバイト数の累計
+        //! @param now_us 現在の時刻 (μs)
+        void update(std::size_t written_count, uint64_t now_us) noexcept
+        {
+            if (written_count != _written_count)
+            {
+                _last_receive_time_us = now_us;
+                _written_count = written_count;
+            }
+            if (Capacity < _written_count - _read_count)  // 読み出す前に上書きされた
+            {
+                _overflow_count += _written_count - _read_count - Capacity;
+                _read_count = _written_count - Capacity;
+            }
+            find_frame_end();
+        }
+
+        //! @brief 読み出していないバイト数を取得
+        std::size_t size() const noexcept
+        {
+            return _written_count - _read_count;
+        }
+
+        //! @brief フレームの終わりまで受信しているかを確認
+        //! @param now_us 現在の時刻 (μs)
+        bool is_frame_ready(uint64_t now_us) const noexcept
+        {
+            if (delimited_size())
+    return true;
+            return size() && _idle_timeout_us && (_idle_timeout_us <= now_us - _last_receive_time_us);
+        }
+
+        //! @brief 受信したデータを古い順にコピー
+        //! @param output コピー先  この大きさまでコピーします
+        //! @return コピーしたバイト数
+        std::size_t read_into(Span<uint8_t> output) noexcept
+        {
+            return copy_out(output, size());
+        }
 
-    //! @brief 気圧の値の保存，操作．
-    //! 単位：hPa
-    class Pressure final : public Quantity
-    {
-        const float _pressure;  // 気圧データ
-    public:
-        static constexpr ID id() {return ID::pressure;}
-        explicit Pressure(float pressure);
-        float get() const noexcept;
-    };
+        //! @brief 1つのフレームをコピー
+        //! @param output コピー先  この大きさまでコピーします
+        //! @param now_us 現在の時刻 (μs)
+        //! @return コピーしたバイト数  フレームの終わりまで受信していなければ0
+        //! 区切り文字で終わるフレームは区切り文字も含めてコピーし，無通信で終わったフレームは受信済みのデータを全てコピーします．
+        std::size_t read_frame_into(Span<uint8_t> output, uint64_t now_us) noexcept
+        {
+            if (const std::size_t frame_size = delimited_size())
+            {
+                const std::size_t count = copy_out(output, frame_size);
+                find_frame_end();  // 続けて届いていた次の文を探す
+    return count;
+            }
+            if (is_frame_ready(now_us))
+    return copy_out(output, size());
+            return 0;
+        }
 
-    //! @brief 湿度の値の保存，操作．
-    //! 単位：%
-    class Humidity final : public Quantity
-    {
-        const float _humidity;  // 湿度データ
-    public:
-        static constexpr ID id() {return ID::humidity;}
-        explicit Humidity(float humidity);
-        float get() const noexcept;
+        //! @brief 読み出す前に上書きされて捨てたバイト数を取得
+        std::size_t get_overflow_count() const noexcept {return _overflow_count;}
     };
-    
-    /**************************************************/
-    /***********************通信***********************/
-    /**************************************************/
 
     //! @brief ピンによる入出力の親クラス
     class PinIO : Noncopyable
@@ -272,6 +1443,80 @@ namespace sc
         virtual void write(bool level) const = 0;
     };
 
+    //! @brief 複数のピンをまとめて入出力する親クラス
+    //! ピンはGPIO番号のビット(rp2040::gpio_maskと同じ形)で指定し，1回のレジスタ操作でまとめて読み書きします．
+    //! グループに含まれないピンのビットは無視します．
+    class PinGroup : Noncopyable
+    {
+    public:
+        using Direction = PinIO::Direction;
+        using Pull = PinIO::Pull;
+
+        //! @brief 入力用ピンからまとめて読み込み
+        //! @return ピンごとのレベルのビット  グループに含まれないピンは0
+        virtual uint32_t read() const = 0;
+
+        //! @brief 出力用ピンにまとめて書き込み
+        //! @param levels ピンごとのレベルのビット  グループの全てのピンに書き込みます
+        virtual void write(uint32_t levels) const = 0;
+
+        //! @brief ビットを立てたピンをHighにする
+        virtual void set(uint32_t mask) const = 0;
+
+        //! @brief ビットを立てたピンをLowにする
+        virtual void clear(uint32_t mask) const = 0;
+
+        //! @brief ビットを立てたピンのレベルを反転する
+        virtual void toggle(uint32_t mask) const = 0;
+    };
+
+    //! @brief ピンのレベルの変化(エッジ)を割り込みで記録する親クラス
+    //! 変化した時刻を割り込み処理で記録するので，read()をループで確認し続ける必要がありません．
+    //! 記録はSC_PIN_EDGE_BUFFER_SIZE個まで保存し，あふれた分は捨てます．
+    class PinEdgeIRQ : Noncopyable
+    {
+    public:
+        //! @brief 記録するエッジ
+        enum class Edge : uint8_t
+        {
+            rising = 1,  // LowからHigh
+            falling = 2,  // HighからLow
+            both = 3  // 両方
+        };
+
+        //! @brief 1回のエッジの記録
+        struct Event
+        {
+            uint64_t time_us;  // 変化した時刻 (μs)
+            uint8_t pin_gpio;  // 変化したピンのGPIO番号
+            bool is_rising;  // LowからHighならtrue
+        };
+
+        //! @brief 古い順に記録を取り出す
+        //! @param event 取り出した記録の保存先
+        //! @return 取り出せたらtrue  記録がなければfalse
+        virtual bool pop(Event& event) = 0;
+
+        //! @brief 取り出す前にあふれて捨てた記録の数を取得
+        virtual std::size_t get_overflow_count() const noexcept = 0;
+    };
+
+    //! @brief トリガーのパルスを出して，返ってきたエコーのパルスの幅を測る親クラス  (超音波距離センサなどで使います)
+    //! 測定は決まった間隔で繰り返し行われ，パルスの幅はFIFOに古い順に保存されます．
+    class PulseCapture : Noncopyable
+    {
+    public:
+        static constexpr uint32_t NoEcho = UINT32_MAX;  // タイムアウトまでにエコーが終わらなかったときの幅
+
+        //! @brief 古い順にエコーのパルスの幅を取り出す
+        //! @param width_us 取り出したパルスの幅(μs)の保存先  タイムアウトしたときはNoEcho
+        //! @return 取り出せたらtrue  まだ測定が終わっていなければfalse
+        virtual bool pop(uint32_t& width_us) = 0;
+
+        //! @brief 次の測定が終わって，pop()で取り出せるようになるまで待つ
+        virtual void wait() = 0;
+    };
+
     //! @brief I2C通信の親クラス
     class I2C : Noncopyable
     {
@@ -282,7 +1527,10 @@ namespace sc
             const uint8_t _slave_addr;
         public:
             explicit SlaveAddr(uint8_t slave_addr);
+            static Result<SlaveAddr> create(uint8_t slave_addr) noexcept;
             uint8_t get() const noexcept;
+        private:
+            static bool is_valid(uint8_t slave_addr) noexcept;
         };
     
         //! @brief スレーブ内のメモリーアドレス
@@ -294,29 +1542,120 @@ namespace sc
             uint8_t get() const noexcept;
         };
 
+        //! @brief transfer()でまとめて行う通信の1区間
+        //! 受信する区間では，受信したデータは結果のバッファに区間の順に詰めて保存されます．
+        class Segment
+        {
+            const uint8_t _slave_addr;  // 通信先のデバイスのスレーブアドレス
+            const int16_t _memory_addr;  // 通信先のデバイス内のメモリアドレス  負の値のときは送らない
+            const bool _is_read;  // 受信か送信か
+            const Span<const uint8_t> _output_data;  // 送信するデータ  (送信のときのみ)
+            const std::size_t _size;  // 送受信するバイト数
+            Segment(SlaveAddr slave_addr, int16_t memory_addr, bool is_read, Span<const uint8_t> output_data, std::size_t size) noexcept;
+        public:
+            static Segment read(std::size_t size, SlaveAddr slave_addr) noexcept;
+            static Segment read_mem(std::size_t size, SlaveAddr slave_addr, MemoryAddr memory_addr) noexcept;
+            static Segment write(Span<const uint8_t> output_data, SlaveAddr slave_addr) noexcept;
+            static Segment write_mem(Span<const uint8_t> output_data, SlaveAddr slave_addr, MemoryAddr memory_addr) noexcept;
+            uint8_t get_slave_addr() const noexcept;
+            bool has_memory_addr() const noexcept;
+            uint8_t get_memory_addr() const noexcept;
+            bool is_read() const noexcept;
+            Span<const uint8_t> get_output_data() const noexcept;
+            std::size_t size() const noexcept;
+        };
+
         //! @brief I2Cによる受信
         //! @param size 受信するバイト数
         //! @param slave_addr 通信先のデバイスのスレーブアドレス
         //! @return Binary型のバイト列
-        virtual Binary read(std::size_t size, SlaveAddr slave_addr) const = 0;
+        Binary read(std::size_t size, SlaveAddr slave_addr) const;
 
         //! @brief I2Cによるメモリからの受信
         //! @param size 受信するバイト数
         //! @param slave_addr 通信先のデバイスのスレーブアドレス
         //! @param memory_addr 通信先のデバイス内のメモリアドレス
         //! @return Binary型のバイト列
-        virtual Binary read_mem(std::size_t size, SlaveAddr slave_addr, MemoryAddr memory_addr) const = 0;
+        Binary read_mem(std::size_t size, SlaveAddr slave_addr, MemoryAddr memory_addr) const;
 
         //! @brief I2Cによる送信
         //! @param output_data 送信するデータ
         //! @param slave_addr 通信先のデバイスのスレーブアドレス
-        virtual void write(Binary output_data, SlaveAddr slave_addr) const = 0;
+        void write(const Binary& output_data, SlaveAddr slave_addr) const;
 
         //! @brief I2Cによるメモリからの送信
         //! @param output_data 送信するデータ
         //! @param slave_addr 通信先のデバイスのスレーブアドレス
         //! @param memory_addr 通信先のデバイス内のメモリアドレス
-        virtual void write_mem(Binary output_data, SlaveAddr slave_addr, MemoryAddr memory_addr) const = 0;
+        void write_mem(const Binary& output_data, SlaveAddr slave_addr, MemoryAddr memory_addr) const;
+
+        //! @brief 複数の区間の通信をまとめて行う
+        //! @param segments 通信する区間  { }で囲んで複数入力
+        //! @return 受信した全てのデータを区間の順に詰めたBinary型のバイト列
+        Binary transfer(std::initializer_list<Segment> segments) const;
+
+        void transfer_into(Span<const Segment> segments, Span<uint8_t> input_data) const;
+
+        Result<Binary> try_read_mem(std::size_t size, SlaveAddr slave_addr, MemoryAddr memory_addr) const;
+        Result<void> try_write_mem(const Binary& output_data, SlaveAddr slave_addr, MemoryAddr memory_addr) const;
+
+        //! @brief 複数の区間の通信を続けて行う  (通信のエラーで例外を投げません)
+        //! @param segments 通信する区間
+        //! @param input_data 受信したデータの保存先  受信する区間のデータを順に詰めて保存します
+        //! @return 通信のエラー
+        //! 同じスレーブアドレスの区間が続く場合は，STOPをせずにリピーテッドスタートで続けます．
+        virtual Result<void> try_transfer_into(Span<const Segment> segments, Span<uint8_t> input_data) const = 0;
+
+        static std::size_t get_read_size(Span<const Segment> segments) noexcept;
+    };
+
+    //! @brief バスの型を指定してI2C通信を行う  (センサのクラスをバスの型のテンプレートにするときに使います)
+    //! Busがpico::I2Cのような具体的な型なら，呼び出す関数がコンパイル時に決まるので，仮想関数を通さずにインライン化できます．
+    //! Busがsc::I2Cなら，これまで通り仮想関数で呼び出します．(どのI2Cでも使えるアダプタになります)
+    //! 受信したデータはBinaryを作らずに，呼び出し側のバッファに直接保存します．
+    template<class Bus>
+    class I2CAccess
+    {
+        static_assert(std::is_base_of_v<I2C, Bus>, "\n\n<!ERROR!> Bus must be a class derived from sc::I2C\n\n");  // Busはsc::I2Cを継承したクラスにしてください
+    public:
+        //! @brief 複数の区間の通信を続けて行う  (通信のエラーで例外を投げません)
+        //! @param bus 通信に使うI2C
+        //! @param segments 通信する区間
+        //! @param input_data 受信したデータの保存先
+        //! @return 通信のエラー
+        static Result<void> transfer_into(const Bus& bus, Span<const I2C::Segment> segments, Span<uint8_t> input_data)
+        {
+            if constexpr (std::is_abstract_v<Bus>)
+            {
+    return bus.try_transfer_into(segments, input_data);  // 実行時に仮想関数で呼び出す
+            } else {
+    return bus.Bus::try_transfer_into(segments, input_data);  // 型を指定して呼び出すので，仮想関数を通さない
+            }
+        }
+
+        //! @brief I2Cによるメモリからの受信  (通信のエラーで例外を投げません)
+        //! @param bus 通信に使うI2C
+        //! @param input_data 受信したデータの保存先  このバイト数だけ受信します
+        //! @param slave_addr 通信先のデバイスのスレーブアドレス
+        //! @param memory_addr 通信先のデバイス内のメモリアドレス
+        //! @return 通信のエラー
+        static Result<void> read_mem_into(const Bus& bus, Span<uint8_t> input_data, I2C::SlaveAddr slave_addr, I2C::MemoryAddr memory_addr)
+        {
+            const I2C::Segment segment = I2C::Segment::read_mem(input_data.size(), slave_addr, memory_addr);
+            return transfer_into(bus, Span<const I2C::Segment>(&segment, 1), input_data);
+        }
+
+        //! @brief I2Cによるメモリへの送信  (通信のエラーで例外を投げません)
+        //! @param bus 通信に使うI2C
+        //! @param output_data 送信するデータ
+        //! @param slave_addr 通信先のデバイスのスレーブアドレス
+        //! @param memory_addr 通信先のデバイス内のメモリアドレス
+        //! @return 通信のエラー
+        static Result<void> write_mem(const Bus& bus, Span<const uint8_t> output_data, I2C::SlaveAddr slave_addr, I2C::MemoryAddr memory_addr)
+        {
+            const I2C::Segment segment = I2C::Segment::write_mem(output_data, slave_addr, memory_addr);
+            return transfer_into(bus, Span<const I2C::Segment>(&segment, 1), Span<uint8_t>());
+        }
     };
 
     //! @brief SPI通信の親クラス
@@ -329,7 +1668,10 @@ namespace sc
             const uint8_t _cs_gpio;
         public:
             explicit CS_Pin(uint8_t cs_gpio);
+            static Result<CS_Pin> create(uint8_t cs_gpio) noexcept;
             uint8_t get() const noexcept;
+        private:
+            static bool is_valid(uint8_t cs_gpio) noexcept;
         };
     
         //! @brief スレーブ内のメモリーアドレス
@@ -343,11 +1685,23 @@ namespace sc
             uint8_t get_1() const noexcept;
         };
 
+        //! @brief 非同期の転送が終わったかを確認し，終わるまで待つためのハンドル
+        //! 転送中は，渡した配列を変更・破棄しないでください．
+        class Transfer
+        {
+            const SPI* _spi;  // 転送を行っているSPI
+            uint32_t _sequence;  // 転送の通し番号
+        public:
+            Transfer(const SPI& spi, uint32_t sequence) noexcept;
+            bool is_done() const;
+            void wait() const;
+        };
+
         //! @brief SPIによる受信
         //! @param size 受信するバイト数
         //! @param cs_pin 通信先につながるCSピン
         //! @return Binary型のバイト列
-        virtual Binary read(std::size_t size, CS_Pin cs_pin) const = 0;
+        Binary read(std::size_t size, CS_Pin cs_pin) const;
 
         //! @brief SPIによるメモリからの受信
         //! @param size 受信するバイト数
@@ -355,19 +1709,52 @@ namespace sc
         //! @param memory_addr 通信先のデバイス内のメモリアドレス
         //! @return Binary型のバイト列
         //! メモリアドレスの8ビット目は1として扱われます．
-        virtual Binary read_mem(std::size_t size, CS_Pin cs_pin, MemoryAddr memory_addr) const = 0;
+        Binary read_mem(std::size_t size, CS_Pin cs_pin, MemoryAddr memory_addr) const;
 
         //! @brief SPIによる送信
         //! @param output_data 送信するデータ
         //! @param cs_pin 通信先につながるCSピン
-        virtual void write(Binary output_data, CS_Pin cs_pin) const = 0;
+        void write(const Binary& output_data, CS_Pin cs_pin) const;
 
         //! @brief SPIによるメモリからの送信
         //! @param output_data 送信するデータ
         //! @param cs_pin 通通信先につながるCSピン
         //! @param memory_addr 通信先のデバイス内のメモリアドレス
         //! メモリアドレスの8ビット目は0として扱われます
-        virtual void write_mem(Binary output_data, CS_Pin cs_pin, MemoryAddr memory_addr) const = 0;
+        void write_mem(const Binary& output_data, CS_Pin cs_pin, MemoryAddr memory_addr) const;
+
+        //! @brief SPIによる受信を開始し，終了を待たずに戻る
+        //! @param input_data 受信したデータの保存先  この大きさだけ受信します
+        //! @param cs_pin 通信先につながるCSピン  転送の開始時にLow，終了時に自動でHighになります
+        //! @return 転送の終了を確認するためのハンドル
+        //! 転送は開始した順に行われます
+        virtual Transfer read_async(Span<uint8_t> input_data, CS_Pin cs_pin) const = 0;
+
+        //! @brief SPIによるメモリからの受信を開始し，終了を待たずに戻る
+        //! @param input_data 受信したデータの保存先  この大きさだけ受信します
+        //! @param cs_pin 通信先につながるCSピン  転送の開始時にLow，終了時に自動でHighになります
+        //! @param memory_addr 通信先のデバイス内のメモリアドレス  8ビット目は1として扱われます
+        //! @return 転送の終了を確認するためのハンドル
+        virtual Transfer read_mem_async(Span<uint8_t> input_data, CS_Pin cs_pin, MemoryAddr memory_addr) const = 0;
+
+        //! @brief SPIによる送信を開始し，終了を待たずに戻る
+        //! @param output_data 送信するデータ
+        //! @param cs_pin 通信先につながるCSピン  転送の開始時にLow，終了時に自動でHighになります
+        //! @return 転送の終了を確認するためのハンドル
+        virtual Transfer write_async(Span<const uint8_t> output_data, CS_Pin cs_pin) const = 0;
+
+        //! @brief SPIによるメモリへの送信を開始し，終了を待たずに戻る
+        //! @param output_data 送信するデータ
+        //! @param cs_pin 通信先につながるCSピン  転送の開始時にLow，終了時に自動でHighになります
+        //! @param memory_addr 通信先のデバイス内のメモリアドレス  8ビット目は0として扱われます
+        //! @return 転送の終了を確認するためのハンドル
+        virtual Transfer write_mem_async(Span<const uint8_t> output_data, CS_Pin cs_pin, MemoryAddr memory_addr) const = 0;
+    protected:
+        //! @brief 通し番号 sequence の転送が終わったかを確認
+        virtual bool is_transfer_done(uint32_t sequence) const = 0;
+
+        //! @brief 通し番号 sequence の転送が終わるまで待つ
+        virtual void wait_transfer(uint32_t sequence) const = 0;
     };
 
 
@@ -383,12 +1770,129 @@ namespace sc
         //! @brief UARTによる受信
         //! @param size 受信するバイト数
         //! @return Binary型のバイト列
-        //! 割り込み処理で受信していたデータを直近の size バイト分返す
+        //! 割り込み処理で受信していたデータを古い順に size バイト分返す
         virtual Binary read(std::size_t size) const = 0;
 
+        //! @brief UARTによる受信
+        //! @param input_data 受信したデータの保存先  この大きさまで受信します
+        //! @return 受信したバイト数
+        //! 割り込み処理で受信していたデータを古い順にコピーする．ヒープは使用しない
+        virtual std::size_t read_into(Span<uint8_t> input_data) const = 0;
+
         //! @brief UARTによる送信
         //! @param output_data 送信するデータ
-        virtual void write(Binary output_data) const = 0;
+        virtual void write(const Binary& output_data) const = 0;
+    };
+
+    //! @brief UARTで受信したGNSS受信機のNMEA 0183の文を，1バイトずつ解析する
+    //! 文を行ごとにコピーせず，フィールドの数値を受信しながら組み立て，チェックサムも受信しながら計算します．
+    //! 途中で受信が途切れても，次に受信したバイトから続きを解析します．
+    //! GGA(位置・時刻・HDOP)，RMC(日付)，GSA(DOP)を解析し，Position・Time・DOPとしてMeasurementに保存します．
+    //! 衛星システム(GP・GL・GA・BD・GNなど)は区別しません．
+    class NmeaParser : Noncopyable
+    {
+    public:
+        static constexpr std::size_t MaxSentenceSize = 82;  // 1つの文の最大文字数  ('$'から"\r\n"まで)
+
+        //! @brief 解析した文の種類
+        enum class Sentence : uint8_t
+        {
+            none,  // 文の途中か，正しくない文
+            gga,
+            rmc,
+            gsa,
+            other  // チェックサムは正しいが，解析しない文
+        };
+
+        //! @brief 受信した文の統計
+        struct Stats
+        {
+            uint32_t sentence_count = 0;  // チェックサムが正しかった文の数
+            uint32_t checksum_error_count = 0;  // チェックサムが違った文の数
+            uint32_t format_error_count = 0;  // 途中で途切れた・長すぎる・値が正しくない文の数
+        };
+    private:
+        //! @brief 文のどこを受信しているか
+        enum class State : uint8_t
+        {
+            wait_start,  // '$'を待っている
+            field,  // フィールドを受信している
+            checksum_high,  // チェックサムの上位の桁を待っている
+            checksum_low,  // チェックサムの下位の桁を待っている
+            wait_end  // 改行を待っている
+        };
+
+        //! @brief 受信中のフィールド  数値は10進数の整数と小数点以下の桁数として組み立てる
+        struct Field
+        {
+            uint64_t mantissa;  // 小数点を除いた数字の列
+            uint8_t size;  // 文字数
+            uint8_t digit_count;  // 数字の数
+            int8_t fraction_count;  // 小数点以下の桁数  小数点がないときは-1
+            bool is_negative;  // 負の数か
+            bool is_number;  // 数値として読めるか
+            char first_char;  // 最初の文字  (N/S，A/Vなど)
+        };
+
+        //! @brief 1つの文から読み取った値  チェックサムが正しければMeasurementに反映する
+        struct Fix
+        {
+            uint32_t millisecond_of_day;  // 時刻 (ms)
+            int32_t latitude_e7;  // 緯度 (1e-7度)
+            int32_t longitude_e7;  // 経度 (1e-7度)
+            int32_t altitude_mm;  // 高度 (mm)
+            uint16_t year;  // 年
+            uint8_t month;  // 月
+            uint8_t day;  // 日
+            uint16_t centi_dop[3];  // PDOP・HDOP・VDOP (0.01)
+            uint8_t field_flags;  // 読み取れた値のビット  FixFlag
+            bool is_fixed;  // 測位できているか
+        };
+
+        //! @brief Fix::field_flagsのビット
+        enum FixFlag : uint8_t
+        {
+            has_time = 1 << 0,
+            has_latitude = 1 << 1,
+            has_longitude = 1 << 2,
+            has_altitude = 1 << 3,
+            has_date = 1 << 4,
+            is_broken = 1 << 7  // 値が正しくないフィールドがあった
+        };
+
+        State _state = State::wait_start;
+        Sentence _sentence = Sentence::none;  // 受信中の文の種類
+        uint8_t _field_index = 0;  // 受信中のフィールドの番号  (0は"GPGGA"などの種類)
+        uint8_t _sentence_size = 0;  // 受信中の文の文字数
+        uint8_t _checksum = 0;  // 受信しながら計算したチェックサム
+        uint8_t _received_checksum = 0;  // 文の末尾のチェックサム
+        char _type[3] = {};  // 文の種類の最後の3文字
+        Field _field{};
+        Fix _fix{};
+        Measurement _measurement;  // 解析した最新の値
+        Stats _stats;
+    public:
+        Sentence feed(uint8_t input_byte) noexcept;
+        std::size_t feed(Span<const uint8_t> input_data) noexcept;
+        std::size_t poll(const UART& uart);
+        const Measurement& get_measurement() const noexcept;
+        const Stats& get_stats() const noexcept;
+        void reset() noexcept;
+    private:
+        void begin_sentence() noexcept;
+        void begin_field() noexcept;
+        void add_to_field(char input_char) noexcept;
+        void end_field() noexcept;
+        Sentence end_sentence() noexcept;
+        void abort_sentence() noexcept;
+        bool read_scaled(uint8_t decimals, int64_t& value) const noexcept;
+        void read_time() noexcept;
+        void read_coordinate(FixFlag flag, int32_t& value_e7) noexcept;
+        void read_altitude() noexcept;
+        void read_date() noexcept;
+        void read_dop(std::size_t index) noexcept;
+        void read_hemisphere(FixFlag flag, int32_t& value_e7, char positive_char, char negative_char) noexcept;
+        bool apply_fix() noexcept;
     };
 
     //! @brief PWMに関する親クラス
@@ -404,6 +1908,352 @@ namespace sc
         virtual void set_freq(uint32_t freq) = 0;
     };
 
+    /**************************************************/
+    /*************パイプライン・スケジューラ**************/
+    /**************************************************/
+
+    //! @brief 時間の統計  (処理時間や周期など)
+    struct TimeStats
+    {
+        uint32_t count = 0;  // 加えた回数
+        uint32_t min_us = UINT32_MAX;  // 最短の時間 (μs)
+        uint32_t max_us = 0;  // 最長の時間 (μs)
+        uint64_t total_us = 0;  // 時間の合計 (μs)
+
+        //! @brief 1回分の時間を加える
+        //! @param time_us 時間 (μs)
+        void add(uint32_t time_us) noexcept
+        {
+            ++count;
+            min_us = std::min(min_us, time_us);
+            max_us = std::max(max_us, time_us);
+            total_us += time_us;
+        }
+
+        //! @brief 平均の時間を取得
+        //! @return 平均の時間 (μs)  まだ加えていなければ0
+        float get_mean_us() const noexcept
+        {
+            return count ? static_cast<float>(total_us) / static_cast<float>(count) : 0.0F;
+        }
+    };
+
+    //! @brief Pipelineの設定と統計  (Pipelineの型によらない部分)
+    class PipelineBase : Noncopyable
+    {
+    public:
+        //! @brief キューが満杯のときにpush()がどうするか
+        enum class Backpressure : uint8_t
+        {
+            wait,  // 空くまで待つ  (測定が遅れる代わりに，値は捨てない)
+            drop  // 新しい値を捨てる  (測定の周期を守る代わりに，値が抜ける)
+        };
+
+        using Stats = TimeStats;  // 処理にかかった時間の統計
+    };
+
+    //! @brief 測定(コア0)と，フィルタ・変換・記録などの処理(コア1)を分けて並列に動かすパイプライン
+    //! コア0はpush()で値をロックフリーのキューに入れるだけで，処理やSDカードへの書き込みが遅くても測定の周期は乱れません．
+    //! コア1はprocess()で値を取り出し，段(Stage)を順に通します．段は bool(Sample&) か void(Sample&) の関数で，falseを返すとその値の処理をやめます．
+    //! 段の型はテンプレートで決まるため，仮想関数を使わずに呼び出せます．make_pipeline()で作ってください．
+    //! 統計はprocess()を呼ぶ側(コア1)で更新するため，処理中に読むときは段の中で読んでください．
+    //! @tparam Sample 段の間で受け渡す値の型
+    //! @tparam QueueSize キューに入る値の数  2のべき乗
+    //! @tparam Stages 段の型
+    template<typename Sample, std::size_t QueueSize, class... Stages>
+    class Pipeline : public PipelineBase
+    {
+        static_assert(sizeof...(Stages) > 0, "\n\n<!ERROR!> Pipeline needs at least one stage\n\n");  // Pipelineには段が1つ以上必要です
+
+        //! @brief キューに入れる値
+        struct Entry
+        {
+            Sample sample;  // 値
+            uint64_t push_time_us;  // キューに入れた時刻 (μs)
+        };
+
+        RingBuffer<Entry, QueueSize> _queue;  // コア0からコア1に値を渡すキュー
+        std::tuple<Stages...> _stages;  // 段
+        const Backpressure _backpressure;  // キューが満杯のときの動作
+        std::atomic<uint32_t> _wait_count{0};  // キューが満杯で待った回数
+        Stats _queue_stats;  // キューに入れてから取り出すまでの時間
+        Stats _stage_stats[sizeof...(Stages)];  // 段ごとの処理時間
+    public:
+        //! @brief パイプラインを構築
+        //! @param backpressure キューが満杯のときの動作
+        //! @param stages 段  この順に値を通します
+        explicit Pipeline(Backpressure backpressure, Stages... stages):
+            _stages(std::move(stages)...),
+            _backpressure(backpressure) {}
+
+        //! @brief 値をキューに入れる  (測定側のみ呼び出せます)
+        //! @param sample 値
+        //! @param now_us 現在の時刻 (μs)  キューで待った時間を測るのに使います
+        //! @return キューに入れたらtrue  Backpressure::dropでキューが満杯のときはfalse
+        bool push(const Sample& sample, uint64_t now_us) noexcept
+        {
+            if (_backpressure == Backpressure::wait && _queue.full())
+            {
+                _wait_count.store(_wait_count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);  // 測定側しか更新しない
+                while (_queue.full()) {}  // 処理側が取り出すのを待つ
+            }
+            return _queue.push(Entry{sample, now_us});
+        }
+
+        //! @brief キューから値を1つ取り出し，全ての段を通す  (処理側のみ呼び出せます)
+        //! @param now_us 現在の時刻(μs)を返す関数  time_us_64など
+        //! @return 値を処理したらtrue  キューが空ならfalse
+        template<class Now>
+        bool process(Now&& now_us)
+        {
+            Entry entry;
+            if (!_queue.pop(entry))
+    return false;
+            _queue_stats.add(static_cast<uint32_t>(now_us() - entry.push_time_us));
+            run_stages(entry.sample, now_us, std::index_sequence_for<Stages...>());
+            return true;
+        }
+
+        //! @brief キューに入って処理を待っている値の数を取得
+        std::size_t get_queue_size() const noexcept {return _queue.size();}
+
+        bool is_queue_full() const noexcept {return _queue.full();}
+
+        //! @brief 満杯で捨てた値の数を取得  (Backpressure::drop)
+        std::size_t get_drop_count() const noexcept {return _queue.get_overflow_count();}
+
+        //! @brief 満杯で待った回数を取得  (Backpressure::wait)
+        uint32_t get_wait_count() const noexcept {return _wait_count.load(std::memory_order_relaxed);}
+
+        //! @brief キューに入れてから取り出すまでの時間の統計を取得
+        const Stats& get_queue_stats() const noexcept {return _queue_stats;}
+
+        //! @brief 段の処理時間の統計を取得
+        //! @param index 段の番号  make_pipeline()に渡した順
+        const Stats& get_stage_stats(std::size_t index) const noexcept {return _stage_stats[index];}
+
+        static constexpr std::size_t stage_num() noexcept {return sizeof...(Stages);}
+    private:
+        //! @brief 全ての段を順に通す  falseを返した段があれば，それ以降は通さない
+        template<class Now, std::size_t... Indices>
+        void run_stages(Sample& sample, Now& now_us, std::index_sequence<Indices...>)
+        {
+            static_cast<void>((run_stage<Indices>(sample, now_us) && ...));
+        }
+
+        //! @brief 1つの段を通し，処理時間を記録
+        template<std::size_t Index, class Now>
+        bool run_stage(Sample& sample, Now& now_us)
+        {
+            auto& stage = std::get<Index>(_stages);
+            const uint64_t start_us = now_us();
+            bool is_continued = true;
+            if constexpr (std::is_void_v<decltype(stage(sample))>)
+            {
+                stage(sample);
+            } else {
+                is_continued = stage(sample);
+            }
+            _stage_stats[Index].add(static_cast<uint32_t>(now_us() - start_us));
+            return is_continued;
+        }
+    };
+
+    //! @brief パイプラインを作る
+    //! 例： auto pipeline = sc::make_pipeline<sc::Measurement, 8>(sc::PipelineBase::Backpressure::wait, [](sc::Measurement& measurement) {...}, ...);
+    //! @tparam Sample 段の間で受け渡す値の型
+    //! @tparam QueueSize キューに入る値の数  2のべき乗
+    //! @param backpressure キューが満杯のときの動作
+    //! @param stages 段  この順に値を通します  ラムダ式などを渡せます
+    template<typename Sample, std::size_t QueueSize, class... Stages>
+    Pipeline<Sample, QueueSize, Stages...> make_pipeline(PipelineBase::Backpressure backpressure, Stages... stages)
+    {
+        return Pipeline<Sample, QueueSize, Stages...>(backpressure, std::move(stages)...);
+    }
+
+    //! @brief 複数のタスク(センサの測定など)を，それぞれ決まった周期で実行するスケジューラ
+    //! タスクは次に実行する時刻ごとにタイマーホイール(時刻をTickUsごとに区切った輪)に並べ，時刻が来た区切りだけを調べます．
+    //! picoではpico::run_scheduler()がハードウェアのアラームで次の時刻まで眠り，PC上ではhost::run_scheduler()がシミュレーション上の時刻を進めます．
+    //! タスクごとに，周期・遅れ・実行時間の統計と，周期を過ぎても実行できなかった回数(オーバーラン)を記録します．
+    //! @tparam MaxTaskNum 登録できるタスクの数
+    //! @tparam WheelSize タイマーホイールの区切りの数
+    //! @tparam TickUs タイマーホイールの1区切りの時間 (μs)
+    template<std::size_t MaxTaskNum = 8, std::size_t WheelSize = 32, uint32_t TickUs = 1000>
+    class Scheduler : Noncopyable
+    {
+        static_assert(MaxTaskNum > 0 && MaxTaskNum < 0xff, "\n\n<!ERROR!> The number of tasks of Scheduler must be 1 to 254\n\n");  // Schedulerのタスクの数は1から254にしてください
+        static_assert(WheelSize > 0 && TickUs > 0, "\n\n<!ERROR!> The timer wheel of Scheduler must not be empty\n\n");  // Schedulerのタイマーホイールの大きさは1以上にしてください
+    public:
+        using TaskID = uint8_t;  // タスクの番号  add()を呼んだ順
+
+        //! @brief 周期を過ぎても実行できなかった(オーバーランした)ときの動作
+        enum class Overrun : uint8_t
+        {
+            catch_up,  // 抜けた回数だけ続けて実行し，元の時刻の並びに戻す  (回数を守る)
+            skip  // 抜けた回を飛ばし，次の周期から実行する  (間隔を守る)
+        };
+
+        //! @brief タスクの統計
+        struct TaskStats
+        {
+            TimeStats period;  // 前回の実行開始からの間隔
+            TimeStats lateness;  // 予定の時刻から実際に実行を始めるまでの遅れ
+            TimeStats execution;  // 実行時間
+            uint32_t overrun_count = 0;  // 実行を始めたときに，すでに次の周期を過ぎていた回数
+            uint32_t skip_count = 0;  // Overrun::skipで飛ばした回数
+        };
+    private:
+        static constexpr uint8_t NoTask = 0xff;  // リストの終わり
+
+        //! @brief 登録したタスク
+        struct Task
+        {
+            void (*function)(void*);  // 実行する関数
+            void* context;  // functionに渡すポインタ
+            uint64_t deadline_us;  // 次に実行する時刻 (μs)
+            uint64_t last_start_us;  // 前回の実行を始めた時刻 (μs)
+            uint32_t period_us;  // 周期 (μs)
+            Overrun overrun;  // オーバーランしたときの動作
+            uint8_t next;  // 同じ区切りにある次のタスク
+            TaskStats stats;  // 統計
+        };
+
+        Task _tasks[MaxTaskNum];  // 登録したタスク
+        std::size_t _task_num = 0;  // 登録したタスクの数
+        uint8_t _wheel[WheelSize];  // 区切りごとのタスクのリストの先頭
+        uint64_t _cursor_tick = 0;  // 次に調べる区切り  (時刻/TickUs)
+    public:
+        Scheduler() noexcept
+        {
+            std::fill(std::begin(_wheel), std::end(_wheel), NoTask);
+        }
+
+        //! @brief タスクを登録
+        //! @param function 実行する関数オブジェクト(ラムダ式など)  Schedulerより長く残るようにしてください
+        //! @param period_us 周期 (μs)
+        //! @param first_us 最初に実行する時刻 (μs)
+        //! @param overrun オーバーランしたときの動作
+        //! @return タスクの番号  統計の取得に使います
+        template<class Function>
+        TaskID add(Function& function, uint32_t period_us, uint64_t first_us = 0, Overrun overrun = Overrun::catch_up)
+        {
+            return add([](void* context) {(*static_cast<Function*>(context))();}, &function, period_us, first_us, overrun);
+        }
+
+        //! @brief タスクを登録
+        //! @param function 実行する関数
+        //! @param context functionに渡すポインタ
+        //! @param period_us 周期 (μs)
+        //! @param first_us 最初に実行する時刻 (μs)
+        //! @param overrun オーバーランしたときの動作
+        //! @return タスクの番号  統計の取得に使います
+        TaskID add(void (*function)(void*), void* context, uint32_t period_us, uint64_t first_us = 0, Overrun overrun = Overrun::catch_up)
+        {
+            if (_task_num == MaxTaskNum)
+            {
+                raise(SC_ERROR_INFO(ErrorCode::buffer_too_small, "Scheduler has no room for another task"));  // これ以上タスクを登録できません  MaxTaskNumを増やしてください
+            }
+            if (!period_us)
+            {
+                raise(SC_ERROR_INFO(ErrorCode::invalid_argument, "The period of a task must not be zero"));  // タスクの周期は1μs以上にしてください
+            }
+            const TaskID id = static_cast<TaskID>(_task_num++);
+            _tasks[id] = Task{function, context, first_us, 0, period_us, overrun, NoTask, TaskStats{}};
+            insert(id);
+            return id;
+        }
+
+        //! @brief 時刻が来たタスクを実行する
+        //! 1回の呼び出しでは，1つのタスクは1回だけ実行します．(Overrun::catch_upで遅れを取り戻すときも，get_next_deadline_us()がすぐに来るので続けて呼び出されます)
+        //! @param now_us 現在の時刻(μs)を返す関数  time_us_64など
+        template<class Now>
+        void run_pending(Now&& now_us)
+        {
+            const uint64_t start_us = now_us();
+            const uint64_t now_tick = start_us / TickUs;
+            const uint64_t tick_num = std::min<uint64_t>(now_tick - std::min(_cursor_tick, now_tick) + 1, WheelSize);  // 1周より多く進んでいても，全ての区切りを1回ずつ調べれば足りる
+            uint8_t due_tasks[MaxTaskNum];  // 時刻が来たタスク
+            std::size_t due_num = 0;
+            for (uint64_t tick = now_tick + 1 - tick_num; tick <= now_tick; ++tick)
+            {
+                uint8_t* link = &_wheel[tick % WheelSize];
+                while (*link != NoTask)
+                {
+                    Task& task = _tasks[*link];
+                    if (task.deadline_us <= start_us)
+                    {
+                        due_tasks[due_num++] = *link;
+                        *link = task.next;  // リストから外す
+                    } else {
+                        link = &task.next;
+                    }
+                }
+            }
+            _cursor_tick = now_tick;
+            for (std::size_t i = 0; i < due_num; ++i)
+            {
+                run_task(due_tasks[i], now_us);
+                insert(due_tasks[i]);
+            }
+        }
+
+        //! @brief 次にタスクを実行する時刻を取得
+        //! @return 時刻 (μs)  タスクがなければUINT64_MAX
+        uint64_t get_next_deadline_us() const noexcept
+        {
+            uint64_t deadline_us = UINT64_MAX;
+            for (std::size_t i = 0; i < _task_num; ++i)
+            {
+                deadline_us = std::min(deadline_us, _tasks[i].deadline_us);
+            }
+            return deadline_us;
+        }
+
+        //! @brief タスクの統計を取得
+        //! @param id add()で受け取ったタスクの番号
+        const TaskStats& get_stats(TaskID id) const noexcept {return _tasks[id].stats;}
+
+        std::size_t get_task_num() const noexcept {return _task_num;}
+    private:
+        //! @brief タスクを次に実行する時刻の区切りに入れる  過ぎた時刻なら次に調べる区切りに入れる
+        void insert(uint8_t id) noexcept
+        {
+            Task& task = _tasks[id];
+            uint8_t& head = _wheel[std::max(task.deadline_us / TickUs, _cursor_tick) % WheelSize];
+            task.next = head;
+            head = id;
+        }
+
+        //! @brief タスクを実行し，統計と次に実行する時刻を更新
+        template<class Now>
+        void run_task(uint8_t id, Now& now_us)
+        {
+            Task& task = _tasks[id];
+            const uint64_t start_us = now_us();
+            if (task.stats.execution.count)
+            {
+                task.stats.period.add(static_cast<uint32_t>(start_us - task.last_start_us));
+            }
+            task.stats.lateness.add(static_cast<uint32_t>(start_us - task.deadline_us));
+            task.last_start_us = start_us;
+            task.function(task.context);
+            task.stats.execution.add(static_cast<uint32_t>(now_us() - start_us));
+
+            const uint64_t missed_num = (start_us - task.deadline_us) / task.period_us;  // 実行を始めたときに過ぎていた周期の数
+            if (missed_num)
+            {
+                ++task.stats.overrun_count;
+            }
+            if (missed_num && task.overrun == Overrun::skip)
+            {
+                task.stats.skip_count += static_cast<uint32_t>(missed_num);
+                task.deadline_us += (missed_num + 1) * task.period_us;
+            } else {
+                task.deadline_us += task.period_us;
+            }
+        }
+    };
+
     /**************************************************/
     /**********************モーター*********************/
     /**************************************************/
@@ -457,10 +2307,179 @@ namespace sc
     /************************記録***********************/
     /**************************************************/
 
-    // SDカード関連の親クラス
+    //! @brief SDカードの親クラス  512バイトのブロック単位で読み書きする
+    //! 連続した複数のブロックは，1つのコマンドでまとめて転送します  (SPIモードのCMD18・CMD25など)
     class SD : Noncopyable
     {
-        virtual void write(Binary output_data) = 0;
+    public:
+        static constexpr std::size_t BlockSize = 512;  // 1ブロックのバイト数
+
+        //! @brief 連続したブロックを読む
+        //! @param block 最初のブロックの番号
+        //! @param input_data 読んだデータの保存先  BlockSizeの倍数のバイト数だけ読みます
+        //! @return 読めなかったときはエラー
+        virtual Result<void> read_blocks(uint32_t block, Span<uint8_t> input_data) const = 0;
+
+        //! @brief 連続したブロックに書く
+        //! @param block 最初のブロックの番号
+        //! @param output_data 書くデータ  BlockSizeの倍数のバイト数
+        //! @return 書けなかったときはエラー
+        virtual Result<void> write_blocks(uint32_t block, Span<const uint8_t> output_data) const = 0;
+
+        //! @brief ブロックの数を取得
+        virtual uint32_t get_block_num() const noexcept = 0;
+    };
+
+    //! @brief FAT32でフォーマットしたSDカードに，連続したクラスタを確保したファイルを作って追記する
+    //! ファイルを作るときに，最大の大きさの分のクラスタを連続して確保してFATに書き込んでおきます．
+    //! 追記はファイル上の位置からブロックの番号を計算して直接書くので，追記中にFATをたどったり書き換えたりしません．
+    //! 最後のブロックの途中までのデータは保存しておき，次の書き出しで続きと合わせて書き直します．
+    //! SectorWriterの書き出し先  (Storage)  として使えます．ディレクトリはルートのみで，長いファイル名は使えません．
+    class FatFile : Noncopyable
+    {
+        const SD& _sd;  // 書き込み先のSDカード
+        uint32_t _fat_block = 0;  // 1つ目のFATの最初のブロック
+        uint32_t _fat_size = 0;  // 1つのFATのブロック数
+        uint8_t _fat_num = 0;  // FATの数
+        uint8_t _cluster_size = 0;  // 1つのクラスタのブロック数
+        uint32_t _data_block = 0;  // クラスタ2の最初のブロック
+        uint32_t _cluster_num = 0;  // クラスタの数
+        uint32_t _root_cluster = 0;  // ルートディレクトリの最初のクラスタ
+        uint32_t _fs_info_block = 0;  // FSInfoのブロック  なければ0
+        uint32_t _first_block = 0;  // ファイルの最初のブロック
+        uint32_t _entry_block = 0;  // ファイルのディレクトリエントリがあるブロック
+        uint16_t _entry_offset = 0;  // ディレクトリエントリのブロック内の位置
+        bool _is_open = false;  // ファイルを作ってからclose()していないか
+        uint64_t _capacity = 0;  // 確保したバイト数
+        uint64_t _size = 0;  // 書いたバイト数
+        alignas(4) uint8_t _block[SD::BlockSize];  // 最後のブロックの途中までのデータ  (ファイルを作るときは作業用に使う)
+    public:
+        static constexpr uint64_t MaxFileSize = UINT32_MAX;  // FAT32のファイルの最大のバイト数
+
+        explicit FatFile(const SD& sd) noexcept;
+        Result<void> create(const char* name, uint64_t capacity);
+        Result<void> begin_write(uint64_t offset, Span<const uint8_t> output_data);
+        Result<void> wait_write() noexcept {return {};}  // 書き出しはbegin_write()の中で終わっている
+        Result<void> sync();
+        Result<void> close();
+        uint64_t get_size() const noexcept {return _size;}
+        uint64_t get_capacity() const noexcept {return _capacity;}
+        bool is_open() const noexcept {return _is_open;}
+    private:
+        Result<void> mount();
+        Result<void> find_entry(const uint8_t (&short_name)[11]);
+        Result<uint32_t> allocate(uint32_t cluster_count);
+        Result<uint32_t> read_fat(uint32_t cluster);
+        uint32_t get_cluster_block(uint32_t cluster) const noexcept {return _data_block + (cluster - 2) * _cluster_size;}
+    };
+
+    //! @brief 2つのバッファに交互に追記し，満杯になった方をセクタ単位でまとめて書き出す  (SDカードへのログの記録など)
+    //! 一方のバッファを書き出している間  (DMAなど)  に，もう一方のバッファに追記できます．
+    //! 書き出しはファイル上の位置がセクタの境界で終わるように区切るため，書き出し先はセクタを読み直して書き直す必要がありません．
+    //! 追記した位置を保存しているので，追記のたびに全体を走査(strlenなど)しません．
+    //! @tparam Storage 書き出し先の型  以下の関数を持つクラス
+    //! Result<void> begin_write(uint64_t offset, Span<const uint8_t> data)  ファイル上の位置 offset から書き出しを始める  (wait_write()まで data は変更しません)
+    //! Result<void> wait_write()  書き出しが終わるまで待つ
+    //! @tparam SectorSize セクタのバイト数
+    //! @tparam BufferSectorNum 1つのバッファのセクタ数
+    template<class Storage, std::size_t SectorSize = 512, std::size_t BufferSectorNum = 4>
+    class SectorWriter : Noncopyable
+    {
+        static_assert(SectorSize && BufferSectorNum, "\n\n<!ERROR!> SectorWriter needs at least one sector\n\n");  // セクタのバイト数と数は1以上にしてください
+        static constexpr std::size_t BufferSize = SectorSize * BufferSectorNum;  // 1つのバッファのバイト数
+
+        Storage& _storage;  // 書き出し先
+        alignas(4) uint8_t _buffers[2][BufferSize];  // 追記するバッファと書き出し中のバッファ  (DMAで転送できるように4バイト境界に置く)
+        std::size_t _active = 0;  // 追記しているバッファの番号
+        std::size_t _size = 0;  // 追記しているバッファのバイト数
+        std::size_t _limit;  // 追記しているバッファを書き出すバイト数  (ファイル上の位置がセクタの境界で終わるように決める)
+        uint64_t _written_offset;  // 書き出しを始めたデータの末尾のファイル上の位置
+        uint32_t _write_count = 0;  // 書き出しを始めた回数
+        bool _is_writing = false;  // 書き出し中のバッファがあるか
+    public:
+        //! @brief 書き出し先を設定
+        //! @param storage 書き出し先
+        //! @param offset 追記を始めるファイル上の位置  (既存のファイルの末尾など)
+        explicit SectorWriter(Storage& storage, uint64_t offset = 0) noexcept:
+            _storage(storage),
+            _limit(BufferSize - static_cast<std::size_t>(offset % SectorSize)),
+            _written_offset(offset) {}
+
+        //! @brief データを追記する  バッファが満杯になったら書き出す
+        //! 書き出しに失敗しても，満杯のバッファは残り，次のflush()かappend()で同じ位置から書き直します．
+        //! @param data 追記するデータ
+        //! @return 書き出しに失敗したときはエラー
+        //! エラーのとき，dataの先頭から (get_size() - 呼び出す前のget_size()) バイトまではバッファに追記済みです．
+        //! 残りは追記されていないため，追記済みの分を飛ばし，flush()で書き直してから残りを追記してください．
+        Result<void> append(Span<const uint8_t> data)
+        {
+            while (!data.empty())
+            {
+                const std::size_t count = std::min(data.size(), _limit - _size);
+                std::copy(data.begin(), data.begin() + count, &_buffers[_active][_size]);
+                _size += count;
+                data = data.subspan(count, data.size() - count);
+                if (_size == _limit)
+                {
+                    const Result<void> result = write_active();
+                    if (!result)
+    return result;
+                }
+            }
+            return {};
+        }
+
+        //! @brief 書き出していないデータを全て書き出し，終わるまで待つ
+        //! 最後のセクタが途中までの場合も書き出します．次の追記はその続きの位置から始め，セクタの境界で書き出します．
+        //! @return 書き出しに失敗したときはエラー
+        Result<void> flush()
+        {
+            if (_size)
+            {
+                const Result<void> result = write_active();
+                if (!result)
+    return result;
+            }
+            return wait();
+        }
+
+        //! @brief 追記したデータの末尾のファイル上の位置を取得  (書き出していないデータを含む)
+        uint64_t get_size() const noexcept {return _written_offset + _size;}
+
+        //! @brief 書き出していないバイト数を取得
+        std::size_t get_pending_size() const noexcept {return _size;}
+
+        //! @brief 書き出しを始めた回数を取得
+        uint32_t get_write_count() const noexcept {return _write_count;}
+
+        static constexpr std::size_t get_sector_size() noexcept {return SectorSize;}
+    private:
+        //! @brief 書き出し中のバッファがあれば，終わるまで待つ
+        Result<void> wait()
+        {
+            if (!_is_writing)
+    return {};
+            _is_writing = false;
+            return _storage.wait_write();
+        }
+
+        //! @brief 追記しているバッファの書き出しを始め，もう一方のバッファに切り替える
+        Result<void> write_active()
+        {
+            const Result<void> wait_result = wait();  // もう一方のバッファの書き出しが終わってから再利用する
+            if (!wait_result)
+    return wait_result;
+            const Result<void> result = _storage.begin_write(_written_offset, Span<const uint8_t>(_buffers[_active], _size));
+            if (!result)
+    return result;
+            _is_writing = true;
+            ++_write_count;
+            _written_offset += _size;
+            _active ^= 1;
+            _size = 0;
+            _limit = BufferSize - static_cast<std::size_t>(_written_offset % SectorSize);
+            return {};
+        }
     };
 
     /**************************************************/
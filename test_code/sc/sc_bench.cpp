@@ -0,0 +1,2530 @@
+/*************************************
+ *************************************
+
+scのライブラリの処理速度とヒープ使用量を計測するプログラムです
+1回あたりの時間(ns/op)，ヒープの確保回数(allocs/op)，確保したバイト数(bytes/op)を出力します
+
+PC上では test_code/host のCMakeでビルドして実行します
+    SC_Bench [--benchmark_format=json] [--benchmark_filter=名前の一部] [--benchmark_min_time=秒]
+picoでは test_code/sc のCMakeでビルドしたSC_Bench.uf2を書き込むと，USBで結果をJSON形式で出力します
+picoではモックのバスやピン，スレッド，ファイルを使うもの(SC_HOSTのとき)を除いたベンチマークを実行します
+
+*************************************
+*************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+#ifdef SC_HOST
+#include <chrono>
+#include <thread>
+#include "gnss_nmea.h"  // spresense/gnss_trackerのNMEAの文  (GNSS.hはhost/spresenseの代わりのもの)
+#include "gnss_log_host.h"  // spresense/gnss_trackerのバイナリのログ  (SDカードの代わりにPCのファイルに書き出す)
+#else
+#include "pico/stdlib.h"
+#include "pico/stdio_usb.h"
+#endif
+
+#include "sc.hpp"
+#ifdef SC_HOST
+#include "sc_host.hpp"  // モックのバスやピンを使うベンチマークはPC上だけで実行する
+#endif
+#include "../exam001/exam001.hpp"
+
+//! @file sc_bench.cpp
+//! @brief scのベンチマーク
+
+namespace
+{
+    std::size_t allocation_count = 0;  // operator newが呼ばれた回数
+    std::size_t allocation_bytes = 0;  // operator newで確保したバイト数の合計
+}
+
+void* operator new(std::size_t size)
+{
+    ++allocation_count;
+    allocation_bytes += size;
+    if (void* pointer = std::malloc(size ? size : 1))
+return pointer;
+#ifdef SC_EXCEPTIONS
+    throw std::bad_alloc();
+#else
+    std::abort();
+#endif
+}
+
+void operator delete(void* pointer) noexcept {std::free(pointer);}
+void operator delete(void* pointer, std::size_t) noexcept {std::free(pointer);}
+void* operator new[](std::size_t size) {return operator new(size);}
+void operator delete[](void* pointer) noexcept {operator delete(pointer);}
+void operator delete[](void* pointer, std::size_t) noexcept {operator delete(pointer);}
+
+//! @brief hc_sr04/test.cpp の以前の処理  (書き換えずにそのまま取り込み，グローバル変数はここで定義する)
+namespace hc_sr04_legacy
+{
+    int16_t distance_sensor_value = 0;  // calc_distance_averageに入れる距離
+    int16_t distance_average_value = 0;  // calc_distance_averageが求めた平均  judge_dist_safeはこれで判定する
+    int8_t distance_safe_state = 0;  // judge_dist_safeが判定した段階
+#include "../hc_sr04/test.cpp"
+}
+
+#ifndef SC_HOST
+namespace
+{
+    bool is_log_discarded = false;  // trueならログを出力しない  (ログの記録だけを計測するため)
+}
+
+//! @brief ログを出力する関数です．  (sc_pico.cppの代わり  計測中は出力を捨てられるようにする)
+//! @param log 書き込む文字列
+//! @param size 文字数
+void sc::Log::output(const char* log, std::size_t size) noexcept
+{
+    if (is_log_discarded)
+return;
+    std::fwrite(log, 1, size, stdout);
+    std::fflush(stdout);
+}
+#endif
+
+namespace
+{
+    /***** ベンチマークの仕組み *****/
+
+#ifdef SC_HOST
+    constexpr const char* Platform = "host";  // 実行している環境
+#else
+    constexpr const char* Platform = "pico";  // 実行している環境
+#endif
+
+    //! @brief 現在時刻を取得
+    //! @return 現在時刻 (ns)
+    uint64_t get_now_ns()
+    {
+#ifdef SC_HOST
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#else
+        return time_us_64() * 1000;  // pico-SDKの関数  起動からの時間(μs)を取得する
+#endif
+    }
+
+    //! @brief パイプラインなどに渡す現在時刻を取得  (PC上では仮想の時刻)
+    //! @return 現在時刻 (μs)
+    uint64_t get_time_us()
+    {
+#ifdef SC_HOST
+        return host::get_time_us();
+#else
+        return time_us_64();
+#endif
+    }
+
+    //! @brief 計算結果を使ったことにして，最適化で処理が消されないようにする
+    template<typename T>
+    inline void do_not_optimize(const T& value)
+    {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    //! @brief 1つのベンチマークの実行状態
+    //! while (state.keep_running()) {...} の中身がiterations()回実行されます．
+    class State
+    {
+    public:
+        static constexpr std::size_t MaxCounterNum = 4;  // 独自の値の最大数
+
+        //! @brief ベンチマークごとの独自の値  (1回あたりの値)
+        struct Counter
+        {
+            const char* name;
+            double value;
+        };
+    private:
+        const std::size_t _iterations;  // 繰り返す回数
+        std::size_t _count = 0;  // 繰り返した回数
+        Counter _counters[MaxCounterNum] = {};  // 独自の値
+        std::size_t _counter_num = 0;  // 独自の値の数
+    public:
+        explicit State(std::size_t iterations) noexcept:
+            _iterations(iterations) {}
+
+        bool keep_running() noexcept {return _count++ < _iterations;}
+
+        std::size_t iterations() const noexcept {return _iterations;}
+
+        //! @brief 独自の値を記録
+        //! @param name 値の名前
+        //! @param total 全体での値  繰り返した回数で割って記録する
+        void set_counter(const char* name, double total) noexcept
+        {
+            if (_counter_num < MaxCounterNum)
+            {
+                _counters[_counter_num++] = Counter{name, total / _iterations};
+            }
+        }
+
+        sc::Span<const Counter> get_counters() const noexcept {return sc::Span<const Counter>(_counters, _counter_num);}
+
+        //! @brief 結果が正しくなかったのでベンチマークを中止する
+        //! @param message エラーの内容
+        [[noreturn]] static void fail(const char* message)
+        {
+            std::printf("<<ERROR>> %s\n", message);
+            std::exit(1);
+        }
+    };
+
+    //! @brief 登録するベンチマーク
+    struct Benchmark
+    {
+        const char* name;  // ベンチマークの名前
+        void (*function)(State&);  // 計測する関数
+    };
+
+    //! @brief 1つのベンチマークの結果
+    struct Result
+    {
+        std::size_t iterations;
+        double ns_per_op;
+        double allocations_per_op;
+        double bytes_per_op;
+        State::Counter counters[State::MaxCounterNum];
+        std::size_t counter_num;
+    };
+
+    //! @brief 回数を増やしながら，min_time_ns以上かかるまでベンチマークを繰り返す
+    //! @param benchmark 計測するベンチマーク
+    //! @param min_time_ns 計測に最低限かける時間 (ns)
+    Result run_benchmark(const Benchmark& benchmark, uint64_t min_time_ns)
+    {
+        constexpr std::size_t MaxIterations = 1000000000;
+        std::size_t iterations = 1;
+        while (true)
+        {
+            State state(iterations);
+            const std::size_t start_count = allocation_count;
+            const std::size_t start_bytes = allocation_bytes;
+            const uint64_t start_ns = get_now_ns();
+            benchmark.function(state);
+            const uint64_t elapsed_ns = get_now_ns() - start_ns;
+            const std::size_t allocations = allocation_count - start_count;
+            const std::size_t bytes = allocation_bytes - start_bytes;
+
+            if (min_time_ns <= elapsed_ns || MaxIterations <= iterations)
+            {
+                Result result{iterations, static_cast<double>(elapsed_ns) / iterations,
+                    static_cast<double>(allocations) / iterations, static_cast<double>(bytes) / iterations, {}, 0};
+                for (const State::Counter& counter : state.get_counters())
+                {
+                    result.counters[result.counter_num++] = counter;
+                }
+    return result;
+            }
+            // 次で min_time_ns を少し超えるように回数を増やす (一度に増やすのは10倍まで)
+            const double scale = (elapsed_ns ? 1.4 * min_time_ns / elapsed_ns : 10.0);
+            iterations = static_cast<std::size_t>(iterations * (10.0 < scale ? 10.0 : scale)) + 1;
+        }
+    }
+
+    //! @brief 人が読むための形式で結果を出力
+    void print_console(const char* name, const Result& result)
+    {
+        std::printf("%-34s %10.1f ns/op %7.2f allocs/op %7.1f bytes/op %10zu", name, result.ns_per_op, result.allocations_per_op, result.bytes_per_op, result.iterations);
+        for (const State::Counter& counter : sc::Span<const State::Counter>(result.counters, result.counter_num))
+        {
+            std::printf("  %s=%.3g", counter.name, counter.value);
+        }
+        std::printf("\n");
+    }
+
+    //! @brief Google Benchmarkと同じ形のJSONで結果を出力
+    void print_json(const char* name, const Result& result, bool is_first)
+    {
+        std::printf("%s\n    {\"name\": \"%s\", \"run_type\": \"iteration\", \"iterations\": %zu, \"real_time\": %.3f, \"cpu_time\": %.3f, \"time_unit\": \"ns\", "
+            "\"allocations_per_iteration\": %.3f, \"bytes_per_iteration\": %.3f",
+            (is_first ? "" : ","), name, result.iterations, result.ns_per_op, result.ns_per_op, result.allocations_per_op, result.bytes_per_op);
+        for (const State::Counter& counter : sc::Span<const State::Counter>(result.counters, result.counter_num))
+        {
+            std::printf(", \"%s\": %.6g", counter.name, counter.value);
+        }
+        std::printf("}");
+    }
+
+    /***** sc::Binary *****/
+
+    //! @brief Exam001::set_measurement_method()と同じく，数バイトのBinaryを作る
+    void bm_binary_initializer_list(State& state)
+    {
+        volatile uint8_t value = 0x0c;
+        while (state.keep_running())
+        {
+            const sc::Binary binary{value, 0x01, 0x02, 0x03};
+            do_not_optimize(binary[0]);
+        }
+    }
+
+    //! @brief InlineCapacityより大きいvectorからBinaryを作る  (ヒープを使う)
+    void bm_binary_vector_64(State& state)
+    {
+        const std::vector<uint8_t> input(64, 0x55);
+        while (state.keep_running())
+        {
+            const sc::Binary binary(input);
+            do_not_optimize(binary[63]);
+        }
+    }
+
+    //! @brief 配列をコピーせずに参照するBinaryを作る
+    void bm_binary_view_of(State& state)
+    {
+        static const uint8_t Input[64] = {};
+        while (state.keep_running())
+        {
+            const sc::Binary binary = sc::Binary::view_of(sc::Span<const uint8_t>(Input));
+            do_not_optimize(binary[63]);
+        }
+    }
+
+    /***** sc::I2C::SlaveAddr / sc::I2C::MemoryAddr *****/
+
+    void bm_slave_addr(State& state)
+    {
+        volatile uint8_t value = 0x76;
+        while (state.keep_running())
+        {
+            const sc::I2C::SlaveAddr slave_addr(value);
+            do_not_optimize(slave_addr.get());
+        }
+    }
+
+    void bm_memory_addr(State& state)
+    {
+        volatile uint8_t value = 0xf7;
+        while (state.keep_running())
+        {
+            const sc::I2C::MemoryAddr memory_addr(value);
+            do_not_optimize(memory_addr.get());
+        }
+    }
+
+    /***** sc::Measurement *****/
+
+    //! @brief 以前のQuantityと同じく仮想デストラクタを持つ測定値
+    class LegacyQuantity
+    {
+    public:
+        virtual ~LegacyQuantity() = default;
+    };
+
+    class LegacyTemperature final : public LegacyQuantity
+    {
+        const float _temperature;
+    public:
+        static constexpr sc::Quantity::ID id() {return sc::Quantity::ID::temperature;}
+        explicit LegacyTemperature(float temperature): _temperature(temperature) {}
+        float get() const noexcept {return _temperature;}
+    };
+
+    //! @brief 以前のMeasurementと同じ方法で測定値を保存
+    class LegacyMeasurement
+    {
+        std::unordered_map<sc::Quantity::ID, LegacyQuantity*> _measurement;
+    public:
+        template<class QuantityDerived>
+        explicit LegacyMeasurement(const QuantityDerived& quantity_derived)
+        {
+            _measurement[QuantityDerived::id()] = new QuantityDerived(quantity_derived);
+        }
+
+        ~LegacyMeasurement()
+        {
+            for (std::pair<const sc::Quantity::ID, LegacyQuantity*>& element : _measurement)
+            {
+                delete element.second;
+            }
+        }
+
+        template<class QuantityDerived>
+        QuantityDerived get() const
+        {
+            return *static_cast<QuantityDerived*>(_measurement.at(QuantityDerived::id()));
+        }
+    };
+
+    //! @brief 以前のMeasurement (unordered_map + new) で，測定値を1つ入れて取り出す
+    void bm_measurement_legacy(State& state)
+    {
+        volatile float input = 25.0F;
+        while (state.keep_running())
+        {
+            const LegacyMeasurement measurement{LegacyTemperature(input)};
+            do_not_optimize(measurement.get<LegacyTemperature>().get());
+        }
+    }
+
+    //! @brief Exam001::measure()と同じく，測定値を1つ入れたMeasurementを作って取り出す
+    void bm_measurement(State& state)
+    {
+        volatile float input = 25.0F;
+        while (state.keep_running())
+        {
+            const sc::Measurement measurement{sc::Temperature(input)};
+            do_not_optimize(measurement.get<sc::Temperature>().get());
+        }
+    }
+
+    /***** Pin *****/
+
+    //! @brief 以前のpico::I2C::Pinと同じく，std::setを作ってピン番号を確認する
+    bool legacy_is_i2c_pin(uint8_t sda_gpio, uint8_t scl_gpio)
+    {
+        const std::set<uint8_t> PossibleSDA_0 = {0, 4, 8, 12, 16, 20};
+        const std::set<uint8_t> PossibleSCL_0 = {1, 5, 9, 13, 17, 21};
+        const std::set<uint8_t> PossibleSDA_1 = {2, 6, 10, 14, 18, 26};
+        const std::set<uint8_t> PossibleSCL_1 = {3, 7, 11, 15, 19, 27};
+        return (PossibleSDA_0.count(sda_gpio) && PossibleSCL_0.count(scl_gpio)) || (PossibleSDA_1.count(sda_gpio) && PossibleSCL_1.count(scl_gpio));
+    }
+
+    //! @brief 実行時に決まるピン番号でI2CのPinを作る  (std::setを使っていた以前の実装)
+    void bm_i2c_pin_legacy(State& state)
+    {
+        volatile uint8_t sda_gpio = 4;
+        volatile uint8_t scl_gpio = 5;
+        while (state.keep_running())
+        {
+            do_not_optimize(legacy_is_i2c_pin(sda_gpio, scl_gpio));
+        }
+    }
+
+#ifdef SC_HOST
+    //! @brief 実行時に決まるピン番号でI2CのPinを作る  (表を引くだけ)
+    void bm_i2c_pin_runtime(State& state)
+    {
+        volatile uint8_t sda_gpio = 4;
+        volatile uint8_t scl_gpio = 5;
+        while (state.keep_running())
+        {
+            const host::I2C::Pin pin(sda_gpio, scl_gpio);
+            do_not_optimize(pin.get_i2c_id());
+        }
+        constexpr host::I2C::Pin Pin = host::I2C::Pin::of<2, 3>();  // コンパイル時に確認される
+        static_assert(Pin.get_i2c_id(), "\n\n<!ERROR!> GPIO2 and GPIO3 must be I2C1\n\n");
+    }
+
+    //! @brief 8個のLEDを1ピンずつPinIOで点灯させる  (ピンの数だけ仮想関数を呼ぶ)
+    void bm_pin_io_write_x8(State& state)
+    {
+        const host::PinIO leds[8] = {{6, host::PinIO::Direction::out}, {7, host::PinIO::Direction::out}, {8, host::PinIO::Direction::out}, {9, host::PinIO::Direction::out},
+            {10, host::PinIO::Direction::out}, {11, host::PinIO::Direction::out}, {12, host::PinIO::Direction::out}, {13, host::PinIO::Direction::out}};
+        uint32_t pattern = 0;
+        while (state.keep_running())
+        {
+            ++pattern;
+            for (std::size_t i = 0; i < 8; ++i)
+            {
+                const sc::PinIO& led = leds[i];
+                led.write((pattern >> i) & 1);
+            }
+        }
+        if (((host::PinIO::get_levels() >> 6) & 0xff) != (pattern & 0xff))
+        {
+            State::fail("PinIO wrote wrong levels");
+        }
+    }
+
+    //! @brief 8個のLEDをPinGroupでまとめて点灯させる  (1回の書き込み)
+    void bm_pin_group_write_8(State& state)
+    {
+        const host::PinGroup leds(rp2040::gpio_mask({6, 7, 8, 9, 10, 11, 12, 13}), host::PinGroup::Direction::out);
+        uint32_t pattern = 0;
+        while (state.keep_running())
+        {
+            ++pattern;
+            const sc::PinGroup& group = leds;
+            group.write(pattern << 6);
+        }
+        if (((host::PinIO::get_levels() >> 6) & 0xff) != (pattern & 0xff))
+        {
+            State::fail("PinGroup wrote wrong levels");
+        }
+    }
+
+    //! @brief HC-SR04のエコーのようなパルスを，エッジの割り込みの記録から測る
+    void bm_pin_edge_irq_pulse(State& state)
+    {
+        constexpr uint8_t EchoGpio = 15;
+        constexpr uint64_t PulseWidthUs = 1166;  // 20cmの距離でのエコーのパルス幅
+        host::PinEdgeIRQ echo(rp2040::gpio_mask({EchoGpio}), host::PinEdgeIRQ::Edge::both);
+        std::size_t wrong_count = 0;
+        while (state.keep_running())
+        {
+            host::PinIO::set_level(EchoGpio, true);
+            host::Clock::advance_ns(PulseWidthUs * 1000);
+            host::PinIO::set_level(EchoGpio, false);
+            sc::PinEdgeIRQ::Event rising{}, falling{};
+            if (!echo.pop(rising) || !echo.pop(falling) || !rising.is_rising || falling.is_rising || falling.time_us - rising.time_us != PulseWidthUs) ++wrong_count;
+        }
+        if (wrong_count || echo.get_overflow_count())
+        {
+            State::fail("PinEdgeIRQ recorded a wrong pulse");
+        }
+    }
+
+    //! @brief HC-SR04のエコーの幅を続けて測る  (PIOの代わりのモデルなので，1回あたりの時間は取り出す処理のみ)
+    //! エコーの長さやタイムアウトによらず，結果が出る間隔が最短の周期(60ms)以上になることを確認する
+    void bm_pulse_capture_cycle(State& state)
+    {
+        constexpr uint8_t EchoGpio = 17;
+        constexpr uint64_t MinCycleUs = 60000;  // HC-SR04の測定の最短の周期
+        static host::EchoDevice device;  // つないだままにするので，関数を抜けても残す
+        device.set_widths({1166, sc::PulseCapture::NoEcho, 100, 29000});
+        host::PulseCapture::connect(EchoGpio, device);
+        host::PulseCapture capture(16, EchoGpio);
+        uint64_t last_us = 0;  // 前の結果が出た時刻
+        bool broken = false;
+        while (state.keep_running())
+        {
+            uint32_t width_us = 0;
+            capture.wait();
+            broken |= !capture.pop(width_us);
+            const uint64_t now_us = host::get_time_us();
+            broken |= (last_us && now_us - last_us < MinCycleUs);
+            last_us = now_us;
+        }
+        if (broken)
+        {
+            State::fail("PulseCapture measured faster than the minimum cycle");
+        }
+    }
+#endif
+
+    /***** sc::Log *****/
+
+    //! @brief ログの出力を捨てるかを切り替える
+    //! @param is_discarded trueなら何も出力せず，falseなら元の出力先に戻す
+    void discard_log_output(bool is_discarded)
+    {
+#ifdef SC_HOST
+        static std::ostream discard(nullptr);  // 何も出力しない出力先
+        host::set_log_output(is_discarded ? discard : std::cout);
+#else
+        is_log_discarded = is_discarded;
+#endif
+    }
+
+    //! @brief exam001_test.cppと同じ形式で書式化する  (出力先は捨てる)
+    void bm_log_write_format(State& state)
+    {
+        discard_log_output(true);
+        volatile float temperature = 25.0F;
+        while (state.keep_running())
+        {
+            sc::Log::write("exam001 temperature: %f\n", temperature);
+        }
+        discard_log_output(false);
+    }
+
+#ifdef SC_HOST
+    //! @brief バイナリ形式で記録する  (出力先は捨てる)
+    //! 最初にhost::LogDecoderで文字列に戻し，テキスト形式と同じになるかを確かめる
+    void bm_log_write_binary(State& state)
+    {
+        std::ostringstream binary_log;
+        host::set_log_output(binary_log);
+        sc::Log::set_format(sc::Log::Format::binary);
+        sc::Log::write("exam001 temperature: %f\n", 25.0F);
+        sc::Log::write("%s %5.1f %d %u %lld %x%%\n", "values", -1.25, -7, 7U, -1234567890123LL, 0xabU);
+        const std::size_t size_before_event = binary_log.str().size();
+        sc::Log::write("exam001 temperature: %f\n", 25.0F);
+        const std::size_t event_size = binary_log.str().size() - size_before_event;  // 書式の定義を出力済みのときの1回あたりのバイト数
+        sc::Log::write("plain text\n");
+        sc::Log::set_format(sc::Log::Format::text);
+        const std::string binary = binary_log.str();
+        host::LogDecoder decoder;
+        const std::string decoded = decoder.decode(sc::Span<const uint8_t>(reinterpret_cast<const uint8_t*>(binary.data()), binary.size()));
+        if (decoded != "exam001 temperature: 25.000000\nvalues  -1.2 -7 7 -1234567890123 ab%\nexam001 temperature: 25.000000\nplain text\n") State::fail("Log::write/binary: the decoded log differs from the text log");
+
+        std::ostream discard(nullptr);  // 何も出力しない出力先
+        host::set_log_output(discard);
+        sc::Log::set_format(sc::Log::Format::binary);
+        volatile float temperature = 25.0F;
+        while (state.keep_running())
+        {
+            sc::Log::write("exam001 temperature: %f\n", temperature);
+        }
+        sc::Log::set_format(sc::Log::Format::text);
+        host::set_log_output(std::cout);
+        state.set_counter("log_bytes", static_cast<double>(event_size) * state.iterations());
+    }
+
+    //! @brief 非同期モードで記録する  (出力は別のスレッドが行い，出力先は捨てる)
+    void bm_log_write_async(State& state)
+    {
+        std::ostream discard(nullptr);  // 何も出力しない出力先
+        host::set_log_output(discard);
+        host::start_log_drain();
+        const std::size_t dropped_count = sc::Log::get_dropped_count();
+        volatile float temperature = 25.0F;
+        while (state.keep_running())
+        {
+            sc::Log::write("exam001 temperature: %f\n", temperature);
+        }
+        host::stop_log_drain();
+        if (sc::Log::is_async()) State::fail("Log::write/async: the log is still async after the drain stopped");
+        state.set_counter("dropped", sc::Log::get_dropped_count() - dropped_count);
+        host::set_log_output(std::cout);
+    }
+#endif
+
+    /***** sc::I2C *****/
+
+#ifdef SC_HOST
+    //! @brief BME280と同じように，0xF7から8バイトの生データをまとめて読む
+    void bm_i2c_read_mem_burst(State& state)
+    {
+        const sc::I2C::SlaveAddr slave_addr(0x76);
+        const sc::I2C::MemoryAddr data_addr(0xf7);
+        host::RegisterDevice device;
+        const host::I2C i2c(host::I2C::Pin(4, 5), 400 * 1000);
+        i2c.connect(slave_addr, device);
+        while (state.keep_running())
+        {
+            const sc::Binary raw_data = i2c.read_mem(8, slave_addr, data_addr);
+            do_not_optimize(raw_data[7]);
+        }
+    }
+
+    //! @brief Exam001と同じメモリを持つセンサ
+    class Exam001Device
+    {
+    public:
+        host::RegisterDevice device;
+        Exam001Device()
+        {
+            device.set(0x00, {0x60});  // チップID
+            device.set(0x88, {0x00, 0x04, 0x01, 0x00, 0x00, 0x00});  // キャリブレーションデータ
+            device.set(0x60, {0x00, 0x9c, 0x40});  // 生データ  キャリブレーション後は25.00度
+        }
+    };
+
+    //! @brief I2C通信の回数とバス上の時間を記録
+    void set_bus_counters(State& state, const host::I2C& i2c, uint64_t start_bus_ns)
+    {
+        state.set_counter("starts", static_cast<double>(i2c.get_start_count()));
+        state.set_counter("stops", static_cast<double>(i2c.get_stop_count()));
+        state.set_counter("bus_us", (host::Clock::get_ns() - start_bus_ns) / 1000.0);
+    }
+
+    //! @brief Exam001と同じく，チップID・キャリブレーションデータ・生データを1区間ずつ読む
+    void bm_i2c_read_mem_x3(State& state)
+    {
+        const sc::I2C::SlaveAddr slave_addr(0x05);
+        Exam001Device exam001_device;
+        const host::I2C i2c(host::I2C::Pin(4, 5), 400 * 1000);
+        i2c.connect(slave_addr, exam001_device.device);
+        const uint64_t start_bus_ns = host::Clock::get_ns();
+        while (state.keep_running())
+        {
+            const sc::Binary chip_id = i2c.read_mem(1, slave_addr, sc::I2C::MemoryAddr(0x00));
+            const sc::Binary calibration_data = i2c.read_mem(6, slave_addr, sc::I2C::MemoryAddr(0x88));
+            const sc::Binary raw_data = i2c.read_mem(3, slave_addr, sc::I2C::MemoryAddr(0x60));
+            if (chip_id[0] != 0x60 || calibration_data[1] != 0x04 || raw_data[1] != 0x9c)
+            {
+                State::fail("I2C read_mem returned wrong data");
+            }
+        }
+        set_bus_counters(state, i2c, start_bus_ns);
+    }
+
+    //! @brief 同じ3区間をtransfer()でまとめて読む  STOPの回数が減る
+    void bm_i2c_transfer_x3(State& state)
+    {
+        const sc::I2C::SlaveAddr slave_addr(0x05);
+        Exam001Device exam001_device;
+        const host::I2C i2c(host::I2C::Pin(4, 5), 400 * 1000);
+        i2c.connect(slave_addr, exam001_device.device);
+        const uint64_t start_bus_ns = host::Clock::get_ns();
+        while (state.keep_running())
+        {
+            const sc::Binary input_data = i2c.transfer({
+                sc::I2C::Segment::read_mem(1, slave_addr, sc::I2C::MemoryAddr(0x00)),
+                sc::I2C::Segment::read_mem(6, slave_addr, sc::I2C::MemoryAddr(0x88)),
+                sc::I2C::Segment::read_mem(3, slave_addr, sc::I2C::MemoryAddr(0x60))});
+            if (input_data.size() != 10 || input_data[0] != 0x60 || input_data[2] != 0x04 || input_data[8] != 0x9c)
+            {
+                State::fail("I2C transfer returned wrong data");
+            }
+        }
+        set_bus_counters(state, i2c, start_bus_ns);
+        if (state.iterations() < i2c.get_stop_count())
+        {
+            State::fail("I2C transfer released the bus between segments");
+        }
+    }
+
+    //! @brief 書き込みはメモリアドレスとデータが1回で送られることを確認する
+    void bm_i2c_write_mem(State& state)
+    {
+        const sc::I2C::SlaveAddr slave_addr(0x05);
+        const sc::I2C::MemoryAddr setting_addr(0xf2);
+        Exam001Device exam001_device;
+        const host::I2C i2c(host::I2C::Pin(4, 5), 400 * 1000);
+        i2c.connect(slave_addr, exam001_device.device);
+        while (state.keep_running())
+        {
+            i2c.write_mem(sc::Binary{0x0c}, slave_addr, setting_addr);
+        }
+        if (exam001_device.device.get(0xf2) != 0x0c)
+        {
+            State::fail("I2C write_mem wrote to a wrong address");
+        }
+    }
+
+#endif
+
+    //! @brief 受信する区間に決まった値を返すだけのI2C  (呼び出し方による差だけを測るため，中身をヘッダ内に書く)
+    class FixedI2C final : public sc::I2C
+    {
+    public:
+        sc::Result<void> try_transfer_into(sc::Span<const Segment> segments, sc::Span<uint8_t> input_data) const override
+        {
+            if (get_read_size(segments) > input_data.size())
+    return SC_ERROR_INFO(sc::ErrorCode::buffer_too_small, "I2C input buffer is too small");
+            for (std::size_t i = 0; i < input_data.size(); ++i) input_data[i] = static_cast<uint8_t>(i);
+            return sc::Result<void>();
+        }
+    };
+
+    //! @brief I2CAccessで3バイトを受信する
+    //! @tparam Bus FixedI2Cなら直接(インライン化して)，sc::I2Cなら仮想関数で呼び出す
+    template<class Bus>
+    void bm_i2c_access_read_mem(State& state)
+    {
+        const sc::I2C::SlaveAddr slave_addr(0x05);
+        const sc::I2C::MemoryAddr data_addr(0x60);
+        const FixedI2C i2c;
+        const Bus* volatile bus_ptr = &i2c;  // コンパイラに実際の型を推測させない
+        const Bus& bus = *bus_ptr;
+        uint8_t raw_data[3];
+        while (state.keep_running())
+        {
+            sc::I2CAccess<Bus>::read_mem_into(bus, raw_data, slave_addr, data_addr).value();
+            do_not_optimize(raw_data[2]);
+        }
+        if (raw_data[2] != 2)
+        {
+            State::fail("I2CAccess read wrong data");
+        }
+    }
+
+    /***** sc::SPI *****/
+
+#ifdef SC_HOST
+    //! @brief 擬似的なDMAでSPIの非同期転送を重ねて行う
+    //! 開始した順に，CSのLow→メモリアドレス→データ→CSのHighの順で転送されることを確認してから，同期の読み込みを計測する
+    void bm_spi_read_mem(State& state)
+    {
+        using Type = host::SPI::Event::Type;
+        host::RegisterDevice device;
+        host::SPI spi(host::SPI::Pin(4, 3, 2, {5}), 10 * 1000 * 1000);
+        const sc::SPI::CS_Pin cs_pin(5);
+        const sc::SPI::MemoryAddr memory_addr(0x10);
+        spi.connect(cs_pin, device);
+
+        static const uint8_t Output[] = {0x11, 0x22, 0x33};
+        uint8_t input[3] = {};
+        auto write_transfer = spi.write_mem_async(sc::Span<const uint8_t>(Output), cs_pin, memory_addr);
+        auto read_transfer = spi.read_mem_async(sc::Span<uint8_t>(input), cs_pin, memory_addr);
+        bool broken = write_transfer.is_done() || read_transfer.is_done();  // まだ転送していない
+        read_transfer.wait();
+        broken |= !write_transfer.is_done() || std::memcmp(input, Output, sizeof(Output));
+
+        static const host::SPI::Event Expected[] = {
+            {Type::select, 5, 0, 0}, {Type::transfer, 5, 0x10, 0}, {Type::transfer, 5, 0x11, 0}, {Type::transfer, 5, 0x22, 0}, {Type::transfer, 5, 0x33, 0}, {Type::deselect, 5, 0, 0},
+            {Type::select, 5, 0, 0}, {Type::transfer, 5, 0x90, 0}, {Type::transfer, 5, 0, 0x11}, {Type::transfer, 5, 0, 0x22}, {Type::transfer, 5, 0, 0x33}, {Type::deselect, 5, 0, 0}};
+        constexpr std::size_t ExpectedNum = sizeof(Expected) / sizeof(Expected[0]);
+        const auto& events = spi.get_events();
+        broken |= (events.size() != ExpectedNum);
+        for (std::size_t i = 0; i < events.size() && i < ExpectedNum; ++i)
+        {
+            broken |= (events[i].type != Expected[i].type || events[i].cs_gpio != Expected[i].cs_gpio
+                || events[i].mosi != Expected[i].mosi || events[i].miso != Expected[i].miso);
+        }
+        if (broken)
+        {
+            State::fail("SPI transfers were out of order or broken");
+        }
+
+        while (state.keep_running())
+        {
+            spi.clear_events();
+            const sc::Binary raw_data = spi.read_mem(3, cs_pin, memory_addr);  // 同期の関数も非同期の転送を待つだけ
+            if (raw_data[0] != 0x11 || raw_data[2] != 0x33)
+            {
+                State::fail("SPI read_mem returned wrong data");
+            }
+        }
+    }
+#endif
+
+    /***** sc::RingBuffer / sc::DmaRingBuffer *****/
+
+#ifdef SC_HOST
+    //! @brief RingBufferの要素  2つの値が食い違っていたら読み書きが混ざっている
+    struct RingElement
+    {
+        uint32_t sequence;
+        uint32_t inverted_sequence;
+    };
+
+    //! @brief 割り込み処理とメインの処理を想定し，2つのスレッドでRingBufferを読み書きする
+    //! 全ての要素が順番通りに，欠けたり混ざったりせずに届くことを確認する
+    void bm_ring_buffer_spsc(State& state)
+    {
+        const uint32_t element_num = static_cast<uint32_t>(state.iterations());
+        sc::RingBuffer<RingElement, 256> ring_buffer;
+
+        std::thread producer([&ring_buffer, element_num]{
+            for (uint32_t sequence = 0; sequence < element_num; ++sequence)
+            {
+                while (ring_buffer.full())
+                {
+                    std::this_thread::yield();
+                }
+                ring_buffer.push(RingElement{sequence, ~sequence});
+            }
+        });
+
+        RingElement received[64];
+        uint32_t expected = 0;
+        bool broken = false;
+        while (expected < element_num && !broken)
+        {
+            const std::size_t count = ring_buffer.read_into(sc::Span<RingElement>(received));
+            if (!count)
+            {
+                std::this_thread::yield();
+            }
+            for (std::size_t i = 0; i < count && !broken; ++i)
+            {
+                broken = (received[i].sequence != expected || received[i].inverted_sequence != ~expected);
+                ++expected;
+            }
+        }
+        producer.join();
+        if (broken)
+        {
+            State::fail("RingBuffer lost or tore an element");
+        }
+    }
+
+    //! @brief DMAで受信したNMEAを，区切り文字と無通信時間でフレームに分ける
+    //! 届いた順と同じ文が1つずつ取り出せることを確認する
+    void bm_dma_framing(State& state)
+    {
+        static const char Sentence[] = "$GPGGA,123519.00,4807.0380,N,01131.0000,E,1,08,0.9,545.4,M,,M,,*47\r\n";
+        constexpr std::size_t SentenceSize = sizeof(Sentence) - 1;
+        static const char Partial[] = "$GPGSA,A,3";  // 区切り文字がなく，無通信で区切られるデータ
+        constexpr std::size_t PartialSize = sizeof(Partial) - 1;
+        sc::DmaRingBuffer<256> ring_buffer;
+        ring_buffer.set_frame('\n', 1000);
+        host::DmaChannel<256> dma(ring_buffer);
+
+        uint8_t frame[256];
+        bool broken = false;
+        while (state.keep_running())
+        {
+            dma.receive(sc::Span<const uint8_t>(reinterpret_cast<const uint8_t*>(Sentence), 20), 87);  // 途中までしか届いていない
+            broken |= dma.update().is_frame_ready(dma.get_now_us());
+            dma.receive(sc::Span<const uint8_t>(reinterpret_cast<const uint8_t*>(Sentence) + 20, SentenceSize - 20), 87);
+            std::size_t size = dma.update().read_frame_into(sc::Span<uint8_t>(frame), dma.get_now_us());
+            broken |= (size != SentenceSize || std::memcmp(frame, Sentence, SentenceSize));
+
+            dma.receive(sc::Span<const uint8_t>(reinterpret_cast<const uint8_t*>(Partial), PartialSize), 87);
+            broken |= dma.update().is_frame_ready(dma.get_now_us());
+            dma.wait(1000);
+            size = dma.update().read_frame_into(sc::Span<uint8_t>(frame), dma.get_now_us());
+            broken |= (size != PartialSize || std::memcmp(frame, Partial, PartialSize));
+
+            for (int i = 0; i < 3; ++i)  // 読み出す前に3つの文が続けて届いた
+            {
+                dma.receive(sc::Span<const uint8_t>(reinterpret_cast<const uint8_t*>(Sentence), SentenceSize), 87);
+            }
+            for (int i = 0; i < 3; ++i)  // 1つずつ区切って返す
+            {
+                size = dma.update().read_frame_into(sc::Span<uint8_t>(frame), dma.get_now_us());
+                broken |= (size != SentenceSize || std::memcmp(frame, Sentence, SentenceSize));
+            }
+            broken |= dma.update().is_frame_ready(dma.get_now_us());
+        }
+        if (broken || ring_buffer.get_overflow_count())
+        {
+            State::fail("DmaRingBuffer returned a wrong frame");
+        }
+    }
+#endif
+
+    /***** フィルタ *****/
+
+    //! @brief 疑似乱数の測定値の列を作る  (xorshift)
+    //! @param seed 乱数の状態  更新される
+    //! @return 0〜4095の値
+    int32_t next_sample(uint32_t& seed) noexcept
+    {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        return static_cast<int32_t>(seed & 0xfff);
+    }
+
+    //! @brief hc_sr04/test.cpp のcalc_distance_averageをそのまま呼び出す
+    //! 窓はグローバル変数なので，同時に1つだけ使ってください．
+    struct HcSr04Average
+    {
+        int16_t update(int32_t value) noexcept
+        {
+            hc_sr04_legacy::distance_sensor_value = static_cast<int16_t>(value);
+            hc_sr04_legacy::calc_distance_average();
+            return hc_sr04_legacy::distance_average_value;
+        }
+    };
+
+    //! @brief calc_distance_averageを窓の大きさで一般化したもの  値をずらして窓の全体を足し直す
+    template<std::size_t WindowSize>
+    class LegacyAverage
+    {
+        int32_t _window[WindowSize] = {};
+    public:
+        int32_t update(int32_t value) noexcept
+        {
+            int32_t sum = 0;
+            for (std::size_t i = WindowSize - 1; i > 0; --i)
+            {
+                _window[i] = _window[i - 1];
+                sum += _window[i];
+            }
+            _window[0] = value;
+            return (sum + value) / static_cast<int32_t>(WindowSize);
+        }
+    };
+
+    //! @brief 移動平均に値を入れる  窓の大きさで時間が変わらないことを見る
+    template<class Average>
+    void bm_moving_average(State& state)
+    {
+        Average average;
+        uint32_t seed = 1;
+        while (state.keep_running())
+        {
+            do_not_optimize(average.update(next_sample(seed)));
+        }
+    }
+
+    //! @brief MovingAverageとLegacyAverage(足し直す実装)の結果が一致することを確認する
+    void bm_moving_average_check(State& state)
+    {
+        LegacyAverage<16> legacy;
+        sc::MovingAverage<int32_t, 16> average;
+        sc::MovingAverage<float, 16> average_float;
+        uint32_t seed = 1;
+        for (std::size_t i = 0; i < 16; ++i)  // 窓を埋める  (埋まるまでは平均の取り方が違う)
+        {
+            const int32_t sample = next_sample(seed);
+            legacy.update(sample);
+            average.update(sample);
+            average_float.update(static_cast<float>(sample));
+        }
+        bool broken = false;
+        while (state.keep_running())
+        {
+            const int32_t sample = next_sample(seed);
+            const int32_t expected = legacy.update(sample);
+            broken |= (average.update(sample) != expected);
+            broken |= (std::fabs(average_float.update(static_cast<float>(sample)) - static_cast<float>(expected)) > 1.0F);
+        }
+        if (broken)
+        {
+            State::fail("MovingAverage returned a wrong average");
+        }
+    }
+
+    //! @brief MovingAverage<int16_t, 3>とhc_sr04/test.cpp のcalc_distance_averageの結果が一致することを確認する
+    //! calc_distance_averageは窓を0で埋めた状態から3で割るので，窓が埋まってから比べる．値はint16_tの全範囲から選ぶ．
+    void bm_calc_distance_average_check(State& state)
+    {
+        HcSr04Average legacy;
+        sc::MovingAverage<int16_t, 3> average;
+        uint32_t seed = 1;
+        const auto next_distance = [&seed] {next_sample(seed); return static_cast<int16_t>(seed);};
+        for (std::size_t i = 0; i < 3; ++i)  // 窓を埋める
+        {
+            const int16_t distance = next_distance();
+            legacy.update(distance);
+            average.update(distance);
+        }
+        bool broken = false;
+        while (state.keep_running())
+        {
+            const int16_t distance = next_distance();
+            broken |= (average.update(distance) != legacy.update(distance));
+        }
+        if (broken)
+        {
+            State::fail("MovingAverage<int16_t, 3> differs from calc_distance_average");
+        }
+    }
+
+    //! @brief MovingMedianに値を入れ，並べ替えて求めた中央値と一致することを確認する
+    void bm_moving_median_5(State& state)
+    {
+        sc::MovingMedian<int32_t, 5> median;
+        int32_t window[5] = {};
+        std::size_t index = 0;
+        uint32_t seed = 1;
+        bool broken = false;
+        while (state.keep_running())
+        {
+            const int32_t sample = next_sample(seed);
+            window[index++ % 5] = sample;
+            const int32_t result = median.update(sample);
+            if (index >= 5)
+            {
+                int32_t sorted[5];
+                std::copy(window, window + 5, sorted);
+                std::nth_element(sorted, sorted + 2, sorted + 5);
+                broken |= (result != sorted[2]);
+            }
+        }
+        if (broken)
+        {
+            State::fail("MovingMedian returned a wrong median");
+        }
+    }
+
+    //! @brief 整数の指数移動平均とローパスフィルタに一定の値を入れ，その値に落ち着くことを確認する
+    template<class Filter>
+    void bm_filter_step(State& state, Filter filter)
+    {
+        filter.update(0);
+        int32_t output = 0;
+        std::size_t count = 0;
+        while (state.keep_running())
+        {
+            output = filter.update(count++ < 1000 ? 1000 : 0);  // 1000回だけ1000を入れ，その後は0に戻す
+            do_not_optimize(output);
+        }
+        const int32_t expected = (count <= 1000) ? 1000 : 0;
+        if (count > 200 && std::abs(output - expected) > 1)  // 十分な回数を入れたら，誤差は切り捨ての1以内
+        {
+            State::fail("The filter did not settle to the input");
+        }
+    }
+
+    void bm_exponential_average(State& state) {bm_filter_step(state, sc::ExponentialAverage<int32_t, 4>());}
+
+    void bm_first_order_iir(State& state) {bm_filter_step(state, sc::FirstOrderIIR<int32_t>::low_pass(10.0F, 1000.0F));}
+
+    //! @brief 測定値(Distance)を中央値のフィルタに通す
+    void bm_quantity_filter(State& state)
+    {
+        sc::QuantityFilter<sc::Distance, sc::MovingMedian<float, 3>> distance_filter;
+        const float distances[3] = {20.0F, 400.0F, 21.0F};  // 2つ目は誤反射
+        std::size_t count = 0;
+        float output = 0.0F;
+        while (state.keep_running())
+        {
+            output = distance_filter.update(sc::Distance(distances[count++ % 3])).get();
+        }
+        if (count >= 3 && output != 21.0F && output != 20.0F)
+        {
+            State::fail("QuantityFilter did not remove the outlier");
+        }
+    }
+
+    /***** sc::HysteresisClassifier *****/
+
+    //! @brief 超音波センサで測った距離(cm)の安全の段階  距離が小さい方から並べる
+    enum class Safety : uint8_t
+    {
+        stop,
+        danger,
+        attention,
+        safe
+    };
+
+    //! @brief hc_sr04/test.cpp のjudge_dist_safeの境目を書き写した表 (cm)  {rise, fall}
+    //! 元の処理は「〜より大きければ上がる」なので，整数のriseは元の境目+1にする．
+    //! 停止と危険の境目だけは元の処理が逆向き(60未満で停止，50より大きければ危険)で，50〜60cmでは呼び出すたびに停止と危険を行き来する．
+    //! ここでは停止に入る60cmを残し，60cmより大きくなるまで停止のままにする．
+    constexpr sc::HysteresisClassifier<int16_t, 4>::Thresholds SafetyThresholds = {{{61, 60}, {151, 140}, {211, 200}}};
+
+    //! @brief hc_sr04/test.cpp のjudge_dist_safeをそのまま呼び出す  (段階の番号は元の処理と逆順)
+    //! @param safety 今の段階
+    //! @param distance 距離の平均 (cm)
+    //! @return 新しい段階
+    Safety judge_dist_safe(Safety safety, int16_t distance)
+    {
+        hc_sr04_legacy::distance_safe_state = static_cast<int8_t>(static_cast<uint8_t>(Safety::safe) - static_cast<uint8_t>(safety));
+        hc_sr04_legacy::distance_average_value = distance;
+        hc_sr04_legacy::judge_dist_safe();
+        return static_cast<Safety>(static_cast<uint8_t>(Safety::safe) - hc_sr04_legacy::distance_safe_state);
+    }
+
+    //! @brief 全ての段階から，int16_tの全ての距離を入れ，step()がjudge_dist_safeと同じ段階になることを確認する
+    //! 停止から51〜60cmのときだけは，元の処理が危険に上がり，step()は停止のままであることを確認する
+    void bm_hysteresis_exhaustive(State& state)
+    {
+        bool broken = false;
+        while (state.keep_running())
+        {
+            for (uint8_t level = 0; level < 4; ++level)
+            {
+                for (int32_t distance = INT16_MIN; distance <= INT16_MAX; ++distance)
+                {
+                    sc::HysteresisClassifier<int16_t, 4> safety(SafetyThresholds, level);
+                    const auto transition = safety.step(static_cast<int16_t>(distance));
+                    Safety expected = judge_dist_safe(static_cast<Safety>(level), static_cast<int16_t>(distance));
+                    if (static_cast<Safety>(level) == Safety::stop && 50 < distance && distance <= 60)
+                    {
+                        broken |= (expected != Safety::danger);  // 元の処理は逆向きの境目で危険に上がる
+                        expected = Safety::stop;
+                    }
+                    broken |= (transition.to != static_cast<uint8_t>(expected) || transition.is_changed() != (expected != static_cast<Safety>(level)));
+                }
+            }
+        }
+        constexpr uint8_t CompileTimeLevel = []{
+            sc::HysteresisClassifier<int16_t, 4> safety(SafetyThresholds, 3);
+            return safety.step(20).to;
+        }();
+        static_assert(CompileTimeLevel == static_cast<uint8_t>(Safety::attention), "\n\n<!ERROR!> HysteresisClassifier must work at compile time\n\n");  // コンパイル時にも判定できる  1段階だけ下がる
+        if (broken)
+        {
+            State::fail("HysteresisClassifier::step differs from judge_dist_safe");
+        }
+    }
+
+    //! @brief 近づいて離れる距離の列で段階を判定する  (hc_sr04/test.cpp のjudge_dist_safe)
+    void bm_hysteresis_legacy(State& state)
+    {
+        Safety safety = Safety::safe;
+        uint32_t seed = 1;
+        while (state.keep_running())
+        {
+            safety = judge_dist_safe(safety, static_cast<int16_t>(next_sample(seed) % 300));
+            do_not_optimize(safety);
+        }
+    }
+
+    //! @brief 近づいて離れる距離の列で段階を判定する  (HysteresisClassifier::step)
+    void bm_hysteresis_step(State& state)
+    {
+        sc::HysteresisClassifier<int16_t, 4> safety(SafetyThresholds, static_cast<uint8_t>(Safety::safe));
+        uint32_t seed = 1;
+        while (state.keep_running())
+        {
+            do_not_optimize(safety.step(static_cast<int16_t>(next_sample(seed) % 300)));
+        }
+    }
+
+    //! @brief 近づいて離れる距離の列で段階を判定する  (HysteresisClassifier::update  一度に何段階でも移る)
+    void bm_hysteresis_update(State& state)
+    {
+        sc::HysteresisClassifier<int16_t, 4> safety(SafetyThresholds, static_cast<uint8_t>(Safety::safe));
+        uint32_t seed = 1;
+        while (state.keep_running())
+        {
+            do_not_optimize(safety.update(static_cast<int16_t>(next_sample(seed) % 300)));
+        }
+    }
+
+    /***** sc::Pipeline *****/
+
+    //! @brief 1つのスレッドで値を入れて処理する  (パイプラインの1値あたりのコスト)
+    //! 2つ目の段がfalseを返した値は3つ目の段を通らないこと，満杯で捨てた値が数えられることを確認する
+    void bm_pipeline_push_process(State& state)
+    {
+        uint32_t passed_count = 0;
+        auto pipeline = sc::make_pipeline<uint32_t, 8>(sc::PipelineBase::Backpressure::drop,
+            [](uint32_t& sample) {sample *= 3;},
+            [](uint32_t& sample) {return sample % 2 == 0;},  // 奇数は捨てる
+            [&passed_count](uint32_t&) {++passed_count;});
+        uint32_t sequence = 0;
+        while (state.keep_running())
+        {
+            pipeline.push(sequence++, get_time_us());
+            pipeline.process(get_time_us);
+        }
+        for (uint32_t i = 0; i < 10; ++i)  // 満杯にして2つ捨てる
+        {
+            pipeline.push(i, get_time_us());
+        }
+        while (pipeline.process(get_time_us)) {}
+        if (pipeline.get_drop_count() != 2 || pipeline.get_stage_stats(0).count != sequence + 8 || pipeline.get_stage_stats(2).count != passed_count || passed_count != (sequence + 1) / 2 + 4)
+        {
+            State::fail("Pipeline processed a wrong number of samples");
+        }
+    }
+
+#ifdef SC_HOST
+    //! @brief コア0(メインのスレッド)で値を入れ，コア1の代わりのスレッドで処理する
+    //! 全ての値が順番通りに全ての段を通ることを確認する
+    void bm_pipeline_2_threads(State& state)
+    {
+        const uint32_t sample_num = static_cast<uint32_t>(state.iterations());
+        uint32_t expected = 0;  // 処理側のスレッドだけが使う
+        bool broken = false;
+        auto pipeline = sc::make_pipeline<uint32_t, 64>(sc::PipelineBase::Backpressure::wait,
+            [](uint32_t& sample) {sample = ~sample;},
+            [&expected, &broken](uint32_t& sample) {broken |= (~sample != expected++);});
+        host::start_pipeline(pipeline);
+        for (uint32_t sequence = 0; sequence < sample_num; ++sequence)
+        {
+            while (pipeline.is_queue_full())  // CPUが1つでも処理側が動けるように，待つ間は譲る  (push()はコア1を待つために回り続ける)
+            {
+                std::this_thread::yield();
+            }
+            pipeline.push(sequence, get_time_us());
+        }
+        host::stop_core1();  // 残りを処理してスレッドを止める
+        if (broken || expected != sample_num || pipeline.get_stage_stats(1).count != sample_num || pipeline.get_queue_stats().count != sample_num || pipeline.get_drop_count())
+        {
+            State::fail("Pipeline lost or reordered a sample");
+        }
+    }
+
+    //! @brief 処理側のスレッド(コア1)と元のスレッド(コア0)の両方からログを書き込みながら，パイプラインを動かす
+    //! 満杯で捨てた数を除いた全てのログが，混ざったり欠けたりせずに書き込んだ順で1行ずつ出力されることを確認する
+    void bm_pipeline_2_threads_log(State& state)
+    {
+        const uint32_t sample_num = static_cast<uint32_t>(state.iterations());
+        std::ostringstream log;
+        host::set_log_output(log);
+        const std::size_t dropped_count = sc::Log::get_dropped_count();
+        auto pipeline = sc::make_pipeline<uint32_t, 64>(sc::PipelineBase::Backpressure::wait,
+            [](uint32_t& sample) {sc::Log::write("core1 %08x\n", sample);});
+        host::start_pipeline(pipeline);
+        for (uint32_t sequence = 0; sequence < sample_num; ++sequence)
+        {
+            while (pipeline.is_queue_full())  // CPUが1つでも処理側が動けるように，待つ間は譲る
+            {
+                std::this_thread::yield();
+            }
+            pipeline.push(sequence, get_time_us());
+            sc::Log::write("core0 %08x\n", sequence);
+        }
+        host::stop_core1();  // 残りを処理してスレッドを止め，残りのログを出力する
+        host::set_log_output(std::cout);
+
+        std::istringstream lines(log.str());
+        std::string line;
+        std::size_t line_count = 0;
+        int64_t last_sequence[2] = {-1, -1};  // コアごとに最後に出力された値
+        bool broken = false;
+        while (std::getline(lines, line))
+        {
+            if (line.compare(0, 7, "<<LOG>>") == 0)
+        continue;  // 捨てたログの数の報告
+            unsigned core = 0, sequence = 0;
+            char rest = 0;
+            if (std::sscanf(line.c_str(), "core%u %8x%c", &core, &sequence, &rest) != 2 || core > 1 || line.size() != 14 || sequence >= sample_num || sequence <= last_sequence[core])
+            {
+                broken = true;
+        break;
+            }
+            last_sequence[core] = sequence;
+            ++line_count;
+        }
+        const std::size_t new_dropped_count = sc::Log::get_dropped_count() - dropped_count;
+        if (broken || line_count + new_dropped_count != 2 * static_cast<std::size_t>(sample_num))
+        {
+            State::fail("Log was torn or lost while both threads wrote it");
+        }
+        state.set_counter("dropped", static_cast<double>(new_dropped_count));
+    }
+#endif
+
+    /***** sc::Scheduler *****/
+
+    //! @brief シミュレーション上の時刻で，3つの周期のタスクを1秒分動かす
+    //! 回数・周期・遅れが予定通りであることを確認する
+    void bm_scheduler_3_rates(State& state)
+    {
+        bool broken = false;
+        while (state.keep_running())
+        {
+            uint64_t now_us = 0;
+            auto get_now_us = [&now_us] {return now_us;};
+            uint32_t counts[3] = {};
+            auto task_1k = [&counts] {++counts[0];};
+            auto task_400 = [&counts] {++counts[1];};
+            auto task_100 = [&counts] {++counts[2];};
+            sc::Scheduler<> scheduler;
+            const auto id_1k = scheduler.add(task_1k, 1000);
+            scheduler.add(task_400, 2500, 500);
+            const auto id_100 = scheduler.add(task_100, 10000);
+            while (scheduler.get_next_deadline_us() < 1000000)
+            {
+                now_us = scheduler.get_next_deadline_us();
+                scheduler.run_pending(get_now_us);
+            }
+            const auto& stats = scheduler.get_stats(id_1k);
+            broken |= (counts[0] != 1000 || counts[1] != 400 || counts[2] != 100);
+            broken |= (stats.period.min_us != 1000 || stats.period.max_us != 1000 || stats.lateness.max_us != 0 || stats.overrun_count);
+            broken |= (scheduler.get_stats(id_100).period.get_mean_us() != 10000.0F);
+        }
+        if (broken)
+        {
+            State::fail("Scheduler ran a task at a wrong time");
+        }
+    }
+
+    //! @brief 5回目の実行だけ3.5周期かかるタスクを，オーバーランしたときの動作を変えて動かす
+    //! @param overrun オーバーランしたときの動作
+    //! @return 統計  実行した回数はexecution.count
+    sc::Scheduler<>::TaskStats run_overrun_task(sc::Scheduler<>::Overrun overrun)
+    {
+        uint64_t now_us = 0;
+        auto get_now_us = [&now_us] {return now_us;};
+        uint32_t count = 0;
+        auto task = [&now_us, &count] {if (count++ == 5) now_us += 3500;};  // 時刻5000に始めた実行が8500まで終わらない
+        sc::Scheduler<> scheduler;
+        const auto id = scheduler.add(task, 1000, 0, overrun);
+        while (scheduler.get_next_deadline_us() <= 20000)
+        {
+            now_us = std::max(now_us, scheduler.get_next_deadline_us());
+            scheduler.run_pending(get_now_us);
+        }
+        return scheduler.get_stats(id);
+    }
+
+    //! @brief オーバーランしたとき，catch_upは抜けた回を続けて実行し，skipは飛ばすことを確認する
+    void bm_scheduler_overrun(State& state)
+    {
+        bool broken = false;
+        while (state.keep_running())
+        {
+            const auto catch_up = run_overrun_task(sc::Scheduler<>::Overrun::catch_up);  // 時刻0〜20000の21回を全て実行する  6000と7000の回は8500に遅れて実行
+            broken |= (catch_up.execution.count != 21 || catch_up.overrun_count != 2 || catch_up.skip_count || catch_up.lateness.max_us != 2500 || catch_up.period.min_us != 0);
+            const auto skip = run_overrun_task(sc::Scheduler<>::Overrun::skip);  // 6000の回を8500に実行し，7000と8000の回を飛ばす
+            broken |= (skip.execution.count != 19 || skip.overrun_count != 1 || skip.skip_count != 2 || skip.period.max_us != 3500);
+        }
+        if (broken)
+        {
+            State::fail("Scheduler handled an overrun wrongly");
+        }
+    }
+
+    //! @brief 8つのタスクのうち1つの時刻が来たときに，run_pending()にかかる時間
+    void bm_scheduler_run_pending(State& state)
+    {
+        uint64_t now_us = 0;
+        auto get_now_us = [&now_us] {return now_us;};
+        uint32_t count = 0;
+        auto task = [&count] {++count;};
+        sc::Scheduler<> scheduler;
+        for (uint32_t i = 0; i < 8; ++i)
+        {
+            scheduler.add(task, 8000, i * 1000);
+        }
+        while (state.keep_running())
+        {
+            now_us = scheduler.get_next_deadline_us();
+            scheduler.run_pending(get_now_us);
+        }
+        if (count != state.iterations())
+        {
+            State::fail("Scheduler missed a task");
+        }
+    }
+
+    /***** NmeaParser *****/
+
+    //! @brief 記録したGNSS受信機のNMEAの出力  (GPS・GLONASSの2つの衛星システム，受信機独自の長い文を含む1秒×2回分)
+    constexpr char RecordedNmea[] =
+        "$GNRMC,032644.00,A,3540.87416,N,13946.02750,E,0.154,,170524,,,A*6B\r\n"
+        "$GNGGA,032644.00,3540.87416,N,13946.02750,E,1,12,0.78,40.3,M,39.4,M,,*77\r\n"
+        "$GNGSA,A,3,03,06,14,17,19,22,24,28,,,,,1.32,0.78,1.07*17\r\n"
+        "$GNGSA,A,3,66,67,76,82,,,,,,,,,1.32,0.78,1.07*1F\r\n"
+        "$GPGSV,3,1,10,03,42,135,38,06,23,061,31,14,67,322,44,17,45,212,40*74\r\n"
+        "$GLGSV,2,1,05,66,33,290,30,67,71,041,35,76,22,152,28,82,18,318,25*6C\r\n"
+        "$PUBX,00,032644.00,3540.87416,N,13946.02750,E,82.2,G3,2.1,2.0,0.007,77.52,0.007,,0.92,1.19,0.77,9,0,0*65\r\n"
+        "$GNRMC,032645.00,A,3540.87420,N,13946.02755,E,0.120,,170524,,,A*69\r\n"
+        "$GNGGA,032645.00,3540.87420,N,13946.02755,E,1,12,0.79,40.4,M,39.4,M,,*70\r\n"
+        "$GNGSA,A,3,03,06,14,17,19,22,24,28,,,,,1.33,0.79,1.08*18\r\n"
+        "$GNGSA,A,3,66,67,76,82,,,,,,,,,1.33,0.79,1.08*10\r\n";
+    constexpr std::size_t RecordedNmeaSentenceNum = 11;  // RecordedNmeaの文の数
+
+    //! @brief RecordedNmeaを文字列の終端を除いたバイト列として取得
+    sc::Span<const uint8_t> get_recorded_nmea() noexcept
+    {
+        return sc::Span<const uint8_t>(reinterpret_cast<const uint8_t*>(RecordedNmea), sizeof(RecordedNmea) - 1);
+    }
+
+    //! @brief RecordedNmeaの最後の測位結果を解析できたかを確認する
+    bool is_recorded_fix(const sc::Measurement& measurement)
+    {
+        if (!measurement.contains<sc::Position>() || !measurement.contains<sc::Time>() || !measurement.contains<sc::DOP>())
+    return false;
+        const sc::Position position = measurement.get<sc::Position>();
+        const sc::Time time = measurement.get<sc::Time>();
+        const sc::DOP dop = measurement.get<sc::DOP>();
+        return position.get_latitude_e7() == 356812367 && position.get_longitude_e7() == 1397671258 && position.get_altitude_mm() == 40400
+            && time.get_millisecond_of_day() == (3 * 3600 + 26 * 60 + 45) * 1000 && time.get_year() == 2024 && time.get_month() == 5 && time.get_day() == 17
+            && dop.get_centi_pdop() == 133 && dop.get_centi_hdop() == 79 && dop.get_centi_vdop() == 108;
+    }
+
+    //! @brief 記録したNMEAの出力を1バイトずつ解析する  bytesの1バイトあたりの時間を，115200bpsの1バイトの時間(約87μs)と比べてください
+    void bm_nmea_parser_recorded(State& state)
+    {
+        const sc::Span<const uint8_t> recorded_nmea = get_recorded_nmea();
+        sc::NmeaParser parser;
+        std::size_t sentence_num = 0;
+        while (state.keep_running())
+        {
+            sentence_num += parser.feed(recorded_nmea);
+        }
+        state.set_counter("bytes", static_cast<double>(recorded_nmea.size()) * state.iterations());
+        if (sentence_num != RecordedNmeaSentenceNum * state.iterations() || parser.get_stats().checksum_error_count || parser.get_stats().format_error_count || !is_recorded_fix(parser.get_measurement()))
+        {
+            State::fail("NmeaParser did not parse the recorded NMEA");
+        }
+    }
+
+    //! @brief 文を途中で区切って少しずつ渡しても，続きから解析できることを確認する
+    void bm_nmea_parser_split(State& state)
+    {
+        const sc::Span<const uint8_t> recorded_nmea = get_recorded_nmea();
+        sc::NmeaParser parser;
+        std::size_t sentence_num = 0;
+        std::size_t chunk_size = 0;
+        while (state.keep_running())
+        {
+            chunk_size = chunk_size % 13 + 1;  // 1〜13バイトずつ
+            for (std::size_t offset = 0; offset < recorded_nmea.size(); offset += chunk_size)
+            {
+                sentence_num += parser.feed(recorded_nmea.subspan(offset, std::min(chunk_size, recorded_nmea.size() - offset)));
+            }
+        }
+        if (sentence_num != RecordedNmeaSentenceNum * state.iterations() || !is_recorded_fix(parser.get_measurement()))
+        {
+            State::fail("NmeaParser did not resume a split sentence");
+        }
+    }
+
+    //! @brief 記録したNMEAの出力の一部のバイトを乱数で壊して解析する  (ファジング)
+    //! 壊れた文はチェックサムで捨て，その後に正しい文を受信すれば元の値に戻ることを確認する
+    void bm_nmea_parser_fuzz(State& state)
+    {
+        const sc::Span<const uint8_t> recorded_nmea = get_recorded_nmea();
+        std::vector<uint8_t> broken_nmea(recorded_nmea.begin(), recorded_nmea.end());
+        sc::NmeaParser parser;
+        uint32_t seed = 1;
+        bool broken = false;
+        while (state.keep_running())
+        {
+            std::copy(recorded_nmea.begin(), recorded_nmea.end(), broken_nmea.begin());
+            for (int i = 0; i < 4; ++i)
+            {
+                const std::size_t index = (static_cast<uint32_t>(next_sample(seed)) << 12 | static_cast<uint32_t>(next_sample(seed))) % broken_nmea.size();
+                broken_nmea[index] = static_cast<uint8_t>(next_sample(seed));  // 任意のバイト  ('$'や改行，0x80以上も含む)
+            }
+            const sc::NmeaParser::Stats before = parser.get_stats();
+            parser.feed(sc::Span<const uint8_t>(broken_nmea.data(), broken_nmea.size()));
+            const sc::NmeaParser::Stats& after = parser.get_stats();
+            broken |= (after.sentence_count - before.sentence_count > RecordedNmeaSentenceNum + 4);  // 壊したバイトが'$'なら文が増えることがある
+            parser.feed(recorded_nmea);
+            broken |= !is_recorded_fix(parser.get_measurement());
+        }
+        if (broken)
+        {
+            State::fail("NmeaParser did not recover from a broken NMEA stream");
+        }
+    }
+
+#ifdef SC_HOST
+    //! @brief UARTで受信したNMEAを，受信バッファから直接解析する  (ヒープを使わない)
+    void bm_nmea_parser_uart(State& state)
+    {
+        const host::UART uart(host::UART::Pin(4, 5), 115200);  // UART1を使う
+        const sc::Span<const uint8_t> recorded_nmea = get_recorded_nmea();
+        sc::NmeaParser parser;
+        std::size_t sentence_num = 0;
+        while (state.keep_running())
+        {
+            for (std::size_t offset = 0; offset < recorded_nmea.size(); offset += host::UART::RxBuffer::capacity())
+            {
+                uart.receive(recorded_nmea.subspan(offset, std::min(host::UART::RxBuffer::capacity(), recorded_nmea.size() - offset)));
+                sentence_num += parser.poll(uart);
+            }
+        }
+        if (sentence_num != RecordedNmeaSentenceNum * state.iterations() || !is_recorded_fix(parser.get_measurement()))
+        {
+            State::fail("NmeaParser did not parse NMEA received by UART");
+        }
+    }
+#endif
+
+    //! @brief 測位が途切れたときにPositionを消し，チェックサムの違う文を捨てることを確認する
+    void bm_nmea_parser_lost_fix(State& state)
+    {
+        static constexpr char LostFix[] =
+            "$GNGGA,032646.00,,,,,0,00,99.99,,,,,,*7D\r\n"
+            "$GNGSA,A,1,,,,,,,,,,,,,99.99,99.99,99.99*2E\r\n"
+            "$GNGGA,032647.00,3540.87420,N,13946.02755,E,1,12,0.79,40.4,M,39.4,M,,*00\r\n";  // チェックサムが違う
+        const sc::Span<const uint8_t> recorded_nmea = get_recorded_nmea();
+        const sc::Span<const uint8_t> lost_fix(reinterpret_cast<const uint8_t*>(LostFix), sizeof(LostFix) - 1);
+        sc::NmeaParser parser;
+        bool broken = false;
+        while (state.keep_running())
+        {
+            parser.feed(recorded_nmea);
+            const uint32_t checksum_error_count = parser.get_stats().checksum_error_count;
+            broken |= (parser.feed(lost_fix) != 2);
+            const sc::Measurement& measurement = parser.get_measurement();
+            broken |= (measurement.contains<sc::Position>() || measurement.contains<sc::DOP>() || !measurement.contains<sc::Time>());
+            broken |= (measurement.get<sc::Time>().get_millisecond_of_day() != (3 * 3600 + 26 * 60 + 46) * 1000 || measurement.get<sc::Time>().get_day() != 17);
+            broken |= (parser.get_stats().checksum_error_count != checksum_error_count + 1);
+        }
+        if (broken)
+        {
+            State::fail("NmeaParser kept a lost fix or accepted a wrong checksum");
+        }
+    }
+
+    /***** SectorWriter *****/
+
+    //! @brief 書き出したデータをメモリに保存する書き出し先  (SectorWriterのStorage)
+    struct MemoryStorage
+    {
+        std::vector<uint8_t> data;  // 書き出したデータ  (ファイルの中身)
+        std::vector<std::pair<uint64_t, std::size_t>> writes;  // 書き出した位置とバイト数
+        bool is_writing = false;  // 書き出し中か
+
+        explicit MemoryStorage(std::size_t capacity)
+        {
+            data.reserve(capacity);
+            writes.reserve(capacity / 512 + 16);
+        }
+
+        sc::Result<void> begin_write(uint64_t offset, sc::Span<const uint8_t> output_data)
+        {
+            if (is_writing || offset != data.size())
+    return SC_ERROR_INFO(sc::ErrorCode::invalid_argument, "Wrong write to MemoryStorage");  // 書き出し中か，末尾以外への書き出し
+            data.insert(data.end(), output_data.begin(), output_data.end());
+            writes.emplace_back(offset, output_data.size());
+            is_writing = true;
+            return {};
+        }
+
+        sc::Result<void> wait_write() noexcept
+        {
+            is_writing = false;
+            return {};
+        }
+
+        void clear() noexcept
+        {
+            data.clear();
+            writes.clear();
+        }
+    };
+
+    //! @brief GNSSの1回の測位で記録するNMEAの文
+    constexpr char NmeaLine[] = "$GPGGA,032645.12,3540.8742,N,13946.0275,E,1,07,0.9,40.2,M,,M,,*4D\r\n";
+    constexpr std::size_t NmeaLinePerWindow = 300;  // 書き出すまでに記録する文の数  (gnss_trackerのIDLE_ACTIVE_TIMEに1秒ごとの測位)
+
+    //! @brief 以前のgnss_trackerと同じく，strncatで文を追記し，300回ごとにstrlenで長さを求めてまとめて書き出す
+    void bm_sector_writer_legacy(State& state)
+    {
+        static char nmea_buffer[128 * NmeaLinePerWindow];  // gnss_trackerのNMEA_BUFFER_SIZE×文の数
+        MemoryStorage storage(sizeof(nmea_buffer) * 2);
+        nmea_buffer[0] = '\0';
+        std::size_t line_count = 0;
+        while (state.keep_running())
+        {
+            std::strncat(nmea_buffer, NmeaLine, sizeof(nmea_buffer) - std::strlen(nmea_buffer) - 1);  // 毎回，文字列の終端を探す
+            if (++line_count % NmeaLinePerWindow == 0)
+            {
+                storage.clear();
+                storage.begin_write(0, sc::Span<const uint8_t>(reinterpret_cast<const uint8_t*>(nmea_buffer), std::strlen(nmea_buffer)));
+                storage.wait_write();
+                nmea_buffer[0] = '\0';
+            }
+        }
+        do_not_optimize(storage.data.size());
+    }
+
+    //! @brief 書き出したバイト数だけを数える書き出し先  (SectorWriterのStorage)
+    struct CountingStorage
+    {
+        uint64_t size = 0;  // 書き出したバイト数
+
+        sc::Result<void> begin_write(uint64_t offset, sc::Span<const uint8_t> output_data) noexcept
+        {
+            if (offset != size)
+    return SC_ERROR_INFO(sc::ErrorCode::invalid_argument, "Wrong write to CountingStorage");  // 末尾以外への書き出し
+            size += output_data.size();
+            do_not_optimize(output_data.data()[output_data.size() - 1]);
+            return {};
+        }
+
+        sc::Result<void> wait_write() noexcept {return {};}
+    };
+
+    //! @brief SectorWriterで文を追記し，バッファが満杯になるたびにセクタ単位で書き出す  300回ごとにflush()する
+    void bm_sector_writer_append(State& state)
+    {
+        CountingStorage storage;
+        sc::SectorWriter<CountingStorage> writer(storage);
+        const sc::Span<const uint8_t> line(reinterpret_cast<const uint8_t*>(NmeaLine), sizeof(NmeaLine) - 1);
+        std::size_t line_count = 0;
+        while (state.keep_running())
+        {
+            writer.append(line).value();
+            if (++line_count % NmeaLinePerWindow == 0)
+            {
+                writer.flush().value();
+            }
+        }
+        writer.flush().value();
+        state.set_counter("writes", static_cast<double>(writer.get_write_count()));
+        if (storage.size != line.size() * state.iterations())
+        {
+            State::fail("SectorWriter lost data");
+        }
+    }
+
+    //! @brief 既存のファイルの途中の位置から追記し，途中でflush()しても，書き出しがセクタの境界で終わり，データが欠けないことを確認する
+    void bm_sector_writer_alignment(State& state)
+    {
+        constexpr std::size_t ExistingSize = 100;  // 既存のファイルのバイト数
+        MemoryStorage storage(64 * 1024);
+        uint32_t seed = 1;
+        bool broken = false;
+        while (state.keep_running())
+        {
+            storage.clear();
+            storage.data.assign(ExistingSize, 0);
+            std::vector<uint8_t> expected = storage.data;
+            std::vector<uint64_t> flush_sizes;  // flush()したときのファイル上の位置
+            {
+                sc::SectorWriter<MemoryStorage, 512, 2> writer(storage, ExistingSize);
+                for (int i = 0; i < 40; ++i)
+                {
+                    uint8_t record[97];  // セクタの大きさと割り切れないバイト数
+                    const std::size_t size = static_cast<std::size_t>(next_sample(seed)) % sizeof(record) + 1;
+                    for (std::size_t j = 0; j < size; ++j) record[j] = static_cast<uint8_t>(next_sample(seed));
+                    expected.insert(expected.end(), record, record + size);
+                    broken |= !writer.append(sc::Span<const uint8_t>(record, size));
+                    if (i % 15 == 14)  // 途中のセクタで書き出す
+                    {
+                        broken |= !writer.flush();
+                        flush_sizes.push_back(writer.get_size());
+                    }
+                    broken |= (writer.get_size() != expected.size());
+                }
+                broken |= !writer.flush();
+                flush_sizes.push_back(writer.get_size());
+                broken |= (writer.get_pending_size() != 0);
+            }
+            broken |= (storage.data != expected);
+            for (const std::pair<uint64_t, std::size_t>& write : storage.writes)
+            {
+                const uint64_t end = write.first + write.second;
+                broken |= (end % 512 != 0 && std::find(flush_sizes.begin(), flush_sizes.end(), end) == flush_sizes.end());  // flush()以外はセクタの境界で終わる
+            }
+        }
+        if (broken)
+        {
+            State::fail("SectorWriter wrote a misaligned sector or lost data");
+        }
+    }
+
+#ifdef SC_HOST
+    /***** FatFile (host::SD) *****/
+
+    constexpr char SdImageName[] = "sc_bench_sd.img";  // ベンチマークで作るSDカードのディスクイメージ  終わったら消す
+    constexpr uint32_t SdImageBlockNum = 131072;  // ディスクイメージのブロック数  (64MiB)
+
+    //! @brief ディスクイメージのブロックを読む  (FatFileを通さずに確認するためのもの)
+    bool read_image_block(std::FILE* image, uint32_t block, uint8_t (&data)[sc::SD::BlockSize])
+    {
+        return std::fseek(image, static_cast<long>(block) * static_cast<long>(sc::SD::BlockSize), SEEK_SET) == 0
+            && std::fread(data, 1, sizeof(data), image) == sizeof(data);
+    }
+
+    uint32_t load_le32(const uint8_t* data) noexcept
+    {
+        return static_cast<uint32_t>(data[0]) | static_cast<uint32_t>(data[1]) << 8 | static_cast<uint32_t>(data[2]) << 16 | static_cast<uint32_t>(data[3]) << 24;
+    }
+
+    //! @brief 確保したファイルに，SectorWriterで256バイトずつ追記する  (8KiBごとに16ブロックをまとめて書く)
+    //! ファイルが満杯になったら，ディスクイメージを作り直して続けます．
+    void bm_fat_file_append(State& state)
+    {
+        constexpr uint64_t FileCapacity = 32 * 1024 * 1024;  // 確保するバイト数
+        uint8_t record[256];
+        for (std::size_t i = 0; i < sizeof(record); ++i) record[i] = static_cast<uint8_t>(i);
+        const sc::Span<const uint8_t> record_span(record, sizeof(record));
+        uint64_t written_size = 0;
+        uint64_t sd_write_count = 0;
+        bool is_running = true;
+        bool broken = false;
+        while (is_running)
+        {
+            host::SD::make_fat32_image(SdImageName, SdImageBlockNum);
+            host::SD sd(SdImageName);
+            sc::FatFile file(sd);
+            broken |= !file.create("LOG00001.BIN", FileCapacity);
+            {
+                sc::SectorWriter<sc::FatFile, 512, 16> writer(file);
+                while ((is_running = state.keep_running()))
+                {
+                    broken |= !writer.append(record_span);
+                    if (FileCapacity - writer.get_size() < sizeof(record))
+                break;  // 満杯
+                }
+                broken |= !writer.flush();
+                written_size += writer.get_size();
+            }
+            broken |= !file.close();
+            sd_write_count += sd.get_write_count();
+        }
+        std::remove(SdImageName);
+        state.set_counter("sd_writes", static_cast<double>(sd_write_count));
+        if (broken || written_size != sizeof(record) * state.iterations())
+        {
+            State::fail("FatFile lost data");
+        }
+    }
+
+    //! @brief FatFileで作ったファイルを，ディスクイメージから直接読んで確認する
+    //! ディレクトリエントリ・連続したクラスタのチェーン・両方のFAT・FSInfo・データが正しいことと，名前の誤りを返すことを確認します．
+    void bm_fat_file_layout(State& state)
+    {
+        constexpr uint64_t FirstCapacity = 100000;  // 1つ目のファイルの大きさ  (196クラスタ)
+        constexpr uint32_t FirstClusterNum = (FirstCapacity + sc::SD::BlockSize - 1) / sc::SD::BlockSize;
+        uint32_t seed = 1;
+        bool broken = false;
+        while (state.keep_running())
+        {
+            host::SD::make_fat32_image(SdImageName, SdImageBlockNum);
+            std::vector<uint8_t> expected;
+            {
+                host::SD sd(SdImageName);
+                sc::FatFile file(sd);
+                broken |= !file.create("gps00001.bin", FirstCapacity);  // 小文字は大文字に直す
+                broken |= file.create("GPS00002.BIN", 10).has_value();  // close()していない
+                {
+                    sc::SectorWriter<sc::FatFile, 512, 2> writer(file);
+                    for (int i = 0; i < 50; ++i)
+                    {
+                        uint8_t record[300];  // ブロックの大きさと割り切れないバイト数
+                        const std::size_t size = static_cast<std::size_t>(next_sample(seed)) % sizeof(record) + 1;
+                        for (std::size_t j = 0; j < size; ++j) record[j] = static_cast<uint8_t>(next_sample(seed));
+                        expected.insert(expected.end(), record, record + size);
+                        broken |= !writer.append(sc::Span<const uint8_t>(record, size));
+                        if (i % 20 == 19)  // 途中のブロックで書き出し，大きさを更新する
+                        {
+                            broken |= !writer.flush() || !file.sync();
+                        }
+                    }
+                    broken |= !writer.flush();
+                }
+                broken |= !file.close();
+                sc::FatFile second(sd);
+                broken |= second.create("GPS00001.BIN", 10).has_value();  // 同じ名前
+                broken |= second.create("TOOLONGNAME.BIN", 10).has_value();  // 8.3形式ではない
+                broken |= !second.create("GPS00002.BIN", 1000) || !second.close();
+            }
+
+            std::FILE* const image = std::fopen(SdImageName, "rb");
+            uint8_t block[sc::SD::BlockSize];
+            if (!image || !read_image_block(image, 0, block))
+            {
+                State::fail("Cannot read the SD card image");
+            }
+            const uint32_t fat_block = block[14] | block[15] << 8;
+            const uint32_t fat_size = load_le32(&block[36]);
+            const uint32_t data_block = fat_block + block[16] * fat_size;
+            const uint32_t cluster_num = (load_le32(&block[32]) - data_block) / block[13];
+            broken |= (block[13] != 1 || load_le32(&block[44]) != 2);  // 1ブロックのクラスタ，ルートディレクトリはクラスタ2
+
+            broken |= !read_image_block(image, data_block, block);  // ルートディレクトリ
+            const uint32_t first_cluster = (block[20] | block[21] << 8) << 16 | (block[26] | block[27] << 8);
+            const uint32_t second_cluster = (block[52] | block[53] << 8) << 16 | (block[58] | block[59] << 8);
+            broken |= (std::memcmp(&block[0], "GPS00001BIN", 11) != 0 || block[11] != 0x20 || load_le32(&block[28]) != expected.size());
+            broken |= (std::memcmp(&block[32], "GPS00002BIN", 11) != 0 || load_le32(&block[60]) != 0 || block[64] != 0x00);
+            broken |= (first_cluster != 3 || second_cluster != first_cluster + FirstClusterNum);  // 続けて確保する
+
+            for (uint32_t fat = 0; fat < 2; ++fat)  // 2つのFATに同じチェーン
+            {
+                for (uint32_t cluster = first_cluster; cluster < first_cluster + FirstClusterNum; ++cluster)
+                {
+                    if (cluster == first_cluster || cluster % 128 == 0)
+                    {
+                        broken |= !read_image_block(image, fat_block + fat * fat_size + cluster / 128, block);
+                    }
+                    const uint32_t next_cluster = load_le32(&block[cluster % 128 * 4]);
+                    broken |= (next_cluster != (cluster + 1 < first_cluster + FirstClusterNum ? cluster + 1 : 0x0FFFFFFF));
+                }
+            }
+
+            broken |= !read_image_block(image, 1, block);  // FSInfo
+            broken |= (load_le32(&block[488]) != cluster_num - 1 - FirstClusterNum - 2 || load_le32(&block[492]) != second_cluster + 2);
+
+            std::vector<uint8_t> data(expected.size());
+            broken |= (std::fseek(image, static_cast<long>(data_block + first_cluster - 2) * static_cast<long>(sc::SD::BlockSize), SEEK_SET) != 0
+                || std::fread(data.data(), 1, data.size(), image) != data.size() || data != expected);
+            std::fclose(image);
+        }
+        std::remove(SdImageName);
+        if (broken)
+        {
+            State::fail("FatFile wrote a wrong FAT32 layout");
+        }
+    }
+
+    //! @brief SDカードへの書き込みが1回失敗しても，SectorWriterが同じ位置から書き直せばデータが欠けないことを確認する
+    //! 失敗させる書き込みを回ごとにずらし，ブロックの続き・ブロック全体・新しいブロックの途中のそれぞれで失敗させる
+    void bm_fat_file_write_retry(State& state)
+    {
+        constexpr uint32_t FailPointNum = 6;  // 失敗させる書き込みの位置の数  (データの書き込みはこれより多い)
+        uint32_t seed = 1;
+        uint32_t run_count = 0;
+        bool broken = false;
+        while (state.keep_running())
+        {
+            host::SD::make_fat32_image(SdImageName, SdImageBlockNum);
+            std::vector<uint8_t> expected;
+            std::size_t error_count = 0;
+            {
+                host::SD sd(SdImageName);
+                sc::FatFile file(sd);
+                broken |= !file.create("RETRY001.BIN", 100000);
+                sd.fail_write_at(sd.get_write_count() + run_count++ % FailPointNum + 1);
+                {
+                    sc::SectorWriter<sc::FatFile, 512, 2> writer(file);
+                    for (int i = 0; i < 40; ++i)
+                    {
+                        uint8_t record[500];  // ブロックの大きさと割り切れないバイト数
+                        const std::size_t size = static_cast<std::size_t>(next_sample(seed)) % 300 + 200;
+                        for (std::size_t j = 0; j < size; ++j) record[j] = static_cast<uint8_t>(next_sample(seed));
+                        expected.insert(expected.end(), record, record + size);
+                        sc::Span<const uint8_t> rest(record, size);
+                        const uint64_t appended_size = writer.get_size();
+                        if (!writer.append(rest))
+                        {
+                            ++error_count;
+                            const std::size_t count = static_cast<std::size_t>(writer.get_size() - appended_size);  // 書き出しに失敗する前に追記できたバイト数
+                            rest = rest.subspan(count, rest.size() - count);
+                            broken |= !writer.flush() || !writer.append(rest);  // 満杯のバッファを同じ位置から書き直し，残りを追記する
+                        }
+                    }
+                    broken |= !writer.flush();
+                    broken |= (file.get_size() != expected.size());
+                }
+                broken |= !file.close();
+            }
+
+            std::FILE* const image = std::fopen(SdImageName, "rb");
+            uint8_t block[sc::SD::BlockSize];
+            if (!image || !read_image_block(image, 0, block))
+            {
+                State::fail("Cannot read the SD card image");
+            }
+            const uint32_t data_block = (block[14] | block[15] << 8) + block[16] * load_le32(&block[36]);
+            broken |= !read_image_block(image, data_block, block);  // ルートディレクトリ
+            const uint32_t first_cluster = (block[20] | block[21] << 8) << 16 | (block[26] | block[27] << 8);
+            broken |= (load_le32(&block[28]) != expected.size());
+            std::vector<uint8_t> data(expected.size());
+            broken |= (std::fseek(image, static_cast<long>(data_block + first_cluster - 2) * static_cast<long>(sc::SD::BlockSize), SEEK_SET) != 0
+                || std::fread(data.data(), 1, data.size(), image) != data.size() || data != expected);
+            std::fclose(image);
+            broken |= (error_count != 1);
+        }
+        std::remove(SdImageName);
+        if (broken)
+        {
+            State::fail("FatFile lost data when a write was retried");
+        }
+    }
+#endif
+
+#ifdef SC_HOST
+    /***** NMEA (spresense/gnss_tracker) *****/
+
+    //! @brief SpNavDataを作る  (記録した測位結果を書き写すためのもの)
+    SpNavData make_nav_data(double latitude, double longitude, double altitude, float hdop, bool is_fixed)
+    {
+        SpNavData nav_data{};
+        nav_data.time = {2024, 5, 17, 3, 26, 45, 120000};
+        nav_data.type = is_fixed ? SpPvtTypeGnss : SpPvtTypeNone;
+        nav_data.numSatellites = 9;
+        nav_data.numSatellitesCalcPos = is_fixed ? 7 : 0;
+        nav_data.latitude = latitude;
+        nav_data.longitude = longitude;
+        nav_data.altitude = altitude;
+        nav_data.velocity = 1.35F;
+        nav_data.direction = 271.25F;
+        nav_data.pdop = 1.85F;
+        nav_data.hdop = hdop;
+        nav_data.vdop = 1.15F;
+        nav_data.posFixMode = is_fixed ? Fix3D : FixInvalid;
+        nav_data.posDataExist = is_fixed;
+        const unsigned short satellite_ids[] = {3, 6, 14, 17, 19, 22, 24, 28, 193};
+        std::copy(std::begin(satellite_ids), std::end(satellite_ids), nav_data.satelliteIds);
+        return nav_data;
+    }
+
+    //! @brief 記録した測位結果  (測位前，東京，南半球，西半球，HDOPなし，%.1fの丸めが際どい値)
+    const SpNavData NavDataFixtures[] = {
+        make_nav_data(0.0, 0.0, 0.0, 0.0F, false),
+        make_nav_data(35.681236, 139.767125, 40.25, 0.9F, true),
+        make_nav_data(-33.856784, 151.215297, 3.05, 1.25F, true),
+        make_nav_data(40.689247, -74.044502, -0.04, 2.35F, true),
+        make_nav_data(-0.000125, -0.5, 12.35, -1.0F, true),
+        make_nav_data(9.999999, 179.999, 1234.5, 0.25F, true),
+    };
+
+    //! @brief NMEAの文のチェックサムが正しいか確認する
+    //! @param sentence "$...*hh\r\n"の形の文
+    bool is_valid_nmea(const char* sentence)
+    {
+        const char* const end = std::strchr(sentence, '*');
+        if (sentence[0] != '$' || end == nullptr || std::strcmp(end + 3, "\r\n") != 0)
+    return false;
+        unsigned int checksum = 0;
+        for (const char* c = sentence + 1; c != end; ++c) checksum ^= static_cast<unsigned char>(*c);
+        char expected[3];
+        std::snprintf(expected, sizeof(expected), "%02X", checksum);
+        return std::strncmp(end + 1, expected, 2) == 0;
+    }
+
+    //! @brief 以前のgetNmeaGgaで，Stringに少しずつ書き足してGGAの文を作る
+    void bm_nmea_gga_legacy(State& state)
+    {
+        std::size_t index = 0;
+        while (state.keep_running())
+        {
+            SpNavData nav_data = NavDataFixtures[index++ % std::size(NavDataFixtures)];
+            const String gga = getNmeaGga(&nav_data);
+            do_not_optimize(gga.c_str()[0]);
+        }
+    }
+
+    //! @brief writeNmeaGgaで，バッファに1回で書き込んでGGAの文を作る
+    void bm_nmea_gga_write(State& state)
+    {
+        char buffer[128];
+        std::size_t index = 0;
+        while (state.keep_running())
+        {
+            SpNavData nav_data = NavDataFixtures[index++ % std::size(NavDataFixtures)];
+            do_not_optimize(writeNmeaGga(buffer, sizeof(buffer), &nav_data));
+        }
+    }
+
+    //! @brief 乱数で緯度か経度を作る  getNmeaGgaが分を"60.0000"と書いてしまう，次の度の0.0001分手前からの範囲は除く
+    //! @param seed 乱数の状態  更新される
+    //! @param max_degree 絶対値の最大 (度)  緯度は90，経度は180
+    double next_coordinate(uint32_t& seed, double max_degree)
+    {
+        while (true)
+        {
+            const uint64_t bits = (static_cast<uint64_t>(next_sample(seed)) << 24) | (static_cast<uint64_t>(next_sample(seed)) << 12) | next_sample(seed);  // 36ビット
+            const double coordinate = (static_cast<double>(bits) / static_cast<double>(1ULL << 35) - 1.0) * max_degree;
+            const double degree = std::fabs(coordinate);
+            if ((degree - std::floor(degree)) * 60 < 59.9999)
+    return coordinate;
+        }
+    }
+
+    //! @brief 記録した測位結果と，緯度・経度・高度・HDOP・時刻を乱数で変えたものについて，writeNmeaGgaとgetNmeaGgaの結果がバイト単位で一致することを確認する
+    //! 分が繰り上がる緯度では，getNmeaGgaと違って度に繰り上げることも確認する
+    void bm_nmea_gga_byte_exact(State& state)
+    {
+        char buffer[128];
+        uint32_t seed = 1;
+        std::size_t index = 0;
+        bool broken = false;
+        while (state.keep_running())
+        {
+            SpNavData nav_data = NavDataFixtures[index++ % std::size(NavDataFixtures)];
+            if (index > std::size(NavDataFixtures))  // 最初の1周は記録したままの値
+            {
+                nav_data.latitude = next_coordinate(seed, 90.0);
+                nav_data.longitude = next_coordinate(seed, 180.0);
+                nav_data.altitude = (next_sample(seed) - 2048) / 8.0 + next_sample(seed) / 4096.0 * 1e-3;
+                nav_data.hdop = next_sample(seed) / 20.0F;
+                nav_data.time.usec = next_sample(seed) * 244;
+            }
+            const std::size_t length = writeNmeaGga(buffer, sizeof(buffer), &nav_data);
+            const String gga = getNmeaGga(&nav_data);
+            broken |= (length != gga.length() || std::strcmp(buffer, gga.c_str()) != 0);
+        }
+        SpNavData rollover = NavDataFixtures[1];
+        rollover.latitude = 36.99999986;  // 59.9999916分は0.0001分単位で60分になる
+        rollover.longitude = -139.99999995;
+        writeNmeaGga(buffer, sizeof(buffer), &rollover);
+        broken |= (std::strstr(buffer, ",3700.0000,N,14000.0000,W,") == nullptr);
+        broken |= (std::strstr(getNmeaGga(&rollover).c_str(), ",3660.0000,N,13960.0000,W,") == nullptr);  // 以前の処理は分が60になる
+        if (broken)
+        {
+            State::fail("writeNmeaGga differs from getNmeaGga or did not carry 60 minutes into the degrees");
+        }
+    }
+
+    //! @brief RMC・GSA・VTGの文を書き込み，形式とチェックサムを確認する  バッファが足りないときは0を返すことも確認する
+    void bm_nmea_rmc_gsa_vtg(State& state)
+    {
+        char buffer[128];
+        std::size_t index = 0;
+        bool broken = false;
+        while (state.keep_running())
+        {
+            SpNavData nav_data = NavDataFixtures[index++ % std::size(NavDataFixtures)];
+            broken |= (writeNmeaRmc(buffer, sizeof(buffer), &nav_data) == 0 || !is_valid_nmea(buffer));
+            broken |= (writeNmeaGsa(buffer, sizeof(buffer), &nav_data) == 0 || !is_valid_nmea(buffer));
+            broken |= (writeNmeaVtg(buffer, sizeof(buffer), &nav_data) == 0 || !is_valid_nmea(buffer));
+        }
+        SpNavData tokyo = NavDataFixtures[1];
+        writeNmeaRmc(buffer, sizeof(buffer), &tokyo);
+        broken |= (std::strcmp(buffer, "$GPRMC,032645.12,A,3540.8742,N,13946.0275,E,2.6,271.2,170524,,,A*5E\r\n") != 0);
+        writeNmeaGsa(buffer, sizeof(buffer), &tokyo);
+        broken |= (std::strcmp(buffer, "$GPGSA,A,3,03,06,14,17,19,22,24,28,193,,,,1.9,0.9,1.1*0A\r\n") != 0);
+        writeNmeaVtg(buffer, sizeof(buffer), &tokyo);
+        broken |= (std::strcmp(buffer, "$GPVTG,271.2,T,,M,2.6,N,4.9,K,A*02\r\n") != 0);
+        const std::size_t length = writeNmeaGga(buffer, sizeof(buffer), &tokyo);
+        broken |= (writeNmeaGga(buffer, length, &tokyo) != 0 || buffer[0] != '\0');  // 終端の分が足りない
+        broken |= (writeNmeaGga(buffer, length + 1, &tokyo) != length);
+        if (broken)
+        {
+            State::fail("writeNmeaRmc/Gsa/Vtg wrote a wrong sentence");
+        }
+    }
+
+    /***** GNSS log (spresense/gnss_tracker) *****/
+
+    constexpr char GnssLogName[] = "sc_bench_gnss_log.bin";  // ベンチマークで書き出すファイル  終わったら消す
+
+    //! @brief 測位結果のバイナリ  (GnssPositionDataと同じくMagicNumber・Data・CRCが並ぶ)
+    struct GnssRecord
+    {
+        uint32_t magic_number;  // 先頭の識別番号
+        uint32_t key;  // 時刻  (FindRecordで探すもの)
+        uint8_t data[244];  // 測位結果
+        uint32_t crc;  // CRC
+    };
+
+    //! @brief 以前のgnss_trackerのように，MagicNumber・Data・CRCをそれぞれファイルを開いて閉じて書き出す
+    void bm_gnss_log_legacy(State& state)
+    {
+        GnssRecord record{};
+        std::remove(GnssLogName);
+        while (state.keep_running())
+        {
+            const std::pair<const void*, std::size_t> parts[] = {
+                {&record.magic_number, sizeof(record.magic_number)},
+                {&record.key, sizeof(record) - sizeof(record.magic_number) - sizeof(record.crc)},
+                {&record.crc, sizeof(record.crc)}};
+            for (const std::pair<const void*, std::size_t>& part : parts)
+            {
+                std::FILE* file = std::fopen(GnssLogName, "ab");
+                if (!file)
+                {
+                    State::fail("Cannot open the GNSS log");
+                }
+                std::fwrite(part.first, 1, part.second, file);
+                std::fclose(file);
+            }
+            ++record.key;
+        }
+        std::remove(GnssLogName);
+    }
+
+    //! @brief RecordFileで，ファイルを開いたまま1回の測位結果を1つのレコードとして追記する
+    void bm_gnss_log_record(State& state)
+    {
+        std::FILE* file = nullptr;
+        const LogBackend backend = get_host_log_backend(file);
+        static RecordFile record_file;  // バッファが大きいのでスタックに置かない
+        GnssRecord record{};
+        std::remove(GnssLogName);
+        bool broken = !OpenRecordFile(&record_file, &backend, GnssLogName, sizeof(record));
+        while (state.keep_running())
+        {
+            broken |= !WriteRecord(&record_file, &record, record.key);
+            ++record.key;
+        }
+        broken |= !CloseRecordFile(&record_file);
+        std::remove(GnssLogName);
+        if (broken)
+        {
+            State::fail("RecordFile failed to write the GNSS log");
+        }
+    }
+
+    //! @brief メモリに追記するLogBackend  指定した回の書き出しを失敗させる
+    struct FailingLogData
+    {
+        std::vector<char> data;  // 書き出したデータ
+        std::size_t write_count = 0;  // 書き出した回数
+        std::size_t fail_at = 0;  // この回の書き出しを失敗させる  (1から数える)
+    };
+
+    LogBackend get_failing_log_backend(FailingLogData& log_data) noexcept
+    {
+        return LogBackend{
+            &log_data,
+            [](void* context, const char*) -> long {return static_cast<long>(static_cast<FailingLogData*>(context)->data.size());},
+            [](void* context, const char* data, unsigned long size) -> unsigned long {
+                FailingLogData& log_data = *static_cast<FailingLogData*>(context);
+                if (++log_data.write_count == log_data.fail_at)
+    return 0;  // 書き出しに失敗
+                log_data.data.insert(log_data.data.end(), data, data + size);
+                return size;
+            },
+            [](void*) {return true;},
+            [](void*) {}};
+    }
+
+    //! @brief セクタの大きさで割り切れないレコード  バッファの書き出しの境目をまたぐ
+    struct OddRecord
+    {
+        uint32_t magic_number;  // 先頭の識別番号
+        uint32_t key;  // 時刻
+        uint8_t data[292];
+    };
+
+    //! @brief 書き出しが1回失敗しても，後のレコードがレコードの大きさの位置に並ぶことを確認する
+    //! 書き出しの境目をまたいでいたレコードだけが無くなり，次の書き出しで残りのレコードが書かれる
+    void bm_gnss_log_write_error(State& state)
+    {
+        constexpr uint32_t RecordNum = 100;  // 書き出しが10回ほど起きる数
+        static RecordFile record_file;  // バッファが大きいのでスタックに置かない
+        bool broken = false;
+        while (state.keep_running())
+        {
+            FailingLogData log_data;
+            log_data.fail_at = 2;
+            const LogBackend backend = get_failing_log_backend(log_data);
+            OddRecord record{};
+            record.magic_number = 0x12345678;
+            uint32_t failed_key = 0;
+            broken |= !OpenRecordFile(&record_file, &backend, "", sizeof(record));
+            for (record.key = 1; record.key <= RecordNum; ++record.key)
+            {
+                if (!WriteRecord(&record_file, &record, record.key))
+                {
+                    broken |= (failed_key != 0);  // 失敗するのは1回だけ
+                    failed_key = record.key;
+                }
+            }
+            broken |= !CloseRecordFile(&record_file) || failed_key == 0;
+            broken |= (log_data.data.size() != sizeof(record) * (RecordNum - 1) + record_file.Footer.IndexCount * sizeof(uint32_t) + sizeof(RecordFooter));
+            for (uint32_t i = 0; i < RecordNum - 1 && !broken; ++i)
+            {
+                OddRecord written;
+                std::memcpy(&written, log_data.data.data() + i * sizeof(record), sizeof(written));
+                broken |= (written.magic_number != record.magic_number || written.key != (i + 1 < failed_key ? i + 1 : i + 2));
+            }
+            broken |= (FindRecord(log_data.data.data(), log_data.data.size(), failed_key + 1) < 0);
+        }
+        if (broken)
+        {
+            State::fail("RecordFile misaligned the records after a write error");
+        }
+    }
+
+    //! @brief 2回に分けて書いたファイルで，索引から時刻のレコードを探す  見つかったレコードが探す時刻の直前の索引の位置にあることを確認する
+    void bm_gnss_log_find(State& state)
+    {
+        constexpr uint32_t SessionRecordNum = 1000;  // 1回に書くレコードの数  (索引に入りきらないので，間隔が広がる)
+        std::FILE* file = nullptr;
+        const LogBackend backend = get_host_log_backend(file);
+        static RecordFile record_file;  // バッファが大きいのでスタックに置かない
+        GnssRecord record{};
+        std::remove(GnssLogName);
+        bool broken = false;
+        for (uint32_t session = 0; session < 2; ++session)
+        {
+            broken |= !OpenRecordFile(&record_file, &backend, GnssLogName, sizeof(record));
+            for (uint32_t i = 0; i < SessionRecordNum; ++i)
+            {
+                record.key = (session * SessionRecordNum + i) * 2 + 10;  // 時刻は飛び飛びに増える
+                broken |= !WriteRecord(&record_file, &record, record.key);
+            }
+            broken |= !CloseRecordFile(&record_file);
+        }
+        const uint32_t max_distance = record_file.Footer.IndexInterval * 2;  // 索引の間隔の分の時刻の差
+
+        std::vector<char> file_data;
+        if (std::FILE* read_file = std::fopen(GnssLogName, "rb"))
+        {
+            char chunk[4096];
+            std::size_t size;
+            while ((size = std::fread(chunk, 1, sizeof(chunk), read_file)) != 0) file_data.insert(file_data.end(), chunk, chunk + size);
+            std::fclose(read_file);
+        }
+        std::remove(GnssLogName);
+        broken |= (FindRecord(file_data.data(), file_data.size(), 9) != -1);  // 最初のレコードより前
+
+        uint32_t seed = 1;
+        while (state.keep_running())
+        {
+            const uint32_t key = next_sample(seed) % (SessionRecordNum * 4 + 9);  // 最後のレコードの時刻まで
+            const long offset = FindRecord(file_data.data(), file_data.size(), key);
+            if (key < 10)
+            {
+                broken |= (offset != -1);
+        continue;
+            }
+            if (offset < 0 || static_cast<std::size_t>(offset) + sizeof(record) > file_data.size())
+            {
+                broken = true;
+        continue;
+            }
+            std::memcpy(&record, &file_data[static_cast<std::size_t>(offset)], sizeof(record));
+            broken |= (record.key > key || key - record.key >= max_distance);
+        }
+        if (broken)
+        {
+            State::fail("FindRecord returned a wrong record");
+        }
+    }
+#endif
+
+    /***** Exam001 *****/
+
+#ifdef SC_HOST
+    //! @brief センサのモデルをつないだI2Cで，Exam001の測定を最初から最後まで行う  (Exam001<host::I2C>なので仮想関数を通さない)
+    void bm_exam001_measure(State& state)
+    {
+        const sc::I2C::SlaveAddr slave_addr(0x05);
+        Exam001Device exam001_device;
+        const host::I2C i2c(host::I2C::Pin(2, 3), 400 * 1000);  // I2C1を使う
+        i2c.connect(slave_addr, exam001_device.device);
+        sc::Exam001 exam001(i2c, slave_addr);
+        while (state.keep_running())
+        {
+            const sc::Measurement measurement = exam001.measure();
+            if (measurement.get<sc::Temperature>().get() != 25.0F)
+            {
+                State::fail("Exam001 measured a wrong temperature");
+            }
+        }
+    }
+
+    //! @brief bm_exam001_measureと同じ測定を，sc::I2Cの参照を通して(仮想関数で)行う
+    //! Exam001<host::I2C>との差が，仮想関数の呼び出しとBinaryを使わないことで減った時間です．
+    void bm_exam001_measure_virtual(State& state)
+    {
+        const sc::I2C::SlaveAddr slave_addr(0x05);
+        Exam001Device exam001_device;
+        const host::I2C i2c(host::I2C::Pin(2, 3), 400 * 1000);  // I2C1を使う
+        i2c.connect(slave_addr, exam001_device.device);
+        sc::Exam001<> exam001(i2c, slave_addr);  // Busはsc::I2C
+        while (state.keep_running())
+        {
+            const sc::Measurement measurement = exam001.measure();
+            if (measurement.get<sc::Temperature>().get() != 25.0F)
+            {
+                State::fail("Exam001 measured a wrong temperature");
+            }
+        }
+    }
+
+#endif
+
+    //! @brief 補正の計算を確認するキャリブレーションデータ  (Exam001のモデル，負の係数，20ビットの生データでint32_tに収まる最大に近い係数)
+    const sc::Exam001Calibration Calibrations[] = {{1024, 1, 0}, {1024, -3, -100}, {27504, 50, -1000}};
+
+    //! @brief 以前のExam001::calibrate_temperatureと同じく，整数で計算した後にdoubleで割って℃にする
+    float legacy_calibrate_temperature(const sc::Exam001Calibration& calibration, int32_t raw_temperature)
+    {
+        const int32_t var1 = (static_cast<int32_t>(calibration.dig_T1 << 1) * (static_cast<int32_t>(calibration.dig_T2))) >> 11;
+        const int32_t var2 = (((static_cast<int32_t>(calibration.dig_T1) * static_cast<int32_t>(calibration.dig_T1)) >> 12) * static_cast<int32_t>(calibration.dig_T3)) >> 14;
+        return (raw_temperature*var1 + var2) / 100.0;
+    }
+
+    //! @brief 補正の計算をdoubleだけで行う  (シフトはfloorで表す)
+    //! @return 補正後の気温 (0.01℃)
+    double reference_calibrate_temperature(const sc::Exam001Calibration& calibration, int32_t raw_temperature)
+    {
+        const double var1 = std::floor(2.0 * calibration.dig_T1 * calibration.dig_T2 / 2048.0);
+        const double var2 = std::floor(std::floor(static_cast<double>(calibration.dig_T1) * calibration.dig_T1 / 4096.0) * calibration.dig_T3 / 16384.0);
+        return raw_temperature * var1 + var2;
+    }
+
+    //! @brief 生データから，範囲を確認したTemperatureを作る  (以前の，doubleで割る計算)
+    void bm_exam001_calibrate_double(State& state)
+    {
+        int32_t raw_temperature = 0;
+        while (state.keep_running())
+        {
+            raw_temperature = (raw_temperature + 1) & 0xfff;
+            do_not_optimize(sc::Temperature::create(legacy_calibrate_temperature(Calibrations[0], raw_temperature)));
+        }
+    }
+
+    //! @brief 生データから，範囲を確認したTemperatureを作る  (整数だけの計算)
+    void bm_exam001_calibrate_fixed(State& state)
+    {
+        int32_t raw_temperature = 0;
+        while (state.keep_running())
+        {
+            raw_temperature = (raw_temperature + 1) & 0xfff;
+            do_not_optimize(sc::Temperature::create_centi(Calibrations[0].compensate_temperature(raw_temperature)));
+        }
+    }
+
+    //! @brief 20ビットの生データ全てについて，整数の補正の計算がdoubleの計算とビット単位で一致することを確認する
+    //! 範囲内の気温は，以前の計算と同じ値をget()で取得できることも確認する
+    void bm_exam001_calibrate_bit_exact(State& state)
+    {
+#ifdef SC_HOST
+        constexpr int32_t RawStep = 1;  // 全ての生データを確認する
+#else
+        constexpr int32_t RawStep = 16;  // picoではdoubleの計算が遅いので間引く
+#endif
+        bool broken = false;
+        while (state.keep_running())
+        {
+            for (const sc::Exam001Calibration& calibration : Calibrations)
+            {
+                for (int32_t raw_temperature = 0; raw_temperature < (1 << 20); raw_temperature += RawStep)
+                {
+                    const int32_t centi_temperature = calibration.compensate_temperature(raw_temperature);
+                    broken |= (static_cast<double>(centi_temperature) != reference_calibrate_temperature(calibration, raw_temperature));
+                    const sc::Result<sc::Temperature> temperature = sc::Temperature::create_centi(centi_temperature);
+                    const sc::Result<sc::Temperature> legacy_temperature = sc::Temperature::create(legacy_calibrate_temperature(calibration, raw_temperature));
+                    broken |= (temperature.has_value() != legacy_temperature.has_value());
+                    if (temperature.has_value() && legacy_temperature.has_value())
+                    {
+                        broken |= (temperature.value().get() != legacy_temperature.value().get() || temperature.value().get_centi() != legacy_temperature.value().get_centi());
+                    }
+                }
+            }
+        }
+        constexpr sc::Exam001Calibration ModelCalibration{1024, 1, 0};
+        static_assert(ModelCalibration.compensate_temperature(2500) == 2500, "\n\n<!ERROR!> The calibration of the Exam001 model must give 25.00 degrees\n\n");  // コンパイル時にも計算できる
+        if (broken)
+        {
+            State::fail("Exam001Calibration differs from the double reference");
+        }
+    }
+
+#ifdef SC_HOST
+#ifdef SC_EXCEPTIONS
+    //! @brief 範囲外の気温を測定し，measure()が投げる例外を受け取る  (エラーの出力先は捨てる)
+    void bm_exam001_error_exception(State& state)
+    {
+        const sc::I2C::SlaveAddr slave_addr(0x05);
+        Exam001Device exam001_device;
+        const host::I2C i2c(host::I2C::Pin(2, 3), 400 * 1000);  // I2C1を使う
+        i2c.connect(slave_addr, exam001_device.device);
+        sc::Exam001 exam001(i2c, slave_addr);
+        exam001_device.device.set(0x60, {0x02, 0x71, 0x00});  // キャリブレーション後は100.00度
+        std::ostream discard(nullptr);  // 何も出力しない出力先
+        host::set_log_output(discard);
+        std::streambuf* const cerr_buffer = std::cerr.rdbuf(nullptr);  // Errorはstd::cerrにも出力する
+        std::size_t error_count = 0;
+        while (state.keep_running())
+        {
+            try
+            {
+                exam001.measure();
+            }
+            catch (const sc::Error&) {++error_count;}
+        }
+        std::cerr.rdbuf(cerr_buffer);
+        std::cerr.clear();
+        host::set_log_output(std::cout);
+        if (error_count != state.iterations()) State::fail("Exam001::measure did not throw for an invalid temperature");
+    }
+#endif
+
+    //! @brief 範囲外の気温を測定し，try_measure()が返すエラーを受け取る
+    void bm_exam001_error_result(State& state)
+    {
+        const sc::I2C::SlaveAddr slave_addr(0x05);
+        Exam001Device exam001_device;
+        const host::I2C i2c(host::I2C::Pin(2, 3), 400 * 1000);  // I2C1を使う
+        i2c.connect(slave_addr, exam001_device.device);
+        sc::Exam001 exam001(i2c, slave_addr);
+        exam001_device.device.set(0x60, {0x02, 0x71, 0x00});  // キャリブレーション後は100.00度
+        std::size_t error_count = 0;
+        while (state.keep_running())
+        {
+            const sc::Result<sc::Measurement> measurement = exam001.try_measure();
+            if (!measurement && measurement.error().code == sc::ErrorCode::invalid_argument) ++error_count;
+        }
+        if (error_count != state.iterations()) State::fail("Exam001::try_measure did not return an error for an invalid temperature");
+    }
+#endif
+
+    const Benchmark Benchmarks[] = {
+        {"Binary/initializer_list", bm_binary_initializer_list},
+        {"Binary/vector_64", bm_binary_vector_64},
+        {"Binary/view_of", bm_binary_view_of},
+        {"I2C::SlaveAddr", bm_slave_addr},
+        {"I2C::MemoryAddr", bm_memory_addr},
+        {"Measurement/legacy_unordered_map", bm_measurement_legacy},
+        {"Measurement", bm_measurement},
+        {"I2C::Pin/legacy_std_set", bm_i2c_pin_legacy},
+#ifdef SC_HOST
+        {"I2C::Pin/runtime", bm_i2c_pin_runtime},
+        {"PinIO/write_x8", bm_pin_io_write_x8},
+        {"PinGroup/write_8", bm_pin_group_write_8},
+        {"PinEdgeIRQ/pulse", bm_pin_edge_irq_pulse},
+        {"PulseCapture/cycle", bm_pulse_capture_cycle},
+#endif
+        {"Log::write/format", bm_log_write_format},
+#ifdef SC_HOST
+        {"Log::write/binary", bm_log_write_binary},
+        {"Log::write/async", bm_log_write_async},
+        {"I2C/read_mem_burst_8", bm_i2c_read_mem_burst},
+        {"I2C/read_mem_x3", bm_i2c_read_mem_x3},
+        {"I2C/transfer_x3", bm_i2c_transfer_x3},
+        {"I2C/write_mem", bm_i2c_write_mem},
+#endif
+        {"I2CAccess/read_mem_static", bm_i2c_access_read_mem<FixedI2C>},
+        {"I2CAccess/read_mem_virtual", bm_i2c_access_read_mem<sc::I2C>},
+#ifdef SC_HOST
+        {"SPI/read_mem_fake_dma", bm_spi_read_mem},
+        {"RingBuffer/spsc_2_threads", bm_ring_buffer_spsc},
+        {"DmaRingBuffer/framing", bm_dma_framing},
+#endif
+        {"Filter/calc_distance_average", bm_moving_average<HcSr04Average>},
+        {"Filter/legacy_average_64", bm_moving_average<LegacyAverage<64>>},
+        {"Filter/moving_average_3", bm_moving_average<sc::MovingAverage<int32_t, 3>>},
+        {"Filter/moving_average_int16_3", bm_moving_average<sc::MovingAverage<int16_t, 3>>},
+        {"Filter/moving_average_64", bm_moving_average<sc::MovingAverage<int32_t, 64>>},
+        {"Filter/moving_average_float_64", bm_moving_average<sc::MovingAverage<float, 64>>},
+        {"Filter/moving_average_check", bm_moving_average_check},
+        {"Filter/calc_distance_average_check", bm_calc_distance_average_check},
+        {"Filter/moving_median_5", bm_moving_median_5},
+        {"Filter/exponential_average", bm_exponential_average},
+        {"Filter/first_order_iir", bm_first_order_iir},
+        {"Filter/quantity_median_3", bm_quantity_filter},
+        {"HysteresisClassifier/exhaustive", bm_hysteresis_exhaustive},
+        {"HysteresisClassifier/judge_dist_safe", bm_hysteresis_legacy},
+        {"HysteresisClassifier/step", bm_hysteresis_step},
+        {"HysteresisClassifier/update", bm_hysteresis_update},
+        {"Pipeline/push_process", bm_pipeline_push_process},
+#ifdef SC_HOST
+        {"Pipeline/2_threads", bm_pipeline_2_threads},
+        {"Pipeline/2_threads_log", bm_pipeline_2_threads_log},
+#endif
+        {"Scheduler/3_rates_1s", bm_scheduler_3_rates},
+        {"Scheduler/overrun", bm_scheduler_overrun},
+        {"Scheduler/run_pending_8", bm_scheduler_run_pending},
+        {"NmeaParser/recorded", bm_nmea_parser_recorded},
+        {"NmeaParser/split", bm_nmea_parser_split},
+        {"NmeaParser/fuzz", bm_nmea_parser_fuzz},
+#ifdef SC_HOST
+        {"NmeaParser/uart_poll", bm_nmea_parser_uart},
+#endif
+        {"NmeaParser/lost_fix", bm_nmea_parser_lost_fix},
+        {"SectorWriter/legacy_strncat", bm_sector_writer_legacy},
+        {"SectorWriter/append", bm_sector_writer_append},
+        {"SectorWriter/alignment", bm_sector_writer_alignment},
+#ifdef SC_HOST
+        {"FatFile/append_256B", bm_fat_file_append},
+        {"FatFile/layout", bm_fat_file_layout},
+        {"FatFile/write_retry", bm_fat_file_write_retry},
+        {"NMEA/gga_legacy_string", bm_nmea_gga_legacy},
+        {"NMEA/gga_write", bm_nmea_gga_write},
+        {"NMEA/gga_byte_exact", bm_nmea_gga_byte_exact},
+        {"NMEA/rmc_gsa_vtg", bm_nmea_rmc_gsa_vtg},
+        {"GnssLog/legacy_3_writes", bm_gnss_log_legacy},
+        {"GnssLog/record_write", bm_gnss_log_record},
+        {"GnssLog/write_error", bm_gnss_log_write_error},
+        {"GnssLog/find_record", bm_gnss_log_find},
+        {"Exam001::measure", bm_exam001_measure},
+        {"Exam001::measure/virtual", bm_exam001_measure_virtual},
+#endif
+        {"Exam001/calibrate_double", bm_exam001_calibrate_double},
+        {"Exam001/calibrate_fixed", bm_exam001_calibrate_fixed},
+        {"Exam001/calibrate_bit_exact", bm_exam001_calibrate_bit_exact},
+#ifdef SC_HOST
+#ifdef SC_EXCEPTIONS
+        {"Exam001/error_exception", bm_exam001_error_exception},
+#endif
+        {"Exam001/error_result", bm_exam001_error_result},
+#endif
+    };
+}
+
+int main(int argc, char* argv[])
+{
+#ifdef SC_HOST
+    bool is_json = false;  // JSON形式で出力するか
+#else
+    stdio_init_all();  // pico-SDKを初期化
+    while (!stdio_usb_connected())  // USBで結果を受け取れるようになるまで待つ
+    {
+        sleep_ms(100);
+    }
+    bool is_json = true;  // picoでは記録しやすいようにJSON形式で出力する
+#endif
+    const char* filter = "";  // 名前にこの文字列を含むベンチマークのみ実行する
+    double min_time_s = 0.1;  // 1つのベンチマークの計測に最低限かける時間 (s)
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--benchmark_format=json")
+        {
+            is_json = true;
+        }
+        else if (arg == "--benchmark_format=console")
+        {
+            is_json = false;
+        }
+        else if (arg.rfind("--benchmark_filter=", 0) == 0)
+        {
+            filter = argv[i] + std::strlen("--benchmark_filter=");
+        }
+        else if (arg.rfind("--benchmark_min_time=", 0) == 0)
+        {
+            min_time_s = std::atof(argv[i] + std::strlen("--benchmark_min_time="));
+        } else {
+            std::printf("unknown option: %s\n", argv[i]);
+    return 1;
+        }
+    }
+
+    if (is_json)
+    {
+        std::printf("{\n  \"context\": {\"library\": \"sc\", \"platform\": \"%s\"},\n  \"benchmarks\": [", Platform);
+    }
+    bool is_first = true;
+    for (const Benchmark& benchmark : Benchmarks)
+    {
+        if (!std::strstr(benchmark.name, filter))
+    continue;
+        const Result result = run_benchmark(benchmark, static_cast<uint64_t>(min_time_s * 1e9));
+        if (is_json)
+        {
+            print_json(benchmark.name, result, is_first);
+        } else {
+            print_console(benchmark.name, result);
+        }
+        is_first = false;
+    }
+    if (is_json)
+    {
+        std::printf("\n  ]\n}\n");
+    }
+}
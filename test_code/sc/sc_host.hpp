@@ -0,0 +1,492 @@
+#ifndef SC19_CODE_TEST_SC_SC_HOST_HPP_
+#define SC19_CODE_TEST_SC_SC_HOST_HPP_
+
+/*************************************
+ *************************************
+
+
+このファイルは見なくてかまいません
+内部の実装を知りたい場合のみ見てください
+
+
+*************************************
+*************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <string>
+#include <vector>
+#ifdef SC_HOST
+#include <chrono>
+#include <mutex>
+#include <thread>
+#endif
+
+#include "sc.hpp"
+#include "sc_rp2040.hpp"
+
+//! @file sc_host.hpp
+//! @brief PC上でpicoの代わりに動かすためのプログラム
+//! @date 2026-10-16
+
+
+//! @brief PC(Linux)上でのシミュレーション用
+//! picoと同じ名前・引数のクラスを，メモリ上のセンサのモデルに対して動かします．
+namespace host
+{
+    void set_log_output(std::ostream& output) noexcept;
+#ifdef SC_HOST
+    void start_log_drain();
+    void stop_log_drain() noexcept;
+#endif
+
+    //! @brief バイナリ形式のログ(sc::Log::Format::binary)を文字列に戻す
+    //! 途中で切れたデータを渡しても，続きを渡したときにまとめて戻します．
+    class LogDecoder
+    {
+        std::string _formats[256];  // 書式のIDごとの書式の文字列
+        std::vector<uint8_t> _pending_data;  // まだ戻していないデータ
+    public:
+        std::string decode(sc::Span<const uint8_t> data);
+    private:
+        std::string decode_event(sc::Span<const uint8_t> payload) const;
+    };
+
+    //! @brief シミュレーション上の時刻
+    //! 通信にかかる時間だけ進みます．環境変数 SC_HOST_TIME_LIMIT_US を設定すると，その時刻を過ぎたところでプログラムを終了します．
+    class Clock
+    {
+        static std::atomic<uint64_t> _now_ns;  // 現在時刻 (ns)  パイプラインのスレッドからも読むためアトミックにする
+    public:
+        static uint64_t get_ns() noexcept;
+        static uint64_t get_us() noexcept;
+        static void advance_ns(uint64_t time_ns);
+    private:
+        static uint64_t get_limit_ns();
+    };
+
+    //! @brief 現在時刻を取得  (pico::get_time_us()の代わり)
+    //! @return シミュレーション開始からの時間 (μs)
+    inline uint64_t get_time_us() noexcept {return Clock::get_us();}
+
+    //! @brief スケジューラを動かし続ける  (pico::run_scheduler()の代わり)
+    //! 次のタスクの時刻までシミュレーション上の時刻を進め，タスクを実行します．SC_HOST_TIME_LIMIT_USを過ぎると終了します
+    //! @param scheduler タスクを登録したsc::Scheduler
+    template<class Scheduler>
+    [[noreturn]] void run_scheduler(Scheduler& scheduler)
+    {
+        while (true)
+        {
+            const uint64_t deadline_us = scheduler.get_next_deadline_us();
+            if (get_time_us() < deadline_us)
+            {
+                Clock::advance_ns((deadline_us - get_time_us()) * 1000);  // 待つ代わりに時刻を進める
+            }
+            scheduler.run_pending(get_time_us);
+        }
+    }
+
+#ifdef SC_HOST
+    void launch_core1(bool (*step)(void*), void* context);
+    void stop_core1() noexcept;
+
+    //! @brief 別のスレッドでパイプラインの処理とログの出力を始める  (picoのコア1での処理の代わり)
+    //! プログラムの終了時(exitを含む)にはstop_core1()が自動で呼ばれ，キューに残った値とログが処理されます
+    //! @param pipeline sc::make_pipeline()で作ったパイプライン  プログラムの終了まで残るようにしてください
+    template<class Pipeline>
+    void start_pipeline(Pipeline& pipeline)
+    {
+        launch_core1([](void* context) {return static_cast<Pipeline*>(context)->process(get_time_us);}, &pipeline);
+    }
+#endif
+
+    //! @brief レジスタ(メモリ)を持つセンサのモデル
+    //! SPIでは，CSがLowになってから最初の1バイトをメモリアドレスとし，8ビット目が1なら読み込み，0なら書き込みとします．
+    //! I2Cでは，書き込みの最初の1バイトをメモリアドレスとします．
+    //! 続くバイトはメモリアドレスを1つずつ進めながら読み書きします．
+    class RegisterDevice
+    {
+        uint8_t _registers[256] = {};  // センサ内のメモリ
+        uint8_t _pointer = 0;  // 次に読み書きするメモリアドレス
+        bool _is_addr_byte = true;  // 次のバイトがメモリアドレスか
+        bool _is_read = false;  // 読み込みか書き込みか
+        uint64_t _latency_ns = 0;  // 通信の開始ごとにかかる時間 (ns)
+    public:
+        void set(uint8_t memory_addr, std::initializer_list<uint8_t> values);
+        uint8_t get(uint8_t memory_addr) const noexcept;
+        void set_latency_ns(uint64_t latency_ns) noexcept;
+        uint64_t get_latency_ns() const noexcept;
+        void spi_select() noexcept;
+        uint8_t spi_transfer(uint8_t mosi) noexcept;
+        void i2c_write(sc::Span<const uint8_t> input_data) noexcept;
+        void i2c_read(sc::Span<uint8_t> output_data) noexcept;
+    };
+
+    //! @brief PC上の汎用入出力  ピンのレベルはメモリ上にGPIO番号のビットで保存します
+    class PinIO final : public sc::PinIO
+    {
+        static constexpr uint8_t MaxPinGpio = rp2040::MaxGpio;  // GPIOピンの最大の番号
+        const uint8_t _pin_gpio;  // ピンのGPIO番号
+        static uint32_t pin_levels;  // ピンごとのレベルのビット
+    public:
+        PinIO(uint8_t pin_gpio, Direction direction, Pull pull = Pull::no_use);
+        bool read() const override;
+        void write(bool level) const override;
+        static void set_level(uint8_t pin_gpio, bool level);
+        static bool get_level(uint8_t pin_gpio);
+        static void set_levels(uint32_t mask, uint32_t levels);
+        static uint32_t get_levels() noexcept;
+    };
+
+    //! @brief PC上の複数のピンの入出力  pico::PinGroupと同じく，まとめて1回で読み書きする
+    class PinGroup final : public sc::PinGroup
+    {
+        const uint32_t _mask;  // グループに含まれるピンのGPIO番号のビット
+    public:
+        PinGroup(uint32_t mask, Direction direction, Pull pull = Pull::no_use);
+        uint32_t read() const override;
+        void write(uint32_t levels) const override;
+        void set(uint32_t mask) const override;
+        void clear(uint32_t mask) const override;
+        void toggle(uint32_t mask) const override;
+        uint32_t get_mask() const noexcept {return _mask;}
+    };
+
+    //! @brief PC上のピンのエッジの記録  PinIO::set_levelなどでレベルが変わったときに，シミュレーション上の時刻で記録する
+    class PinEdgeIRQ final : public sc::PinEdgeIRQ
+    {
+        const uint32_t _mask;  // 記録するピンのGPIO番号のビット
+        const Edge _edge;  // 記録するエッジ
+        sc::RingBuffer<Event, SC_PIN_EDGE_BUFFER_SIZE> _events;  // 記録したエッジ
+        static PinEdgeIRQ* edge_irqs[rp2040::MaxGpio + 1];  // ピンごとの記録先
+    public:
+        PinEdgeIRQ(uint32_t mask, Edge edge, PinIO::Pull pull = PinIO::Pull::no_use);
+        ~PinEdgeIRQ();
+        bool pop(Event& event) override;
+        std::size_t get_overflow_count() const noexcept override;
+        static void notify(uint32_t changed_mask, uint32_t levels);
+    };
+
+    //! @brief 超音波距離センサなどのエコーのモデル  記録しておいたエコーのパルスの幅を順に繰り返し返す
+    class EchoDevice
+    {
+        std::vector<uint32_t> _widths_us;  // 返すパルスの幅 (μs)  sc::PulseCapture::NoEchoならエコーなし
+        std::size_t _index = 0;  // 次に返す幅の位置
+    public:
+        void set_widths(std::initializer_list<uint32_t> widths_us);
+        uint32_t next_width_us() noexcept;
+    };
+
+    //! @brief PC上でのトリガーとエコーのパルスの幅の測定  pico::PulseCaptureと同じ間隔で測定したことにする
+    //! エコーのピンにつないだEchoDeviceの幅を，シミュレーション上の時刻で測定が終わっていれば返します．つながっていなければエコーなしとします．
+    class PulseCapture final : public sc::PulseCapture
+    {
+        const uint8_t _echo_gpio;  // エコーを受けるピンのGPIO番号
+        const uint32_t _timeout_us;  // エコーを待つ最大の時間 (μs)
+        const uint32_t _min_cycle_us;  // 測定の最短の周期 (μs)
+        uint64_t _start_us;  // 次の測定を始める時刻 (μs)
+        uint64_t _end_us = 0;  // 測定中の結果が出る時刻 (μs)
+        uint32_t _width_us = NoEcho;  // 測定中の結果
+        bool _is_measuring = false;  // 測定中か
+        static EchoDevice* devices[rp2040::MaxGpio + 1];  // エコーのピンごとにつながるモデル
+    public:
+        PulseCapture(uint8_t trigger_gpio, uint8_t echo_gpio, uint32_t timeout_us = 30000, uint32_t min_cycle_us = 60000);
+        bool pop(uint32_t& width_us) override;
+        void wait() override;
+        static void connect(uint8_t echo_gpio, EchoDevice& device);
+    private:
+        void start_measurement() noexcept;
+    };
+
+    //! @brief PC上のI2C通信  I2C0とI2C1のバスにスレーブアドレスごとにRegisterDeviceをつなぐ
+    //! finalなので，型がhost::I2Cだとわかっている呼び出しは仮想関数を通さずに行われます．
+    //! バス上のSTART(リピーテッドスタートを含む)とSTOPの回数を数え，通信の効率を確認できます．
+    class I2C final : public sc::I2C
+    {
+    public:
+        //! @brief I2C通信で使用するピンの番号
+        class Pin
+        {
+            const uint8_t _sda_gpio;  // SDAピンのGPIO番号
+            const uint8_t _scl_gpio;  // SCLピンのGPIO番号
+            const bool _i2c_id;  // I2C0かI2C1か
+        public:
+            //! @brief pico::I2C::Pinと同じように，使用できないピンはエラー
+            constexpr Pin(uint8_t sda_gpio, uint8_t scl_gpio):
+                _sda_gpio(sda_gpio),
+                _scl_gpio(scl_gpio),
+                _i2c_id(check_id(rp2040::find_i2c_id(sda_gpio, scl_gpio))) {}
+
+            //! @brief コンパイル時に確認してピン番号をセットアップ
+            template<uint8_t SdaGpio, uint8_t SclGpio>
+            static constexpr Pin of() noexcept
+            {
+                static_assert(rp2040::find_i2c_id(SdaGpio, SclGpio) >= 0, "\n\n<!ERROR!> Invalid i2c gpio number entered\n\n");  // 無効なI2CのGPIO番号が入力されました
+                return Pin(SdaGpio, SclGpio);
+            }
+
+            constexpr uint8_t get_sda_gpio() const noexcept {return _sda_gpio;}
+            constexpr uint8_t get_scl_gpio() const noexcept {return _scl_gpio;}
+            constexpr bool get_i2c_id() const noexcept {return _i2c_id;}
+        private:
+            static constexpr bool check_id(int i2c_id)
+            {
+                return (0 <= i2c_id ? i2c_id == 1 : (sc::raise(SC_ERROR_INFO(sc::ErrorCode::invalid_argument, "Invalid i2c gpio number entered")), false));  // 無効なI2CのGPIO番号が入力されました
+            }
+        };
+    private:
+        static constexpr uint8_t MaxSlaveAddr = 0x7f;  // 7ビットのスレーブアドレスの最大値
+        const bool _i2c_id;  // I2C0かI2C1か
+        const uint32_t _freq;  // 周波数 (/s)
+        mutable std::size_t _start_count = 0;  // STARTとリピーテッドスタートの回数  (バスの向きやアドレスの切り替え)
+        mutable std::size_t _stop_count = 0;  // STOPの回数  (バスが空く回数)
+        static RegisterDevice* devices[2][MaxSlaveAddr + 1];  // I2C0とI2C1のスレーブアドレスごとにつながっているセンサ
+    public:
+        I2C(Pin i2c_pin, uint32_t freq);
+        void connect(SlaveAddr slave_addr, RegisterDevice& device) const;
+        sc::Result<void> try_transfer_into(sc::Span<const Segment> segments, sc::Span<uint8_t> input_data) const override;
+        std::size_t get_start_count() const noexcept;
+        std::size_t get_stop_count() const noexcept;
+        static void connect(bool i2c_id, SlaveAddr slave_addr, RegisterDevice& device);
+    private:
+        RegisterDevice* find_device(uint8_t slave_addr) const noexcept;
+        void start(RegisterDevice& device) const;
+        void advance_bytes(std::size_t byte_num) const;
+    };
+
+    //! @brief PC上のSPI通信  DMAによる非同期の転送を擬似的に行う
+    //! 転送はrun_dma()を呼んだとき(またはwait()で待ったとき)に，開始した順に1バイトずつ進みます．
+    //! CSピンの変化と送受信したバイトを記録し，順番や区切りを確認できます．
+    class SPI final : public sc::SPI
+    {
+    public:
+        //! @brief SPI通信で使用するピンの番号
+        class Pin
+        {
+            const uint8_t _miso_gpio;  // MISOピンのGPIO番号
+            const uint8_t _mosi_gpio;  // MOSIピンのGPIO番号
+            const uint8_t _sck_gpio;  // SCKピンのGPIO番号
+            const uint32_t _cs_gpio_mask;  // CSピンのGPIO番号のビット
+            const bool _spi_id;  // SPI0かSPI1か
+        public:
+            //! @brief pico::SPI::Pinと同じように，使用できないピンはエラー
+            constexpr Pin(uint8_t miso_gpio, uint8_t mosi_gpio, uint8_t sck_gpio, std::initializer_list<uint8_t> cs_gpios):
+                _miso_gpio(miso_gpio),
+                _mosi_gpio(mosi_gpio),
+                _sck_gpio(sck_gpio),
+                _cs_gpio_mask(rp2040::gpio_mask(cs_gpios)),
+                _spi_id(check_id(rp2040::find_spi_id(miso_gpio, mosi_gpio, sck_gpio), cs_gpios)) {}
+
+            //! @brief コンパイル時に確認してピン番号をセットアップ
+            template<uint8_t MisoGpio, uint8_t MosiGpio, uint8_t SckGpio, uint8_t... CsGpios>
+            static constexpr Pin of() noexcept
+            {
+                static_assert(rp2040::find_spi_id(MisoGpio, MosiGpio, SckGpio) >= 0 && ((CsGpios <= rp2040::MaxGpio) && ...), "\n\n<!ERROR!> Invalid spi gpio number entered\n\n");  // 無効なSPIのGPIO番号が入力されました
+                return Pin(MisoGpio, MosiGpio, SckGpio, {CsGpios...});
+            }
+
+            constexpr uint8_t get_miso_gpio() const noexcept {return _miso_gpio;}
+            constexpr uint8_t get_mosi_gpio() const noexcept {return _mosi_gpio;}
+            constexpr uint8_t get_sck_gpio() const noexcept {return _sck_gpio;}
+            constexpr uint32_t get_cs_gpio_mask() const noexcept {return _cs_gpio_mask;}
+            constexpr bool get_spi_id() const noexcept {return _spi_id;}
+        private:
+            static constexpr bool check_id(int spi_id, std::initializer_list<uint8_t> cs_gpios)
+            {
+                for (uint8_t cs_gpio : cs_gpios)
+                {
+                    if (rp2040::MaxGpio < cs_gpio) spi_id = -1;
+                }
+                return (0 <= spi_id ? spi_id == 1 : (sc::raise(SC_ERROR_INFO(sc::ErrorCode::invalid_argument, "Invalid spi gpio number entered")), false));  // 無効なSPIのGPIO番号が入力されました
+            }
+        };
+
+        //! @brief SPIの線上で起きたこと
+        struct Event
+        {
+            enum class Type
+            {
+                select,  // CSがLowになった
+                transfer,  // 1バイト送受信した
+                deselect  // CSがHighになった
+            };
+            Type type;
+            uint8_t cs_gpio;  // CSピンのGPIO番号
+            uint8_t mosi;  // 送信したバイト
+            uint8_t miso;  // 受信したバイト
+        };
+    private:
+        //! @brief 開始した転送
+        struct Job
+        {
+            uint32_t sequence;  // 転送の通し番号
+            uint8_t cs_gpio;  // CSピンのGPIO番号
+            const uint8_t* output_data;  // 送信するデータ  nullptrのときは0を送信
+            uint8_t* input_data;  // 受信したデータの保存先  nullptrのときは捨てる
+            std::size_t size;  // 転送するバイト数
+            int memory_addr_num;  // 最初に送るメモリアドレス  負の値のときは送らない
+            std::size_t transferred;  // 転送したバイト数
+            bool is_selected;  // CSをLowにしたか
+        };
+
+        static constexpr uint8_t MaxCsGpio = 28;  // CSピンのGPIO番号の最大値
+        const bool _spi_id;  // SPI0かSPI1か
+        const uint32_t _freq;  // 周波数 (/s)
+        mutable std::deque<Job> _jobs;  // 終わっていない転送
+        mutable uint32_t _started_sequence = 0;  // 最後に開始した転送の通し番号
+        mutable uint32_t _completed_sequence = 0;  // 最後に終了した転送の通し番号
+        mutable std::vector<Event> _events;  // 線上で起きたことの記録
+        static RegisterDevice* devices[2][MaxCsGpio + 1];  // SPI0とSPI1のCSピンごとにつながっているセンサ
+    public:
+        SPI(Pin spi_pin, uint32_t freq);
+        void connect(CS_Pin cs_pin, RegisterDevice& device) const;
+        void run_dma(std::size_t byte_num) const;
+        const std::vector<Event>& get_events() const noexcept;
+        void clear_events() noexcept;
+        Transfer read_async(sc::Span<uint8_t> input_data, CS_Pin cs_pin) const override;
+        Transfer read_mem_async(sc::Span<uint8_t> input_data, CS_Pin cs_pin, MemoryAddr memory_addr) const override;
+        Transfer write_async(sc::Span<const uint8_t> output_data, CS_Pin cs_pin) const override;
+        Transfer write_mem_async(sc::Span<const uint8_t> output_data, CS_Pin cs_pin, MemoryAddr memory_addr) const override;
+        static void connect(bool spi_id, CS_Pin cs_pin, RegisterDevice& device);
+    protected:
+        bool is_transfer_done(uint32_t sequence) const override;
+        void wait_transfer(uint32_t sequence) const override;
+    private:
+        Transfer start_transfer(const uint8_t* output_data, uint8_t* input_data, std::size_t size, CS_Pin cs_pin, int memory_addr_num) const;
+        uint8_t exchange(uint8_t cs_gpio, uint8_t mosi) const;
+    };
+
+    //! @brief PC上のUART通信
+    //! receive()で届いたことにしたデータを受信し，送信したデータはget_output_data()で確認できます．
+    class UART final : public sc::UART
+    {
+    public:
+        //! @brief UART通信で使用するピンの番号
+        class Pin
+        {
+            const uint8_t _tx_gpio;  // TXピンのGPIO番号
+            const uint8_t _rx_gpio;  // RXピンのGPIO番号
+            const bool _uart_id;  // UART0かUART1か
+        public:
+            //! @brief pico::UART::Pinと同じように，使用できないピンはエラー
+            constexpr Pin(uint8_t tx_gpio, uint8_t rx_gpio):
+                _tx_gpio(tx_gpio),
+                _rx_gpio(rx_gpio),
+                _uart_id(check_id(rp2040::find_uart_id(tx_gpio, rx_gpio))) {}
+
+            //! @brief コンパイル時に確認してピン番号をセットアップ
+            template<uint8_t TxGpio, uint8_t RxGpio>
+            static constexpr Pin of() noexcept
+            {
+                static_assert(rp2040::find_uart_id(TxGpio, RxGpio) >= 0, "\n\n<!ERROR!> Invalid uart gpio number entered\n\n");  // 無効なUARTのGPIO番号が入力されました
+                return Pin(TxGpio, RxGpio);
+            }
+
+            constexpr uint8_t get_tx_gpio() const noexcept {return _tx_gpio;}
+            constexpr uint8_t get_rx_gpio() const noexcept {return _rx_gpio;}
+            constexpr bool get_uart_id() const noexcept {return _uart_id;}
+        private:
+            static constexpr bool check_id(int uart_id)
+            {
+                return (0 <= uart_id ? uart_id == 1 : (sc::raise(SC_ERROR_INFO(sc::ErrorCode::invalid_argument, "Invalid uart gpio number entered")), false));  // 無効なUARTのGPIO番号が入力されました
+            }
+        };
+
+        using RxBuffer = sc::RingBuffer<uint8_t, 256>;  // 受信したデータの保存先
+    private:
+        const bool _uart_id;  // UART0かUART1か
+        const uint32_t _freq;  // 周波数 (/s)
+        static RxBuffer input_data[2];  // UART0とUART1で受信したデータ
+        static std::vector<uint8_t> output_data[2];  // UART0とUART1で送信したデータ
+    public:
+        UART(Pin uart_pin, uint32_t freq);
+        sc::Binary read() const override;
+        sc::Binary read(std::size_t size) const override;
+        std::size_t read_into(sc::Span<uint8_t> input_data) const override;
+        void write(const sc::Binary& output_data) const override;
+        void receive(sc::Span<const uint8_t> input_data) const;
+        const std::vector<uint8_t>& get_output_data() const noexcept;
+        void clear_output_data() const noexcept;
+    private:
+        void advance_bytes(std::size_t byte_num) const;
+    };
+
+    //! @brief PC上のPWM  設定した値を保存するだけ
+    class PWM final : public sc::PWM
+    {
+        const uint8_t _pin_gpio;  // ピンのGPIO番号
+        uint32_t _freq;  // 周波数 (/s)
+        float _level = 0;  // 出力レベル
+    public:
+        PWM(uint8_t pin_gpio, uint32_t freq) noexcept;
+        void set_freq(uint32_t freq) override;
+        void set_level(float output_level) override;
+        uint32_t get_freq() const noexcept;
+        float get_level() const noexcept;
+    };
+
+    //! @brief PC上のSDカード  ディスクイメージのファイルをブロック単位で読み書きする
+    //! make_fat32_image()で，FAT32でフォーマットした空のイメージを作れます．
+    class SD final : public sc::SD
+    {
+        std::FILE* _image;  // ディスクイメージのファイル
+        uint32_t _block_num;  // ブロックの数
+        mutable uint32_t _write_count = 0;  // write_blocks()を呼んだ回数
+        uint32_t _fail_write_count = 0;  // この回数目のwrite_blocks()を失敗させる  0のときは失敗させない
+    public:
+        explicit SD(const std::string& image_path);
+        ~SD();
+        sc::Result<void> read_blocks(uint32_t block, sc::Span<uint8_t> input_data) const override;
+        sc::Result<void> write_blocks(uint32_t block, sc::Span<const uint8_t> output_data) const override;
+        uint32_t get_block_num() const noexcept override;
+        uint32_t get_write_count() const noexcept;
+        void fail_write_at(uint32_t write_count) noexcept;
+        static void make_fat32_image(const std::string& image_path, uint32_t block_num);
+    private:
+        sc::Result<void> check_range(uint32_t block, std::size_t size) const noexcept;
+    };
+
+    //! @brief DMAのリング機能で循環バッファに書き込むUART受信のシミュレーション
+    //! picoのDMAと同じく，読み出しに関係なくバッファを上書きし続け，書き込んだバイト数の累計を数えます
+    template<std::size_t Capacity>
+    class DmaChannel
+    {
+        sc::DmaRingBuffer<Capacity>& _ring_buffer;  // 書き込み先
+        std::size_t _written_count = 0;  // 書き込んだバイト数の累計  (picoではDMAの転送回数から計算する値)
+        uint64_t _now_us = 0;  // 仮想的な現在時刻 (μs)
+    public:
+        explicit DmaChannel(sc::DmaRingBuffer<Capacity>& ring_buffer):
+            _ring_buffer(ring_buffer) {}
+
+        //! @brief UARTでデータが届いたことにする
+        //! @param input_data 届いたデータ
+        //! @param byte_time_us 1バイトの受信にかかる時間 (μs)
+        void receive(sc::Span<const uint8_t> input_data, uint64_t byte_time_us = 0)
+        {
+            uint8_t* const buffer = _ring_buffer.get_dma_buffer();
+            for (uint8_t input_byte : input_data)
+            {
+                buffer[_written_count++ % Capacity] = input_byte;
+                _now_us += byte_time_us;
+            }
+        }
+
+        //! @brief 時間を進める
+        //! @param time_us 進める時間 (μs)
+        void wait(uint64_t time_us) noexcept {_now_us += time_us;}
+
+        std::size_t get_written_count() const noexcept {return _written_count;}
+
+        uint64_t get_now_us() const noexcept {return _now_us;}
+
+        //! @brief picoのUART::get_dma_input_data()と同じく，書き込んだ分をバッファに反映する
+        sc::DmaRingBuffer<Capacity>& update() noexcept
+        {
+            _ring_buffer.update(_written_count, _now_us);
+            return _ring_buffer;
+        }
+    };
+}
+
+#endif  // SC19_CODE_TEST_SC_SC_HOST_HPP_
@@ -0,0 +1,37 @@
+/*************************************
+ *************************************
+
+バイナリ形式(sc::Log::Format::binary)で記録したログを文字列に戻すプログラムです
+
+PC上では test_code/host のCMakeでビルドして実行します
+    SC_LogDecode [ログのファイル]  (ファイルを指定しなければ標準入力から読み込みます)
+picoのUSB出力を読む場合は，例えば次のようにします
+    SC_LogDecode < /dev/ttyACM0
+
+*************************************
+*************************************/
+
+#include <cstdio>
+
+#include "sc_host.hpp"
+
+int main(int argc, char* argv[])
+{
+    std::FILE* input = (argc > 1 ? std::fopen(argv[1], "rb") : stdin);
+    if (!input)
+    {
+        std::fprintf(stderr, "<<ERROR>> cannot open %s\n", argv[1]);  // ファイルを開けません
+        return 1;
+    }
+    host::LogDecoder decoder;
+    uint8_t data[1024];
+    std::size_t size;
+    while ((size = std::fread(data, 1, sizeof(data), input)) > 0)
+    {
+        const std::string decoded = decoder.decode(sc::Span<const uint8_t>(data, size));
+        std::fwrite(decoded.data(), 1, decoded.size(), stdout);
+        std::fflush(stdout);  // picoから少しずつ届く場合もすぐに表示する
+    }
+    if (input != stdin) std::fclose(input);
+    return 0;
+}
@@ -0,0 +1,1230 @@
+/*************************************
+ *************************************
+
+
+このファイルは見なくてかまいません
+内部の実装を知りたい場合のみ見てください
+
+
+*************************************
+*************************************/
+
+#include "sc_host.hpp"
+
+//! @file sc_host.cpp
+//! @brief PC上でpicoの代わりに動かすためのプログラム
+//! @date 2026-10-16
+
+
+namespace
+{
+    std::ostream* log_output = &std::cout;  // ログの出力先
+#ifdef SC_HOST
+    std::thread log_drain_thread;  // ログを出力するスレッド  (picoのコア1の代わり)
+    std::atomic<bool> is_log_draining{false};  // ログを出力するスレッドが動いているか
+    std::thread core1_thread;  // パイプラインの処理とログの出力を行うスレッド  (picoのコア1の代わり)
+    std::atomic<bool> is_core1_running{false};  // core1_threadが動いているか
+    bool (*core1_step)(void*) = nullptr;  // core1_threadで繰り返し呼ぶ関数
+    void* core1_context = nullptr;  // core1_stepに渡すポインタ
+    std::mutex log_mutex;  // 複数のスレッドからのログの書き込みを排他する  (picoのスピンロックの代わり)
+
+    //! @brief ログの排他を始める
+    //! @return 元の状態  (PC上では使わない)
+    uint32_t lock_log()
+    {
+        log_mutex.lock();
+        return 0;
+    }
+
+    //! @brief ログの排他を終える
+    void unlock_log(uint32_t)
+    {
+        log_mutex.unlock();
+    }
+#endif
+}
+
+//! @brief ログを出力する関数です．(PC上では標準出力に出力)
+//! @param log 書き込む文字列
+//! @param size 文字数
+void sc::Log::output(const char* log, std::size_t size) noexcept
+{
+    log_output->write(log, size);  // 出力先で例外を有効にしていなければ，失敗しても例外は投げられない
+    log_output->flush();
+}
+
+namespace host
+{
+    //! @brief ログの出力先を変更する
+    //! @param output 出力先  ファイルやstd::ostringstreamなどを指定できます
+    void set_log_output(std::ostream& output) noexcept
+    {
+        log_output = &output;
+    }
+
+#ifdef SC_HOST
+    //! @brief 別のスレッドでログの出力を始める  (picoのコア1での出力の代わり)
+    //! プログラムの終了時(exitを含む)にはstop_log_drain()が自動で呼ばれ，残りのログが出力されます
+    void start_log_drain()
+    {
+        if (is_log_draining.exchange(true))
+    return;
+        static const bool is_registered = (std::atexit(stop_log_drain) == 0);  // 終了時に1回だけ呼ばれるように登録
+        static_cast<void>(is_registered);
+        sc::Log::set_lock(lock_log, unlock_log);  // 元のスレッドとログを出力するスレッドの両方が書き込めるようにする
+        sc::Log::set_async(true);
+        log_drain_thread = std::thread([]
+        {
+            while (is_log_draining.load(std::memory_order_acquire))
+            {
+                if (!sc::Log::flush()) std::this_thread::sleep_for(std::chrono::microseconds(100));  // 出力するログがなければ少し待つ
+            }
+        });
+    }
+
+    //! @brief ログを出力するスレッドを止め，残りのログを全て出力する
+    void stop_log_drain() noexcept
+    {
+        if (!is_log_draining.exchange(false))
+    return;
+        log_drain_thread.join();
+        sc::Log::set_async(false);
+        sc::Log::flush();  // スレッドが止まったので，こちらのスレッドが読み込み側になる
+    }
+
+    //! @brief 別のスレッドで，処理(step)とログの出力を繰り返す  (picoのコア1の代わり)
+    //! プログラムの終了時(exitを含む)にはstop_core1()が自動で呼ばれます
+    //! @param step 繰り返し呼ぶ関数  処理することがなければfalseを返す
+    //! @param context stepに渡すポインタ
+    void launch_core1(bool (*step)(void*), void* context)
+    {
+        if (is_core1_running.exchange(true))
+    return;
+        static const bool is_registered = (std::atexit(stop_core1) == 0);  // 終了時に1回だけ呼ばれるように登録
+        static_cast<void>(is_registered);
+        core1_step = step;
+        core1_context = context;
+        sc::Log::set_lock(lock_log, unlock_log);  // 処理の中と元のスレッドの両方から書き込めるようにする
+        sc::Log::set_async(true);
+        core1_thread = std::thread([]
+        {
+            while (is_core1_running.load(std::memory_order_acquire))
+            {
+                const bool is_processed = core1_step(core1_context);
+                if (!sc::Log::flush() && !is_processed) std::this_thread::yield();  // 処理もログもなければ他のスレッドに譲る
+            }
+        });
+    }
+
+    //! @brief launch_core1()のスレッドを止め，残りの処理とログを全て行う
+    void stop_core1() noexcept
+    {
+        if (!is_core1_running.exchange(false))
+    return;
+        if (core1_thread.get_id() == std::this_thread::get_id())  // 処理の中でexitした場合は，自分自身を待てない
+        {
+            core1_thread.detach();
+    return;
+        }
+        core1_thread.join();
+        while (core1_step(core1_context)) {}  // スレッドが止まったので，こちらのスレッドで残りを処理する
+        sc::Log::set_async(false);
+        sc::Log::flush();
+    }
+#endif
+
+    /***** class LogDecoder *****/
+
+    //! @brief バイナリ形式のログを文字列に戻す
+    //! バイナリ形式のレコードの外にあるバイト(バイナリ形式にする前の文字列など)はそのまま出力します
+    //! @param data ログのデータ
+    //! @return 戻した文字列  レコードの途中までしかない部分は，次に呼び出したときに戻します
+    std::string LogDecoder::decode(sc::Span<const uint8_t> data)
+    {
+        _pending_data.insert(_pending_data.end(), data.begin(), data.end());
+        std::string decoded;
+        std::size_t position = 0;
+        while (position < _pending_data.size())
+        {
+            const uint8_t record_type = _pending_data[position];
+            if (record_type != static_cast<uint8_t>(sc::Log::RecordType::text) && record_type != static_cast<uint8_t>(sc::Log::RecordType::format) && record_type != static_cast<uint8_t>(sc::Log::RecordType::event))
+            {
+                decoded += static_cast<char>(record_type);
+                ++position;
+        continue;
+            }
+            if (position + 2 > _pending_data.size() || position + 2 + _pending_data[position + 1] > _pending_data.size())
+        break;  // レコードの残りを待つ
+            const sc::Span<const uint8_t> payload(&_pending_data[position + 2], _pending_data[position + 1]);
+            position += 2 + payload.size();
+            if (record_type == static_cast<uint8_t>(sc::Log::RecordType::text))
+            {
+                decoded.append(reinterpret_cast<const char*>(payload.data()), payload.size());
+            }
+            else if (record_type == static_cast<uint8_t>(sc::Log::RecordType::format))
+            {
+                if (payload.size()) _formats[payload[0]].assign(reinterpret_cast<const char*>(payload.data()) + 1, payload.size() - 1);
+            }
+            else
+            {
+                decoded += decode_event(payload);
+            }
+        }
+        _pending_data.erase(_pending_data.begin(), _pending_data.begin() + position);
+        return decoded;
+    }
+
+    //! @brief 書式を使ったログのレコードを文字列に戻す
+    //! 書式の変換指定ごとに，記録された引数の型に合わせてsnprintfで書式化します
+    //! @param payload 書式のIDと引数
+    //! @return 戻した文字列
+    std::string LogDecoder::decode_event(sc::Span<const uint8_t> payload) const
+    {
+        if (payload.empty() || _formats[payload[0]].empty())
+    return "<<LOG>> unknown log format\n";  // 書式の定義を受け取っていない
+        const std::string& format = _formats[payload[0]];
+        std::string decoded;
+        std::size_t arg_position = 1;
+        std::size_t format_position = 0;
+        while (format_position < format.size())
+        {
+            const std::size_t spec_begin = format.find('%', format_position);
+            decoded.append(format, format_position, spec_begin - format_position);
+            if (spec_begin == std::string::npos)
+        break;
+            if (spec_begin + 1 < format.size() && format[spec_begin + 1] == '%')
+            {
+                decoded += '%';
+                format_position = spec_begin + 2;
+        continue;
+            }
+            const std::size_t conversion = format.find_first_of("diouxXeEfFgGaAcsp", spec_begin + 1);
+            if (conversion == std::string::npos)
+        break;
+            format_position = conversion + 1;
+            std::string spec = format.substr(spec_begin, conversion - spec_begin);
+            spec.erase(std::remove_if(spec.begin() + 1, spec.end(), [](char c) {return c == 'h' || c == 'l' || c == 'j' || c == 'z' || c == 't' || c == 'L';}), spec.end());  // 長さの指定は引数の型に合わせて付け直す
+            if (arg_position >= payload.size())
+        break;
+            const auto arg_type = static_cast<sc::Log::ArgType>(payload[arg_position++]);
+            const uint8_t* arg = &payload[arg_position];
+            const std::size_t arg_remaining = payload.size() - arg_position;
+            char formatted[256];
+            int formatted_size = 0;
+            auto read_arg = [&](auto value)
+            {
+                if (arg_remaining >= sizeof(value)) std::memcpy(&value, arg, sizeof(value));
+                arg_position += sizeof(value);
+                return value;
+            };
+            switch (arg_type)
+            {
+            case sc::Log::ArgType::int32:
+            case sc::Log::ArgType::int64:
+            {
+                const long long value = (arg_type == sc::Log::ArgType::int32 ? read_arg(int32_t()) : read_arg(int64_t()));
+                formatted_size = std::snprintf(formatted, sizeof(formatted), (spec + (format[conversion] == 'c' ? "" : "ll") + format[conversion]).c_str(), value);
+                break;
+            }
+            case sc::Log::ArgType::uint32:
+            case sc::Log::ArgType::uint64:
+            {
+                const unsigned long long value = (arg_type == sc::Log::ArgType::uint32 ? read_arg(uint32_t()) : read_arg(uint64_t()));
+                formatted_size = std::snprintf(formatted, sizeof(formatted), (spec + (format[conversion] == 'c' ? "" : "ll") + format[conversion]).c_str(), value);
+                break;
+            }
+            case sc::Log::ArgType::float32:
+            case sc::Log::ArgType::float64:
+            {
+                const double value = (arg_type == sc::Log::ArgType::float32 ? read_arg(float()) : read_arg(double()));
+                formatted_size = std::snprintf(formatted, sizeof(formatted), (spec + format[conversion]).c_str(), value);
+                break;
+            }
+            case sc::Log::ArgType::string:
+            {
+                const std::size_t length = std::min<std::size_t>(arg_remaining ? arg[0] : 0, arg_remaining ? arg_remaining - 1 : 0);
+                const std::string value(reinterpret_cast<const char*>(arg) + 1, length);
+                arg_position += 1 + length;
+                formatted_size = std::snprintf(formatted, sizeof(formatted), (spec + 's').c_str(), value.c_str());
+                break;
+            }
+            case sc::Log::ArgType::pointer:
+            {
+                formatted_size = std::snprintf(formatted, sizeof(formatted), "0x%llx", static_cast<unsigned long long>(read_arg(uint64_t())));
+                break;
+            }
+            default:
+    return decoded + "<<LOG>> unknown log argument\n";  // 知らない種類の引数
+            }
+            if (formatted_size > 0) decoded.append(formatted, std::min<std::size_t>(formatted_size, sizeof(formatted) - 1));
+        }
+        return decoded;
+    }
+
+    /***** class Clock *****/
+
+    std::atomic<uint64_t> Clock::_now_ns{0};
+
+    //! @brief 現在時刻を取得
+    //! @return シミュレーション開始からの時間 (ns)
+    uint64_t Clock::get_ns() noexcept
+    {
+        return _now_ns.load(std::memory_order_relaxed);
+    }
+
+    //! @brief 現在時刻を取得
+    //! @return シミュレーション開始からの時間 (μs)
+    uint64_t Clock::get_us() noexcept
+    {
+        return _now_ns.load(std::memory_order_relaxed) / 1000;
+    }
+
+    //! @brief 時刻を進める
+    //! @param time_ns 進める時間 (ns)
+    //! SC_HOST_TIME_LIMIT_USの時刻を過ぎたらプログラムを終了する
+    void Clock::advance_ns(uint64_t time_ns)
+    {
+        static const uint64_t limit_ns = get_limit_ns();
+        if (limit_ns < _now_ns.fetch_add(time_ns, std::memory_order_relaxed) + time_ns)
+        {
+            std::cout << std::flush;
+            std::exit(0);
+        }
+    }
+
+    //! @brief 環境変数 SC_HOST_TIME_LIMIT_US からシミュレーションを終了する時刻を取得
+    //! @return 終了する時刻 (ns)  設定されていなければ終了しない
+    uint64_t Clock::get_limit_ns()
+    {
+        const char* const limit_us = std::getenv("SC_HOST_TIME_LIMIT_US");
+        if (!limit_us)
+    return UINT64_MAX;
+        return std::strtoull(limit_us, nullptr, 10) * 1000;
+    }
+
+    /***** class RegisterDevice *****/
+
+    //! @brief センサ内のメモリに値を書き込む
+    //! @param memory_addr 書き込む先頭のメモリアドレス
+    //! @param values 書き込む値
+    void RegisterDevice::set(uint8_t memory_addr, std::initializer_list<uint8_t> values)
+    {
+        for (uint8_t value : values)
+        {
+            _registers[memory_addr++] = value;
+        }
+    }
+
+    //! @brief センサ内のメモリの値を取得
+    //! @param memory_addr メモリアドレス
+    uint8_t RegisterDevice::get(uint8_t memory_addr) const noexcept
+    {
+        return _registers[memory_addr];
+    }
+
+    //! @brief 通信の開始ごとにかかる時間を設定
+    //! @param latency_ns かかる時間 (ns)
+    void RegisterDevice::set_latency_ns(uint64_t latency_ns) noexcept
+    {
+        _latency_ns = latency_ns;
+    }
+
+    //! @brief 通信の開始ごとにかかる時間を取得
+    //! @return かかる時間 (ns)
+    uint64_t RegisterDevice::get_latency_ns() const noexcept
+    {
+        return _latency_ns;
+    }
+
+    //! @brief CSがLowになった  次のバイトをメモリアドレスとして受け取る
+    void RegisterDevice::spi_select() noexcept
+    {
+        _is_addr_byte = true;
+    }
+
+    //! @brief SPIで1バイト送受信
+    //! @param mosi センサが受信したバイト
+    //! @return センサが送信したバイト
+    uint8_t RegisterDevice::spi_transfer(uint8_t mosi) noexcept
+    {
+        if (_is_addr_byte)
+        {
+            _is_addr_byte = false;
+            _is_read = mosi & 0b10000000;
+            _pointer = mosi & 0b01111111;
+    return 0;
+        }
+        if (_is_read)
+    return _registers[_pointer++];
+        _registers[_pointer++] = mosi;
+        return 0;
+    }
+
+    //! @brief I2Cで受信  最初の1バイトをメモリアドレスとし，続くバイトをメモリに書き込む
+    //! @param input_data センサが受信したデータ  (STARTからSTOPまたはリピーテッドスタートまで)
+    void RegisterDevice::i2c_write(sc::Span<const uint8_t> input_data) noexcept
+    {
+        if (input_data.empty())
+    return;
+        _pointer = input_data[0];
+        for (uint8_t value : input_data.subspan(1, input_data.size() - 1))
+        {
+            _registers[_pointer++] = value;
+        }
+    }
+
+    //! @brief I2Cで送信  メモリアドレスを1つずつ進めながらメモリの値を送る
+    //! @param output_data センサが送信したデータの保存先
+    void RegisterDevice::i2c_read(sc::Span<uint8_t> output_data) noexcept
+    {
+        for (uint8_t& value : output_data)
+        {
+            value = _registers[_pointer++];
+        }
+    }
+
+    /***** class PinIO *****/
+
+    uint32_t PinIO::pin_levels = 0;
+
+    //! @brief 汎用入出力をセットアップ
+    //! 入力用のピンはプルアップならHigh，それ以外ならLowから始める
+    PinIO::PinIO(uint8_t pin_gpio, Direction direction, Pull pull):
+        _pin_gpio(pin_gpio)
+    {
+        if (MaxPinGpio < _pin_gpio)
+        {
+            sc::raise(SC_ERROR_INFO(sc::ErrorCode::invalid_argument, "Invalid pin_gpio number entered"));  // 無効なピンのGPIO番号が入力されました
+        }
+        if (direction == Direction::in)
+        {
+            set_levels(1UL << _pin_gpio, (pull == Pull::up) ? UINT32_MAX : 0);
+        }
+    }
+
+    //! @brief 入力用ピンから読み込み
+    //! @return High(1)かLow(0)か
+    bool PinIO::read() const
+    {
+        return (pin_levels >> _pin_gpio) & 1;
+    }
+
+    //! @brief 出力用ピンに書き込み
+    //! @param level High(1)かLow(0)か
+    void PinIO::write(bool level) const
+    {
+        set_levels(1UL << _pin_gpio, level ? UINT32_MAX : 0);
+    }
+
+    //! @brief 外部からピンのレベルを変える  (入力用ピンにつながるセンサのシミュレーション)
+    //! @param pin_gpio ピンのGPIO番号
+    //! @param level High(1)かLow(0)か
+    void PinIO::set_level(uint8_t pin_gpio, bool level)
+    {
+        if (MaxPinGpio < pin_gpio)
+        {
+            sc::raise(SC_ERROR_INFO(sc::ErrorCode::invalid_argument, "Invalid pin_gpio number entered"));  // 無効なピンのGPIO番号が入力されました
+        }
+        set_levels(1UL << pin_gpio, level ? UINT32_MAX : 0);
+    }
+
+    //! @brief 外部からピンのレベルを確認する  (出力用ピンにつながる機器のシミュレーション)
+    //! @param pin_gpio ピンのGPIO番号
+    //! @return High(1)かLow(0)か
+    bool PinIO::get_level(uint8_t pin_gpio)
+    {
+        if (MaxPinGpio < pin_gpio)
+        {
+            sc::raise(SC_ERROR_INFO(sc::ErrorCode::invalid_argument, "Invalid pin_gpio number entered"));  // 無効なピンのGPIO番号が入力されました
+        }
+        return (pin_levels >> pin_gpio) & 1;
+    }
+
+    //! @brief 複数のピンのレベルをまとめて変える  変わったピンはPinEdgeIRQに記録する
+    //! @param mask 変えるピンのGPIO番号のビット
+    //! @param levels ピンごとのレベルのビット
+    void PinIO::set_levels(uint32_t mask, uint32_t levels)
+    {
+        const uint32_t changed_mask = (pin_levels ^ levels) & mask;
+        pin_levels ^= changed_mask;
+        if (changed_mask) PinEdgeIRQ::notify(changed_mask, pin_levels);
+    }
+
+    //! @brief 全てのピンのレベルをビットで取得
+    uint32_t PinIO::get_levels() noexcept
+    {
+        return pin_levels;
+    }
+
+    /***** class PinGroup *****/
+
+    //! @brief 複数のピンをまとめてセットアップ
+    //! 入力用のピンはプルアップならHigh，それ以外ならLowから始める
+    PinGroup::PinGroup(uint32_t mask, Direction direction, Pull pull):
+        _mask(mask)
+    {
+        if (!_mask || (_mask >> (rp2040::MaxGpio + 1)))
+        {
+            sc::raise(SC_ERROR_INFO(sc::ErrorCode::invalid_argument, "Invalid pin_gpio number entered"));  // 無効なピンのGPIO番号が入力されました
+        }
+        if (direction == Direction::in)
+        {
+            PinIO::set_levels(_mask, (pull == Pull::up) ? UINT32_MAX : 0);
+        }
+    }
+
+    //! @brief 入力用ピンからまとめて読み込み
+    uint32_t PinGroup::read() const
+    {
+        return PinIO::get_levels() & _mask;
+    }
+
+    //! @brief 出力用ピンにまとめて書き込み
+    void PinGroup::write(uint32_t levels) const
+    {
+        PinIO::set_levels(_mask, levels);
+    }
+
+    //! @brief ビットを立てたピンをHighにする
+    void PinGroup::set(uint32_t mask) const
+    {
+        PinIO::set_levels(mask & _mask, UINT32_MAX);
+    }
+
+    //! @brief ビットを立てたピンをLowにする
+    void PinGroup::clear(uint32_t mask) const
+    {
+        PinIO::set_levels(mask & _mask, 0);
+    }
+
+    //! @brief ビットを立てたピンのレベルを反転する
+    void PinGroup::toggle(uint32_t mask) const
+    {
+        PinIO::set_levels(mask & _mask, ~PinIO::get_levels());
+    }
+
+    /***** class PinEdgeIRQ *****/
+
+    PinEdgeIRQ* PinEdgeIRQ::edge_irqs[rp2040::MaxGpio + 1] = {};
+
+    //! @brief ピンのエッジの記録をセットアップ
+    //! @param mask 記録するピンのGPIO番号のビット
+    //! @param edge 記録するエッジ
+    //! @param pull プルアップならHigh，それ以外ならLowから始める
+    PinEdgeIRQ::PinEdgeIRQ(uint32_t mask, Edge edge, PinIO::Pull pull):
+        _mask(mask), _edge(edge)
+    {
+        if (!_mask || (_mask >> (rp2040::MaxGpio + 1)))
+        {
+            sc::raise(SC_ERROR_INFO(sc::ErrorCode::invalid_argument, "Invalid pin_gpio number entered"));  // 無効なピンのGPIO番号が入力されました
+        }
+        for (uint8_t pin_gpio = 0; pin_gpio <= rp2040::MaxGpio; ++pin_gpio)
+        {
+            if (rp2040::contains(_mask, pin_gpio) && edge_irqs[pin_gpio])
+            {
+                sc::raise(SC_ERROR_INFO(sc::ErrorCode::invalid_argument, "The pin already has a PinEdgeIRQ"));  // このピンには既にPinEdgeIRQが作られています
+            }
+        }
+        PinIO::set_levels(_mask, (pull == PinIO::Pull::up) ? UINT32_MAX : 0);  // 初期のレベルは記録しない
+        for (uint8_t pin_gpio = 0; pin_gpio <= rp2040::MaxGpio; ++pin_gpio)
+        {
+            if (rp2040::contains(_mask, pin_gpio)) edge_irqs[pin_gpio] = this;
+        }
+    }
+
+    //! @brief ピンの記録先を解除する
+    PinEdgeIRQ::~PinEdgeIRQ()
+    {
+        for (uint8_t pin_gpio = 0; pin_gpio <= rp2040::MaxGpio; ++pin_gpio)
+        {
+            if (rp2040::contains(_mask, pin_gpio)) edge_irqs[pin_gpio] = nullptr;
+        }
+    }
+
+    //! @brief 古い順に記録を取り出す
+    //! @param event 取り出した記録の保存先
+    //! @return 取り出せたらtrue  記録がなければfalse
+    bool PinEdgeIRQ::pop(Event& event)
+    {
+        return _events.pop(event);
+    }
+
+    //! @brief 取り出す前にあふれて捨てた記録の数を取得
+    std::size_t PinEdgeIRQ::get_overflow_count() const noexcept
+    {
+        return _events.get_overflow_count();
+    }
+
+    //! @brief ピンのレベルが変わったことを記録する  (picoでの割り込み処理の代わり)
+    //! @param changed_mask 変わったピンのGPIO番号のビット
+    //! @param levels 変わった後の全てのピンのレベルのビット
+    void PinEdgeIRQ::notify(uint32_t changed_mask, uint32_t levels)
+    {
+        for (uint8_t pin_gpio = 0; pin_gpio <= rp2040::MaxGpio; ++pin_gpio)
+        {
+            PinEdgeIRQ* const edge_irq = edge_irqs[pin_gpio];
+            if (!rp2040::contains(changed_mask, pin_gpio) || !edge_irq)
+        continue;
+            const bool is_rising = (levels >> pin_gpio) & 1;
+            const Edge edge = is_rising ? Edge::rising : Edge::falling;
+            if (static_cast<uint8_t>(edge_irq->_edge) & static_cast<uint8_t>(edge))
+            {
+                edge_irq->_events.push(Event{Clock::get_us(), pin_gpio, is_rising});
+            }
+        }
+    }
+
+    /***** class EchoDevice *****/
+
+    //! @brief 返すエコーのパルスの幅を設定
+    //! @param widths_us パルスの幅 (μs)  { }で囲んで複数入力  最後まで返したら最初に戻ります
+    void EchoDevice::set_widths(std::initializer_list<uint32_t> widths_us)
+    {
+        _widths_us.assign(widths_us);
+        _index = 0;
+    }
+
+    //! @brief 次のエコーのパルスの幅を取得
+    //! @return パルスの幅 (μs)  設定されていなければエコーなし
+    uint32_t EchoDevice::next_width_us() noexcept
+    {
+        if (_widths_us.empty())
+    return sc::PulseCapture::NoEcho;
+        const uint32_t width_us = _widths_us[_index];
+        _index = (_index + 1) % _widths_us.size();
+        return width_us;
+    }
+
+    /***** class PulseCapture *****/
+
+    namespace
+    {
+        constexpr uint32_t PulseCaptureTriggerUs = 10;  // トリガーのパルスの幅 (μs)
+    }
+
+    EchoDevice* PulseCapture::devices[rp2040::MaxGpio + 1] = {};
+
+    //! @brief 測定をセットアップ  この時刻から測定を繰り返したことにする
+    //! @param trigger_gpio トリガーを出すピンのGPIO番号
+    //! @param echo_gpio エコーを受けるピンのGPIO番号
+    //! @param timeout_us エコーを待つ最大の時間 (μs)
+    //! @param min_cycle_us 測定の最短の周期 (μs)  トリガーからこの時間が過ぎるまで次の測定を始めません
+    PulseCapture::PulseCapture(uint8_t trigger_gpio, uint8_t echo_gpio, uint32_t timeout_us, uint32_t min_cycle_us):
+        _echo_gpio(echo_gpio),
+        _timeout_us(timeout_us),
+        _min_cycle_us(min_cycle_us),
+        _start_us(Clock::get_us())
+    {
+        if (rp2040::MaxGpio < trigger_gpio || rp2040::MaxGpio < echo_gpio || trigger_gpio == echo_gpio)
+        {
+            sc::raise(SC_ERROR_INFO(sc::ErrorCode::invalid_argument, "Invalid pin_gpio number entered"));  // 無効なピンのGPIO番号が入力されました
+        }
+        if (!timeout_us || timeout_us == NoEcho)
+        {
+            sc::raise(SC_ERROR_INFO(sc::ErrorCode::invalid_argument, "Invalid timeout entered"));  // 無効なタイムアウトが入力されました
+        }
+        if (min_cycle_us <= PulseCaptureTriggerUs)
+        {
+            sc::raise(SC_ERROR_INFO(sc::ErrorCode::invalid_argument, "Invalid minimum cycle entered"));  // 無効な最短の周期が入力されました
+        }
+    }
+
+    //! @brief 古い順にエコーのパルスの幅を取り出す
+    //! @param width_us 取り出したパルスの幅(μs)の保存先  タイムアウトしたときはNoEcho
+    //! @return 取り出せたらtrue  シミュレーション上の時刻でまだ測定が終わっていなければfalse
+    bool PulseCapture::pop(uint32_t& width_us)
+    {
+        if (!_is_measuring) start_measurement();
+        if (Clock::get_us() < _end_us)
+    return false;
+        width_us = _width_us;
+        _is_measuring = false;
+        return true;
+    }
+
+    //! @brief 次の測定が終わる時刻まで時刻を進める
+    void PulseCapture::wait()
+    {
+        if (!_is_measuring) start_measurement();
+        const uint64_t now_us = Clock::get_us();
+        if (now_us < _end_us) Clock::advance_ns((_end_us - now_us) * 1000);
+    }
+
+    //! @brief 次の測定の結果と，結果が出る時刻を決める
+    void PulseCapture::start_measurement() noexcept
+    {
+        EchoDevice* const device = devices[_echo_gpio];
+        const uint32_t echo_us = (device ? device->next_width_us() : NoEcho);  // つながっていなければエコーなし
+        _width_us = (_timeout_us < echo_us) ? NoEcho : echo_us;
+        _end_us = _start_us + PulseCaptureTriggerUs + std::min(echo_us, _timeout_us);
+        _start_us = _end_us + (_min_cycle_us - PulseCaptureTriggerUs);  // picoと同じく，エコーの後に最短の周期からトリガーを除いた時間だけ待つ
+        _is_measuring = true;
+    }
+
+    //! @brief エコーのピンにモデルをつなぐ
+    //! @param echo_gpio エコーを受けるピンのGPIO番号
+    //! @param device つなぐモデル
+    void PulseCapture::connect(uint8_t echo_gpio, EchoDevice& device)
+    {
+        if (rp2040::MaxGpio < echo_gpio)
+        {
+            sc::raise(SC_ERROR_INFO(sc::ErrorCode::invalid_argument, "Invalid pin_gpio number entered"));  // 無効なピンのGPIO番号が入力されました
+        }
+        devices[echo_gpio] = &device;
+    }
+
+    /***** class I2C *****/
+
+    RegisterDevice* I2C::devices[2][MaxSlaveAddr + 1] = {};
+
+    //! @brief I2Cのセットアップ
+    //! @param i2c_pin I2Cで使用するピン
+    //! @param freq 周波数 (/s)  通信にかかる時間の計算に使う
+    I2C::I2C(Pin i2c_pin, uint32_t freq):
+        _i2c_id(i2c_pin.get_i2c_id()),
+        _freq(freq)
+    {
+        if (!_freq)
+        {
+            sc::raise(SC_ERROR_INFO(sc::ErrorCode::invalid_argument, "Invalid frequency entered"));  // 無効な周波数が入力されました
+        }
+    }
+
+    //! @brief このI2Cのバスにセンサをつなぐ
+    //! @param slave_addr センサのスレーブアドレス
+    //! @param device つなぐセンサ
+    void I2C::connect(SlaveAddr slave_addr, RegisterDevice& device) const
+    {
+        connect(_i2c_id, slave_addr, device);
+    }
+
+    //! @brief I2Cのバスにセンサをつなぐ  (I2Cを作る前につなぐ場合)
+    //! @param i2c_id I2C0かI2C1か
+    //! @param slave_addr センサのスレーブアドレス
+    //! @param device つなぐセンサ
+    void I2C::connect(bool i2c_id, SlaveAddr slave_addr, RegisterDevice& device)
+    {
+        if (MaxSlaveAddr < slave_addr.get())
+        {
+            sc::raise(SC_ERROR_INFO(sc::ErrorCode::invalid_argument, "Invalid slave address entered."));  // 無効なスレーブアドレスの値が入力されました
+        }
+        devices[i2c_id][slave_addr.get()] = &device;
+    }
+
+    //! @brief スレーブアドレスにつながるセンサを取得
+    //! @return つながっていなければnullptr
+    RegisterDevice* I2C::find_device(uint8_t slave_addr) const noexcept
+    {
+        if (MaxSlaveAddr < slave_addr)
+    return nullptr;
+        return devices[_i2c_id][slave_addr];
+    }
+
+    //! @brief STARTとスレーブアドレスの送信
+    void I2C::start(RegisterDevice& device) const
+    {
+        ++_start_count;
+        Clock::advance_ns(device.get_latency_ns() + 10 * 1000000000ull / _freq);  // START(1ビット)とアドレス(9ビット)
+    }
+
+    //! @brief データの送受信にかかる時間だけ時刻を進める
+    void I2C::advance_bytes(std::size_t byte_num) const
+    {
+        Clock::advance_ns(9 * byte_num * 1000000000ull / _freq);  // 1バイトは8ビットとACKの9ビット
+    }
+
+    //! @brief 複数の区間の通信を続けて行う  pico::I2Cと同じ順にSTARTとSTOPを行う
+    //! @param segments 通信する区間
+    //! @param input_data 受信したデータの保存先  受信する区間のデータを順に詰めて保存します
+    //! @return 通信のエラー
+    sc::Result<void> I2C::try_transfer_into(sc::Span<const Segment> segments, sc::Span<uint8_t> input_data) const
+    {
+        if (input_data.size() < get_read_size(segments))
+        {
+    return SC_ERROR_INFO(sc::ErrorCode::buffer_too_small, "Input buffer is too small for the transfer");  // 受信したデータの保存先が小さすぎます
+        }
+
+        std::size_t input_size = 0;  // 保存先に受信したバイト数
+        for (std::size_t i = 0; i < segments.size(); ++i)
+        {
+            const Segment& segment = segments[i];
+            const bool no_stop = (i + 1 < segments.size() && segments[i + 1].get_slave_addr() == segment.get_slave_addr());
+            RegisterDevice* const found_device = find_device(segment.get_slave_addr());
+            if (!found_device)
+    return SC_ERROR_INFO(sc::ErrorCode::no_response, "I2C device did not respond");  // I2Cのデバイスが応答しませんでした
+            RegisterDevice& device = *found_device;
+            if (segment.is_read())
+            {
+                if (segment.has_memory_addr())
+                {
+                    const uint8_t memory_addr_num = segment.get_memory_addr();
+                    start(device);
+                    device.i2c_write(sc::Span<const uint8_t>(&memory_addr_num, 1));
+                    advance_bytes(1);
+                }
+                start(device);
+                device.i2c_read(input_data.subspan(input_size, segment.size()));
+                advance_bytes(segment.size());
+                input_size += segment.size();
+            } else {
+                uint8_t output_data[256];  // メモリアドレスとデータを1回で送る
+                if (sizeof(output_data) - 1 < segment.size())
+                {
+    return SC_ERROR_INFO(sc::ErrorCode::buffer_too_small, "Too much data for the register device");  // センサのメモリより大きいデータです
+                }
+                std::size_t output_size = 0;
+                if (segment.has_memory_addr())
+                {
+                    output_data[output_size++] = segment.get_memory_addr();
+                }
+                for (uint8_t value : segment.get_output_data())
+                {
+                    output_data[output_size++] = value;
+                }
+                start(device);
+                device.i2c_write(sc::Span<const uint8_t>(output_data, output_size));
+                advance_bytes(output_size);
+            }
+            if (!no_stop)
+            {
+                ++_stop_count;
+                Clock::advance_ns(1000000000ull / _freq);  // STOP(1ビット)
+            }
+        }
+        return sc::Result<void>();
+    }
+
+    //! @brief STARTとリピーテッドスタートの回数を取得
+    std::size_t I2C::get_start_count() const noexcept
+    {
+        return _start_count;
+    }
+
+    //! @brief STOPの回数を取得
+    std::size_t I2C::get_stop_count() const noexcept
+    {
+        return _stop_count;
+    }
+
+    /***** class SPI *****/
+
+    RegisterDevice* SPI::devices[2][MaxCsGpio + 1] = {};
+
+    //! @brief SPIのセットアップ
+    //! @param spi_pin SPIで使用するピン
+    //! @param freq 周波数 (/s)  通信にかかる時間の計算に使う
+    SPI::SPI(Pin spi_pin, uint32_t freq):
+        _spi_id(spi_pin.get_spi_id()),
+        _freq(freq)
+    {
+        if (!_freq)
+        {
+            sc::raise(SC_ERROR_INFO(sc::ErrorCode::invalid_argument, "Invalid frequency entered"));  // 無効な周波数が入力されました
+        }
+    }
+
+    //! @brief このSPIのCSピンにセンサをつなぐ
+    //! @param cs_pin センサのCSピン
+    //! @param device つなぐセンサ
+    void SPI::connect(CS_Pin cs_pin, RegisterDevice& device) const
+    {
+        connect(_spi_id, cs_pin, device);
+    }
+
+    //! @brief SPIのCSピンにセンサをつなぐ  (SPIを作る前につなぐ場合)
+    //! @param spi_id SPI0かSPI1か
+    //! @param cs_pin センサのCSピン
+    //! @param device つなぐセンサ
+    void SPI::connect(bool spi_id, CS_Pin cs_pin, RegisterDevice& device)
+    {
+        devices[spi_id][cs_pin.get()] = &device;
+    }
+
+    //! @brief CSピンにつながるセンサと1バイト送受信し，記録する
+    //! @return 受信したバイト  センサがつながっていなければ0xff
+    uint8_t SPI::exchange(uint8_t cs_gpio, uint8_t mosi) const
+    {
+        RegisterDevice* const device = devices[_spi_id][cs_gpio];
+        const uint8_t miso = (device ? device->spi_transfer(mosi) : 0xff);
+        _events.push_back(Event{Event::Type::transfer, cs_gpio, mosi, miso});
+        Clock::advance_ns(8 * 1000000000ull / _freq);
+        return miso;
+    }
+
+    //! @brief 擬似的なDMAで転送を進める
+    //! @param byte_num 進めるバイト数  (メモリアドレスの送信は含まない)
+    void SPI::run_dma(std::size_t byte_num) const
+    {
+        while (!_jobs.empty())
+        {
+            Job& job = _jobs.front();
+            if (!job.is_selected)  // picoと同じく，CSをLowにしてメモリアドレスを送ってからDMAを開始する
+            {
+                job.is_selected = true;
+                _events.push_back(Event{Event::Type::select, job.cs_gpio, 0, 0});
+                if (RegisterDevice* const device = devices[_spi_id][job.cs_gpio])
+                {
+                    device->spi_select();
+                    Clock::advance_ns(device->get_latency_ns());
+                }
+                if (0 <= job.memory_addr_num)
+                {
+                    exchange(job.cs_gpio, static_cast<uint8_t>(job.memory_addr_num));
+                }
+            }
+            if (job.transferred == job.size)
+            {
+                _events.push_back(Event{Event::Type::deselect, job.cs_gpio, 0, 0});  // 転送が終わったら自動でCSをHighにする
+                _completed_sequence = job.sequence;
+                _jobs.pop_front();
+        continue;
+            }
+            if (!byte_num)
+    return;
+            const uint8_t miso = exchange(job.cs_gpio, (job.output_data ? job.output_data[job.transferred] : 0));
+            if (job.input_data)
+            {
+                job.input_data[job.transferred] = miso;
+            }
+            ++job.transferred;
+            --byte_num;
+        }
+    }
+
+    //! @brief SPIの線上で起きたことの記録を取得
+    const std::vector<SPI::Event>& SPI::get_events() const noexcept
+    {
+        return _events;
+    }
+
+    //! @brief SPIの線上で起きたことの記録を消去
+    void SPI::clear_events() noexcept
+    {
+        _events.clear();
+    }
+
+    //! @brief 転送を開始する  実際の転送はrun_dma()で進む
+    sc::SPI::Transfer SPI::start_transfer(const uint8_t* output_data, uint8_t* input_data, std::size_t size, CS_Pin cs_pin, int memory_addr_num) const
+    {
+        const uint32_t sequence = ++_started_sequence;
+        _jobs.push_back(Job{sequence, cs_pin.get(), output_data, input_data, size, memory_addr_num, 0, false});
+        return Transfer(*this, sequence);
+    }
+
+    sc::SPI::Transfer SPI::read_async(sc::Span<uint8_t> input_data, CS_Pin cs_pin) const
+    {
+        return start_transfer(nullptr, input_data.data(), input_data.size(), cs_pin, -1);
+    }
+
+    sc::SPI::Transfer SPI::read_mem_async(sc::Span<uint8_t> input_data, CS_Pin cs_pin, MemoryAddr memory_addr) const
+    {
+        return start_transfer(nullptr, input_data.data(), input_data.size(), cs_pin, memory_addr.get_1());
+    }
+
+    sc::SPI::Transfer SPI::write_async(sc::Span<const uint8_t> output_data, CS_Pin cs_pin) const
+    {
+        return start_transfer(output_data.data(), nullptr, output_data.size(), cs_pin, -1);
+    }
+
+    sc::SPI::Transfer SPI::write_mem_async(sc::Span<const uint8_t> output_data, CS_Pin cs_pin, MemoryAddr memory_addr) const
+    {
+        return start_transfer(output_data.data(), nullptr, output_data.size(), cs_pin, memory_addr.get_0());
+    }
+
+    //! @brief 通し番号 sequence の転送が終わったかを確認
+    bool SPI::is_transfer_done(uint32_t sequence) const
+    {
+        return 0 <= static_cast<int32_t>(_completed_sequence - sequence);
+    }
+
+    //! @brief 通し番号 sequence の転送が終わるまで擬似的なDMAを進める
+    void SPI::wait_transfer(uint32_t sequence) const
+    {
+        while (!is_transfer_done(sequence))
+        {
+            run_dma(1);
+        }
+    }
+
+    /***** class UART *****/
+
+    UART::RxBuffer UART::input_data[2];
+    std::vector<uint8_t> UART::output_data[2];
+
+    //! @brief UARTのセットアップ
+    //! @param uart_pin UARTで使用するピン
+    //! @param freq 周波数 (/s)  通信にかかる時間の計算に使う
+    UART::UART(Pin uart_pin, uint32_t freq):
+        _uart_id(uart_pin.get_uart_id()),
+        _freq(freq)
+    {
+        if (!_freq)
+        {
+            sc::raise(SC_ERROR_INFO(sc::ErrorCode::invalid_argument, "Invalid frequency entered"));  // 無効な周波数が入力されました
+        }
+    }
+
+    //! @brief UARTによる受信
+    //! @return Binary型のバイト列
+    //! 受信していたデータを全てまとめて返す
+    sc::Binary UART::read() const
+    {
+        return read(input_data[_uart_id].size());
+    }
+
+    //! @brief UARTによる受信
+    //! @param size 受信するバイト数
+    //! @return Binary型のバイト列
+    //! 受信していたデータを古い順に size バイト分返す
+    sc::Binary UART::read(std::size_t size) const
+    {
+        if (input_data[_uart_id].size() < size)
+        {
+            sc::raise(SC_ERROR_INFO(sc::ErrorCode::not_found, "Not enough data has been received"));  // 十分なデータを受信していません
+        }
+        sc::Binary read_data(size);  // InlineCapacity以下ならヒープを使用しない
+        input_data[_uart_id].read_into(sc::Span<uint8_t>(read_data.writable_data(), size));
+        return read_data;
+    }
+
+    //! @brief UARTによる受信
+    //! @param input_data 受信したデータの保存先  この大きさまで受信します
+    //! @return 受信したバイト数
+    std::size_t UART::read_into(sc::Span<uint8_t> read_data) const
+    {
+        return input_data[_uart_id].read_into(read_data);
+    }
+
+    //! @brief UARTによる送信
+    //! @param output_data 送信するデータ
+    void UART::write(const sc::Binary& write_data) const
+    {
+        output_data[_uart_id].insert(output_data[_uart_id].end(), write_data.get_view().begin(), write_data.get_view().end());
+        advance_bytes(write_data.size());
+    }
+
+    //! @brief 接続先からデータが届いたことにする
+    //! @param received_data 届いたデータ  受信にかかる時間だけ時刻が進む
+    void UART::receive(sc::Span<const uint8_t> received_data) const
+    {
+        for (uint8_t received_byte : received_data)
+        {
+            input_data[_uart_id].push(received_byte);
+        }
+        advance_bytes(received_data.size());
+    }
+
+    //! @brief 送信したデータを取得
+    const std::vector<uint8_t>& UART::get_output_data() const noexcept
+    {
+        return output_data[_uart_id];
+    }
+
+    //! @brief 送信したデータの記録を消去
+    void UART::clear_output_data() const noexcept
+    {
+        output_data[_uart_id].clear();
+    }
+
+    //! @brief データの送受信にかかる時間だけ時刻を進める
+    void UART::advance_bytes(std::size_t byte_num) const
+    {
+        Clock::advance_ns(10 * byte_num * 1000000000ull / _freq);  // 1バイトはスタートビットとストップビットを含めて10ビット
+    }
+
+    /***** class PWM *****/
+
+    //! @brief PWMのセットアップ
+    //! @param pin_gpio ピンのGPIO番号
+    //! @param freq 周波数 (/s)
+    PWM::PWM(uint8_t pin_gpio, uint32_t freq) noexcept:
+        _pin_gpio(pin_gpio),
+        _freq(freq) {}
+
+    //! @brief 周波数を設定
+    //! @param freq 周波数 (/s)
+    void PWM::set_freq(uint32_t freq)
+    {
+        _freq = freq;
+    }
+
+    //! @brief 出力レベルを設定
+    //! @param output_level 出力レベル  0.0以上1.0以下の小数
+    void PWM::set_level(float output_level)
+    {
+        if (output_level < 0.0f || 1.0f < output_level)
+        {
+            sc::raise(SC_ERROR_INFO(sc::ErrorCode::invalid_argument, "Invalid output level entered"));  // 無効な出力レベルが入力されました
+        }
+        _level = output_level;
+    }
+
+    //! @brief 周波数を取得
+    uint32_t PWM::get_freq() const noexcept
+    {
+        return _freq;
+    }
+
+    //! @brief 出力レベルを取得
+    float PWM::get_level() const noexcept
+    {
+        return _level;
+    }
+
+    /***** class SD *****/
+
+    //! @brief ディスクイメージのファイルを開く
+    //! @param image_path ディスクイメージのファイル  ブロックの数はファイルの大きさから決める
+    SD::SD(const std::string& image_path):
+        _image(std::fopen(image_path.c_str(), "r+b")),
+        _block_num(0)
+    {
+        if (!_image)
+        {
+            sc::raise(SC_ERROR_INFO(sc::ErrorCode::not_found, "Cannot open SD card image"));  // イメージのファイルがない
+        }
+        std::fseek(_image, 0, SEEK_END);
+        _block_num = static_cast<uint32_t>(std::ftell(_image) / static_cast<long>(BlockSize));
+    }
+
+    SD::~SD()
+    {
+        std::fclose(_image);
+    }
+
+    //! @brief 連続したブロックを読む
+    //! @param block 最初のブロックの番号
+    //! @param input_data 読んだデータの保存先  BlockSizeの倍数のバイト数
+    //! @return 範囲外のとき，読めなかったときはエラー
+    sc::Result<void> SD::read_blocks(uint32_t block, sc::Span<uint8_t> input_data) const
+    {
+        const sc::Result<void> result = check_range(block, input_data.size());
+        if (!result)
+    return result;
+        if (std::fseek(_image, static_cast<long>(block) * static_cast<long>(BlockSize), SEEK_SET) != 0
+            || std::fread(input_data.data(), 1, input_data.size(), _image) != input_data.size())
+    return SC_ERROR_INFO(sc::ErrorCode::no_response, "Cannot read SD card image");  // ファイルを読めなかった
+        return {};
+    }
+
+    //! @brief 連続したブロックに書く  SDカードのコマンドと同じく，1回で全てのブロックを書く
+    //! @param block 最初のブロックの番号
+    //! @param output_data 書くデータ  BlockSizeの倍数のバイト数
+    //! @return 範囲外のとき，書けなかったときはエラー
+    sc::Result<void> SD::write_blocks(uint32_t block, sc::Span<const uint8_t> output_data) const
+    {
+        const sc::Result<void> result = check_range(block, output_data.size());
+        if (!result)
+    return result;
+        if (++_write_count == _fail_write_count)
+    return SC_ERROR_INFO(sc::ErrorCode::no_response, "SD card write failed (simulated)");  // 書き込みの失敗のシミュレーション
+        if (std::fseek(_image, static_cast<long>(block) * static_cast<long>(BlockSize), SEEK_SET) != 0
+            || std::fwrite(output_data.data(), 1, output_data.size(), _image) != output_data.size())
+    return SC_ERROR_INFO(sc::ErrorCode::no_response, "Cannot write SD card image");  // ファイルに書けなかった
+        return {};
+    }
+
+    uint32_t SD::get_block_num() const noexcept
+    {
+        return _block_num;
+    }
+
+    //! @brief write_blocks()を呼んだ回数  (picoではSDカードへの書き込みのコマンドの数)
+    uint32_t SD::get_write_count() const noexcept
+    {
+        return _write_count;
+    }
+
+    //! @brief write_blocks()を1回だけ失敗させる  (書き直しを確認するためのもの)
+    //! @param write_count 失敗させるwrite_blocks()の回数目  get_write_count()と同じ数え方  0のときは失敗させない
+    void SD::fail_write_at(uint32_t write_count) noexcept
+    {
+        _fail_write_count = write_count;
+    }
+
+    //! @brief 読み書きするブロックがイメージの中にあるかを確認
+    sc::Result<void> SD::check_range(uint32_t block, std::size_t size) const noexcept
+    {
+        if (!size || size % BlockSize)
+    return SC_ERROR_INFO(sc::ErrorCode::invalid_argument, "SD data size must be a multiple of BlockSize");  // ブロック単位でしか読み書きできない
+        if (_block_num < block || _block_num - block < size / BlockSize)
+    return SC_ERROR_INFO(sc::ErrorCode::invalid_argument, "SD block is out of range");  // イメージの外
+        return {};
+    }
+
+    //! @brief FAT32でフォーマットした空のディスクイメージを作る  (パーティションテーブルなし)
+    //! 1ブロック目からFAT32の領域で，ルートディレクトリはクラスタ2です．既にあるファイルは上書きします．
+    //! @param image_path 作るファイル
+    //! @param block_num ブロックの数  FAT32になるように，65525個以上のクラスタが必要です  (32MiB程度以上)
+    void SD::make_fat32_image(const std::string& image_path, uint32_t block_num)
+    {
+        constexpr uint16_t ReservedBlockNum = 32;  // 予約領域のブロック数
+        constexpr uint8_t FatNum = 2;  // FATの数
+        const uint8_t cluster_size = (block_num <= (1U << 20)) ? 1 : 8;  // 512MiBまでは1ブロック，それより大きいときは4KiB
+        const uint32_t fat_divisor = (256U * cluster_size + FatNum) / 2;  // FATの大きさの計算  (Microsoftの仕様書の式)
+        const uint32_t fat_size = (block_num - ReservedBlockNum + fat_divisor - 1) / fat_divisor;
+        const uint32_t data_block = ReservedBlockNum + FatNum * fat_size;
+        if (block_num <= data_block || (block_num - data_block) / cluster_size < 65525)
+        {
+            sc::raise(SC_ERROR_INFO(sc::ErrorCode::invalid_argument, "SD card image is too small for FAT32"));  // クラスタが少ないとFAT16になる
+        }
+        const uint32_t cluster_num = (block_num - data_block) / cluster_size;
+
+        auto store = [](uint8_t* data, uint32_t value, std::size_t size)
+        {
+            for (std::size_t i = 0; i < size; ++i) data[i] = static_cast<uint8_t>(value >> (8 * i));
+        };
+        uint8_t boot[BlockSize] = {0xEB, 0x58, 0x90, 'S', 'C', '1', '9', ' ', ' ', ' ', ' '};  // ジャンプ命令とOEM名
+        store(&boot[11], BlockSize, 2);
+        boot[13] = cluster_size;
+        store(&boot[14], ReservedBlockNum, 2);
+        boot[16] = FatNum;
+        boot[21] = 0xF8;  // メディアの種類  (固定ディスク)
+        store(&boot[24], 63, 2);  // 1トラックのセクタ数
+        store(&boot[26], 255, 2);  // ヘッドの数
+        store(&boot[32], block_num, 4);
+        store(&boot[36], fat_size, 4);
+        store(&boot[44], 2, 4);  // ルートディレクトリのクラスタ
+        store(&boot[48], 1, 2);  // FSInfoのブロック
+        store(&boot[50], 6, 2);  // ブートセクタのバックアップのブロック
+        boot[64] = 0x80;  // ドライブ番号
+        boot[66] = 0x29;  // 拡張ブートシグネチャ
+        store(&boot[67], 0x20261016, 4);  // ボリュームのシリアル番号
+        std::memcpy(&boot[71], "NO NAME    FAT32   ", 19);  // ボリュームラベルとファイルシステムの種類
+        store(&boot[510], 0xAA55, 2);
+
+        uint8_t fs_info[BlockSize] = {};
+        store(&fs_info[0], 0x41615252, 4);
+        store(&fs_info[484], 0x61417272, 4);
+        store(&fs_info[488], cluster_num - 1, 4);  // 空きクラスタの数  (ルートディレクトリの分を除く)
+        store(&fs_info[492], 3, 4);  // 次の空きクラスタ
+        store(&fs_info[508], 0xAA550000, 4);
+
+        uint8_t fat[BlockSize] = {};
+        store(&fat[0], 0x0FFFFFF8, 4);  // クラスタ0はメディアの種類
+        store(&fat[4], 0x0FFFFFFF, 4);  // クラスタ1は予約
+        store(&fat[8], 0x0FFFFFFF, 4);  // ルートディレクトリは1クラスタ
+
+        std::FILE* const image = std::fopen(image_path.c_str(), "wb");
+        if (!image)
+        {
+            sc::raise(SC_ERROR_INFO(sc::ErrorCode::read_only, "Cannot create SD card image"));  // ファイルを作れなかった
+        }
+        const uint8_t zero_block[BlockSize] = {};
+        const std::pair<uint32_t, const uint8_t*> blocks[] = {
+            {0, boot}, {1, fs_info}, {6, boot}, {7, fs_info},
+            {ReservedBlockNum, fat}, {ReservedBlockNum + fat_size, fat},
+            {block_num - 1, zero_block}};  // 最後のブロックまで書いて，ファイルの大きさを決める  (他は0のまま)
+        bool is_written = true;
+        for (const std::pair<uint32_t, const uint8_t*>& block : blocks)
+        {
+            is_written &= (std::fseek(image, static_cast<long>(block.first) * static_cast<long>(BlockSize), SEEK_SET) == 0
+                && std::fwrite(block.second, 1, BlockSize, image) == BlockSize);
+        }
+        is_written &= (std::fclose(image) == 0);
+        if (!is_written)
+        {
+            sc::raise(SC_ERROR_INFO(sc::ErrorCode::read_only, "Cannot write SD card image"));  // ファイルに書けなかった
+        }
+    }
+}
@@ -12,18 +12,35 @@
 *************************************
 *************************************/
 
-#include <set>
-#include <deque>
+#ifdef SC_HOST  // PC上でシミュレーションする場合は，picoの代わりにhostの実装を使います
+#include "sc_host.hpp"
+
+namespace pico = host;
+inline void stdio_init_all() {}  // pico-SDKの関数の代わり  PC上では何もしない
+#else
+
 #include <algorithm>
 
+#include "hardware/clocks.h"
+#include "hardware/dma.h"
 #include "hardware/gpio.h"
 #include "hardware/i2c.h"
+#include "hardware/irq.h"
+#include "hardware/pio.h"
 #include "hardware/pwm.h"
 #include "hardware/spi.h"
+#include "hardware/sync.h"
 #include "hardware/uart.h"
+#include "pico/multicore.h"
 #include "pico/stdlib.h"
 
 #include "sc.hpp"
+#include "sc_rp2040.hpp"
+
+// UARTの受信用バッファのバイト数 (2のべき乗)  コンパイル時に -DSC_PICO_UART_RX_BUFFER_SIZE=1024 のようにして変更できます
+#ifndef SC_PICO_UART_RX_BUFFER_SIZE
+#define SC_PICO_UART_RX_BUFFER_SIZE 256
+#endif
 
 //! @file sc_pico.hpp
 //! @brief picoに関するプログラム
@@ -32,8 +49,44 @@
 
 namespace pico
 {
+    void start_log_drain();
+    void launch_core1(bool (*step)(void*), void* context);
+
+    //! @brief 現在時刻を取得
+    //! @return 起動からの時間 (μs)
+    inline uint64_t get_time_us() noexcept
+    {
+        return time_us_64();  // pico-SDKの関数  起動からの時間(μs)を取得する
+    }
+
+    //! @brief コア1でパイプラインの処理とログの出力を始める
+    //! コア0はpipeline.push()で測定値を入れるだけになります．start_log_drain()とは一緒に使えません．(どちらもコア1を使うため)
+    //! @param pipeline sc::make_pipeline()で作ったパイプライン  プログラムの終了まで残るようにしてください
+    template<class Pipeline>
+    void start_pipeline(Pipeline& pipeline)
+    {
+        launch_core1([](void* context) {return static_cast<Pipeline*>(context)->process(get_time_us);}, &pipeline);
+    }
+
+    //! @brief スケジューラを動かし続ける
+    //! 次のタスクの時刻まではハードウェアのアラームで待ち，時刻が来たらタスクを実行します
+    //! @param scheduler タスクを登録したsc::Scheduler
+    template<class Scheduler>
+    [[noreturn]] void run_scheduler(Scheduler& scheduler)
+    {
+        while (true)
+        {
+            const uint64_t deadline_us = scheduler.get_next_deadline_us();
+            if (get_time_us() < deadline_us)
+            {
+                sleep_until(from_us_since_boot(deadline_us));  // pico-SDKの関数  ハードウェアのアラームで起こされるまで眠る
+            }
+            scheduler.run_pending(get_time_us);
+        }
+    }
+
     //! @brief picoの汎用入出力
-    class PinIO : public sc::PinIO
+    class PinIO final : public sc::PinIO
     {
         const uint8_t _pin_gpio;  // ピンのGPIO番号
     public:
@@ -46,111 +99,292 @@ namespace pico
         void set_pull(Pull pull) const;
     };
 
+    //! @brief picoの複数のピンの入出力  SIOのセット・クリア・反転のレジスタで，まとめて1回で読み書きする
+    //! 例：PinGroup leds(rp2040::gpio_mask({6, 7, 8, 9}), PinGroup::Direction::out);
+    class PinGroup final : public sc::PinGroup
+    {
+        const uint32_t _mask;  // グループに含まれるピンのGPIO番号のビット
+    public:
+        PinGroup(uint32_t mask, Direction direction, Pull pull = Pull::no_use);
+        uint32_t read() const override {return gpio_get_all() & _mask;}  // pico-SDKの関数  全てのピンのレベルを1回で読む
+        void write(uint32_t levels) const override {gpio_put_masked(_mask, levels);}  // pico-SDKの関数  グループのピンだけを1回で書き換える
+        void set(uint32_t mask) const override {sio_hw->gpio_set = mask & _mask;}
+        void clear(uint32_t mask) const override {sio_hw->gpio_clr = mask & _mask;}
+        void toggle(uint32_t mask) const override {sio_hw->gpio_togl = mask & _mask;}
+        uint32_t get_mask() const noexcept {return _mask;}
+    };
+
+    //! @brief picoのピンのエッジを割り込みで記録する
+    //! 割り込み処理では時刻と向きをリングバッファに入れるだけなので，HC-SR04のエコーのようなパルスの幅も測れます．
+    //! 1つのピンにつき1つのPinEdgeIRQのみ作れます．
+    class PinEdgeIRQ final : public sc::PinEdgeIRQ
+    {
+        const uint32_t _mask;  // 記録するピンのGPIO番号のビット
+        sc::RingBuffer<Event, SC_PIN_EDGE_BUFFER_SIZE> _events;  // 割り込み処理で記録したエッジ
+        static PinEdgeIRQ* edge_irqs[rp2040::MaxGpio + 1];  // ピンごとの記録先
+    public:
+        PinEdgeIRQ(uint32_t mask, Edge edge, PinIO::Pull pull = PinIO::Pull::no_use);
+        ~PinEdgeIRQ();
+        bool pop(Event& event) override;
+        std::size_t get_overflow_count() const noexcept override;
+    private:
+        static void irq_handler(uint gpio, uint32_t events);
+    };
+
+    //! @brief picoのPIOで，トリガーのパルスを出してエコーのパルスの幅を測る
+    //! 測定はPIOのステートマシンだけで繰り返し行い，パルスの幅(μs)をRX FIFO(4個)に入れます．CPUはFIFOから取り出すだけです．
+    //! 1回の測定は，トリガー(10μs)・エコー(最大でタイムアウトまで)・待機(最短の周期からトリガーを除いた時間)の順に行うため，周期は最短の周期以上になります．
+    class PulseCapture final : public sc::PulseCapture
+    {
+        const uint32_t _timeout_us;  // エコーを待つ最大の時間 (μs)
+        const PIO _pio;  // 使用するPIO
+        const uint _sm;  // 使用するステートマシンの番号
+        uint _program_offset;  // PIOの命令メモリ内でのプログラムの位置
+    public:
+        PulseCapture(uint8_t trigger_gpio, uint8_t echo_gpio, uint32_t timeout_us = 30000, uint32_t min_cycle_us = 60000);
+        ~PulseCapture();
+        bool pop(uint32_t& width_us) override;
+        void wait() override;
+    };
+
     //! @brief picoのI2C通信
-    class I2C : public sc::I2C
+    //! finalなので，型がpico::I2Cだとわかっている呼び出し(sc::Exam001<pico::I2C>など)は仮想関数を通さずに行われます．
+    class I2C final : public sc::I2C
     {
     public:
         //! @brief I2C通信で使用するピンの番号
+        //! constexprで作るか，Pin::of<SDA, SCL>()で作ると，使用できないピンはコンパイルエラーになります．
         class Pin
         {
             const uint8_t _sda_gpio;  // SDAピンのGPIO番号
             const uint8_t _scl_gpio;  // SCLピンのGPIO番号
+            const bool _i2c_id;  // I2C0かI2C1か
         public:
-            Pin(uint8_t sda_gpio, uint8_t scl_gpio);
-            uint8_t get_sda_gpio() const;
-            uint8_t get_scl_gpio() const;
-            bool get_i2c_id() const;
+            //! @brief I2C通信で使うピン番号をセットアップ
+            //! @param sda_gpio SDAピンのGPIO番号
+            //! @param scl_gpio SCLピンのGPIO番号
+            constexpr Pin(uint8_t sda_gpio, uint8_t scl_gpio):
+                _sda_gpio(sda_gpio),
+                _scl_gpio(scl_gpio),
+                _i2c_id(check_id(rp2040::find_i2c_id(sda_gpio, scl_gpio))) {}
+
+            //! @brief コンパイル時に確認してピン番号をセットアップ
+            template<uint8_t SdaGpio, uint8_t SclGpio>
+            static constexpr Pin of() noexcept
+            {
+                static_assert(rp2040::find_i2c_id(SdaGpio, SclGpio) >= 0, "\n\n<!ERROR!> Invalid i2c gpio number entered\n\n");  // 無効なI2CのGPIO番号が入力されました
+                return Pin(SdaGpio, SclGpio);
+            }
+
+            constexpr uint8_t get_sda_gpio() const noexcept {return _sda_gpio;}
+            constexpr uint8_t get_scl_gpio() const noexcept {return _scl_gpio;}
+            constexpr bool get_i2c_id() const noexcept {return _i2c_id;}
+        private:
+            //! @brief Raspberry Pi PicoでI2C用として使用できないピンの場合はエラー  (定数式ではコンパイルエラー)
+            static constexpr bool check_id(int i2c_id)
+            {
+                return (0 <= i2c_id ? i2c_id == 1 : (sc::raise(SC_ERROR_INFO(sc::ErrorCode::invalid_argument, "Invalid i2c gpio number entered")), false));  // 無効なI2CのGPIO番号が入力されました
+            }
         };
     private:
-        const bool _i2c_id;  // I2C0かI2C1か
+        i2c_inst_t* const _i2c;  // 使用するI2C  (i2c0かi2c1)
         const Pin _i2c_pin;  // I2Cで使用しているピン
         const uint32_t _freq;  // 周波数 (/s)
     public:
         I2C(Pin i2c_pin, uint32_t freq);
-        sc::Binary read(std::size_t size, SlaveAddr slave_addr) const override;
-        sc::Binary read_mem(std::size_t size, SlaveAddr slave_addr, MemoryAddr memory_addr) const override;
-        void write(sc::Binary output_data, SlaveAddr slave_addr) const override;
-        void write_mem(sc::Binary output_data, SlaveAddr slave_addr, MemoryAddr memory_addr) const override;
+        sc::Result<void> try_transfer_into(sc::Span<const Segment> segments, sc::Span<uint8_t> input_data) const override;
     private:
         void init_i2c();
         void set_i2c_pin();
     };
 
     //! @brief picoのSPI通信
-    class SPI : public sc::SPI
+    class SPI final : public sc::SPI
     {
     public:
+        //! @brief SPI通信で使用するピンの番号
+        //! constexprで作るか，Pin::of<MISO, MOSI, SCK, CS...>()で作ると，使用できないピンはコンパイルエラーになります．
         class Pin
         {
-            const uint8_t _miso_gpio;
-            const uint8_t _mosi_gpio;
-            const uint8_t _sck_gpio;
-            const std::vector<uint8_t> _cs_gpios;
-            static constexpr uint8_t MinPinGpio = 0;
-            static constexpr uint8_t MaxPinGpio = 28;
+            const uint8_t _miso_gpio;  // MISO(RX)ピンのGPIO番号
+            const uint8_t _mosi_gpio;  // MOSI(TX)ピンのGPIO番号
+            const uint8_t _sck_gpio;  // SCKピンのGPIO番号
+            const uint32_t _cs_gpio_mask;  // CSピンのGPIO番号のビット  (ヒープを使わないようにビットで保存する)
+            const bool _spi_id;  // SPI0かSPI1か
         public:
-            Pin(uint8_t miso_gpio, uint8_t mosi_gpio, uint8_t sck_gpio, std::initializer_list<uint8_t> cs_gpios);
-            uint8_t get_miso_gpio() const;
-            uint8_t get_mosi_gpio() const;
-            uint8_t get_sck_gpio() const;
-            std::vector<uint8_t> get_cs_gpios() const;
-            bool get_spi_id() const;
+            //! @brief SPI通信で使うピン番号をセットアップ
+            //! @param miso_gpio MISO(RX)ピンのGPIO番号  注:接続先デバイスのTX
+            //! @param mosi_gpio MOSI(TX)ピンのGPIO番号  注:接続先デバイスのRX
+            //! @param sck_gpio SCKピンのGPIO番号
+            //! @param cs_gpios CSピンのGPIO番号  { }で囲んで複数入力
+            constexpr Pin(uint8_t miso_gpio, uint8_t mosi_gpio, uint8_t sck_gpio, std::initializer_list<uint8_t> cs_gpios):
+                _miso_gpio(miso_gpio),
+                _mosi_gpio(mosi_gpio),
+                _sck_gpio(sck_gpio),
+                _cs_gpio_mask(rp2040::gpio_mask(cs_gpios)),
+                _spi_id(check_id(rp2040::find_spi_id(miso_gpio, mosi_gpio, sck_gpio), cs_gpios)) {}
+
+            //! @brief コンパイル時に確認してピン番号をセットアップ
+            template<uint8_t MisoGpio, uint8_t MosiGpio, uint8_t SckGpio, uint8_t... CsGpios>
+            static constexpr Pin of() noexcept
+            {
+                static_assert(rp2040::find_spi_id(MisoGpio, MosiGpio, SckGpio) >= 0 && ((CsGpios <= rp2040::MaxGpio) && ...), "\n\n<!ERROR!> Invalid spi gpio number entered\n\n");  // 無効なSPIのGPIO番号が入力されました
+                return Pin(MisoGpio, MosiGpio, SckGpio, {CsGpios...});
+            }
+
+            constexpr uint8_t get_miso_gpio() const noexcept {return _miso_gpio;}
+            constexpr uint8_t get_mosi_gpio() const noexcept {return _mosi_gpio;}
+            constexpr uint8_t get_sck_gpio() const noexcept {return _sck_gpio;}
+            constexpr uint32_t get_cs_gpio_mask() const noexcept {return _cs_gpio_mask;}
+            constexpr bool get_spi_id() const noexcept {return _spi_id;}
+        private:
+            //! @brief Raspberry Pi PicoでSPI用として使用できないピンの場合はエラー  (定数式ではコンパイルエラー)
+            static constexpr bool check_id(int spi_id, std::initializer_list<uint8_t> cs_gpios)
+            {
+                for (uint8_t cs_gpio : cs_gpios)
+                {
+                    if (rp2040::MaxGpio < cs_gpio) spi_id = -1;
+                }
+                return (0 <= spi_id ? spi_id == 1 : (sc::raise(SC_ERROR_INFO(sc::ErrorCode::invalid_argument, "Invalid spi gpio number entered")), false));  // 無効なSPIのGPIO番号が入力されました
+            }
         };
     private:
-        const bool _spi_id;
+        //! @brief DMAによる転送の状態  割り込み処理からも使うためstaticにする
+        struct DmaState
+        {
+            int tx_channel = -1;  // 送信に使うDMAのチャンネル
+            int rx_channel = -1;  // 受信に使うDMAのチャンネル  このチャンネルの終了で転送の終了とする
+            uint8_t cs_gpio = 0;  // 転送中のCSピンのGPIO番号
+            volatile uint32_t started_sequence = 0;  // 最後に開始した転送の通し番号
+            volatile uint32_t completed_sequence = 0;  // 最後に終了した転送の通し番号
+        };
+
+        const bool _spi_id;  // SPI0かSPI1か
+        spi_inst_t* const _spi;  // 使用するSPI  (spi0かspi1)
         const Pin _spi_pin;
         const uint32_t _freq;
     public:
         SPI(Pin spi_pin, uint32_t freq);
-        sc::Binary read(std::size_t size, CS_Pin cs_pin) const override;
-        sc::Binary read_mem(std::size_t size, CS_Pin cs_pin, MemoryAddr memory_addr) const override;
-        void write(sc::Binary output_data, CS_Pin cs_pin) const override;
-        void write_mem(sc::Binary output_data, CS_Pin cs_pin, MemoryAddr memory_addr) const override;
+        Transfer read_async(sc::Span<uint8_t> input_data, CS_Pin cs_pin) const override;
+        Transfer read_mem_async(sc::Span<uint8_t> input_data, CS_Pin cs_pin, MemoryAddr memory_addr) const override;
+        Transfer write_async(sc::Span<const uint8_t> output_data, CS_Pin cs_pin) const override;
+        Transfer write_mem_async(sc::Span<const uint8_t> output_data, CS_Pin cs_pin, MemoryAddr memory_addr) const override;
+
+        // CSピンを選択したまま，複数回に分けて送受信するためのもの  (SDカードのように，コマンドの途中でCSピンを戻せないデバイス)
+        // select_cs()からdeselect_cs()までの間は，非同期の転送を始めないでください．
+        void select_cs(CS_Pin cs_pin) const;
+        void deselect_cs(CS_Pin cs_pin) const;
+        void write_blocking(sc::Span<const uint8_t> output_data) const;
+        void read_blocking(sc::Span<uint8_t> input_data, uint8_t fill_byte) const;
+        void set_freq(uint32_t freq) const;
+        uint32_t get_freq() const noexcept;
+    protected:
+        bool is_transfer_done(uint32_t sequence) const override;
+        void wait_transfer(uint32_t sequence) const override;
     private:
         void init_spi();
         void set_spi_pin();
-        void select_cs(CS_Pin cs_pin) const;
-        void deselect_cs(CS_Pin cs_pin) const;
+        void set_dma();
+        Transfer start_transfer(const uint8_t* output_data, uint8_t* input_data, std::size_t size, CS_Pin cs_pin, const uint8_t* memory_addr_num) const;
+        static DmaState dma_states[2];  // SPI0とSPI1の転送の状態
+        static void dma_handler();
     };
 
 
     //! @brief picoのUART通信
-    class UART : public sc::UART
+    class UART final : public sc::UART
     {
     public:
         //! @brief UART通信で使用するピンの番号
+        //! constexprで作るか，Pin::of<TX, RX>()で作ると，使用できないピンはコンパイルエラーになります．
         class Pin
         {
             const uint8_t _tx_gpio;  // TXピンのGPIO番号
             const uint8_t _rx_gpio;  // RXピンのGPIO番号
+            const bool _uart_id;  // UART0かUART1か
         public:
-            Pin(uint8_t tx_gpio, uint8_t rx_gpio);
-            uint8_t get_tx_gpio() const;
-            uint8_t get_rx_gpio() const;
-            bool get_uart_id() const;
+            //! @brief UART通信で使うピン番号をセットアップ
+            //! @param tx_gpio TXピンのGPIO番号
+            //! @param rx_gpio RXピンのGPIO番号
+            constexpr Pin(uint8_t tx_gpio, uint8_t rx_gpio):
+                _tx_gpio(tx_gpio),
+                _rx_gpio(rx_gpio),
+                _uart_id(check_id(rp2040::find_uart_id(tx_gpio, rx_gpio))) {}
+
+            //! @brief コンパイル時に確認してピン番号をセットアップ
+            template<uint8_t TxGpio, uint8_t RxGpio>
+            static constexpr Pin of() noexcept
+            {
+                static_assert(rp2040::find_uart_id(TxGpio, RxGpio) >= 0, "\n\n<!ERROR!> Invalid uart gpio number entered\n\n");  // 無効なUARTのGPIO番号が入力されました
+                return Pin(TxGpio, RxGpio);
+            }
+
+            constexpr uint8_t get_tx_gpio() const noexcept {return _tx_gpio;}
+            constexpr uint8_t get_rx_gpio() const noexcept {return _rx_gpio;}
+            constexpr bool get_uart_id() const noexcept {return _uart_id;}
+        private:
+            //! @brief Raspberry Pi PicoでUART用として使用できないピンの場合はエラー  (定数式ではコンパイルエラー)
+            static constexpr bool check_id(int uart_id)
+            {
+                return (0 <= uart_id ? uart_id == 1 : (sc::raise(SC_ERROR_INFO(sc::ErrorCode::invalid_argument, "Invalid uart gpio number entered")), false));  // 無効なUARTのGPIO番号が入力されました
+            }
+        };
+        //! @brief 受信の方法
+        enum class RxMode
+        {
+            interrupt,  // FIFOを使わず，1バイトごとの割り込み処理で受信する
+            dma  // FIFOを使い，DMAで循環バッファに受信する  (CPUをほとんど使わない)
         };
+
+        using RxBuffer = sc::RingBuffer<uint8_t, SC_PICO_UART_RX_BUFFER_SIZE>;  // 割り込み処理で受信したデータの保存先
+        using DmaRxBuffer = sc::DmaRingBuffer<SC_PICO_UART_RX_BUFFER_SIZE>;  // DMAで受信したデータの保存先
     private:
+        //! @brief DMAによる受信の状態  割り込み処理で転送をやり直すため，UART0とUART1でstaticに持つ
+        struct DmaRxState
+        {
+            int channel = -1;  // 受信に使うDMAのチャンネル
+            volatile uint32_t restarted_count = 0;  // 転送をやり直すまでに書き込んだバイト数の累計  (2^32で一周する)
+            volatile uint32_t restart_sequence = 0;  // 転送をやり直した回数  読み出しの途中でやり直したかを確認する
+        };
+        static constexpr uint32_t DmaRxTransferCount = 1U << 30;  // 1回の転送のバイト数  終わるたびに割り込み処理で転送をやり直す
+
         const bool _uart_id;  // UART0かUART1か
+        uart_inst_t* const _uart;  // 使用するUART  (uart0かuart1)
         const Pin _uart_pin;  // UARTで使用しているピン
         const uint32_t _freq;  // 周波数 (/s)
+        const RxMode _rx_mode;  // 受信の方法
     public:
-        UART(Pin uart_pin, uint32_t freq);
+        UART(Pin uart_pin, uint32_t freq, RxMode rx_mode = RxMode::interrupt);
         sc::Binary read() const override;
         sc::Binary read(std::size_t size) const override;
-        void write(sc::Binary output_data) const override;
+        std::size_t read_into(sc::Span<uint8_t> input_data) const override;
+        void write(const sc::Binary& output_data) const override;
+        std::size_t get_overflow_count() const noexcept;
+        void set_rx_frame(int delimiter, uint32_t idle_timeout_us);
+        bool is_frame_ready() const;
+        sc::Binary read_frame() const;
     private:
         void init_uart();
         void set_uart_pin();
         void set_irq();
+        void set_dma();
+        RxBuffer& get_input_data() const noexcept;
+        DmaRxBuffer& get_dma_input_data() const;
+        std::size_t available() const;
     public:
-        static std::deque<uint8_t> uart0_input_data;
-        static std::deque<uint8_t> uart1_input_data;
+        static RxBuffer uart0_input_data;
+        static RxBuffer uart1_input_data;
+        static DmaRxBuffer uart0_dma_input_data;
+        static DmaRxBuffer uart1_dma_input_data;
         static void uart0_handler();
         static void uart1_handler();
+    private:
+        static DmaRxState dma_rx_states[2];  // UART0とUART1のDMAによる受信の状態
+        static void dma_handler();
     };
 
     //! @brief picoのPWM
-    class PWM : public sc::PWM
+    class PWM final : public sc::PWM
     {
     public:
         PWM(uint8_t pin_gpio, uint32_t freq);  // 未実装
@@ -160,10 +394,31 @@ namespace pico
         void set_level(float output_level) override;  // 未実装
     };
 
-    class SD : sc::SD
+    //! @brief picoのSPIにつないだSDカード  (SPIモード)
+    //! 初期化は400kHzで行い，終わったらSPIの周波数に戻します．SPIの周波数は25MHz以下にしてください．
+    //! 連続した複数のブロックは，CMD18・CMD25の1つのコマンドでまとめて読み書きします．
+    class SD final : public sc::SD
     {
-        // 未実装
+        const SPI& _spi;  // 通信に使うSPI
+        const SPI::CS_Pin _cs_pin;  // SDカードにつながるCSピン
+        uint32_t _block_num = 0;  // ブロックの数
+        bool _is_block_address = false;  // ブロックの番号でアドレスを指定するか  (SDHC・SDXC)  falseのときはバイト単位 (SDSC)
+    public:
+        SD(const SPI& spi, SPI::CS_Pin cs_pin);
+        sc::Result<void> read_blocks(uint32_t block, sc::Span<uint8_t> input_data) const override;
+        sc::Result<void> write_blocks(uint32_t block, sc::Span<const uint8_t> output_data) const override;
+        uint32_t get_block_num() const noexcept override;
+    private:
+        sc::Result<void> init();
+        sc::Result<void> check_range(uint32_t block, std::size_t size) const noexcept;
+        void deselect() const;
+        uint8_t receive_byte() const;
+        bool wait_ready(uint64_t timeout_us) const;
+        uint8_t send_command(uint8_t command, uint32_t argument) const;
+        bool receive_data(sc::Span<uint8_t> input_data) const;
+        bool send_block(uint8_t token, const uint8_t* output_data) const;
     };
 }
 
+#endif  // SC_HOST
 #endif  // SC19_CODE_TEST_SC_SC_PICO_HPP_
\ No newline at end of file
@@ -0,0 +1,94 @@
+#ifndef SC19_CODE_TEST_SC_SC_RP2040_HPP_
+#define SC19_CODE_TEST_SC_SC_RP2040_HPP_
+
+/*************************************
+ *************************************
+
+
+このファイルは見なくてかまいません
+内部の実装を知りたい場合のみ見てください
+
+
+*************************************
+*************************************/
+
+#include <cstdint>
+#include <initializer_list>
+
+//! @file sc_rp2040.hpp
+//! @brief RP2040(pico)のピンの割り当て  picoとPC上のシミュレーションで共通
+//! @date 2026-10-16
+
+
+//! @brief RP2040のピンの割り当て
+//! 全てconstexprなので，定数式で使えばコンパイル時に，そうでなければ表を引くだけで確認できます．
+namespace rp2040
+{
+    constexpr uint8_t MaxGpio = 28;  // GPIOピンの最大の番号
+
+    //! @brief GPIO番号の集合をビットで表す
+    //! @param gpios GPIO番号  { }で囲んで複数入力
+    //! @return GPIO番号のビットを立てた値
+    constexpr uint32_t gpio_mask(std::initializer_list<uint8_t> gpios) noexcept
+    {
+        uint32_t mask = 0;
+        for (uint8_t gpio : gpios) mask |= (1UL << gpio);
+        return mask;
+    }
+
+    //! @brief GPIO番号がビットの集合に含まれるかを確認
+    constexpr bool contains(uint32_t mask, uint8_t gpio) noexcept
+    {
+        return gpio <= MaxGpio && ((mask >> gpio) & 1);
+    }
+
+    constexpr uint32_t I2C_SDA[2] = {gpio_mask({0, 4, 8, 12, 16, 20}), gpio_mask({2, 6, 10, 14, 18, 26})};  // I2C0とI2C1のSDAのピン番号が取りうる値
+    constexpr uint32_t I2C_SCL[2] = {gpio_mask({1, 5, 9, 13, 17, 21}), gpio_mask({3, 7, 11, 15, 19, 27})};  // I2C0とI2C1のSCLのピン番号が取りうる値
+    constexpr uint32_t SPI_MISO[2] = {gpio_mask({0, 4, 16}), gpio_mask({8, 12})};  // SPI0とSPI1のMISOのピン番号が取りうる値
+    constexpr uint32_t SPI_MOSI[2] = {gpio_mask({3, 7, 19}), gpio_mask({11, 15})};  // SPI0とSPI1のMOSIのピン番号が取りうる値
+    constexpr uint32_t SPI_SCK[2] = {gpio_mask({2, 6, 18}), gpio_mask({10, 14})};  // SPI0とSPI1のSCKのピン番号が取りうる値
+    constexpr uint32_t UART_TX[2] = {gpio_mask({0, 12, 16}), gpio_mask({4, 8})};  // UART0とUART1のTXのピン番号が取りうる値
+    constexpr uint32_t UART_RX[2] = {gpio_mask({1, 13, 17}), gpio_mask({5, 9})};  // UART0とUART1のRXのピン番号が取りうる値
+
+    //! @brief I2Cのピンの組み合わせから，I2C0かI2C1かを求める
+    //! @return 0か1  使用できない組み合わせなら-1
+    constexpr int find_i2c_id(uint8_t sda_gpio, uint8_t scl_gpio) noexcept
+    {
+        for (int id = 0; id < 2; ++id)
+        {
+            if (contains(I2C_SDA[id], sda_gpio) && contains(I2C_SCL[id], scl_gpio))
+    return id;
+        }
+        return -1;
+    }
+
+    //! @brief SPIのピンの組み合わせから，SPI0かSPI1かを求める
+    //! @return 0か1  使用できない組み合わせなら-1
+    constexpr int find_spi_id(uint8_t miso_gpio, uint8_t mosi_gpio, uint8_t sck_gpio) noexcept
+    {
+        for (int id = 0; id < 2; ++id)
+        {
+            if (contains(SPI_MISO[id], miso_gpio) && contains(SPI_MOSI[id], mosi_gpio) && contains(SPI_SCK[id], sck_gpio))
+    return id;
+        }
+        return -1;
+    }
+
+    //! @brief UARTのピンの組み合わせから，UART0かUART1かを求める
+    //! @return 0か1  使用できない組み合わせなら-1
+    constexpr int find_uart_id(uint8_t tx_gpio, uint8_t rx_gpio) noexcept
+    {
+        for (int id = 0; id < 2; ++id)
+        {
+            if (contains(UART_TX[id], tx_gpio) && contains(UART_RX[id], rx_gpio))
+    return id;
+        }
+        return -1;
+    }
+
+    static_assert(find_i2c_id(4, 5) == 0 && find_i2c_id(2, 3) == 1 && find_i2c_id(4, 3) == -1, "\n\n<!ERROR!> The I2C pin map is broken\n\n");  // I2Cのピンの割り当てが間違っています
+    static_assert(find_spi_id(16, 19, 18) == 0 && find_spi_id(12, 15, 14) == 1, "\n\n<!ERROR!> The SPI pin map is broken\n\n");  // SPIのピンの割り当てが間違っています
+    static_assert(find_uart_id(0, 1) == 0 && find_uart_id(4, 5) == 1, "\n\n<!ERROR!> The UART pin map is broken\n\n");  // UARTのピンの割り当てが間違っています
+}
+
+#endif  // SC19_CODE_TEST_SC_SC_RP2040_HPP_
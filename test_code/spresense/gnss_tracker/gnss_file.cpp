@@ -96,6 +96,85 @@ int WriteChar(const char* pBuff, const char* pName, int flag)
   return WriteBinary(pBuff, pName, write_size, flag);
 }
 
+/**
+ * @brief Open a file on SD card for appending.
+ *
+ * @param [in,out] pContext File object
+ * @param [in] pName File name
+ * @return File size. -1 if failure.
+ */
+static long SdOpen(void* pContext, const char* pName)
+{
+  File* pFile = (File*)pContext;
+
+  if (theSD.exists("/") == false) {
+    return -1;
+  }
+
+  *pFile = theSD.open(pName, (FILE_WRITE | O_APPEND));
+  if (*pFile == NULL)
+  {
+    /* if the file didn't open, print an error. */
+    APP_PRINT_E("Open ");
+    APP_PRINT_E(pName);
+    APP_PRINT_E(" Not found.\n");
+    return -1;
+  }
+
+  return (long)pFile->size();
+}
+
+/**
+ * @brief Write data to the opened file.
+ *
+ * @param [in,out] pContext File object
+ * @param [in] pBuff Data to be written
+ * @param [in] size Bytes to be written
+ * @return Bytes written
+ */
+static unsigned long SdWrite(void* pContext, const char* pBuff, unsigned long size)
+{
+  unsigned long write_result = ((File*)pContext)->write(pBuff, size);
+
+  if (write_result != size)
+  {
+    /* Write error. */
+    APP_PRINT_E("Append write error!!\n");
+  }
+
+  return write_result;
+}
+
+/**
+ * @brief Update the directory entry without closing the file.
+ *
+ * @param [in,out] pContext File object
+ * @return true
+ */
+static bool SdFlush(void* pContext)
+{
+  ((File*)pContext)->flush();
+
+  return true;
+}
+
+/**
+ * @brief Close the file.
+ *
+ * @param [in,out] pContext File object
+ */
+static void SdClose(void* pContext)
+{
+  ((File*)pContext)->close();
+}
+
+LogBackend GetSdLogBackend(File* pFile)
+{
+  LogBackend backend = { pFile, SdOpen, SdWrite, SdFlush, SdClose };
+
+  return backend;
+}
+
 int ReadChar(char* pBuff, int BufferSize, const char* pName, int flag)
 {
   int read_result = 0;
@@ -29,6 +29,8 @@
 /* include the SDHCI library */
 #include <SDHCI.h>
 
+#include "gnss_log.h"
+
 /**
  * @brief Mount SD card.
  * 
@@ -57,6 +59,14 @@ int WriteBinary(const char* pBuff, const char* pName, unsigned long write_size,
  */
 int WriteChar(const char* pBuff, const char* pName, int flag);
 
+/**
+ * @brief Get the log backend on SD card.
+ *
+ * @param [in] pFile File object used by the backend. It must live while the log is open.
+ * @return Backend for OpenAppendFile() and OpenRecordFile()
+ */
+LogBackend GetSdLogBackend(File* pFile);
+
 /**
  * @brief Read character string data from SD card.
  * 
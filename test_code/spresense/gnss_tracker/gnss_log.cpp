@@ -0,0 +1,273 @@
+/*
+ *  gnss_log.cpp - Append-only log files
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/**
+ * @file gnss_log.cpp
+ * @brief Append-only log files
+ */
+
+#include <string.h>
+
+#include "gnss_log.h"
+
+/**
+ * @brief Write the buffer and start the next one at a sector boundary.
+ *
+ * @param [in,out] pAppend Append file
+ * @return true if success, false if failure
+ */
+static bool WriteAppendBuffer(AppendFile *pAppend)
+{
+  unsigned long write_result;
+
+  write_result = pAppend->Backend.Write(pAppend->Backend.pContext, pAppend->Buffer, pAppend->Length);
+  if (write_result != pAppend->Length)
+  {
+    /* Write error. */
+    return false;
+  }
+
+  pAppend->FileSize += pAppend->Length;
+  pAppend->Length = 0;
+  pAppend->Limit = APPEND_BUFFER_SIZE - (pAppend->FileSize % APPEND_SECTOR_SIZE);
+
+  return true;
+}
+
+bool OpenAppendFile(AppendFile *pAppend, const LogBackend *pBackend, const char *pName)
+{
+  long file_size;
+
+  pAppend->Backend = *pBackend;
+  pAppend->IsOpen = false;
+  pAppend->Length = 0;
+
+  /* Open file once. It is kept open for all appends. */
+  file_size = pAppend->Backend.Open(pAppend->Backend.pContext, pName);
+  if (file_size < 0)
+  {
+    return false;
+  }
+
+  /* Continue from the end of the existing file. */
+  pAppend->FileSize = (unsigned long)file_size;
+  pAppend->Limit = APPEND_BUFFER_SIZE - (pAppend->FileSize % APPEND_SECTOR_SIZE);
+  pAppend->IsOpen = true;
+
+  return true;
+}
+
+unsigned long AppendData(AppendFile *pAppend, const char *pBuff, unsigned long size)
+{
+  unsigned long appended = 0;
+  unsigned long copy_size;
+
+  if (!pAppend->IsOpen)
+  {
+    return 0;
+  }
+
+  while (appended < size)
+  {
+    copy_size = pAppend->Limit - pAppend->Length;
+    if (copy_size > size - appended)
+    {
+      copy_size = size - appended;
+    }
+    memcpy(&pAppend->Buffer[pAppend->Length], &pBuff[appended], copy_size);
+    pAppend->Length += copy_size;
+    appended += copy_size;
+
+    /* Write full sectors. */
+    if ((pAppend->Length == pAppend->Limit) && !WriteAppendBuffer(pAppend))
+    {
+      break;
+    }
+  }
+
+  return appended;
+}
+
+bool FlushAppendFile(AppendFile *pAppend)
+{
+  if (!pAppend->IsOpen)
+  {
+    return false;
+  }
+
+  if ((pAppend->Length != 0) && !WriteAppendBuffer(pAppend))
+  {
+    return false;
+  }
+
+  /* Save the data without closing the file. */
+  return pAppend->Backend.Flush(pAppend->Backend.pContext);
+}
+
+bool CloseAppendFile(AppendFile *pAppend)
+{
+  bool result = FlushAppendFile(pAppend);
+
+  if (pAppend->IsOpen)
+  {
+    pAppend->Backend.Close(pAppend->Backend.pContext);
+    pAppend->IsOpen = false;
+  }
+
+  return result;
+}
+
+bool OpenRecordFile(RecordFile *pRecord, const LogBackend *pBackend, const char *pName,
+                    unsigned long RecordSize)
+{
+  /* A record must be written with at most one buffer write, so that a
+     failed write can be undone by WriteRecord(). */
+  if ((RecordSize == 0) || (RecordSize > RECORD_MAX_SIZE))
+  {
+    pRecord->File.IsOpen = false;
+    return false;
+  }
+
+  if (!OpenAppendFile(&pRecord->File, pBackend, pName))
+  {
+    return false;
+  }
+
+  /* Start a new session at the end of the file. */
+  pRecord->Footer.StartOffset = (uint32_t)pRecord->File.FileSize;
+  pRecord->Footer.RecordSize = (uint32_t)RecordSize;
+  pRecord->Footer.RecordCount = 0;
+  pRecord->Footer.IndexInterval = 1;
+  pRecord->Footer.IndexCount = 0;
+  pRecord->Footer.Magic = RECORD_FOOTER_MAGIC;
+
+  return true;
+}
+
+bool WriteRecord(RecordFile *pRecord, const void *pData, uint32_t Key)
+{
+  RecordFooter *pFooter = &pRecord->Footer;
+  unsigned long length = pRecord->File.Length;
+  uint32_t cnt;
+
+  if (AppendData(&pRecord->File, (const char*)pData, pFooter->RecordSize) != pFooter->RecordSize)
+  {
+    /* Write error. Drop the part of the record left in the buffer, so the
+       next record starts at a record boundary. Nothing of this record has
+       reached the file, because RecordSize is at most RECORD_MAX_SIZE. */
+    pRecord->File.Length = length;
+    return false;
+  }
+
+  /* Update the index. */
+  if ((pFooter->RecordCount % pFooter->IndexInterval) == 0)
+  {
+    if (pFooter->IndexCount == RECORD_INDEX_SIZE)
+    {
+      /* Index is full. Keep every other entry. */
+      for (cnt = 0; cnt < RECORD_INDEX_SIZE / 2; cnt++)
+      {
+        pRecord->IndexKey[cnt] = pRecord->IndexKey[cnt * 2];
+      }
+      pFooter->IndexCount = RECORD_INDEX_SIZE / 2;
+      pFooter->IndexInterval *= 2;
+    }
+
+    if ((pFooter->RecordCount % pFooter->IndexInterval) == 0)
+    {
+      pRecord->IndexKey[pFooter->IndexCount++] = Key;
+    }
+  }
+  pFooter->RecordCount++;
+
+  return true;
+}
+
+bool CloseRecordFile(RecordFile *pRecord)
+{
+  RecordFooter *pFooter = &pRecord->Footer;
+  unsigned long index_size = pFooter->IndexCount * sizeof(pRecord->IndexKey[0]);
+  bool result = true;
+
+  if (!pRecord->File.IsOpen)
+  {
+    return false;
+  }
+
+  /* Write the index and the footer of the session. */
+  if (pFooter->RecordCount != 0)
+  {
+    result = (AppendData(&pRecord->File, (const char*)pRecord->IndexKey, index_size) == index_size)
+          && (AppendData(&pRecord->File, (const char*)pFooter, sizeof(*pFooter)) == sizeof(*pFooter));
+  }
+
+  return CloseAppendFile(&pRecord->File) && result;
+}
+
+long FindRecord(const char *pFileData, unsigned long FileSize, uint32_t Key)
+{
+  RecordFooter Footer;
+  uint32_t IndexKey;
+  unsigned long end = FileSize;
+  unsigned long index_offset;
+  uint32_t low;
+  uint32_t high;
+  uint32_t mid;
+
+  /* Follow the sessions back from the file end. */
+  while (end >= sizeof(Footer))
+  {
+    memcpy(&Footer, &pFileData[end - sizeof(Footer)], sizeof(Footer));
+    index_offset = end - sizeof(Footer) - Footer.IndexCount * sizeof(IndexKey);
+    if ((Footer.Magic != RECORD_FOOTER_MAGIC) || (Footer.IndexCount == 0)
+        || (Footer.IndexCount > RECORD_INDEX_SIZE)
+        || (end < sizeof(Footer) + Footer.IndexCount * sizeof(IndexKey))
+        || (index_offset != Footer.StartOffset + (unsigned long)Footer.RecordSize * Footer.RecordCount))
+    {
+      /* No footer. The session was not closed. */
+      return -1;
+    }
+
+    memcpy(&IndexKey, &pFileData[index_offset], sizeof(IndexKey));
+    if (IndexKey <= Key)
+    {
+      /* Binary search of the last entry not greater than Key. */
+      low = 0;
+      high = Footer.IndexCount - 1;
+      while (low < high)
+      {
+        mid = (low + high + 1) / 2;
+        memcpy(&IndexKey, &pFileData[index_offset + mid * sizeof(IndexKey)], sizeof(IndexKey));
+        if (IndexKey <= Key)
+        {
+          low = mid;
+        }
+        else
+        {
+          high = mid - 1;
+        }
+      }
+      return (long)(Footer.StartOffset + (unsigned long)low * Footer.IndexInterval * Footer.RecordSize);
+    }
+
+    /* Key is in an earlier session. */
+    end = Footer.StartOffset;
+  }
+
+  return -1;
+}
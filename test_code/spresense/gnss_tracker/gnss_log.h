@@ -0,0 +1,176 @@
+/*
+ *  gnss_log.h - Append-only log files
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GNSS_LOG_H
+#define _GNSS_LOG_H
+
+/**
+ * @file gnss_log.h
+ * @brief Append-only log files
+ *
+ * The files are written through LogBackend, so the same code runs on the
+ * SD card (gnss_file.cpp) and on a PC file for testing.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define APPEND_SECTOR_SIZE   512                            /**< SD card sector size */
+#define APPEND_BUFFER_SIZE   (APPEND_SECTOR_SIZE * 4)       /**< Append buffer size */
+
+#define RECORD_INDEX_SIZE    128                            /**< Max index entries of a record file */
+#define RECORD_MAX_SIZE      (APPEND_BUFFER_SIZE - APPEND_SECTOR_SIZE)  /**< Max bytes of a record */
+#define RECORD_FOOTER_MAGIC  0x58444947UL                   /**< Record footer magic number "GIDX" */
+
+/**
+ * @brief Storage to append a file to.
+ */
+typedef struct {
+  void *pContext;                                                                 /**< Backend data */
+  long (*Open)(void *pContext, const char *pName);                                /**< Open for appending. Returns file size, -1 if failure */
+  unsigned long (*Write)(void *pContext, const char *pData, unsigned long Size);  /**< Append. Returns bytes written */
+  bool (*Flush)(void *pContext);                                                  /**< Save written data */
+  void (*Close)(void *pContext);                                                  /**< Close */
+} LogBackend;
+
+/**
+ * @brief Append-only file kept open across writes.
+ *
+ * Data is collected in the buffer with a tracked length and written in
+ * whole sectors, so each write ends on a sector boundary of the file.
+ */
+typedef struct {
+  LogBackend    Backend;                     /**< Storage */
+  unsigned long FileSize;                    /**< Bytes written to the file */
+  unsigned long Length;                      /**< Bytes in Buffer */
+  unsigned long Limit;                       /**< Length to write Buffer at */
+  bool          IsOpen;                      /**< File is opened */
+  char          Buffer[APPEND_BUFFER_SIZE];  /**< Data not written yet */
+} AppendFile;
+
+/**
+ * @brief Footer written after the records and the index of a session.
+ *
+ * A file is a sequence of sessions: [records][index][footer].
+ * The magic number is last, so the footer can be found from the file end.
+ */
+typedef struct {
+  uint32_t StartOffset;    /**< File offset of the first record of the session */
+  uint32_t RecordSize;     /**< Bytes of a record */
+  uint32_t RecordCount;    /**< Number of records */
+  uint32_t IndexInterval;  /**< Records per index entry */
+  uint32_t IndexCount;     /**< Number of index entries before the footer */
+  uint32_t Magic;          /**< RECORD_FOOTER_MAGIC */
+} RecordFooter;
+
+/**
+ * @brief File of fixed-size records with a key index.
+ *
+ * Index entry i is the key of record i * IndexInterval. When the index is
+ * full, every other entry is dropped and the interval is doubled.
+ */
+typedef struct {
+  AppendFile    File;                         /**< Appended file */
+  RecordFooter  Footer;                       /**< Footer of the current session */
+  uint32_t      IndexKey[RECORD_INDEX_SIZE];  /**< Index of the current session */
+} RecordFile;
+
+/**
+ * @brief Open a file for appending. The file stays open until CloseAppendFile().
+ *
+ * @param [out] pAppend Append file
+ * @param [in] pBackend Storage
+ * @param [in] pName File name
+ * @return true if success, false if failure
+ */
+bool OpenAppendFile(AppendFile *pAppend, const LogBackend *pBackend, const char *pName);
+
+/**
+ * @brief Append data. Full sectors are written to the storage.
+ *
+ * @param [in,out] pAppend Append file
+ * @param [in] pBuff Data to be appended
+ * @param [in] size Bytes to be appended
+ * @return Bytes appended
+ */
+unsigned long AppendData(AppendFile *pAppend, const char *pBuff, unsigned long size);
+
+/**
+ * @brief Write all appended data including the last partial sector.
+ *
+ * @param [in,out] pAppend Append file
+ * @return true if success, false if failure
+ */
+bool FlushAppendFile(AppendFile *pAppend);
+
+/**
+ * @brief Flush and close the file.
+ *
+ * @param [in,out] pAppend Append file
+ * @return true if success, false if failure
+ */
+bool CloseAppendFile(AppendFile *pAppend);
+
+/**
+ * @brief Open a record file and start a new session at its end.
+ *
+ * @param [out] pRecord Record file
+ * @param [in] pBackend Storage
+ * @param [in] pName File name
+ * @param [in] RecordSize Bytes of a record (1 to RECORD_MAX_SIZE)
+ * @return true if success, false if failure
+ */
+bool OpenRecordFile(RecordFile *pRecord, const LogBackend *pBackend, const char *pName,
+                    unsigned long RecordSize);
+
+/**
+ * @brief Append one record in a single buffered write.
+ *
+ * If the write fails, the record is dropped from the buffer, so the
+ * following records stay aligned to RecordSize.
+ *
+ * @param [in,out] pRecord Record file
+ * @param [in] pData Record (RecordSize bytes)
+ * @param [in] Key Key of the record, not decreasing (e.g. time)
+ * @return true if success, false if failure
+ */
+bool WriteRecord(RecordFile *pRecord, const void *pData, uint32_t Key);
+
+/**
+ * @brief Write the index and the footer, then close the file.
+ *
+ * @param [in,out] pRecord Record file
+ * @return true if success, false if failure
+ */
+bool CloseRecordFile(RecordFile *pRecord);
+
+/**
+ * @brief Find a record by key in a record file loaded to memory.
+ *
+ * Sessions are followed back from the file end with their footers.
+ *
+ * @param [in] pFileData File contents
+ * @param [in] FileSize Bytes of the file
+ * @param [in] Key Key to find
+ * @return File offset of the last indexed record whose key is not greater
+ *         than Key. Up to IndexInterval records from there have to be
+ *         checked. -1 if not found.
+ */
+long FindRecord(const char *pFileData, unsigned long FileSize, uint32_t Key);
+
+#endif
@@ -1,5 +1,5 @@
 /*
- *  gnss_nmea.cpp - NMEA's GGA sentence
+ *  gnss_nmea.cpp - NMEA sentences
  *  Copyright 2017 Sony Semiconductor Solutions Corporation
  *
  *  This library is free software; you can redistribute it and/or
@@ -20,9 +20,11 @@
 /**
  * @file gnss_nmea.cpp
  * @author Sony Semiconductor Solutions Corporation
- * @brief NMEA's GGA sentence
+ * @brief NMEA sentences
  */
 
+#include <math.h>
+
 /* include the GNSS library */
 #include <GNSS.h>
 
@@ -31,6 +33,10 @@
 
 #define STRING_BUFFER_SIZE  128      /**< Sentence buffer size */
 
+#define NMEA_GSA_SATELLITE_NUM  12   /**< Number of satellite fields in GSA */
+#define KNOT_PER_METER_SEC  1.943844 /**< Convert m/s to knots */
+#define KMH_PER_METER_SEC   3.6      /**< Convert m/s to km/h */
+
 /**
  * @brief Calculate the checksum and add it to the end.
  * 
@@ -197,3 +203,401 @@ String getNmeaGga(SpNavData* pNavData)
   return Gga;
 }
 
+
+/**
+ * @brief Sentence writer state.
+ */
+typedef struct {
+  char *pBuffer;          /**< Output buffer */
+  size_t BufferSize;      /**< Size of pBuffer */
+  size_t Length;          /**< Written length */
+  unsigned char CheckSum; /**< XOR of characters after '$' */
+  bool Overflow;          /**< pBuffer was too small */
+} NmeaWriter;
+
+/**
+ * @brief Write one character and update the checksum.
+ *
+ * @param [in,out] pWriter Writer
+ * @param [in] c Character
+ */
+static void NmeaPutChar(NmeaWriter *pWriter, char c)
+{
+  /* Keep one byte for the terminator. */
+  if (pWriter->Length + 1 >= pWriter->BufferSize)
+  {
+    pWriter->Overflow = true;
+    return;
+  }
+  pWriter->pBuffer[pWriter->Length++] = c;
+  pWriter->CheckSum ^= (unsigned char)c;
+}
+
+/**
+ * @brief Write a string and update the checksum.
+ *
+ * @param [in,out] pWriter Writer
+ * @param [in] pString Null terminated string
+ */
+static void NmeaPutString(NmeaWriter *pWriter, const char *pString)
+{
+  while (*pString != 0x00)
+  {
+    NmeaPutChar(pWriter, *pString++);
+  }
+}
+
+/**
+ * @brief Write an unsigned integer padded with zeros.
+ *
+ * @param [in,out] pWriter Writer
+ * @param [in] Value Value
+ * @param [in] Width Minimum number of digits
+ */
+static void NmeaPutUint(NmeaWriter *pWriter, unsigned long Value, int Width)
+{
+  char Digits[10];
+  int Num = 0;
+
+  do
+  {
+    Digits[Num++] = (char)('0' + Value % 10);
+    Value /= 10;
+  } while (Value != 0 && Num < (int)sizeof(Digits));
+
+  for (; Width > Num; Width--)
+  {
+    NmeaPutChar(pWriter, '0');
+  }
+  while (Num > 0)
+  {
+    NmeaPutChar(pWriter, Digits[--Num]);
+  }
+}
+
+/**
+ * @brief Write a value with one decimal, same as printf("%.1f").
+ *
+ * The value is rounded to the nearest tenth of its exact binary value
+ * (ties to even), so the output matches the C library.
+ *
+ * @param [in,out] pWriter Writer
+ * @param [in] Value Value
+ */
+static void NmeaPutFixed1(NmeaWriter *pWriter, double Value)
+{
+  double Magnitude;
+  double Tenths;
+  double Diff;
+  unsigned long Integer;
+
+  if (!isfinite(Value))
+  {
+    /* Leave the field empty. */
+    return;
+  }
+
+  Magnitude = fabs(Value);
+  Tenths = floor(Magnitude * 10);
+
+  /* Correct floor() of the rounded product by the exact difference. */
+  if (fma(Magnitude, 10, -Tenths) < 0)
+  {
+    Tenths -= 1;
+  }
+  else if (fma(Magnitude, 10, -(Tenths + 1)) >= 0)
+  {
+    Tenths += 1;
+  }
+
+  /* Round half to even. */
+  Diff = fma(Magnitude, 10, -(Tenths + 0.5));
+  if ((Diff > 0) || ((Diff == 0) && (fmod(Tenths, 2) != 0)))
+  {
+    Tenths += 1;
+  }
+
+  if (signbit(Value))
+  {
+    NmeaPutChar(pWriter, '-');
+  }
+  Integer = (unsigned long)Tenths;
+  NmeaPutUint(pWriter, Integer / 10, 1);
+  NmeaPutChar(pWriter, '.');
+  NmeaPutUint(pWriter, Integer % 10, 1);
+}
+
+/**
+ * @brief Write a coordinate as "DDMM.MMMM,N," with integer arithmetic.
+ *
+ * @param [in,out] pWriter Writer
+ * @param [in] Coordinate Latitude or longitude
+ * @param [in] cordinate_type Coordinate type: CORIDNATE_TYPE_LATITUDE or CORIDNATE_TYPE_LONGITUDE
+ */
+static void NmeaPutCoordinate(NmeaWriter *pWriter, double Coordinate,
+                              unsigned int cordinate_type)
+{
+  /* 1 unit = 0.0001 minute */
+  const unsigned long UnitPerMinute = 10000;
+  const unsigned long UnitPerDegree = 60 * UnitPerMinute;
+  unsigned long Units;
+  unsigned long Minute;
+
+  if (cordinate_type > CORIDNATE_TYPE_LONGITUDE)
+  {
+    NmeaPutString(pWriter, ",,");
+    return;
+  }
+
+  Units = (unsigned long)(fabs(Coordinate) * UnitPerDegree + 0.5);
+  Minute = Units % UnitPerDegree;
+
+  NmeaPutUint(pWriter, Units / UnitPerDegree,
+              (cordinate_type == CORIDNATE_TYPE_LATITUDE) ? 2 : 3);
+  NmeaPutUint(pWriter, Minute / UnitPerMinute, 2);
+  NmeaPutChar(pWriter, '.');
+  NmeaPutUint(pWriter, Minute % UnitPerMinute, 4);
+  NmeaPutChar(pWriter, ',');
+  if (cordinate_type == CORIDNATE_TYPE_LATITUDE)
+  {
+    NmeaPutChar(pWriter, (Coordinate >= 0.0) ? 'N' : 'S');
+  }
+  else
+  {
+    NmeaPutChar(pWriter, (Coordinate >= 0.0) ? 'E' : 'W');
+  }
+  NmeaPutChar(pWriter, ',');
+}
+
+/**
+ * @brief Write UTC time as "hhmmss.ss,".
+ *
+ * @param [in,out] pWriter Writer
+ * @param [in] pNavData Navigation data
+ */
+static void NmeaPutTime(NmeaWriter *pWriter, SpNavData *pNavData)
+{
+  NmeaPutUint(pWriter, pNavData->time.hour, 2);
+  NmeaPutUint(pWriter, pNavData->time.minute, 2);
+  NmeaPutUint(pWriter, pNavData->time.sec, 2);
+  NmeaPutChar(pWriter, '.');
+  NmeaPutUint(pWriter, pNavData->time.usec / 10000, 2);
+  NmeaPutChar(pWriter, ',');
+}
+
+/**
+ * @brief Start a sentence with "$<Header>,".
+ *
+ * @param [out] pWriter Writer
+ * @param [out] pBuffer Buffer to write the sentence
+ * @param [in] BufferSize Size of pBuffer
+ * @param [in] pHeader Talker and sentence ID (e.g. "GPGGA")
+ */
+static void NmeaBegin(NmeaWriter *pWriter, char *pBuffer, size_t BufferSize,
+                      const char *pHeader)
+{
+  pWriter->pBuffer = pBuffer;
+  pWriter->BufferSize = BufferSize;
+  pWriter->Length = 0;
+  pWriter->CheckSum = 0;
+  pWriter->Overflow = (pBuffer == NULL) || (BufferSize == 0);
+
+  NmeaPutChar(pWriter, '$');
+  pWriter->CheckSum = 0;  /* '$' is not included in the checksum. */
+  NmeaPutString(pWriter, pHeader);
+  NmeaPutChar(pWriter, ',');
+}
+
+/**
+ * @brief Finish a sentence with "*hh\r\n".
+ *
+ * @param [in,out] pWriter Writer
+ * @return Length of the sentence. 0 if the buffer is too small.
+ */
+static size_t NmeaEnd(NmeaWriter *pWriter)
+{
+  static const char Hex[] = "0123456789ABCDEF";
+  unsigned char CheckSum = pWriter->CheckSum;
+
+  NmeaPutChar(pWriter, '*');
+  NmeaPutChar(pWriter, Hex[CheckSum >> 4]);
+  NmeaPutChar(pWriter, Hex[CheckSum & 0x0F]);
+  NmeaPutString(pWriter, "\r\n");
+
+  if (pWriter->Overflow)
+  {
+    if ((pWriter->pBuffer != NULL) && (pWriter->BufferSize > 0))
+    {
+      pWriter->pBuffer[0] = 0x00;
+    }
+    return 0;
+  }
+
+  pWriter->pBuffer[pWriter->Length] = 0x00;
+  return pWriter->Length;
+}
+
+size_t writeNmeaGga(char *pBuffer, size_t BufferSize, SpNavData *pNavData)
+{
+  NmeaWriter Writer;
+
+  NmeaBegin(&Writer, pBuffer, BufferSize, "GPGGA");
+  NmeaPutTime(&Writer, pNavData);
+
+  /* Set Coordinate. */
+  if (pNavData->posDataExist)
+  {
+    NmeaPutCoordinate(&Writer, pNavData->latitude, CORIDNATE_TYPE_LATITUDE);
+    NmeaPutCoordinate(&Writer, pNavData->longitude, CORIDNATE_TYPE_LONGITUDE);
+  }
+  else
+  {
+    NmeaPutString(&Writer, ",,,,");
+  }
+
+  /* Set Quality indicator. */
+  NmeaPutString(&Writer, (pNavData->type != SpPvtTypeGnss) ? "0," : "1,");
+
+  /* Set Number of satellites in use. */
+  NmeaPutUint(&Writer, pNavData->numSatellitesCalcPos, 2);
+  NmeaPutChar(&Writer, ',');
+
+  if (pNavData->posDataExist)
+  {
+    /* HDOP, MSL altitude and units, Geoid separation (skipped). */
+    if (pNavData->hdop != -1.0)
+    {
+      NmeaPutFixed1(&Writer, pNavData->hdop);
+    }
+    NmeaPutChar(&Writer, ',');
+    NmeaPutFixed1(&Writer, pNavData->altitude);
+    NmeaPutString(&Writer, ",M,,M,");
+  }
+  else
+  {
+    NmeaPutString(&Writer, ",,,,,");
+  }
+
+  /* Set the Age of Differential GPS data. Not really applicable. */
+  NmeaPutChar(&Writer, ',');
+
+  return NmeaEnd(&Writer);
+}
+
+size_t writeNmeaRmc(char *pBuffer, size_t BufferSize, SpNavData *pNavData)
+{
+  NmeaWriter Writer;
+  bool Valid = (pNavData->posDataExist) && (pNavData->posFixMode != FixInvalid);
+
+  NmeaBegin(&Writer, pBuffer, BufferSize, "GPRMC");
+  NmeaPutTime(&Writer, pNavData);
+
+  /* Set Status. */
+  NmeaPutString(&Writer, Valid ? "A," : "V,");
+
+  /* Set Coordinate. */
+  if (pNavData->posDataExist)
+  {
+    NmeaPutCoordinate(&Writer, pNavData->latitude, CORIDNATE_TYPE_LATITUDE);
+    NmeaPutCoordinate(&Writer, pNavData->longitude, CORIDNATE_TYPE_LONGITUDE);
+  }
+  else
+  {
+    NmeaPutString(&Writer, ",,,,");
+  }
+
+  /* Set Speed over ground (knots) and Course over ground. */
+  if (Valid)
+  {
+    NmeaPutFixed1(&Writer, pNavData->velocity * KNOT_PER_METER_SEC);
+    NmeaPutChar(&Writer, ',');
+    NmeaPutFixed1(&Writer, pNavData->direction);
+    NmeaPutChar(&Writer, ',');
+  }
+  else
+  {
+    NmeaPutString(&Writer, ",,");
+  }
+
+  /* Set Date "ddmmyy". */
+  NmeaPutUint(&Writer, pNavData->time.day, 2);
+  NmeaPutUint(&Writer, pNavData->time.month, 2);
+  NmeaPutUint(&Writer, pNavData->time.year % 100, 2);
+
+  /* Magnetic variation is not available. Set Mode indicator. */
+  NmeaPutString(&Writer, Valid ? ",,,A" : ",,,N");
+
+  return NmeaEnd(&Writer);
+}
+
+size_t writeNmeaGsa(char *pBuffer, size_t BufferSize, SpNavData *pNavData)
+{
+  NmeaWriter Writer;
+  unsigned long SatelliteNum = 0;
+  unsigned long cnt;
+
+  NmeaBegin(&Writer, pBuffer, BufferSize, "GPGSA");
+
+  /* Set Mode (automatic) and Fix type. */
+  NmeaPutString(&Writer, "A,");
+  if ((!pNavData->posDataExist) || (pNavData->posFixMode == FixInvalid))
+  {
+    NmeaPutString(&Writer, "1,");
+  }
+  else
+  {
+    NmeaPutString(&Writer, (pNavData->posFixMode == Fix2D) ? "2," : "3,");
+    SatelliteNum = pNavData->numSatellites;
+  }
+
+  /* Set Satellite IDs. */
+  for (cnt = 0; cnt < NMEA_GSA_SATELLITE_NUM; cnt++)
+  {
+    if (cnt < SatelliteNum)
+    {
+      NmeaPutUint(&Writer, pNavData->getSatelliteId(cnt), 2);
+    }
+    NmeaPutChar(&Writer, ',');
+  }
+
+  /* Set PDOP, HDOP and VDOP. */
+  if (pNavData->posDataExist)
+  {
+    NmeaPutFixed1(&Writer, pNavData->pdop);
+    NmeaPutChar(&Writer, ',');
+    NmeaPutFixed1(&Writer, pNavData->hdop);
+    NmeaPutChar(&Writer, ',');
+    NmeaPutFixed1(&Writer, pNavData->vdop);
+  }
+  else
+  {
+    NmeaPutString(&Writer, ",,");
+  }
+
+  return NmeaEnd(&Writer);
+}
+
+size_t writeNmeaVtg(char *pBuffer, size_t BufferSize, SpNavData *pNavData)
+{
+  NmeaWriter Writer;
+  bool Valid = (pNavData->posDataExist) && (pNavData->posFixMode != FixInvalid);
+
+  NmeaBegin(&Writer, pBuffer, BufferSize, "GPVTG");
+
+  if (Valid)
+  {
+    /* Set Course (true), Course (magnetic, not available) and Speed. */
+    NmeaPutFixed1(&Writer, pNavData->direction);
+    NmeaPutString(&Writer, ",T,,M,");
+    NmeaPutFixed1(&Writer, pNavData->velocity * KNOT_PER_METER_SEC);
+    NmeaPutString(&Writer, ",N,");
+    NmeaPutFixed1(&Writer, pNavData->velocity * KMH_PER_METER_SEC);
+    NmeaPutString(&Writer, ",K,A");
+  }
+  else
+  {
+    NmeaPutString(&Writer, ",T,,M,,N,,K,N");
+  }
+
+  return NmeaEnd(&Writer);
+}
@@ -1,5 +1,5 @@
 /*
- *  gnss_nmea.h - NMEA's GGA sentence
+ *  gnss_nmea.h - NMEA sentences
  *  Copyright 2017 Sony Semiconductor Solutions Corporation
  *
  *  This library is free software; you can redistribute it and/or
@@ -23,7 +23,7 @@
 /**
  * @file gnss_nmea.h
  * @author Sony Semiconductor Solutions Corporation
- * @brief NMEA's GGA sentence
+ * @brief NMEA sentences
  */
 
 /* include the GNSS library */
@@ -36,5 +36,55 @@
  */
 String getNmeaGga(SpNavData* pNavData);
 
+/**
+ * @brief Write NMEA's GGA sentence to the buffer.
+ *
+ * The sentence is written in one pass without heap allocation, and the
+ * checksum is calculated while writing. The output is identical to
+ * getNmeaGga() except when a coordinate is within 0.00005 minute of the
+ * next whole degree: the minutes are rounded together with the degrees,
+ * so 36.99999986 is written as "3700.0000" where getNmeaGga() writes
+ * the invalid "3660.0000".
+ *
+ * @param [out] pBuffer Buffer to write the sentence (null terminated)
+ * @param [in] BufferSize Size of pBuffer
+ * @param [in] pNavData Navigation data
+ * @return Length of the sentence. 0 if pBuffer is too small.
+ */
+size_t writeNmeaGga(char *pBuffer, size_t BufferSize, SpNavData *pNavData);
+
+/**
+ * @brief Write NMEA's RMC sentence to the buffer.
+ *
+ * @param [out] pBuffer Buffer to write the sentence (null terminated)
+ * @param [in] BufferSize Size of pBuffer
+ * @param [in] pNavData Navigation data
+ * @return Length of the sentence. 0 if pBuffer is too small.
+ */
+size_t writeNmeaRmc(char *pBuffer, size_t BufferSize, SpNavData *pNavData);
+
+/**
+ * @brief Write NMEA's GSA sentence to the buffer.
+ *
+ * Satellites in use are not reported by the GNSS library,
+ * so the first 12 tracked satellites are listed.
+ *
+ * @param [out] pBuffer Buffer to write the sentence (null terminated)
+ * @param [in] BufferSize Size of pBuffer
+ * @param [in] pNavData Navigation data
+ * @return Length of the sentence. 0 if pBuffer is too small.
+ */
+size_t writeNmeaGsa(char *pBuffer, size_t BufferSize, SpNavData *pNavData);
+
+/**
+ * @brief Write NMEA's VTG sentence to the buffer.
+ *
+ * @param [out] pBuffer Buffer to write the sentence (null terminated)
+ * @param [in] BufferSize Size of pBuffer
+ * @param [in] pNavData Navigation data
+ * @return Length of the sentence. 0 if pBuffer is too small.
+ */
+size_t writeNmeaVtg(char *pBuffer, size_t BufferSize, SpNavData *pNavData);
+
 #endif
 
@@ -670,6 +670,39 @@ static void SleepOut(void)
   APP_PRINT("out.\n");
 }
 
+/**
+ * @brief Check that the navigation data can be written to the binary file.
+ *
+ * @param [in] pNavData Navigation data
+ * @return true if the position is fixed and the time is valid, so the
+ *         record key increases with time.
+ */
+static bool IsRecordValid(const SpNavData *pNavData)
+{
+  return (pNavData->posDataExist && (pNavData->posFixMode != FixInvalid)
+          && (pNavData->time.year >= 2000)
+          && (pNavData->time.month >= 1) && (pNavData->time.month <= 12)
+          && (pNavData->time.day >= 1) && (pNavData->time.day <= 31));
+}
+
+/**
+ * @brief Get the record key of the binary file.
+ *
+ * @param [in] pNavData Navigation data, checked by IsRecordValid()
+ * @return Seconds from 2000, counting every month as 31 days. It only has to
+ *         increase with time, so the index of the file can be searched.
+ */
+static uint32_t GetRecordKey(const SpNavData *pNavData)
+{
+  uint32_t Days;
+
+  Days = ((uint32_t)(pNavData->time.year - 2000) * 12 + (pNavData->time.month - 1)) * 31
+       + (pNavData->time.day - 1);
+
+  return ((Days * 24 + pNavData->time.hour) * 60 + pNavData->time.minute) * 60
+       + pNavData->time.sec;
+}
+
 /**
  * @brief Get file number.
  * 
@@ -927,7 +960,10 @@ void loop() {
   static int State = eStateActive;
   static int TimeOut = IDLE_ACTIVE_TIME;
   static bool PosFixflag = false;
-  static char *pNmeaBuff     = NULL;
+  static File NmeaSdFile;
+  static File BinarySdFile;
+  static AppendFile NmeaFile;
+  static RecordFile BinaryFile;
   static char *pBinaryBuffer = NULL;
 
   /* Check state. */
@@ -964,13 +1000,13 @@ void loop() {
   {
     /* Active. */
     unsigned long BuffSize;
-    unsigned long WriteSize;
+    size_t NmeaLength;
     bool LedSet;
 
     TimeOut -= Parameter.IntervalSec;
 
     SpNavData NavData;
-    String NmeaString = "";
+    char NmeaString[NMEA_BUFFER_SIZE];
 
     /* Blink LED. */
     Led_isActive();
@@ -997,8 +1033,8 @@ void loop() {
       }
 
       /* Get Nmea Data. */
-      NmeaString = getNmeaGga(&NavData);
-      if (strlen(NmeaString.c_str()) == 0)
+      NmeaLength = writeNmeaGga(NmeaString, sizeof(NmeaString), &NavData);
+      if (NmeaLength == 0)
       {
         /* Error case. */
         APP_PRINT_E("getNmea error");
@@ -1010,29 +1046,28 @@ void loop() {
         if (Parameter.NmeaOutUart == true)
         {
           /* To Uart. */
-          APP_PRINT(NmeaString.c_str());
+          APP_PRINT(NmeaString);
         }
 
         if (Parameter.NmeaOutFile == true)
         {
           /* To SDCard. */
-          BuffSize = NMEA_BUFFER_SIZE * (IDLE_ACTIVE_TIME / Parameter.IntervalSec);
-
-          if (pNmeaBuff == NULL)
+          if (!NmeaFile.IsOpen)
           {
-            /* Alloc buffer. */
-            pNmeaBuff = (char*)malloc(BuffSize);
-            if (pNmeaBuff != NULL)
-            {
-              /* Clear Buffer */
-              pNmeaBuff[0] = 0x00;
-            }
+            /* Open file once and keep it open. */
+            LogBackend Backend = GetSdLogBackend(&NmeaSdFile);
+            OpenAppendFile(&NmeaFile, &Backend, FilenameTxt);
           }
 
-          if (pNmeaBuff != NULL)
+          if (NmeaFile.IsOpen)
           {
-            /* Store Nmea Data to buffer. */
-            strncat(pNmeaBuff, NmeaString.c_str(), BuffSize);
+            /* Store Nmea Data. Full sectors are written here. */
+            Led_isSdAccess(true);
+            if (AppendData(&NmeaFile, NmeaString, NmeaLength) != NmeaLength)
+            {
+              Led_isError(true);
+            }
+            Led_isSdAccess(false);
           }
         }
 
@@ -1050,24 +1085,24 @@ void loop() {
               pBinaryBuffer[0] = 0x00;
             }
           }
-          if (pBinaryBuffer != NULL)
+          if ((pBinaryBuffer != NULL) && !BinaryFile.File.IsOpen)
           {
-
-            if (Gnss.getPositionData(pBinaryBuffer) == BuffSize)
+            /* Open file once and keep it open. */
+            LogBackend Backend = GetSdLogBackend(&BinarySdFile);
+            OpenRecordFile(&BinaryFile, &Backend, FilenameBin, BuffSize);
+          }
+          if ((pBinaryBuffer != NULL) && BinaryFile.File.IsOpen)
+          {
+            /* Skip until the position is fixed and the time is valid. */
+            if (IsRecordValid(&NavData) && (Gnss.getPositionData(pBinaryBuffer) == BuffSize))
             {
-              /* Write Binary Data. */
-              GnssPositionData *pAdr = (GnssPositionData*)pBinaryBuffer;
+              /* Write MagicNumber, Data and CRC as one record. */
               Led_isSdAccess(true);
-              WriteSize  = WriteBinary((char*)&pAdr->MagicNumber, FilenameBin, sizeof(pAdr->MagicNumber), (FILE_WRITE | O_APPEND));
-              WriteSize += WriteBinary((char*)&pAdr->Data,        FilenameBin, sizeof(pAdr->Data),        (FILE_WRITE | O_APPEND));
-              WriteSize += WriteBinary((char*)&pAdr->CRC,         FilenameBin, sizeof(pAdr->CRC),         (FILE_WRITE | O_APPEND));
-              Led_isSdAccess(false);
-
-              /* Check result. */
-              if (WriteSize != BuffSize)
+              if (!WriteRecord(&BinaryFile, pBinaryBuffer, GetRecordKey(&NavData)))
               {
                 Led_isError(true);
               }
+              Led_isSdAccess(false);
             }
           }
         }
@@ -1097,30 +1132,29 @@ void loop() {
       WriteRequest = true;
     }
 
-    /* Check NMEA buffer. */
-    if(strlen(pNmeaBuff) > (BuffSize - NMEA_BUFFER_SIZE))
-    {
-      /* There is no capacity for writing in the next NMEA. */
-    }
-
     /* Write NMEA data. */
     if(WriteRequest == true)
     {
-      if (pNmeaBuff != NULL)
+      if (NmeaFile.IsOpen)
       {
-        /* Write Nmea Data. */
+        /* Write the last partial sector. */
         Led_isSdAccess(true);
-        WriteSize = WriteChar(pNmeaBuff, FilenameTxt, (FILE_WRITE | O_APPEND));
+        if (!FlushAppendFile(&NmeaFile))
+        {
+          Led_isError(true);
+        }
         Led_isSdAccess(false);
+      }
 
-        /* Check result. */
-        if (WriteSize != strlen(pNmeaBuff))
+      if (BinaryFile.File.IsOpen)
+      {
+        /* Write the index and close. The next record starts a new session. */
+        Led_isSdAccess(true);
+        if (!CloseRecordFile(&BinaryFile))
         {
           Led_isError(true);
         }
-
-        /* Clear Buffer */
-        pNmeaBuff[0] = 0x00;
+        Led_isSdAccess(false);
       }
     }
   }